@@ -0,0 +1,2913 @@
+#include <JEngine/Core/Log.h>
+#include <JEngine/Core/AssetDB.h>
+#include <JEngine/Assets/AssetDependencies.h>
+#include <JEngine/Assets/AssetLoader.h>
+#include <JEngine/Assets/AssetPacking.h>
+#include <JEngine/Assets/AssetResidency.h>
+#include <JEngine/Audio/AudioDevice.h>
+#include <JEngine/Audio/AudioEngine.h>
+#include <JEngine/Audio/AudioMixer.h>
+#include <JEngine/Audio/Resampler.h>
+#include <JEngine/IO/Audio.h>
+#include <JEngine/IO/BitStream.h>
+#include <JEngine/IO/BufferedStream.h>
+#include <JEngine/IO/Compression/ZLib.h>
+#include <JEngine/IO/Compression/LZ4.h>
+#include <JEngine/IO/DirectoryMonitor.h>
+#include <JEngine/IO/Image.h>
+#include <JEngine/IO/MappedFileStream.h>
+#include <JEngine/IO/MemoryStream.h>
+#include <JEngine/IO/VFS/VFS.h>
+#include <JEngine/Collections/SPSCQueue.h>
+#include <JEngine/Utility/XXHash.h>
+#include <JEngine/Math/Graphics/JColor32.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+// Image codec and stream benchmark, everything runs on synthetic data through MemoryStreams so no files are needed.
+// The FileStream and pak cases write scratch files next to the executable and remove them afterwards, the VFS cases only use runtime entries.
+// The directory monitor cases work in a scratch folder under the system temp directory.
+// Usage: J-Bench [--size=N] [--iters=N] [--only=substring]
+// Exits with 1 if any case fails or a lossless round trip doesn't match its source.
+
+using namespace JEngine;
+
+static std::atomic<uint64_t> s_allocations{ 0 };
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+// The debug CRT reports every malloc/realloc, which is what the codecs use directly
+static int allocHook(int allocType, void*, size_t, int blockType, long, const unsigned char*, int) {
+	if (blockType != _CRT_BLOCK && (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC)) {
+		s_allocations++;
+	}
+	return 1;
+}
+#else
+// Without the debug CRT only operator new is seen, plain malloc calls in the codecs go uncounted
+void* operator new(size_t size) {
+	s_allocations++;
+	if (void* mem = std::malloc(size ? size : 1)) { return mem; }
+	throw std::bad_alloc();
+}
+
+void operator delete(void* mem) noexcept { std::free(mem); }
+void operator delete(void* mem, size_t) noexcept { std::free(mem); }
+#endif
+
+namespace JEngine::Bench {
+	struct Options {
+		int32_t size{ 512 };
+		int32_t iterations{ 5 };
+		const char* only{ nullptr };
+	};
+
+	struct SourceImage {
+		const char* name;
+		ImageData image;
+	};
+
+	struct Codec {
+		const char* name;
+		bool lossless;
+		bool usesDecodeParams;
+		std::function<bool(const Stream&, const ImageData&)> encode;
+		std::function<bool(const Stream&, ImageData&, const ImageDecodeParams&)> decode;
+		std::function<bool(const Stream&, ImageData&)> getInfo;
+
+		//Source formats the encoder takes, empty takes every format
+		std::vector<TextureFormat> formats{};
+	};
+
+	static Options s_options{};
+	static int32_t s_failures = 0;
+
+	static uint32_t nextRandom(uint32_t& state) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+
+	static ImageData makeGradient(int32_t size) {
+		ImageData img{};
+		img.doAllocate(size, size, TextureFormat::RGB24);
+		uint8_t* pixels = img.getData();
+		for (int32_t y = 0; y < size; y++) {
+			for (int32_t x = 0; x < size; x++, pixels += 3) {
+				pixels[0] = uint8_t((x * 255) / size);
+				pixels[1] = uint8_t((y * 255) / size);
+				pixels[2] = uint8_t(((x + y) * 127) / size);
+			}
+		}
+		return img;
+	}
+
+	static ImageData makeNoise(int32_t size) {
+		ImageData img{};
+		img.doAllocate(size, size, TextureFormat::RGBA32);
+		img.flags |= IMG_FLAG_HAS_ALPHA;
+
+		uint32_t state = 0x9E3779B9U;
+		uint32_t* pixels = reinterpret_cast<uint32_t*>(img.getData());
+		for (size_t i = 0, count = size_t(size) * size; i < count; i++) {
+			pixels[i] = nextRandom(state);
+		}
+		return img;
+	}
+
+	static ImageData makeIndexed(int32_t size) {
+		ImageData img{};
+		img.doAllocate(size, size, TextureFormat::Indexed8, 256);
+
+		JColor32* palette = reinterpret_cast<JColor32*>(img.data);
+		for (int32_t i = 0; i < 16; i++) {
+			palette[i] = JColor32(uint8_t(i * 17), uint8_t(255 - i * 13), uint8_t((i * 71) & 0xFF), 255);
+		}
+
+		//Tile art, 16 colors in 8x8 cells with a diagonal stripe
+		uint8_t* pixels = img.getData();
+		for (int32_t y = 0; y < size; y++) {
+			for (int32_t x = 0; x < size; x++) {
+				uint8_t cell = uint8_t(((x >> 3) + (y >> 3) * 3) & 0xF);
+				*pixels++ = ((x + y) & 0xF) == 0 ? 15 - cell : cell;
+			}
+		}
+		return img;
+	}
+
+	static ImageData makeSprite(int32_t size) {
+		ImageData img{};
+		img.doAllocate(size, size, TextureFormat::RGBA32);
+		img.flags |= IMG_FLAG_HAS_ALPHA;
+
+		//Soft edged blobs on a fully transparent background
+		JColor32* pixels = reinterpret_cast<JColor32*>(img.getData());
+		float cell = size / 4.0f;
+		for (int32_t y = 0; y < size; y++) {
+			for (int32_t x = 0; x < size; x++) {
+				float fx = fmodf(float(x), cell) - cell * 0.5f;
+				float fy = fmodf(float(y), cell) - cell * 0.5f;
+				float dist = sqrtf(fx * fx + fy * fy) / (cell * 0.45f);
+				float alpha = dist >= 1.0f ? 0.0f : dist <= 0.8f ? 1.0f : (1.0f - dist) * 5.0f;
+
+				uint8_t a = uint8_t(alpha * 255.0f + 0.5f);
+				pixels[y * size + x] = a ? JColor32(uint8_t(x * 255 / size), 96, uint8_t(y * 255 / size), a) : JColor32(0, 0, 0, 0);
+			}
+		}
+		return img;
+	}
+
+	static bool isSelected(const char* group, const char* image, const char* op) {
+		if (!s_options.only) { return true; }
+		std::string name = std::string(group) + "/" + image + "/" + op;
+		return name.find(s_options.only) != std::string::npos;
+	}
+
+	static void report(const char* group, const char* image, const char* op, double ms, size_t bytes, double allocs, size_t outBytes = 0) {
+		double mbs = ms > 0.0 ? (double(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+		if (outBytes > 0) {
+			printf("%-14s %-9s %-15s %10.3f ms %10.1f MB/s %9.1f allocs %10zu bytes (%.1f%%)\n", group, image, op, ms, mbs, allocs, outBytes, outBytes * 100.0 / double(bytes));
+			return;
+		}
+		printf("%-14s %-9s %-15s %10.3f ms %10.1f MB/s %9.1f allocs\n", group, image, op, ms, mbs, allocs);
+	}
+
+	// Runs 'func' once to warm up, then times 'iterations' calls and reports the average per call
+	template<typename Func>
+	static bool run(const char* group, const char* image, const char* op, size_t bytes, Func&& func, size_t outBytes = 0) {
+		if (!isSelected(group, image, op)) { return true; }
+
+		if (!func()) {
+			printf("%-14s %-9s %-15s FAILED\n", group, image, op);
+			s_failures++;
+			return false;
+		}
+
+		uint64_t allocs = s_allocations;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int32_t i = 0; i < s_options.iterations; i++) {
+			func();
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		allocs = s_allocations - allocs;
+
+		double ms = std::chrono::duration<double, std::milli>(end - start).count() / s_options.iterations;
+		report(group, image, op, ms, bytes, double(allocs) / s_options.iterations, outBytes);
+		return true;
+	}
+
+	static bool matches(const ImageData& source, const ImageData& decoded) {
+		if (source.width != decoded.width || source.height != decoded.height || source.format != decoded.format) {
+			//Codecs are free to pick a different layout, only same-format round trips are compared
+			return true;
+		}
+
+		size_t pixelBytes = source.getSize() - source.getPaletteOffset();
+		return memcmp(source.getData(), decoded.getData(), pixelBytes) == 0;
+	}
+
+	static void runCodec(const Codec& codec, const SourceImage& source) {
+		const ImageData& img = source.image;
+		const size_t bytes = img.getSize();
+
+		if (!codec.formats.empty() && std::find(codec.formats.begin(), codec.formats.end(), img.format) == codec.formats.end()) {
+			printf("%-14s %-9s %-15s unsupported\n", codec.name, source.name, "encode");
+			return;
+		}
+
+		MemoryStream encoded(bytes + 4096, true);
+		encoded.seek(0, SEEK_SET);
+		if (!codec.encode(encoded, img)) {
+			printf("%-14s %-9s %-15s FAILED\n", codec.name, source.name, "encode");
+			s_failures++;
+			return;
+		}
+		const size_t encodedSize = encoded.tell();
+
+		MemoryStream output(bytes + 4096, true);
+		run(codec.name, source.name, "encode", bytes, [&]() {
+			output.seek(0, SEEK_SET);
+			return codec.encode(output, img);
+		}, encodedSize);
+
+		ImageData decoded{};
+		auto decodeWith = [&](const char* op, const ImageDecodeParams& params) {
+			bool checked = false;
+			run(codec.name, source.name, op, bytes, [&]() {
+				encoded.seek(0, SEEK_SET);
+				if (!codec.decode(encoded, decoded, params)) { return false; }
+
+				if (!checked && codec.lossless && params.flags == 0) {
+					checked = true;
+					if (!matches(img, decoded)) {
+						printf("%-14s %-9s %-15s MISMATCH\n", codec.name, source.name, op);
+						s_failures++;
+					}
+				}
+				return true;
+			});
+		};
+
+		decodeWith("decode", ImageDecodeParams{});
+		if (codec.usesDecodeParams) {
+			decodeWith("decode+palette", ImageDecodeParams{ F_IMG_BUILD_PALETTE });
+		}
+		decoded.clear(true);
+
+		if (codec.getInfo) {
+			ImageData info{};
+			run(codec.name, source.name, "getInfo", bytes, [&]() {
+				encoded.seek(0, SEEK_SET);
+				return codec.getInfo(encoded, info);
+			});
+		}
+	}
+
+	static void runPixelOps(const SourceImage& source) {
+		const ImageData& img = source.image;
+		const size_t count = size_t(img.width) * img.height;
+		const size_t bytes = img.getSize();
+
+		if (img.format == TextureFormat::RGBA32 || img.format == TextureFormat::RGB24) {
+			std::vector<uint8_t> buffer(count * 16);
+			const TextureFormat targets[] = { TextureFormat::RGBA32, TextureFormat::RGB24, TextureFormat::RGBAF };
+			for (TextureFormat target : targets) {
+				if (target == img.format) { continue; }
+
+				std::string op = std::string("convert->") + (target == TextureFormat::RGBA32 ? "RGBA32" : target == TextureFormat::RGB24 ? "RGB24" : "RGBAF");
+				run("convertPixels", source.name, op.c_str(), bytes, [&]() {
+					return convertPixels(img.format, target, img.getData(), buffer.data(), count);
+				});
+			}
+		}
+
+		ImageData resampled{};
+		run("resample", source.name, "box 1/2", bytes, [&]() {
+			return resample(img, resampled, img.width / 2, img.height / 2, ResampleFilter::Box);
+		});
+		run("resample", source.name, "lanczos3 3/4", bytes, [&]() {
+			return resample(img, resampled, img.width * 3 / 4, img.height * 3 / 4, ResampleFilter::Lanczos3);
+		});
+		resampled.clear(true);
+
+		std::vector<ImageData> mips{};
+		run("resample", source.name, "mip chain", bytes, [&]() {
+			for (auto& mip : mips) {
+				mip.clear(true);
+			}
+			return generateMipChain(img, mips);
+		});
+		for (auto& mip : mips) {
+			mip.clear(true);
+		}
+	}
+
+	static std::vector<Codec> getCodecs() {
+		std::vector<Codec> codecs{};
+
+		auto pngDecode = [](const Stream& stream, ImageData& img, const ImageDecodeParams& params) { return Png::decode(stream, img, params); };
+		auto pngInfo = [](const Stream& stream, ImageData& img) { return Png::getInfo(stream, img); };
+		const std::vector<TextureFormat> pngFormats{ TextureFormat::R8, TextureFormat::Indexed8, TextureFormat::Indexed16, TextureFormat::RGB24, TextureFormat::RGBA32 };
+		codecs.push_back({ "PNG", true, true, [](const Stream& stream, const ImageData& img) {
+			return Png::encode(stream, img, 6);
+		}, pngDecode, pngInfo, pngFormats });
+
+		codecs.push_back({ "PNG-fast-mt", true, true, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_FAST_FILTER | F_IMG_ENC_MULTITHREAD;
+			return Png::encode(stream, img, params);
+		}, pngDecode, pngInfo, pngFormats });
+
+		codecs.push_back({ "BMP", true, false, [](const Stream& stream, const ImageData& img) {
+			return Bmp::encode(stream, img);
+		}, [](const Stream& stream, ImageData& img, const ImageDecodeParams& params) {
+			return Bmp::decode(stream, img, params);
+		}, [](const Stream& stream, ImageData& img) {
+			return Bmp::getInfo(stream, img);
+		} });
+
+		auto ddsDecode = [](const Stream& stream, ImageData& img, const ImageDecodeParams& params) { return DDS::decode(stream, img, params); };
+		auto ddsInfo = [](const Stream& stream, ImageData& img) { return DDS::getInfo(stream, img); };
+		codecs.push_back({ "DDS", true, false, [](const Stream& stream, const ImageData& img) {
+			return DDS::encode(stream, img);
+		}, ddsDecode, ddsInfo, { TextureFormat::R8, TextureFormat::RGB24, TextureFormat::RGBA32, TextureFormat::Indexed8, TextureFormat::Indexed16, TextureFormat::RGBA4444 } });
+
+		codecs.push_back({ "DDS-DXT5", false, false, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MULTITHREAD;
+			params.targetFormat = TextureFormat::DXT5;
+			return DDS::encode(stream, img, params);
+		}, ddsDecode, ddsInfo });
+
+		//Raw DXT streams carry no header, the decoder takes the dimensions from the target image
+		const int32_t size = s_options.size;
+		codecs.push_back({ "DXT1", false, false, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MULTITHREAD;
+			return DXT::encodeDxt1(stream, img, params);
+		}, [size](const Stream& stream, ImageData& img, const ImageDecodeParams& params) {
+			img.width = size;
+			img.height = size;
+			img.format = TextureFormat::RGB24;
+			return DXT::decodeDxt1(stream, img, params);
+		}, nullptr });
+
+		codecs.push_back({ "DXT5", false, false, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MULTITHREAD;
+			return DXT::encodeDxt5(stream, img, params);
+		}, [size](const Stream& stream, ImageData& img, const ImageDecodeParams& params) {
+			img.width = size;
+			img.height = size;
+			img.format = TextureFormat::RGBA32;
+			return DXT::decodeDxt5(stream, img, params);
+		}, nullptr });
+
+		auto jtexDecode = [](const Stream& stream, ImageData& img, const ImageDecodeParams& params) { return JTEX::decode(stream, img, params); };
+		auto jtexInfo = [](const Stream& stream, ImageData& img) { return JTEX::getInfo(stream, img); };
+		codecs.push_back({ "JTEX", true, false, [](const Stream& stream, const ImageData& img) {
+			return JTEX::encode(stream, img);
+		}, jtexDecode, jtexInfo });
+
+		codecs.push_back({ "JTEX-zlib", true, false, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_ZLIB;
+			return JTEX::encode(stream, img, params);
+		}, jtexDecode, jtexInfo });
+
+		codecs.push_back({ "JTEX-mips-DXT5", false, false, [](const Stream& stream, const ImageData& img) {
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MIPMAPS | F_IMG_ENC_MULTITHREAD;
+			params.targetFormat = TextureFormat::DXT5;
+			return JTEX::encode(stream, img, params);
+		}, jtexDecode, jtexInfo });
+		return codecs;
+	}
+
+	//What the DXT decoders used to do, every pixel widened and picked from its endpoints one at a time
+	static void unpack565Ref(uint16_t color, uint8_t rgb[3]) {
+		uint32_t temp = (color >> 11) * 255 + 16;
+		rgb[0] = uint8_t((temp / 32 + temp) / 32);
+		temp = ((color & 0x07E0) >> 5) * 255 + 32;
+		rgb[1] = uint8_t((temp / 64 + temp) / 64);
+		temp = (color & 0x001F) * 255 + 16;
+		rgb[2] = uint8_t((temp / 32 + temp) / 32);
+	}
+
+	static void decodeColorRef(const uint8_t* block, bool allowAlpha, int32_t pixel, uint8_t* target) {
+		uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+		uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
+		uint32_t code = uint32_t(block[4]) | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+
+		uint8_t e0[3], e1[3];
+		unpack565Ref(c0, e0);
+		unpack565Ref(c1, e1);
+		uint8_t index = (code >> (pixel * 2)) & 0x3;
+		for (int32_t c = 0; c < 3; c++) {
+			if (c0 > c1 || !allowAlpha) {
+				target[c] = index == 0 ? e0[c] : index == 1 ? e1[c] : index == 2 ? uint8_t((2 * e0[c] + e1[c]) / 3) : uint8_t((e0[c] + 2 * e1[c]) / 3);
+			}
+			else {
+				target[c] = index == 0 ? e0[c] : index == 1 ? e1[c] : index == 2 ? uint8_t((e0[c] + e1[c]) / 2) : 0;
+			}
+		}
+	}
+
+	static uint8_t decodeAlphaRef(const uint8_t* block, int32_t pixel) {
+		uint8_t a0 = block[0];
+		uint8_t a1 = block[1];
+		uint64_t bits = 0;
+		for (int32_t i = 0; i < 6; i++) {
+			bits |= uint64_t(block[2 + i]) << (i * 8);
+		}
+
+		int32_t code = int32_t((bits >> (pixel * 3)) & 0x7);
+		if (code < 2) { return code == 0 ? a0 : a1; }
+		if (a0 > a1) { return uint8_t(((8 - code) * a0 + (code - 1) * a1) / 7); }
+		return code == 6 ? 0 : code == 7 ? 255 : uint8_t(((6 - code) * a0 + (code - 1) * a1) / 5);
+	}
+
+	static void decodeDxtRef(const uint8_t* blocks, ImageData& img, bool dxt5) {
+		const int32_t bpp = dxt5 ? 4 : 3;
+		const int32_t blockCountX = (img.width + 3) >> 2;
+		const int32_t blockCountY = (img.height + 3) >> 2;
+		uint8_t* pixels = img.getData();
+		for (int32_t by = 0; by < blockCountY; by++) {
+			for (int32_t bx = 0; bx < blockCountX; bx++, blocks += dxt5 ? 16 : 8) {
+				for (int32_t p = 0; p < 16; p++) {
+					int32_t x = (bx << 2) + (p & 3);
+					int32_t y = (by << 2) + (p >> 2);
+					if (x >= img.width || y >= img.height) { continue; }
+
+					uint8_t* target = pixels + (size_t(y) * img.width + x) * bpp;
+					decodeColorRef(dxt5 ? blocks + 8 : blocks, !dxt5, p, target);
+					if (dxt5) {
+						target[3] = decodeAlphaRef(blocks, p);
+					}
+				}
+			}
+		}
+	}
+
+	//Random blocks hit every palette mode, the block decoders have to match the per-pixel reference byte for byte
+	static void runDxtDecode() {
+		const int32_t size = s_options.size;
+		const size_t blockCount = size_t((size + 3) >> 2) * size_t((size + 3) >> 2);
+		std::vector<uint8_t> blocks(blockCount * 16);
+		uint32_t state = 0x2545F491U;
+		for (auto& value : blocks) {
+			value = uint8_t(nextRandom(state));
+		}
+
+		for (bool dxt5 : { false, true }) {
+			const char* name = dxt5 ? "DXT5" : "DXT1";
+			const size_t blockBytes = blockCount * (dxt5 ? 16 : 8);
+			TextureFormat format = dxt5 ? TextureFormat::RGBA32 : TextureFormat::RGB24;
+
+			ImageData reference{};
+			ImageData decoded{};
+			reference.doAllocate(size, size, format);
+			decoded.doAllocate(size, size, format);
+			const size_t bytes = reference.getSize();
+
+			run("dxt-decode", name, "scalar-ref", bytes, [&]() {
+				decodeDxtRef(blocks.data(), reference, dxt5);
+				return true;
+			});
+
+			MemoryStream stream(static_cast<const uint8_t*>(blocks.data()), blockBytes, blockBytes);
+			run("dxt-decode", name, "block", bytes, [&]() {
+				stream.seek(0, SEEK_SET);
+				return dxt5 ? DXT::decodeDxt5(stream, decoded) : DXT::decodeDxt1(stream, decoded);
+			});
+
+			if (memcmp(reference.getData(), decoded.getData(), bytes) != 0) {
+				printf("%-14s %-9s %-15s MISMATCH\n", "dxt-decode", name, "block");
+				s_failures++;
+			}
+			reference.clear(true);
+			decoded.clear(true);
+		}
+	}
+
+	//Fixed size so the floors don't move with --size, smaller images have more edge blocks and score lower
+	static constexpr int32_t DXT_QUALITY_SIZE = 256;
+
+	//Colour PSNR weighted by alpha, DXT1 punch-through alpha blacks out the colour of anything under half coverage
+	static double getDxtPsnr(const ImageData& source, const ImageData& decoded) {
+		const size_t count = size_t(source.width) * source.height;
+		std::vector<uint8_t> pixels(count * 4);
+		convertPixels(source.format, TextureFormat::RGBA32, source.getData(), pixels.data(), count);
+
+		const uint8_t* target = decoded.getData();
+		double error = 0;
+		for (size_t i = 0; i < count * 4; i += 4) {
+			for (size_t c = 0; c < 3; c++) {
+				double diff = (pixels[i + c] * pixels[i + 3] - target[i + c] * target[i + 3]) / 255.0;
+				error += diff * diff;
+			}
+		}
+
+		double mse = error / double(count * 3);
+		return mse > 0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	}
+
+	static bool decodeDxtBlocks(const ImageData& blocks, ImageData& decoded) {
+		if (!decoded.doAllocate(blocks.width, blocks.height, TextureFormat::RGBA32)) { return false; }
+
+		const bool dxt5 = blocks.format == TextureFormat::DXT5;
+		const size_t rowBytes = size_t((blocks.width + 3) >> 2) * (dxt5 ? 16 : 8);
+		for (int32_t y = 0; y < ((blocks.height + 3) >> 2); y++) {
+			const uint8_t* row = blocks.getData() + y * rowBytes;
+			if (dxt5) {
+				DXT::decodeDxt5Row(row, decoded, y);
+			}
+			else {
+				DXT::decodeDxt1Row(row, decoded, y);
+			}
+		}
+		return true;
+	}
+
+	//Compression quality per endpoint fit, a lossy codec that gets worse still round trips so the floors are what catches it.
+	//Floors sit about a dB under what each mode scores today.
+	static void runDxtQuality() {
+		struct Mode {
+			const char* image;
+			const char* op;
+			TextureFormat format;
+			uint8_t flags;
+			double floor;
+		};
+
+		static constexpr Mode MODES[] = {
+			{ "gradient", "DXT1-range", TextureFormat::DXT1, 0, 43.5 },
+			{ "gradient", "DXT1-cluster", TextureFormat::DXT1, F_IMG_ENC_DXT_CLUSTER_FIT, 45.0 },
+			{ "gradient", "DXT5-range", TextureFormat::DXT5, 0, 43.5 },
+			{ "gradient", "DXT5-cluster", TextureFormat::DXT5, F_IMG_ENC_DXT_CLUSTER_FIT, 45.0 },
+			{ "sprite", "DXT5-range", TextureFormat::DXT5, 0, 42.5 },
+			{ "sprite", "DXT5-cluster", TextureFormat::DXT5, F_IMG_ENC_DXT_CLUSTER_FIT, 43.0 },
+		};
+
+		SourceImage sources[] = {
+			{ "gradient", makeGradient(DXT_QUALITY_SIZE) },
+			{ "sprite", makeSprite(DXT_QUALITY_SIZE) },
+		};
+
+		auto check = [](const char* image, const char* op, const ImageData& source, const ImageData& blocks, double floor) {
+			ImageData decoded{};
+			if (!decodeDxtBlocks(blocks, decoded)) {
+				printf("%-14s %-9s %-15s FAILED\n", "dxt-quality", image, op);
+				s_failures++;
+				return;
+			}
+
+			double psnr = getDxtPsnr(source, decoded);
+			decoded.clear(true);
+			if (psnr < floor) {
+				printf("%-14s %-9s %-15s PSNR %.2f dB below %.1f dB\n", "dxt-quality", image, op, psnr, floor);
+				s_failures++;
+				return;
+			}
+			printf("%-14s %-9s %-15s PSNR %.2f dB (floor %.1f dB)\n", "dxt-quality", image, op, psnr, floor);
+		};
+
+		ImageData blocks{};
+		for (const Mode& mode : MODES) {
+			if (!isSelected("dxt-quality", mode.image, mode.op)) { continue; }
+
+			const ImageData& source = (strcmp(mode.image, "gradient") == 0 ? sources[0] : sources[1]).image;
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MULTITHREAD | mode.flags;
+			if (!run("dxt-quality", mode.image, mode.op, source.getSize(), [&]() { return DXT::compress(source, blocks, mode.format, params); })) {
+				continue;
+			}
+			check(mode.image, mode.op, source, blocks, mode.floor);
+		}
+
+		//Block compressed sources get decoded before they're compressed again
+		if (isSelected("dxt-quality", "gradient", "DXT5->DXT1")) {
+			const ImageData& source = sources[0].image;
+			ImageData dxt5{};
+			ImageEncodeParams params{};
+			params.flags = F_IMG_ENC_MULTITHREAD;
+			if (DXT::compress(source, dxt5, TextureFormat::DXT5, params) &&
+				run("dxt-quality", "gradient", "DXT5->DXT1", source.getSize(), [&]() { return DXT::compress(dxt5, blocks, TextureFormat::DXT1, params); })) {
+				check("gradient", "DXT5->DXT1", source, blocks, 42.5);
+			}
+			dxt5.clear(true);
+		}
+
+		blocks.clear(true);
+		for (auto& source : sources) {
+			source.image.clear(true);
+		}
+	}
+
+	//Scene-serialization style traffic: lots of small values with the odd big endian one
+	static constexpr int32_t STREAM_RECORDS = 100000;
+	static constexpr size_t STREAM_RECORD_SIZE = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint16_t) + sizeof(float) + 12;
+	static constexpr const char* STREAM_SCRATCH_FILE = "J-Bench-stream.tmp";
+
+	template<typename S>
+	static bool writeRecords(const S& stream) {
+		static constexpr char NAME[12] = "record-name";
+		for (int32_t i = 0; i < STREAM_RECORDS; i++) {
+			stream.writeValue(uint8_t(i));
+			stream.writeValue(uint32_t(i * 2654435761U));
+			stream.writeValue(uint16_t(i), 1, true);
+			stream.writeValue(float(i) * 0.5f);
+			stream.write(NAME, 1, sizeof(NAME), false);
+		}
+		return stream.flush();
+	}
+
+	template<typename S>
+	static bool readRecords(const S& stream) {
+		char name[12]{};
+		for (int32_t i = 0; i < STREAM_RECORDS; i++) {
+			bool valid = true;
+			valid &= stream.template readValue<uint8_t>(false) == uint8_t(i);
+			valid &= stream.template readValue<uint32_t>(false) == uint32_t(i * 2654435761U);
+			valid &= stream.template readValue<uint16_t>(true) == uint16_t(i);
+			valid &= stream.template readValue<float>(false) == float(i) * 0.5f;
+			valid &= stream.read(name, 1, sizeof(name), false) == sizeof(name);
+			if (!valid) { return false; }
+		}
+		return true;
+	}
+
+	template<typename S>
+	static void runStreamCase(const char* name, const S& stream) {
+		const size_t bytes = size_t(STREAM_RECORDS) * STREAM_RECORD_SIZE;
+		run("stream", name, "write", bytes, [&]() {
+			stream.seek(0, SEEK_SET);
+			return writeRecords(stream);
+		});
+		run("stream", name, "read", bytes, [&]() {
+			stream.seek(0, SEEK_SET);
+			return readRecords(stream);
+		});
+	}
+
+	static void runStreams() {
+		const size_t bytes = size_t(STREAM_RECORDS) * STREAM_RECORD_SIZE;
+
+		MemoryStream memory(bytes, true);
+		runStreamCase("memory", memory);
+
+		MemoryStream bufferedMemory(bytes, true);
+		BufferedStream memoryBuffer(bufferedMemory);
+		runStreamCase("memory+buf", memoryBuffer);
+		memoryBuffer.close();
+
+		//Opening with "wb" creates the scratch file, the read pass reopens what the write pass left
+		auto runFile = [&](const char* name, bool buffered) {
+			FileStream file(STREAM_SCRATCH_FILE, "wb");
+			if (!file.isOpen()) {
+				printf("%-14s %-9s %-15s FAILED (couldn't open '%s')\n", "stream", name, "write", STREAM_SCRATCH_FILE);
+				s_failures++;
+				return;
+			}
+
+			BufferedStream writer{};
+			if (buffered) { writer.setStream(&file); }
+			run("stream", name, "write", bytes, [&]() {
+				if (buffered) {
+					writer.seek(0, SEEK_SET);
+					return writeRecords(writer);
+				}
+				file.seek(0, SEEK_SET);
+				return writeRecords(file);
+			});
+			writer.close();
+			file.close();
+
+			file.open(STREAM_SCRATCH_FILE, "rb");
+			BufferedStream reader{};
+			if (buffered) { reader.setStream(&file); }
+			run("stream", name, "read", bytes, [&]() {
+				if (buffered) {
+					reader.seek(0, SEEK_SET);
+					return readRecords(reader);
+				}
+				file.seek(0, SEEK_SET);
+				return readRecords(file);
+			});
+			reader.close();
+			file.close();
+		};
+
+		runFile("file", false);
+		runFile("file+buf", true);
+
+		//The scratch file still holds the records, 'view' parses them in place out of the mapping
+		MappedFileStream mapped(STREAM_SCRATCH_FILE);
+		if (mapped.isOpen()) {
+			run("stream", "mapped", "read", bytes, [&]() {
+				mapped.seek(0, SEEK_SET);
+				return readRecords(mapped);
+			});
+			run("stream", "mapped", "view", bytes, [&]() {
+				Span<const uint8_t> records = mapped.view(0, bytes);
+				MemoryStream stream(records.get(), records.length(), records.length());
+				return records.length() == bytes && readRecords(stream);
+			});
+			mapped.close();
+		}
+		else {
+			printf("%-14s %-9s %-15s FAILED (couldn't map '%s')\n", "stream", "mapped", "read", STREAM_SCRATCH_FILE);
+			s_failures++;
+		}
+		remove(STREAM_SCRATCH_FILE);
+	}
+
+	//Pak traffic: half the entries compress well, half are noise and stay raw even in a compressed pak
+	static constexpr int32_t BITS_ENTITIES = 100000;
+	static constexpr uint32_t BITS_POSITION = 18;
+	static constexpr int32_t BITS_PACKED_COUNT = 1024 * 1024;
+	static constexpr uint32_t BITS_PACKED = 11;
+	static constexpr size_t BITS_BULK_SIZE = 4 * 1024 * 1024;
+
+	static void runBitStream() {
+		//Snapshot style entity records, a varint id, quantized position, zigzag velocities and a couple of flags
+		struct Entity {
+			uint32_t id;
+			uint32_t position[3];
+			int32_t velocity[3];
+			bool visible;
+			bool sleeping;
+		};
+
+		std::vector<Entity> entities(BITS_ENTITIES);
+		uint32_t state = 0x9E3779B9U;
+		for (int32_t i = 0; i < BITS_ENTITIES; i++) {
+			auto& entity = entities[i];
+			entity.id = uint32_t(i) * 3 + 1;
+			for (int32_t j = 0; j < 3; j++) {
+				entity.position[j] = nextRandom(state) & ((1U << BITS_POSITION) - 1);
+				entity.velocity[j] = int32_t(nextRandom(state) % 129) - 64;
+			}
+
+			uint32_t rnd = nextRandom(state);
+			entity.visible = (rnd & 0x1) != 0;
+			entity.sleeping = (rnd & 0x6) == 0;
+		}
+
+		MemoryStream memory(size_t(BITS_ENTITIES) * sizeof(Entity), true);
+		BitStream bits{};
+
+		auto writeSnapshot = [&]() {
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			for (const auto& entity : entities) {
+				bits.writeVarUInt(entity.id);
+				for (int32_t j = 0; j < 3; j++) {
+					bits.writeBits(entity.position[j], BITS_POSITION);
+				}
+				for (int32_t j = 0; j < 3; j++) {
+					bits.writeVarInt(entity.velocity[j]);
+				}
+				bits.writeBool(entity.visible);
+				bits.writeBool(entity.sleeping);
+			}
+			return bits.close();
+		};
+
+		auto readSnapshot = [&]() {
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			bool match = true;
+			for (const auto& entity : entities) {
+				match &= bits.readVarUInt() == entity.id;
+				for (int32_t j = 0; j < 3; j++) {
+					match &= bits.readBits(BITS_POSITION) == entity.position[j];
+				}
+				for (int32_t j = 0; j < 3; j++) {
+					match &= bits.readVarInt() == entity.velocity[j];
+				}
+				match &= bits.readBool() == entity.visible;
+				match &= bits.readBool() == entity.sleeping;
+			}
+			match &= !bits.hasOverrun();
+			bits.close();
+			return match;
+		};
+
+		const size_t snapshotBytes = entities.size() * sizeof(Entity);
+		if (!writeSnapshot()) {
+			printf("%-14s %-9s %-15s FAILED\n", "bitstream", "snapshot", "write");
+			s_failures++;
+			return;
+		}
+		size_t snapshotSize = memory.tell();
+		run("bitstream", "snapshot", "write", snapshotBytes, writeSnapshot, snapshotSize);
+		run("bitstream", "snapshot", "read", snapshotBytes, readSnapshot, snapshotSize);
+
+		//Fixed width arrays, e.g. palette indices or tile ids
+		std::vector<uint16_t> packed(BITS_PACKED_COUNT);
+		std::vector<uint16_t> unpacked(BITS_PACKED_COUNT);
+		for (auto& value : packed) {
+			value = uint16_t(nextRandom(state) & ((1U << BITS_PACKED) - 1));
+		}
+
+		const size_t packedBytes = packed.size() * sizeof(uint16_t);
+		run("bitstream", "packed", "write", packedBytes, [&]() {
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			bool ret = bits.writePacked(packed.data(), packed.size(), BITS_PACKED) == packed.size();
+			return bits.close() && ret;
+		}, (packed.size() * BITS_PACKED + 7) >> 3);
+		run("bitstream", "packed", "read", packedBytes, [&]() {
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			bool ret = bits.readPacked(unpacked.data(), unpacked.size(), BITS_PACKED) == unpacked.size();
+			bits.close();
+			return ret && memcmp(unpacked.data(), packed.data(), packedBytes) == 0;
+		});
+
+		//A single flag bit in front knocks the bulk copy off byte alignment, so it goes through the word path
+		std::vector<uint8_t> bulk(BITS_BULK_SIZE);
+		std::vector<uint8_t> bulkOut(BITS_BULK_SIZE);
+		for (auto& value : bulk) {
+			value = uint8_t(nextRandom(state));
+		}
+
+		for (uint32_t lead : { 0U, 1U }) {
+			const char* op = lead ? "unaligned" : "aligned";
+			run("bitstream", "bulk", op, BITS_BULK_SIZE * 2, [&]() {
+				memory.seek(0, SEEK_SET);
+				bits.setStream(&memory);
+				bool ret = bits.writeBits(1, lead) && bits.writeBits(bulk.data(), BITS_BULK_SIZE * 8) == BITS_BULK_SIZE * 8;
+				bits.close();
+
+				memory.seek(0, SEEK_SET);
+				bits.setStream(&memory);
+				ret &= bits.readBits(lead) == (lead ? 1 : 0);
+				ret &= bits.readBits(bulkOut.data(), BITS_BULK_SIZE * 8) == BITS_BULK_SIZE * 8;
+				bits.close();
+				return ret && memcmp(bulkOut.data(), bulk.data(), BITS_BULK_SIZE) == 0;
+			});
+		}
+
+		//Patching a length placeholder after a partial byte, SEEK_CUR has to count from behind the padding
+		run("bitstream", "patch", "seek-cur", 3, [&]() {
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			bool ret = bits.writeBits(0xA5, 8) && bits.writeBits(0xFF, 8) && bits.writeBits(0x15, 5);
+			ret &= bits.seek(-2, SEEK_CUR) == 1 && bits.writeBits(5, 8);
+			bits.close();
+
+			memory.seek(0, SEEK_SET);
+			bits.setStream(&memory);
+			ret &= bits.readBits(8) == 0xA5 && bits.readBits(8) == 5 && bits.readBits(8) == 0x15;
+			bits.close();
+			return ret;
+		});
+	}
+
+	static constexpr uint32_t WAV_SAMPLE_RATE = 48000;
+	static constexpr size_t WAV_FRAMES = WAV_SAMPLE_RATE * 30;
+	static constexpr size_t WAV_BLOCK = 1024;
+
+	static void runWav() {
+		//30 seconds of stereo tones, streamed through a single small block both ways
+		std::vector<float> source(WAV_FRAMES * 2);
+		for (size_t i = 0; i < WAV_FRAMES; i++) {
+			float t = float(i) / WAV_SAMPLE_RATE;
+			source[i * 2 + 0] = 0.8f * sinf(t * 440.0f * 6.2831853f);
+			source[i * 2 + 1] = 0.5f * sinf(t * 659.25f * 6.2831853f);
+		}
+
+		struct Format {
+			const char* name;
+			AudioSampleType type;
+			uint8_t depth;
+			float tolerance;
+		};
+
+		static constexpr Format FORMATS[] = {
+			{ "u8", AudioSampleType::Unsigned, 8, 1.0f / 64.0f },
+			{ "i16", AudioSampleType::Signed, 16, 1.0f / 16384.0f },
+			{ "i24", AudioSampleType::Signed, 24, 1.0f / 4194304.0f },
+			{ "f32", AudioSampleType::Float, 32, 0.0f },
+		};
+
+		const size_t bytes = source.size() * sizeof(float);
+		std::vector<float> block(WAV_BLOCK * 2);
+		for (const auto& format : FORMATS) {
+			MemoryStream memory(WAV_FRAMES * 2 * (format.depth >> 3) + 128, true);
+			auto encode = [&]() {
+				memory.seek(0, SEEK_SET);
+				Wav::WavWriter writer{};
+				if (!writer.open(memory, format.type, format.depth, 2, WAV_SAMPLE_RATE)) { return false; }
+				for (size_t i = 0; i < WAV_FRAMES; i += WAV_BLOCK) {
+					size_t count = std::min(WAV_BLOCK, WAV_FRAMES - i);
+					if (writer.writeFloat(source.data() + i * 2, count) != count) { return false; }
+				}
+				return writer.close();
+			};
+
+			if (!encode()) {
+				printf("%-14s %-9s %-15s FAILED\n", "wav", format.name, "encode");
+				s_failures++;
+				continue;
+			}
+			size_t encoded = memory.tell();
+			run("wav", format.name, "encode", bytes, encode, encoded);
+
+			run("wav", format.name, "decode-stream", bytes, [&]() {
+				memory.seek(0, SEEK_SET);
+				Wav::WavReader reader(memory);
+				if (!reader.isOpen() || reader.getFrameCount() != WAV_FRAMES || reader.getChannels() != 2) { return false; }
+
+				size_t frame = 0;
+				while (size_t read = reader.readFloat(block.data(), WAV_BLOCK)) {
+					for (size_t i = 0; i < read * 2; i++) {
+						if (fabsf(block[i] - source[frame * 2 + i]) > format.tolerance) { return false; }
+					}
+					frame += read;
+				}
+				return frame == WAV_FRAMES;
+			}, encoded);
+
+			//Seeking lands on the exact frame and the whole file decodes in one go as well
+			memory.seek(0, SEEK_SET);
+			Wav::WavReader reader(memory);
+			const size_t target = WAV_FRAMES / 3 + 7;
+			bool valid = reader.seek(target) && reader.readFloat(block.data(), 1) == 1 &&
+				fabsf(block[0] - source[target * 2]) <= format.tolerance && reader.getFramePosition() == target + 1;
+
+			AudioData audio{};
+			memory.seek(0, SEEK_SET);
+			valid &= Wav::decode(memory, audio) && audio.sampleCount == WAV_FRAMES && audio.depth == format.depth && audio.sampleType == format.type;
+			audio.release();
+
+			if (!valid) {
+				printf("%-14s %-9s %-15s FAILED (seek/decode)\n", "wav", format.name, "decode");
+				s_failures++;
+			}
+		}
+	}
+
+	static constexpr uint32_t RESAMPLE_RATE = 44100;
+	static constexpr size_t RESAMPLE_FRAMES = RESAMPLE_RATE * 10;
+
+	//RMS difference from the ideal tone, skipping the edges where the filter runs into the zero padding
+	static double getToneError(const float* samples, size_t frames, uint32_t channels, double freq, uint32_t sampleRate, float amplitude) {
+		double sum = 0;
+		size_t count = 0;
+		for (size_t i = 64; i + 64 < frames; i++) {
+			double expected = amplitude * sin(double(i) * freq * 6.283185307179586 / sampleRate);
+			for (uint32_t c = 0; c < channels; c++) {
+				double diff = samples[i * channels + c] - expected;
+				sum += diff * diff;
+				count++;
+			}
+		}
+		return count > 0 ? sqrt(sum / count) : 1.0;
+	}
+
+	static void runResampler() {
+		//10 seconds of a 1 kHz stereo tone at 44.1 kHz, converted offline to 48 kHz the way an import would
+		std::vector<float> tone(RESAMPLE_FRAMES * 2);
+		for (size_t i = 0; i < RESAMPLE_FRAMES; i++) {
+			tone[i * 2 + 0] = tone[i * 2 + 1] = 0.5f * float(sin(double(i) * 1000.0 * 6.283185307179586 / RESAMPLE_RATE));
+		}
+
+		AudioData source{};
+		source.format = AudioFormat::PCM;
+		source.sampleType = AudioSampleType::Signed;
+		source.depth = 16;
+		source.channels = 2;
+		source.sampleRate = RESAMPLE_RATE;
+		source.blockAlign = 4;
+		source.sampleCount = RESAMPLE_FRAMES;
+		source.doAllocate();
+		Audio::floatToSamples(tone.data(), source.sampleType, source.depth, source.data, tone.size());
+
+		struct Mode {
+			const char* name;
+			ResampleQuality quality;
+			double maxError;
+		};
+
+		static constexpr Mode MODES[] = {
+			{ "linear", ResampleQuality::Linear, 2e-3 },
+			{ "sinc", ResampleQuality::Sinc, 1e-4 },
+		};
+
+		const size_t bytes = RESAMPLE_FRAMES * source.blockAlign;
+		for (const auto& mode : MODES) {
+			AudioData converted{};
+			run("resample", mode.name, "44.1k-48k", bytes, [&]() {
+				return Resampler::convert(source, converted, 48000, mode.quality) && converted.sampleRate == 48000 &&
+					converted.sampleCount == Resampler::getOutputFrames(RESAMPLE_FRAMES, Resampler::getStep(RESAMPLE_RATE, 48000));
+			}, converted.calculateSize());
+
+			std::vector<float> output(converted.sampleCount * 2);
+			Audio::samplesToFloat(converted.data, converted.sampleType, converted.depth, output.data(), output.size());
+			double error = getToneError(output.data(), converted.sampleCount, 2, 1000.0, 48000, 0.5f);
+			if (error > mode.maxError) {
+				printf("%-14s %-9s %-15s FAILED (error %.6f)\n", "resample", mode.name, "44.1k-48k", error);
+				s_failures++;
+			}
+		}
+	}
+
+	static constexpr size_t MIX_VOICES = 64;
+	static constexpr size_t MIX_FRAMES = 48000;
+	static constexpr size_t MIX_CHUNK = 480;
+
+	//What the mixer used to do, one converter call per sample per voice
+	typedef float (*GetMixSample)(const uint8_t*);
+
+	static float getMixSampleI16(const uint8_t* data) {
+		int16_t value;
+		memcpy(&value, data, 2);
+		return float(value) * (1.0f / 32768.0f);
+	}
+
+	static float getMixSampleI24(const uint8_t* data) {
+		int32_t value = int32_t(uint32_t(data[0]) << 8 | uint32_t(data[1]) << 16 | uint32_t(data[2]) << 24) >> 8;
+		return float(value) * (1.0f / 8388608.0f);
+	}
+
+	static float getMixSampleI32(const uint8_t* data) {
+		int32_t value;
+		memcpy(&value, data, 4);
+		return float(value) * (1.0f / 2147483648.0f);
+	}
+
+	static float getMixSampleF32(const uint8_t* data) {
+		float value;
+		memcpy(&value, data, 4);
+		return value;
+	}
+
+	static void runMixer() {
+		struct Format {
+			AudioSampleType type;
+			uint8_t depth;
+			GetMixSample getSample;
+		};
+
+		static constexpr Format FORMATS[] = {
+			{ AudioSampleType::Signed, 16, getMixSampleI16 },
+			{ AudioSampleType::Signed, 24, getMixSampleI24 },
+			{ AudioSampleType::Signed, 32, getMixSampleI32 },
+			{ AudioSampleType::Float, 32, getMixSampleF32 },
+		};
+
+		//Every voice gets its own format, layout and gains: mono, stereo or two mono layers
+		std::vector<AudioData> clips(MIX_VOICES);
+		std::vector<MixVoice> voices(MIX_VOICES);
+		std::vector<float> tone(MIX_FRAMES * 2);
+		for (size_t v = 0; v < MIX_VOICES; v++) {
+			const Format& format = FORMATS[v & 0x3];
+			AudioData& clip = clips[v];
+			MixVoice& voice = voices[v];
+
+			uint8_t layout = uint8_t((v >> 2) % 3);
+			clip.sampleType = format.type;
+			clip.depth = format.depth;
+			clip.channels = layout == 0 ? 1 : 2;
+			clip.sampleRate = 48000;
+			clip.sampleCount = MIX_FRAMES;
+			clip.doAllocate();
+
+			float freq = 110.0f + 20.0f * v;
+			for (size_t i = 0; i < MIX_FRAMES * clip.channels; i++) {
+				tone[i] = 0.9f * sinf(float(i / clip.channels) * freq * (6.2831853f / 48000.0f) + float(i % clip.channels));
+			}
+			Audio::floatToSamples(tone.data(), clip.sampleType, clip.depth, clip.data, MIX_FRAMES * clip.channels);
+
+			float pan = float(v % 9) * 0.25f - 1.0f;
+			voice.data = &clip;
+			voice.layers = layout == 2 ? 2 : 1;
+			voice.setTarget(0, 0.25f * Audio::getPanL(pan), 0.25f * Audio::getPanR(pan));
+			voice.setTarget(1, 0.125f * Audio::getPanL(-pan), 0.125f * Audio::getPanR(-pan));
+			voice.snapGains();
+		}
+
+		const size_t bytes = MIX_VOICES * MIX_FRAMES * 2 * sizeof(float);
+		std::vector<float> reference(MIX_FRAMES * 2);
+		std::vector<float> bus(MIX_FRAMES * 2);
+
+		run("mixer", "64-voice", "per-sample", bytes, [&]() {
+			std::fill(reference.begin(), reference.end(), 0.0f);
+			for (size_t f = 0; f < MIX_FRAMES; f += MIX_CHUNK) {
+				for (size_t v = 0; v < MIX_VOICES; v++) {
+					const AudioData& clip = clips[v];
+					const MixVoice& voice = voices[v];
+					GetMixSample getSample = FORMATS[v & 0x3].getSample;
+
+					size_t bps = clip.depth >> 3;
+					size_t layerChannels = clip.channels / voice.layers;
+					for (size_t i = f; i < f + MIX_CHUNK; i++) {
+						const uint8_t* frame = clip.data + i * clip.channels * bps;
+						for (size_t l = 0; l < voice.layers; l++) {
+							const uint8_t* data = frame + l * layerChannels * bps;
+							float left = getSample(data);
+							float right = layerChannels > 1 ? getSample(data + bps) : left;
+							reference[i * 2 + 0] += left * voice.gains[l * 2 + 0];
+							reference[i * 2 + 1] += right * voice.gains[l * 2 + 1];
+						}
+					}
+				}
+			}
+			return true;
+		});
+
+		auto mixer = std::make_unique<AudioMixer>();
+		run("mixer", "64-voice", "block", bytes, [&]() {
+			std::fill(bus.begin(), bus.end(), 0.0f);
+			for (auto& voice : voices) {
+				voice.position = 0;
+			}
+
+			for (size_t f = 0; f < MIX_FRAMES; f += MIX_CHUNK) {
+				for (auto& voice : voices) {
+					if (mixer->mix(voice, bus.data() + f * 2, MIX_CHUNK) != MIX_CHUNK) { return false; }
+				}
+			}
+
+			for (size_t i = 0; i < bus.size(); i++) {
+				if (fabsf(bus[i] - reference[i]) > 1e-5f) { return false; }
+			}
+			return true;
+		});
+
+		//Gain changes ramp over a block and voices stop at the end of their data
+		MixVoice& voice = voices[3];
+		voice.position = MIX_FRAMES - AudioMixer::BLOCK_FRAMES - 16;
+		voice.setTarget(0, 1.0f, 0.0f);
+		voice.gains[0] = 0.0f;
+		voice.gains[1] = 0.5f;
+
+		std::fill(bus.begin(), bus.end(), 0.0f);
+		const float* source = reinterpret_cast<const float*>(clips[3].data) + voice.position;
+		bool valid = mixer->mix(voice, bus.data(), MIX_CHUNK) == AudioMixer::BLOCK_FRAMES + 16;
+		for (size_t i = 0; i < AudioMixer::BLOCK_FRAMES + 16 && valid; i++) {
+			float t = std::min(float(i) / AudioMixer::BLOCK_FRAMES, 1.0f);
+			valid = fabsf(bus[i * 2 + 0] - source[i] * t) <= 1e-5f && fabsf(bus[i * 2 + 1] - source[i] * 0.5f * (1.0f - t)) <= 1e-5f;
+		}
+		valid &= bus[(AudioMixer::BLOCK_FRAMES + 16) * 2] == 0.0f && voice.position == MIX_FRAMES;
+
+		if (!valid) {
+			printf("%-14s %-9s %-15s FAILED (ramp/end)\n", "mixer", "64-voice", "block");
+			s_failures++;
+		}
+
+		//Voices at 44.1 kHz with a spread of pitches, resampled to the mixer's 48 kHz in blocks
+		for (size_t v = 0; v < MIX_VOICES; v++) {
+			clips[v].sampleRate = 44100;
+			voices[v].pitch = 0.75f + float(v) / MIX_VOICES;
+		}
+
+		static constexpr const char* PITCH_OPS[] = { "resample-lin", "resample-sinc" };
+		for (ResampleQuality quality : { ResampleQuality::Linear, ResampleQuality::Sinc }) {
+			for (auto& voice : voices) {
+				voice.quality = quality;
+			}
+
+			run("mixer", "64-voice", PITCH_OPS[size_t(quality)], bytes, [&]() {
+				std::fill(bus.begin(), bus.end(), 0.0f);
+				for (auto& voice : voices) {
+					voice.position = 0;
+					voice.fraction = 0;
+				}
+
+				//Pitches above 1 run out of data before the bus is full
+				for (size_t f = 0; f < MIX_FRAMES; f += MIX_CHUNK) {
+					for (auto& voice : voices) {
+						mixer->mix(voice, bus.data() + f * 2, MIX_CHUNK);
+					}
+				}
+				return true;
+			});
+		}
+
+		//A 440 Hz tone played at 1.5x has to come out as a clean 660 Hz one
+		AudioData sine{};
+		sine.sampleType = AudioSampleType::Float;
+		sine.depth = 32;
+		sine.channels = 1;
+		sine.sampleRate = 48000;
+		sine.sampleCount = MIX_FRAMES;
+		sine.doAllocate();
+		float* sineData = reinterpret_cast<float*>(sine.data);
+		for (size_t i = 0; i < MIX_FRAMES; i++) {
+			sineData[i] = float(sin(double(i) * 440.0 * 6.283185307179586 / 48000.0));
+		}
+
+		MixVoice pitched{};
+		pitched.data = &sine;
+		pitched.pitch = 1.5f;
+		pitched.setTarget(0, 1.0f, 1.0f);
+		pitched.snapGains();
+
+		std::fill(bus.begin(), bus.end(), 0.0f);
+		size_t pitchedFrames = 0;
+		for (size_t f = 0; f < MIX_FRAMES; f += MIX_CHUNK) {
+			pitchedFrames += mixer->mix(pitched, bus.data() + f * 2, MIX_CHUNK);
+		}
+
+		double pitchError = getToneError(bus.data(), pitchedFrames, 2, 660.0, 48000, 1.0f);
+		if (pitchedFrames != MIX_FRAMES * 2 / 3 || pitchError > 1e-4) {
+			printf("%-14s %-9s %-15s FAILED (%zu frames, error %.6f)\n", "mixer", "pitch", "resample-sinc", pitchedFrames, pitchError);
+			s_failures++;
+		}
+	}
+
+	static constexpr size_t SPSC_ITEMS = 1 << 20;
+	static constexpr size_t DEVICE_VOICES = 64;
+	static constexpr size_t DEVICE_FRAMES = 48000;
+
+	//What AudioEngine's mixer thread does with a device, one small buffer at a time until the device stops taking audio
+	static void renderToDevice(IAudioDevice& device, AudioMixer& mixer, std::vector<MixVoice>& voices, std::vector<float>& bus, uint64_t frameLimit = UINT64_MAX) {
+		const size_t frames = device.getBufferFrames();
+		bool pending = false;
+		while (device.getFramesSubmitted() < frameLimit && device.waitForBuffer()) {
+			if (!pending) {
+				std::fill(bus.begin(), bus.begin() + frames * 2, 0.0f);
+				for (auto& voice : voices) {
+					mixer.mix(voice, bus.data(), frames);
+				}
+			}
+
+			pending = device.submit(bus.data(), frames) < 1;
+			if (pending && !device.isOpen()) { break; }
+		}
+	}
+
+	static void runAudioDevice() {
+		//Commands cross between two threads in order, neither side ever waits on a lock
+		run("audio", "spsc", "push-pop", SPSC_ITEMS * sizeof(uint64_t), []() {
+			auto queue = std::make_unique<SPSCQueue<uint64_t, AudioEngine::COMMAND_CAPACITY>>();
+			std::thread producer([&]() {
+				for (uint64_t i = 0; i < SPSC_ITEMS;) {
+					if (queue->push(i)) { i++; }
+					else { std::this_thread::yield(); }
+				}
+			});
+
+			bool ordered = true;
+			for (uint64_t expected = 0; expected < SPSC_ITEMS;) {
+				uint64_t value;
+				if (queue->pop(value)) { ordered &= value == expected++; }
+				else { std::this_thread::yield(); }
+			}
+			producer.join();
+			return ordered && queue->isEmpty();
+		});
+
+		std::vector<AudioData> clips(DEVICE_VOICES);
+		std::vector<MixVoice> voices(DEVICE_VOICES);
+		for (size_t v = 0; v < DEVICE_VOICES; v++) {
+			AudioData& clip = clips[v];
+			clip.sampleType = AudioSampleType::Float;
+			clip.depth = 32;
+			clip.channels = 1;
+			clip.sampleRate = AudioEngine::AUDIO_SAMPLE_RATE;
+			clip.sampleCount = DEVICE_FRAMES;
+			clip.doAllocate();
+
+			float* data = reinterpret_cast<float*>(clip.data);
+			float freq = 110.0f + 20.0f * v;
+			for (size_t i = 0; i < DEVICE_FRAMES; i++) {
+				data[i] = 0.9f * sinf(float(i) * freq * (6.2831853f / 48000.0f));
+			}
+
+			float pan = float(v % 9) * 0.25f - 1.0f;
+			voices[v].data = &clip;
+			voices[v].setTarget(0, 0.25f * Audio::getPanL(pan), 0.25f * Audio::getPanR(pan));
+			voices[v].snapGains();
+		}
+
+		auto mixer = std::make_unique<AudioMixer>(AudioEngine::AUDIO_SAMPLE_RATE);
+		std::vector<float> reference(DEVICE_FRAMES * 2);
+		for (size_t f = 0; f < DEVICE_FRAMES; f += MIX_CHUNK) {
+			for (auto& voice : voices) {
+				mixer->mix(voice, reference.data() + f * 2, MIX_CHUNK);
+			}
+		}
+
+		//A second of 64 voices rendered into a WAV as fast as the mixer goes, in engine sized buffers
+		const size_t bytes = DEVICE_VOICES * DEVICE_FRAMES * 2 * sizeof(float);
+		std::vector<float> bus(AudioEngine::AUDIO_BUFFER_FRAMES * 2);
+		MemoryStream memory(DEVICE_FRAMES * 2 * sizeof(float) + 128, true);
+		run("audio", "offline", "render-wav", bytes, [&]() {
+			for (auto& voice : voices) {
+				voice.position = 0;
+			}
+
+			memory.seek(0, SEEK_SET);
+			OfflineAudioDevice device(memory, DEVICE_FRAMES);
+			if (!device.open(AudioEngine::AUDIO_SAMPLE_RATE, AudioEngine::AUDIO_BUFFER_FRAMES)) { return false; }
+			renderToDevice(device, *mixer, voices, bus);
+			device.close();
+			return device.getFramesSubmitted() == DEVICE_FRAMES;
+		});
+
+		AudioData rendered{};
+		memory.seek(0, SEEK_SET);
+		bool valid = Wav::decode(memory, rendered) && rendered.sampleCount == DEVICE_FRAMES && rendered.channels == 2 && rendered.sampleType == AudioSampleType::Float;
+		const float* renderedData = reinterpret_cast<const float*>(rendered.data);
+		for (size_t i = 0; i < DEVICE_FRAMES * 2 && valid; i++) {
+			valid = fabsf(renderedData[i] - reference[i]) <= 1e-6f;
+		}
+		rendered.release();
+
+		if (!valid) {
+			printf("%-14s %-9s %-15s FAILED (output)\n", "audio", "offline", "render-wav");
+			s_failures++;
+		}
+
+		//The null device has to pace the mixer like hardware, ~100 ms of audio should take about as long
+		if (isSelected("audio", "null", "realtime")) {
+			const uint64_t target = AudioEngine::AUDIO_SAMPLE_RATE / 10;
+			for (auto& voice : voices) {
+				voice.position = 0;
+			}
+
+			NullAudioDevice device;
+			auto start = std::chrono::steady_clock::now();
+			device.open(AudioEngine::AUDIO_SAMPLE_RATE, AudioEngine::AUDIO_BUFFER_FRAMES);
+			renderToDevice(device, *mixer, voices, bus, target);
+			device.close();
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			double bufferMs = 1000.0 * AudioEngine::AUDIO_BUFFER_FRAMES / AudioEngine::AUDIO_SAMPLE_RATE;
+			if (ms < 100.0 - 3.0 * bufferMs || ms > 200.0) {
+				printf("%-14s %-9s %-15s FAILED (%.1f ms)\n", "audio", "null", "realtime", ms);
+				s_failures++;
+			}
+			else {
+				printf("%-14s %-9s %-15s %10.3f ms %10.3f ms buffer\n", "audio", "null", "realtime", ms, bufferMs);
+			}
+		}
+
+		for (auto& clip : clips) {
+			clip.release();
+		}
+	}
+
+	//A second long clip played through the engine itself, every render is a fresh offline device in engine sized buffers
+	static constexpr size_t ENGINE_CLIP_FRAMES = 48000;
+	static constexpr size_t ENGINE_RENDER_FRAMES = 32 * AudioEngine::AUDIO_BUFFER_FRAMES;
+	static constexpr int64_t ENGINE_SEEK_FRAME = 20000;
+
+	static void runAudioEngine() {
+		if (!isSelected("audio", "engine", "play-stop")) { return; }
+
+		AudioData data{};
+		data.sampleType = AudioSampleType::Float;
+		data.depth = 32;
+		data.channels = 1;
+		data.sampleRate = AudioEngine::AUDIO_SAMPLE_RATE;
+		data.sampleCount = ENGINE_CLIP_FRAMES;
+		data.doAllocate();
+
+		float* wave = reinterpret_cast<float*>(data.data);
+		for (size_t i = 0; i < ENGINE_CLIP_FRAMES; i++) {
+			wave[i] = 0.8f * sinf(float(i) * (6.2831853f * 330.0f / 48000.0f));
+		}
+
+		AudioClip clip{};
+		clip.setAudioData(data);
+		const float* samples = reinterpret_cast<const float*>(clip.getAudioData().data);
+
+		auto engine = std::make_unique<AudioEngine>();
+		std::vector<float> output{};
+		auto render = [&]() {
+			MemoryStream memory(ENGINE_RENDER_FRAMES * 2 * sizeof(float) + 128, true);
+			OfflineAudioDevice device(memory, ENGINE_RENDER_FRAMES);
+			if (!engine->start(device)) { return false; }
+			engine->finish();
+			engine->update();
+
+			AudioData rendered{};
+			memory.seek(0, SEEK_SET);
+			bool valid = Wav::decode(memory, rendered) && rendered.sampleCount == ENGINE_RENDER_FRAMES && rendered.channels == 2 && rendered.sampleType == AudioSampleType::Float;
+			if (valid) {
+				const float* renderedData = reinterpret_cast<const float*>(rendered.data);
+				output.assign(renderedData, renderedData + ENGINE_RENDER_FRAMES * 2);
+			}
+			rendered.release();
+			return valid;
+		};
+
+		//Frames [from, to) of the last render have to be the clip from 'start' on at 'volume', silence past its end
+		auto matches = [&](size_t from, size_t to, int64_t start, float volume) {
+			for (size_t f = from; f < to; f++) {
+				size_t pos = size_t(start) + f;
+				float expected = pos < ENGINE_CLIP_FRAMES ? volume * samples[pos] : 0.0f;
+				if (fabsf(output[f * 2] - expected) > 1e-5f || fabsf(output[f * 2 + 1] - expected) > 1e-5f) { return false; }
+			}
+			return true;
+		};
+
+		auto fail = [](const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "audio", "engine", "play-stop", reason);
+			s_failures++;
+		};
+
+		auto start = std::chrono::steady_clock::now();
+		IAudioSource first{};
+		first.setAudioClip(&clip);
+		if (!engine->play(first) || !render() || !matches(0, ENGINE_RENDER_FRAMES, 0, 1.0f) ||
+			!engine->isPlaying(first) || first.getTimeSamples() != int64_t(ENGINE_RENDER_FRAMES)) {
+			fail("play");
+			return;
+		}
+
+		//Volume ramps over the first block after a change, the seek lands right away
+		first.setVolume(0.5f);
+		first.setTimeSamples(ENGINE_SEEK_FRAME);
+		engine->update();
+		if (!render() || !matches(AudioEngine::AUDIO_BUFFER_FRAMES, ENGINE_RENDER_FRAMES, ENGINE_SEEK_FRAME, 0.5f) ||
+			first.getTimeSamples() != ENGINE_SEEK_FRAME + int64_t(ENGINE_RENDER_FRAMES)) {
+			fail("volume/seek");
+			return;
+		}
+
+		//The stopped source's voice goes to the next one, changes to the stopped source can't reach it anymore
+		IAudioSource second{};
+		second.setAudioClip(&clip);
+		const int64_t tail = int64_t(ENGINE_CLIP_FRAMES - ENGINE_RENDER_FRAMES / 2);
+		second.setTimeSamples(tail);
+		if (!engine->stop(first) || engine->isPlaying(first) || !engine->play(second)) {
+			fail("stop");
+			return;
+		}
+
+		first.setVolume(0.25f);
+		engine->update();
+		if (!render() || !matches(0, ENGINE_RENDER_FRAMES, tail, 1.0f) ||
+			engine->isPlaying(second) || second.getTimeSamples() != int64_t(ENGINE_CLIP_FRAMES)) {
+			fail("reuse");
+			return;
+		}
+
+		first.setTimeSamples(0);
+		if (!engine->play(first) || !render() || !matches(0, ENGINE_RENDER_FRAMES, 0, 0.25f) || !engine->stop(first)) {
+			fail("replay");
+			return;
+		}
+		engine.reset();
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		printf("%-14s %-9s %-15s %10.3f ms %10d renders\n", "audio", "engine", "play-stop", ms, 4);
+	}
+
+	static constexpr int32_t PAK_ENTRIES = 256;
+	static constexpr size_t PAK_ENTRY_SIZE = 64 * 1024;
+	static constexpr const char* PAK_SCRATCH_FILE = "J-Bench-pak.tmp";
+
+	static void runPak() {
+		const size_t bytes = size_t(PAK_ENTRIES) * PAK_ENTRY_SIZE;
+
+		std::vector<uint8_t> text(PAK_ENTRY_SIZE);
+		std::vector<uint8_t> noise(PAK_ENTRY_SIZE);
+		uint32_t state = 0x9E3779B9U;
+		for (size_t i = 0; i < PAK_ENTRY_SIZE; i++) {
+			static constexpr char WORDS[] = "position: [0, 1, 2] color: #FFAA00 name: sprite_";
+			text[i] = uint8_t(WORDS[i % (sizeof(WORDS) - 1)] + ((i >> 10) & 0x7));
+
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			noise[i] = uint8_t(state);
+		}
+
+		std::vector<std::string> names{};
+		size_t nameBytes = 0;
+		for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+			names.push_back("Assets/Folder" + std::to_string(i % 16) + "/Entry" + std::to_string(i) + ((i & 1) ? ".bin" : ".txt"));
+			nameBytes += names.back().length();
+		}
+		auto getSource = [&](int32_t i) -> const std::vector<uint8_t>& { return (i & 1) ? noise : text; };
+
+		auto runMode = [&](const char* mode, uint32_t flags) {
+			auto writePak = [&]() {
+				FileStream file(PAK_SCRATCH_FILE, "wb");
+				AssetPacking::PakWriter writer{};
+				if (!writer.begin(file, flags)) { return false; }
+				for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+					const auto& src = getSource(i);
+					if (!writer.addEntry(names[i], src.data(), src.size())) { return false; }
+				}
+				return writer.end();
+			};
+
+			if (!writePak()) {
+				printf("%-14s %-9s %-15s FAILED (couldn't write '%s')\n", "pak", mode, "write", PAK_SCRATCH_FILE);
+				s_failures++;
+				return;
+			}
+
+			size_t pakSize = 0;
+			{
+				AssetPacking::PakFile pak(PAK_SCRATCH_FILE);
+				for (size_t i = 0; i < pak.getEntryCount(); i++) {
+					pakSize += size_t(pak.getEntry(i)->size);
+				}
+			}
+			run("pak", mode, "write", bytes, writePak, pakSize);
+
+			AssetPacking::PakFile pak(PAK_SCRATCH_FILE);
+			if (!pak.isOpen()) {
+				printf("%-14s %-9s %-15s FAILED (couldn't map '%s')\n", "pak", mode, "open", PAK_SCRATCH_FILE);
+				s_failures++;
+				return;
+			}
+
+			std::vector<uint8_t> buffer(PAK_ENTRY_SIZE);
+			for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+				const AssetPacking::PakEntry* entry = pak.find(names[i]);
+				if (!entry || !pak.read(*entry, buffer.data(), buffer.size(), true) || memcmp(buffer.data(), getSource(i).data(), PAK_ENTRY_SIZE) != 0) {
+					printf("%-14s %-9s %-15s FAILED (entry '%s' doesn't match)\n", "pak", mode, "read", names[i].c_str());
+					s_failures++;
+					return;
+				}
+			}
+
+			run("pak", mode, "lookup", nameBytes, [&]() {
+				for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+					if (pak.indexOf(names[i]) == SIZE_MAX) { return false; }
+				}
+				return true;
+			});
+
+			auto readAll = [&](bool verifyCRC) {
+				for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+					const AssetPacking::PakEntry* entry = pak.find(names[i]);
+					if (!entry || !pak.read(*entry, buffer.data(), buffer.size(), verifyCRC)) { return false; }
+				}
+				return true;
+			};
+			run("pak", mode, "read", bytes, [&]() { return readAll(false); });
+			run("pak", mode, "read+crc", bytes, [&]() { return readAll(true); });
+
+			//Raw entries straight out of the mapping, the sum just keeps the reads from being optimized out
+			run("pak", mode, "view", bytes, [&]() {
+				uint64_t sum = 0;
+				for (int32_t i = 0; i < PAK_ENTRIES; i++) {
+					const AssetPacking::PakEntry* entry = pak.find(names[i]);
+					if (!entry) { return false; }
+					Span<const uint8_t> view = pak.view(*entry);
+					for (size_t j = 0; j < view.length(); j += 64) {
+						sum += view[j];
+					}
+				}
+				return sum != UINT64_MAX;
+			});
+		};
+
+		runMode("raw", AssetPacking::PAK_FLAG_NONE);
+		runMode("zlib", AssetPacking::PAK_FLAG_COMPRESS);
+		runMode("lz4", AssetPacking::PAK_FLAG_COMPRESS | AssetPacking::PAK_FLAG_FAST);
+
+		//An entry flag from a newer writer has to keep the pak from opening instead of being read as raw data
+		if (isSelected("pak", "flags", "reject")) {
+			AssetPacking::PakHeader header{};
+			bool patched = false;
+			FILE* file = fopen(PAK_SCRATCH_FILE, "r+b");
+			if (file) {
+				if (fread(&header, sizeof(header), 1, file) == 1 && header.entryCount > 0) {
+					uint16_t flags = 0;
+					long offset = long(header.tocOffset + offsetof(AssetPacking::PakEntry, flags));
+					if (fseek(file, offset, SEEK_SET) == 0 && fread(&flags, sizeof(flags), 1, file) == 1) {
+						flags |= 0x8000;
+						patched = fseek(file, offset, SEEK_SET) == 0 && fwrite(&flags, sizeof(flags), 1, file) == 1;
+					}
+				}
+				fclose(file);
+			}
+
+			AssetPacking::PakFile pak(PAK_SCRATCH_FILE);
+			if (!patched || pak.isOpen()) {
+				printf("%-14s %-9s %-15s FAILED (%s)\n", "pak", "flags", "reject", patched ? "opened a pak with unknown entry flags" : "couldn't patch pak");
+				s_failures++;
+			}
+		}
+		remove(PAK_SCRATCH_FILE);
+	}
+
+	static constexpr size_t DEFLATE_SIZE = 16 * 1024 * 1024;
+	static constexpr int32_t DEFLATE_LEVEL = 6;
+
+	static void runDeflate() {
+		//Asset-like text with some noise mixed in, compressible but not trivially so
+		static constexpr const char* WORDS[] = { "position", "rotation", "scale", "texture", "material", "shader", "sprite", ": [", "], ", "0.5", "1.0", "\n", "  ", "name: ", "uuid: " };
+		std::vector<uint8_t> source(DEFLATE_SIZE);
+		uint32_t state = 0x9E3779B9U;
+		for (size_t i = 0; i < DEFLATE_SIZE;) {
+			uint32_t rnd = nextRandom(state);
+			if ((rnd & 0xF) == 0) {
+				source[i++] = uint8_t(rnd >> 8);
+				continue;
+			}
+
+			const char* word = WORDS[(rnd >> 4) % (sizeof(WORDS) / sizeof(WORDS[0]))];
+			for (size_t j = 0; word[j] && i < DEFLATE_SIZE; j++) {
+				source[i++] = uint8_t(word[j]);
+			}
+		}
+
+		std::vector<uint8_t> packed{};
+		std::vector<uint8_t> unpacked(DEFLATE_SIZE);
+		auto roundTrip = [&]() {
+			return ZLib::inflateData(packed.data(), packed.size(), unpacked.data(), unpacked.size()) == int32_t(DEFLATE_SIZE) &&
+				memcmp(unpacked.data(), source.data(), DEFLATE_SIZE) == 0;
+		};
+
+		static constexpr uint32_t THREADS[] = { 1, 2, 4, 8 };
+		for (uint32_t threads : THREADS) {
+			char op[16]{};
+			snprintf(op, sizeof(op), "%u-thread%s", threads, threads > 1 ? "s" : "");
+
+			packed.clear();
+			if (ZLib::deflateParallel(source.data(), source.size(), packed, DEFLATE_LEVEL, threads) != Z_OK || !roundTrip()) {
+				printf("%-14s %-9s %-15s FAILED (round trip)\n", "deflate", "text", op);
+				s_failures++;
+				continue;
+			}
+
+			run("deflate", "text", op, DEFLATE_SIZE, [&]() {
+				packed.clear();
+				return ZLib::deflateParallel(source.data(), source.size(), packed, DEFLATE_LEVEL, threads) == Z_OK;
+			}, packed.size());
+		}
+
+		//Streamed through batches of blocks, the dictionary carries over between batches
+		MemoryStream input(static_cast<const uint8_t*>(source.data()), source.size(), source.size());
+		MemoryStream output(DEFLATE_SIZE, true);
+		bool streamed = ZLib::deflateData(input, output, DEFLATE_LEVEL, 4) == Z_OK;
+		if (streamed) {
+			packed.resize(output.tell());
+			output.seek(0, SEEK_SET);
+			streamed = output.read(packed.data(), 1, packed.size(), false) == packed.size() && roundTrip();
+		}
+
+		if (!streamed) {
+			printf("%-14s %-9s %-15s FAILED (round trip)\n", "deflate", "text", "stream");
+			s_failures++;
+		}
+
+		//Decoding is what runtime loads pay for, LZ4 gives up some ratio to decode several times faster than inflate
+		packed.clear();
+		if (ZLib::deflateParallel(source.data(), source.size(), packed, DEFLATE_LEVEL, 1) == Z_OK) {
+			run("deflate", "text", "inflate", DEFLATE_SIZE, roundTrip, packed.size());
+		}
+
+		static constexpr int32_t LZ4_LEVELS[] = { LZ4::MIN_LEVEL, 4, LZ4::MAX_LEVEL };
+		std::vector<uint8_t> fast(LZ4::compressBound(DEFLATE_SIZE));
+		int32_t fastSize = 0;
+		for (int32_t level : LZ4_LEVELS) {
+			char op[16]{};
+			snprintf(op, sizeof(op), "level-%d", level);
+
+			fastSize = LZ4::compressData(source.data(), source.size(), fast.data(), fast.size(), level);
+			if (fastSize < 0) {
+				printf("%-14s %-9s %-15s FAILED (compress)\n", "lz4", "text", op);
+				s_failures++;
+				continue;
+			}
+
+			run("lz4", "text", op, DEFLATE_SIZE, [&]() {
+				return LZ4::compressData(source.data(), source.size(), fast.data(), fast.size(), level) == fastSize;
+			}, size_t(fastSize));
+		}
+
+		if (fastSize > 0) {
+			run("lz4", "text", "decompress", DEFLATE_SIZE, [&]() {
+				return LZ4::decompressData(fast.data(), size_t(fastSize), unpacked.data(), unpacked.size()) == int32_t(DEFLATE_SIZE) &&
+					memcmp(unpacked.data(), source.data(), DEFLATE_SIZE) == 0;
+			}, size_t(fastSize));
+		}
+
+		//Framed round trip fed in pieces that don't line up with the blocks, decoded both segmented and straight from the stream
+		static constexpr size_t SEGMENT_SIZE = 10007;
+		MemoryStream framed(DEFLATE_SIZE, true);
+		LZ4::LZ4Context context{};
+		bool framedOk = LZ4::compressBegin(context, framed) == LZ4::LZ4_OK;
+		for (size_t i = 0; framedOk && i < DEFLATE_SIZE; i += SEGMENT_SIZE) {
+			framedOk = LZ4::compressSegment(context, source.data() + i, std::min(SEGMENT_SIZE, DEFLATE_SIZE - i)) == LZ4::LZ4_OK;
+		}
+		framedOk &= LZ4::compressEnd(context) == LZ4::LZ4_OK;
+
+		if (framedOk) {
+			packed.resize(framed.tell());
+			framed.seek(0, SEEK_SET);
+			framedOk = framed.read(packed.data(), 1, packed.size(), false) == packed.size();
+		}
+
+		MemoryStream decoded(DEFLATE_SIZE, true);
+		framedOk &= LZ4::decompressBegin(context, decoded) == LZ4::LZ4_OK;
+		for (size_t i = 0; framedOk && i < packed.size(); i += SEGMENT_SIZE) {
+			int32_t ret = LZ4::decompressSegment(context, packed.data() + i, std::min(SEGMENT_SIZE, packed.size() - i));
+			framedOk = ret == LZ4::LZ4_OK || ret == LZ4::LZ4_STREAM_END;
+		}
+		framedOk &= LZ4::decompressEnd(context) == LZ4::LZ4_OK && decoded.tell() == DEFLATE_SIZE;
+
+		if (framedOk) {
+			MemoryStream input(static_cast<const uint8_t*>(packed.data()), packed.size(), packed.size());
+			decoded.seek(0, SEEK_SET);
+			framedOk = decoded.read(unpacked.data(), 1, unpacked.size(), false) == unpacked.size() &&
+				memcmp(unpacked.data(), source.data(), DEFLATE_SIZE) == 0 &&
+				LZ4::decompressData(input, decoded) == LZ4::LZ4_OK;
+		}
+
+		if (framedOk) {
+			decoded.seek(0, SEEK_SET);
+			memset(unpacked.data(), 0, unpacked.size());
+			framedOk = decoded.read(unpacked.data(), 1, unpacked.size(), false) == unpacked.size() &&
+				memcmp(unpacked.data(), source.data(), DEFLATE_SIZE) == 0;
+		}
+
+		if (!framedOk) {
+			printf("%-14s %-9s %-15s FAILED (round trip)\n", "lz4", "text", "stream");
+			s_failures++;
+		}
+	}
+
+	static constexpr int32_t VFS_ENTRIES = 40 * 1024;
+
+	static void runVFS() {
+		//Wide folders on purpose, lookups shouldn't get slower with the amount of siblings
+		std::vector<std::string> names{};
+		size_t nameBytes = 0;
+		for (int32_t i = 0; i < VFS_ENTRIES; i++) {
+			names.push_back("Assets/Folder" + std::to_string(i % 16) + "/Sub" + std::to_string(i % 4) + "/Entry" + std::to_string(i) + ".bin");
+			nameBytes += names.back().length();
+		}
+
+		auto addAll = [&](VFS& vfs) {
+			for (int32_t i = 0; i < VFS_ENTRIES; i++) {
+				if (!vfs.addEntry(FileEntry::NULL_SOURCE, names[i], RUNTIME_EINF).isValid()) { return false; }
+			}
+			return true;
+		};
+
+		run("vfs", "runtime", "add", nameBytes, [&]() {
+			VFS vfs{};
+			return addAll(vfs);
+		});
+
+		VFS vfs{};
+		if (!addAll(vfs)) {
+			printf("%-14s %-9s %-15s FAILED (couldn't add entries)\n", "vfs", "runtime", "add");
+			s_failures++;
+			return;
+		}
+
+		run("vfs", "runtime", "lookup", nameBytes, [&]() {
+			for (int32_t i = 0; i < VFS_ENTRIES; i++) {
+				if (!vfs.indexOfFileEntry(names[i]).isValid()) { return false; }
+			}
+			return true;
+		});
+
+		run("vfs", "runtime", "lookup-miss", nameBytes, [&]() {
+			for (int32_t i = 0; i < VFS_ENTRIES; i++) {
+				ConstSpan<char> name(names[i].c_str(), names[i].length() - 1);
+				if (vfs.indexOfFileEntry(name).isValid()) { return false; }
+			}
+			return true;
+		});
+
+		//Absolute paths only lose the root when it ends at a separator, 'Bench/RootAssets' is a sibling of 'Bench/Root'
+		VFS rooted(ConstSpan<char>("Bench/Root"), VFS::VFS_FLAG_NONE);
+		if (!addAll(rooted)) {
+			printf("%-14s %-9s %-15s FAILED (couldn't add entries)\n", "vfs", "rooted", "add");
+			s_failures++;
+			return;
+		}
+
+		run("vfs", "rooted", "lookup-abs", nameBytes, [&]() {
+			std::string path{};
+			for (int32_t i = 0; i < VFS_ENTRIES; i++) {
+				path.assign("Bench/Root/").append(names[i]);
+				if (!rooted.indexOfFileEntry(path).isValid()) { return false; }
+
+				path.assign("Bench/Root").append(names[i]);
+				if (rooted.indexOfFileEntry(path).isValid()) { return false; }
+			}
+			return true;
+		});
+	}
+
+	static constexpr int32_t LOADER_ASSETS = 384;
+	static constexpr int32_t LOADER_IMAGES = 8;
+	static constexpr size_t LOADER_BUDGET = 256 * 1024;
+
+	static void runLoader() {
+		//Assets are generated in memory and fed through custom readers so the test doesn't depend on disk speed.
+		//Every third asset is a PNG, a JSON document or a raw blob, every 16th one is cancelled right after queueing.
+		ImageData images[LOADER_IMAGES]{};
+		std::vector<uint8_t> pngs[LOADER_IMAGES]{};
+		for (int32_t i = 0; i < LOADER_IMAGES; i++) {
+			images[i] = makeGradient(32 + i * 16);
+
+			pngs[i].resize(images[i].getSize() + 4096);
+			MemoryStream stream(pngs[i].data(), 0, pngs[i].size());
+			if (!Png::encode(stream, images[i], 6)) {
+				printf("%-14s %-9s %-15s FAILED (couldn't encode sources)\n", "loader", "mixed", "load-all");
+				s_failures++;
+				return;
+			}
+			pngs[i].resize(stream.tell());
+		}
+
+		std::vector<std::vector<uint8_t>> sources(LOADER_ASSETS);
+		size_t bytes = 0;
+		for (int32_t i = 0; i < LOADER_ASSETS; i++) {
+			switch (i % 3) {
+				case 0:
+					sources[i] = pngs[(i / 3) % LOADER_IMAGES];
+					break;
+				case 1: {
+					std::string text = "{ \"index\": " + std::to_string(i) + ", \"name\": \"Asset" + std::to_string(i) + "\", \"tags\": [1, 2, 3] }";
+					sources[i].assign(text.begin(), text.end());
+					break;
+				}
+				default:
+					sources[i].resize(1024 + (i * 97) % 8192);
+					for (size_t j = 0; j < sources[i].size(); j++) {
+						sources[i][j] = uint8_t(j * 31 + i);
+					}
+					break;
+			}
+			bytes += sources[i].size();
+		}
+
+		auto loadAll = [&]() {
+			AssetLoader loader(4, LOADER_BUDGET);
+			std::atomic<size_t> peak{ 0 };
+			std::vector<uint8_t> cancelled(LOADER_ASSETS, 0);
+			int32_t delivered = 0;
+			bool valid = true;
+
+			//Last asset that doesn't get cancelled
+			const int32_t urgent = LOADER_ASSETS - 2;
+			bool urgentLoaded = false;
+
+			auto check = [&](int32_t i, LoadResult& result) {
+				delivered++;
+				if (i == urgent) {
+					urgentLoaded = result.succeeded();
+				}
+				if (cancelled[i]) {
+					//Cancellation can lose the race against a worker that already decoded it
+					valid &= result.state == LoadState::Cancelled || result.succeeded();
+					return;
+				}
+
+				if (!result.succeeded()) {
+					valid = false;
+					return;
+				}
+
+				switch (i % 3) {
+					case 0: {
+						const ImageData& source = images[(i / 3) % LOADER_IMAGES];
+						valid &= result.image.width == source.width && matches(source, result.image);
+						break;
+					}
+					case 1:
+						valid &= result.serialized.value("index", -1) == i;
+						break;
+					default:
+						valid &= result.bytes == sources[i];
+						break;
+				}
+			};
+
+			std::vector<uint64_t> ids(LOADER_ASSETS);
+			for (int32_t i = 0; i < LOADER_ASSETS; i++) {
+				static constexpr LoadType TYPES[3]{ LoadType::Image, LoadType::Serialized, LoadType::Raw };
+				LoadPriority priority = (i & 1) ? LoadPriority::Prefetch : LoadPriority::Visible;
+
+				ids[i] = loader.load(std::to_string(i), [&, i](LoadSource& source) {
+					size_t inFlight = loader.getInFlightBytes();
+					size_t prev = peak;
+					while (inFlight > prev && !peak.compare_exchange_weak(prev, inFlight)) {}
+
+					//Every other asset of each type is handed over as a view, like a mapped file
+					if ((i / 3) & 1) {
+						source.view = ConstSpan<uint8_t>(sources[i].data(), sources[i].size());
+					}
+					else {
+						source.bytes = sources[i];
+					}
+					return true;
+				}, sources[i].size(), TYPES[i % 3], priority, [&, i](LoadResult& result) { check(i, result); });
+
+				if ((i & 15) == 15) {
+					cancelled[i] = 1;
+					loader.cancel(ids[i]);
+				}
+			}
+
+			//One of the last assets is needed right away, it jumps ahead of everything still queued
+			if (!loader.wait(ids[urgent]) || !urgentLoaded) { return false; }
+
+			while (loader.getPendingCount() > 0) {
+				if (loader.update() < 1) {
+					std::this_thread::yield();
+				}
+			}
+
+			//Decoded images can push past the budget after they're read but nothing new starts until it's freed again
+			return valid && delivered == LOADER_ASSETS && loader.getInFlightBytes() == 0 && peak <= LOADER_BUDGET + 4 * images[LOADER_IMAGES - 1].getSize();
+		};
+
+		run("loader", "mixed", "load-all", bytes, loadAll);
+
+		for (auto& image : images) {
+			image.clear(true);
+		}
+	}
+
+	static constexpr int32_t RESIDENCY_ASSETS = 64 * 1024;
+	static constexpr int32_t RESIDENCY_FRAMES = 2048;
+	static constexpr int32_t RESIDENCY_PER_FRAME = 64;
+	static constexpr size_t RESIDENCY_BUDGET = 32 * 1024 * 1024;
+
+	static void runResidency() {
+		struct SimAsset {
+			AssetRef ref;
+			size_t bytes;
+			bool resident;
+		};
+
+		//Assets spread over 3 sources and 4 types, sizes between 1 KiB and 64 KiB
+		std::vector<SimAsset> assets(RESIDENCY_ASSETS);
+		uint32_t state = 0x1234567U;
+		for (int32_t i = 0; i < RESIDENCY_ASSETS; i++) {
+			assets[i].ref = AssetRef(false, uint64_t(i & 3), uint64_t(i % 3), uint64_t(i));
+			assets[i].bytes = 1024 + (nextRandom(state) & 0xFFFF);
+			assets[i].resident = false;
+		}
+
+		auto simulate = [&]() {
+			AssetResidency residency{};
+			residency.setBudget(RESIDENCY_BUDGET);
+			residency.setEvictCallback([&](AssetRef ref) {
+				assets[ref.getUUID()].resident = false;
+				return true;
+			});
+			for (auto& asset : assets) {
+				asset.resident = false;
+			}
+
+			//Most requests hit a small hot set, the rest are spread over everything
+			uint32_t rng = 0x9E3779B9U;
+			std::vector<int32_t> frame{};
+			for (int32_t f = 0; f < RESIDENCY_FRAMES; f++) {
+				frame.clear();
+				for (int32_t i = 0; i < RESIDENCY_PER_FRAME; i++) {
+					uint32_t r = nextRandom(rng);
+					int32_t index = (r & 0xF) < 12 ? int32_t((r >> 4) % 2048) : int32_t((r >> 4) % RESIDENCY_ASSETS);
+
+					SimAsset& asset = assets[index];
+					residency.acquire(asset.ref);
+					frame.push_back(index);
+					if (!asset.resident) {
+						asset.resident = true;
+						residency.setResident(asset.ref, asset.bytes);
+					}
+					else {
+						residency.touch(asset.ref);
+					}
+				}
+
+				//Only what's referenced may keep the total over budget
+				const ResidencyStats& stats = residency.getStats();
+				if (stats.residentBytes > RESIDENCY_BUDGET && stats.residentBytes != stats.referencedBytes) { return false; }
+
+				for (int32_t index : frame) {
+					residency.release(assets[index].ref);
+				}
+			}
+
+			//Accounting has to agree with what the callbacks actually unloaded
+			const ResidencyStats& stats = residency.getStats();
+			size_t bytes = 0;
+			size_t sourceBytes[3]{};
+			for (const auto& asset : assets) {
+				if (asset.resident != residency.isResident(asset.ref)) { return false; }
+				if (!asset.resident) { continue; }
+				bytes += asset.bytes;
+				sourceBytes[asset.ref.getSource()] += asset.bytes;
+			}
+
+			return stats.referencedCount == 0 && stats.residentBytes == bytes && stats.residentBytes <= RESIDENCY_BUDGET &&
+				stats.sourceBytes[0] == sourceBytes[0] && stats.sourceBytes[1] == sourceBytes[1] && stats.sourceBytes[2] == sourceBytes[2] &&
+				stats.typeBytes[0] + stats.typeBytes[1] + stats.typeBytes[2] + stats.typeBytes[3] == bytes;
+		};
+
+		run("residency", "lru", "frames", size_t(RESIDENCY_FRAMES) * RESIDENCY_PER_FRAME * sizeof(AssetRef), simulate);
+
+		//An asset that refuses to unload has to stay without stalling the trim
+		AssetResidency residency{};
+		residency.setEvictCallback([](AssetRef ref) { return ref.getUUID() != 1; });
+		residency.setResident(AssetRef(false, 0, 0, 1), 4096);
+		residency.setResident(AssetRef(false, 0, 0, 2), 4096);
+		residency.setSourceBudget(0, 0);
+		if (!residency.isResident(AssetRef(false, 0, 0, 1)) || residency.isResident(AssetRef(false, 0, 0, 2)) || residency.getStats().evictedCount != 1) {
+			printf("%-14s %-9s %-15s FAILED (refused eviction)\n", "residency", "lru", "refuse");
+			s_failures++;
+		}
+	}
+
+	//Assets read out of a mounted pak through AssetDB, the residency budget only fits a quarter of them
+	static constexpr int32_t ASSETDB_ASSETS = 64;
+	static constexpr size_t ASSETDB_ASSET_SIZE = 64 * 1024;
+	static constexpr int32_t ASSETDB_RESIDENT = 16;
+	static constexpr const char* ASSETDB_SCRATCH_FILE = "J-Bench-assets.tmp";
+
+	class BenchAsset : public IAsset {
+	public:
+		std::vector<uint8_t> data{};
+
+		void setLoaded(std::vector<uint8_t>& bytes) {
+			data.swap(bytes);
+			getFlags() |= FLAG_IS_LOADED;
+		}
+
+		bool unload() override {
+			if (!IAsset::unload()) { return false; }
+			data.clear();
+			data.shrink_to_fit();
+			return true;
+		}
+
+		size_t getMemorySize() const override { return data.size(); }
+
+	protected:
+		void deserializeImpl(const SerializedItem&) override {}
+		void serializeImpl(SerializedItem&) const override {}
+	};
+
+	static void runAssetDB() {
+		const size_t bytes = size_t(ASSETDB_ASSETS) * ASSETDB_ASSET_SIZE;
+		auto fail = [](const char* op, const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "assetdb", "pak", op, reason);
+			s_failures++;
+		};
+
+		std::vector<std::string> names{};
+		{
+			FileStream file(ASSETDB_SCRATCH_FILE, "wb");
+			AssetPacking::PakWriter writer{};
+			bool written = writer.begin(file, AssetPacking::PAK_FLAG_NONE);
+			std::vector<uint8_t> data(ASSETDB_ASSET_SIZE);
+			for (int32_t i = 0; i < ASSETDB_ASSETS && written; i++) {
+				for (size_t j = 0; j < data.size(); j++) {
+					data[j] = uint8_t(j * 31 + i);
+				}
+				names.push_back("Assets/Asset" + std::to_string(i) + ".bin");
+				written = writer.addEntry(names.back(), data.data(), data.size());
+			}
+
+			if (!written || !writer.end()) {
+				fail("load-all", "couldn't write pak");
+				remove(ASSETDB_SCRATCH_FILE);
+				return;
+			}
+		}
+
+		{
+			AssetDB db{};
+			VFS* vfs = db.getVFS(AssetDB::SRC_GAME);
+			if (db.mountPak(AssetDB::SRC_GAME, ASSETDB_SCRATCH_FILE) == UINT32_MAX) {
+				fail("load-all", "couldn't mount pak");
+				remove(ASSETDB_SCRATCH_FILE);
+				return;
+			}
+
+			std::vector<BenchAsset> assets(ASSETDB_ASSETS);
+			std::vector<AssetRef> refs(ASSETDB_ASSETS);
+			for (int32_t i = 0; i < ASSETDB_ASSETS; i++) {
+				refs[i] = db.addAsset(&assets[i], AssetDB::SRC_GAME, vfs->getEntryByPath(names[i]));
+			}
+
+			AssetResidency& residency = db.getResidency();
+			residency.setBudget(size_t(ASSETDB_RESIDENT) * ASSETDB_ASSET_SIZE);
+
+			//Whatever's still resident from the last round goes through 'unloadAsset' first
+			auto unloadAll = [&]() {
+				for (int32_t i = 0; i < ASSETDB_ASSETS; i++) {
+					if (residency.isResident(refs[i]) != db.unloadAsset(refs[i])) { return false; }
+				}
+				return residency.getStats().residentBytes == 0 && residency.getStats().residentCount == 0;
+			};
+
+			run("assetdb", "pak", "load-all", bytes, [&]() {
+				if (!unloadAll()) { return false; }
+
+				bool valid = true;
+				for (int32_t i = 0; i < ASSETDB_ASSETS; i++) {
+					uint64_t id = db.loadAsync(refs[i], LoadType::Raw, LoadPriority::Visible, [&, i](LoadResult& result) {
+						valid &= result.succeeded() && result.bytes.size() == ASSETDB_ASSET_SIZE && result.bytes[7] == uint8_t(7 * 31 + i);
+						if (result.succeeded()) {
+							assets[i].setLoaded(result.bytes);
+						}
+					});
+					valid &= id != AssetLoader::INVALID_ID;
+				}
+
+				while (db.getLoader().getPendingCount() > 0) {
+					db.update();
+					std::this_thread::yield();
+				}
+
+				//Every load reported itself, the oldest ones got evicted and unloaded to stay in budget
+				const ResidencyStats& stats = residency.getStats();
+				valid &= stats.residentCount == ASSETDB_RESIDENT && stats.residentBytes == size_t(ASSETDB_RESIDENT) * ASSETDB_ASSET_SIZE;
+				for (int32_t i = 0; i < ASSETDB_ASSETS; i++) {
+					valid &= residency.isResident(refs[i]) == !assets[i].data.empty();
+				}
+				return valid;
+			});
+
+			if (!unloadAll()) {
+				fail("unload-all", "residency still holds unloaded assets");
+			}
+		}
+		remove(ASSETDB_SCRATCH_FILE);
+	}
+
+	//Reference XXH64 digests, the patterned inputs land on either side of the 32 byte stripe and the 4/8 byte tails
+	static constexpr size_t XXH_PATTERN_SIZE = 256;
+	static constexpr size_t XXH_BULK_SIZE = 16 * 1024 * 1024;
+
+	static void runXXHash() {
+		struct TextVector {
+			const char* text;
+			uint64_t seed;
+			uint64_t digest;
+		};
+		static constexpr TextVector TEXT_VECTORS[] = {
+			{ "", 0, 0xEF46DB3751D8E999ULL },
+			{ "", 1, 0xD5AFBA1336A3BE4BULL },
+			{ "a", 0, 0xD24EC4F1A98C6E5BULL },
+			{ "abc", 0, 0x44BC2CF5AD770999ULL },
+			{ "abc", 0x9E3779B97F4A7C15ULL, 0x2ED0F59D6B43AC8BULL },
+			{ "The quick brown fox jumps over the lazy dog", 0, 0x0B242D361FDA71BCULL },
+			{ "The quick brown fox jumps over the lazy dog", 0x9E3779B1ULL, 0xB31B9019EC176B0CULL },
+		};
+
+		struct PatternVector {
+			size_t length;
+			uint64_t seed;
+			uint64_t digest;
+		};
+		static constexpr PatternVector PATTERN_VECTORS[] = {
+			{ 31, 0, 0xA2AA5F33CC4A6119ULL },
+			{ 31, 0x12345678, 0x13E4D3A33290E4B4ULL },
+			{ 32, 0, 0x23C3C17EF790FD97ULL },
+			{ 32, 0x12345678, 0x39BA501B32942425ULL },
+			{ 33, 0, 0x50A7CFC7BA588784ULL },
+			{ 33, 0x12345678, 0x395F049635DAD93AULL },
+			{ 63, 0, 0x5E3E54B431C7493CULL },
+			{ 63, 0x12345678, 0xCA005E103F1DD057ULL },
+			{ 64, 0, 0x0EB64B3EF6EEB01FULL },
+			{ 64, 0x12345678, 0xABDDEFE6B5926F11ULL },
+			{ 65, 0, 0xA383B724B2BD12F1ULL },
+			{ 65, 0x12345678, 0x69741F643950F6CDULL },
+			{ 100, 0, 0xA61F8D4C170FE531ULL },
+			{ 100, 0x12345678, 0xB8C11536FEB34E64ULL },
+			{ 256, 0, 0x00CFC5207DD8E201ULL },
+			{ 256, 0x12345678, 0x919FF6398500B97FULL },
+		};
+
+		uint8_t pattern[XXH_PATTERN_SIZE];
+		for (size_t i = 0; i < XXH_PATTERN_SIZE; i++) {
+			pattern[i] = uint8_t(i * 7 + 3);
+		}
+
+		//The streaming hasher has to give the same digest no matter how the input is split
+		auto check = [](const void* data, size_t length, uint64_t seed, uint64_t digest) {
+			if (Data::xxHash64(data, length, seed) != digest) { return false; }
+
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+			for (size_t step : { size_t(1), size_t(7), size_t(13), size_t(32), size_t(33) }) {
+				Data::XXHash64 hasher(seed);
+				for (size_t i = 0; i < length; i += step) {
+					hasher.update(bytes + i, std::min(step, length - i));
+				}
+				if (hasher.digest() != digest) { return false; }
+			}
+			return true;
+		};
+
+		for (const auto& vec : TEXT_VECTORS) {
+			if (!check(vec.text, strlen(vec.text), vec.seed, vec.digest)) {
+				printf("%-14s %-9s %-15s MISMATCH ('%s', seed %llx)\n", "xxhash", "xxh64", "vectors", vec.text, (unsigned long long)vec.seed);
+				s_failures++;
+			}
+		}
+
+		for (const auto& vec : PATTERN_VECTORS) {
+			if (!check(pattern, vec.length, vec.seed, vec.digest)) {
+				printf("%-14s %-9s %-15s MISMATCH (%zu bytes, seed %llx)\n", "xxhash", "xxh64", "vectors", vec.length, (unsigned long long)vec.seed);
+				s_failures++;
+			}
+		}
+
+		std::vector<uint8_t> bulk(XXH_BULK_SIZE);
+		uint32_t state = 0x51ED270BU;
+		for (auto& b : bulk) {
+			b = uint8_t(nextRandom(state));
+		}
+
+		const uint64_t expected = Data::xxHash64(bulk.data(), bulk.size());
+		run("xxhash", "xxh64", "one-shot", bulk.size(), [&]() {
+			return Data::xxHash64(bulk.data(), bulk.size()) == expected;
+		});
+
+		run("xxhash", "xxh64", "stream", bulk.size(), [&]() {
+			Data::XXHash64 hasher{};
+			for (size_t i = 0; i < bulk.size(); i += 4093) {
+				hasher.update(bulk.data() + i, std::min<size_t>(4093, bulk.size() - i));
+			}
+			return hasher.digest() == expected;
+		});
+	}
+
+	static constexpr int32_t DEPS_TEXTURES = 4096;
+	static constexpr int32_t DEPS_SHADERS = 64;
+	static constexpr int32_t DEPS_MATERIALS = 2048;
+	static constexpr int32_t DEPS_SPRITES = 4096;
+
+	static void runDependencies() {
+		//Materials use a shader and two textures, sprites use a texture and a material.
+		//Importers declare those, the graph learns them from the first full import.
+		auto getDependencies = [](const std::string& path, std::vector<std::string>& deps) {
+			int32_t index = atoi(path.c_str() + path.find_first_of("0123456789"));
+			if (path.compare(0, 4, "Mat/") == 0) {
+				deps.push_back("Shader/" + std::to_string(index % DEPS_SHADERS) + ".glsl");
+				deps.push_back("Tex/" + std::to_string(index % DEPS_TEXTURES) + ".png");
+				deps.push_back("Tex/" + std::to_string((index * 7 + 1) % DEPS_TEXTURES) + ".png");
+			}
+			else if (path.compare(0, 7, "Sprite/") == 0) {
+				deps.push_back("Tex/" + std::to_string(index % DEPS_TEXTURES) + ".png");
+				deps.push_back("Mat/" + std::to_string(index % DEPS_MATERIALS) + ".mat");
+			}
+		};
+
+		AssetDependencies graph{};
+		auto addAll = [&](const char* prefix, int32_t count, const char* ext) {
+			for (int32_t i = 0; i < count; i++) {
+				std::string path = prefix + std::to_string(i) + ext;
+				graph.setContentHash(path, Data::xxHash64(path.c_str(), path.length()));
+			}
+		};
+		addAll("Tex/", DEPS_TEXTURES, ".png");
+		addAll("Shader/", DEPS_SHADERS, ".glsl");
+		addAll("Mat/", DEPS_MATERIALS, ".mat");
+		addAll("Sprite/", DEPS_SPRITES, ".spr");
+
+		//Every dependency has to be imported before anything that uses it
+		std::vector<uint8_t> done{};
+		std::atomic<bool> ordered{ true };
+		auto import = [&](const std::string& path, std::vector<std::string>& deps) {
+			uint32_t node = graph.indexOf(path);
+			for (uint32_t dep : graph.getNode(node)->dependencies) {
+				if (!done[dep]) { ordered = false; }
+			}
+			getDependencies(path, deps);
+			done[node] = 1;
+			return true;
+		};
+
+		const size_t total = graph.getNodeCount();
+		done.assign(total, 0);
+		graph.reimport(import);
+
+		//First pass discovered the edges, the second one settles dependents whose dependencies were imported after them
+		done.assign(total, 1);
+		graph.reimport(import);
+
+		std::vector<uint32_t> order{};
+		if (!graph.collectReimports(order) || order.size() > 0 || !ordered) {
+			printf("%-14s %-9s %-15s FAILED (initial import didn't settle, %zu left)\n", "deps", "graph", "import", order.size());
+			s_failures++;
+			return;
+		}
+
+		//Changing one texture reimports it and exactly what uses it, directly or through a material
+		const std::string changed = "Tex/5.png";
+		size_t expected = 1;
+		{
+			std::vector<uint8_t> affected(total, 0);
+			std::vector<uint32_t> stack{ graph.indexOf(changed) };
+			while (stack.size() > 0) {
+				uint32_t node = stack.back();
+				stack.pop_back();
+				for (uint32_t dependent : graph.getNode(node)->dependents) {
+					if (!affected[dependent]) {
+						affected[dependent] = 1;
+						expected++;
+						stack.push_back(dependent);
+					}
+				}
+			}
+		}
+
+		uint64_t revision = 0;
+		run("deps", "graph", "reimport-one", 0, [&]() {
+			graph.setContentHash(changed, ++revision);
+			graph.collectReimports(order);
+			done.assign(total, 1);
+			for (uint32_t node : order) {
+				done[node] = 0;
+			}
+			ordered = true;
+			return graph.reimport(import) == expected && ordered;
+		});
+
+		//Survives a save/load round trip without anything becoming dirty
+		MemoryStream stream(1024, true);
+		AssetDependencies loaded{};
+		if (!graph.save(stream) || (stream.seek(0, SEEK_SET), !loaded.load(stream)) || !loaded.collectReimports(order) || order.size() > 0 || loaded.getNodeCount() != total) {
+			printf("%-14s %-9s %-15s FAILED (save/load round trip)\n", "deps", "graph", "persist");
+			s_failures++;
+		}
+	}
+
+	static constexpr int32_t DIRMON_PATHS = 4096;
+	static constexpr int32_t DIRMON_FILES = 256;
+	static constexpr uint32_t DIRMON_DEBOUNCE_MS = 50;
+	static constexpr uint32_t DIRMON_TIMEOUT_MS = 5000;
+	static constexpr size_t DIRMON_OVERFLOW_MAX_FILES = 256 * 1024;
+
+	static bool writeText(const std::filesystem::path& path, const char* text) {
+		FILE* file = fopen(path.string().c_str(), "wb");
+		if (!file) { return false; }
+		fwrite(text, 1, strlen(text), file);
+		fclose(file);
+		return true;
+	}
+
+	//Polls until 'count' paths came out or the timeout hit, a path reported twice sets 'duplicates'
+	static uint32_t settleChanges(DirectoryMonitor& monitor, size_t count, std::map<std::string, DirectoryChange>& received, bool& duplicates) {
+		std::vector<DirectoryChange> changes{};
+		auto start = std::chrono::steady_clock::now();
+		uint32_t elapsed = 0;
+		while (elapsed < DIRMON_TIMEOUT_MS) {
+			if (monitor.poll(changes)) {
+				for (const auto& change : changes) {
+					duplicates |= !received.emplace(change.getPath(), change).second;
+				}
+			}
+
+			if (received.size() >= count) { break; }
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			elapsed = uint32_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		//Late stragglers would show up as extra paths
+		std::this_thread::sleep_for(std::chrono::milliseconds(DIRMON_DEBOUNCE_MS * 2));
+		monitor.poll(changes);
+		for (const auto& change : changes) {
+			duplicates |= !received.emplace(change.getPath(), change).second;
+		}
+		return elapsed;
+	}
+
+	static constexpr int32_t SCAN_FOLDERS = 16;
+	static constexpr int32_t SCAN_FILES = 64;
+
+	static bool sameScan(const DirectoryScan& lhs, const DirectoryScan& rhs) {
+		const auto& lDirs = lhs.getDirectories();
+		const auto& rDirs = rhs.getDirectories();
+		if (lDirs.size() != rDirs.size()) { return false; }
+
+		for (size_t i = 0; i < lDirs.size(); i++) {
+			if (lDirs[i].path != rDirs[i].path || lDirs[i].modTime != rDirs[i].modTime || lDirs[i].items.size() != rDirs[i].items.size()) { return false; }
+
+			for (size_t j = 0; j < lDirs[i].items.size(); j++) {
+				const ScanItem& a = lDirs[i].items[j];
+				const ScanItem& b = rDirs[i].items[j];
+				if (a.name != b.name || a.type != b.type || a.size != b.size || a.modTime != b.modTime) { return false; }
+
+				//Loaded snapshots don't carry the folder links, those only exist after a scan
+				if (a.dir != b.dir && a.dir != ScanItem::NO_DIR && b.dir != ScanItem::NO_DIR) { return false; }
+			}
+		}
+		return true;
+	}
+
+	//Real tree in a scratch folder: scans have to come out the same whatever the thread count,
+	//and a snapshot of an untouched tree has to be reused without listing a single directory
+	static void runVfsScan() {
+		namespace fs = std::filesystem;
+		if (!isSelected("vfs", "tempdir", "scan")) { return; }
+
+		std::error_code ec{};
+		fs::path root = fs::temp_directory_path(ec) / "J-Bench-vfs";
+		fs::remove_all(root, ec);
+
+		auto fail = [&](const char* op, const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "vfs", "tempdir", op, reason);
+			s_failures++;
+			fs::remove_all(root, ec);
+		};
+
+		size_t nameBytes = 0;
+		for (int32_t i = 0; i < SCAN_FOLDERS; i++) {
+			fs::path folder = root / ("Folder" + std::to_string(i)) / ("Sub" + std::to_string(i % 4));
+			fs::create_directories(folder, ec);
+			for (int32_t j = 0; j < SCAN_FILES; j++) {
+				std::string name = "File" + std::to_string(j) + ".txt";
+				nameBytes += name.length();
+				if (!writeText(folder / name, "data")) {
+					fail("scan", "couldn't create scratch files");
+					return;
+				}
+			}
+		}
+
+		const std::string rootPath = root.string();
+		const ConstSpan<char> rootSpan(rootPath.c_str(), rootPath.length());
+		DirectoryScan single{};
+		DirectoryScan scan{};
+		if (!single.scan(rootSpan, nullptr, 1) || !scan.scan(rootSpan)) {
+			fail("scan", "couldn't scan");
+			return;
+		}
+
+		run("vfs", "tempdir", "scan", nameBytes, [&]() { return scan.scan(rootSpan); });
+		if (!sameScan(single, scan)) {
+			fail("scan", "differs from a single threaded scan");
+			return;
+		}
+
+		MemoryStream snapshot(4096, true);
+		DirectoryScan loaded{};
+		if (!scan.save(snapshot) || !(snapshot.seek(0, SEEK_SET), loaded.load(snapshot)) || !sameScan(scan, loaded)) {
+			fail("snapshot", "snapshot doesn't round trip");
+			return;
+		}
+
+		DirectoryScan rescan{};
+		run("vfs", "tempdir", "rescan", nameBytes, [&]() { return rescan.scan(rootSpan, &loaded); });
+		if (!rescan.scan(rootSpan, &loaded) || !sameScan(scan, rescan) || rescan.getRescannedCount() != 0) {
+			fail("rescan", "snapshot of an unchanged tree wasn't reused");
+			return;
+		}
+
+		//A new file only changes its own directory, that one gets listed again and nothing else
+		if (!writeText(root / "Folder0" / "Sub0" / "Added.txt", "added") || !rescan.scan(rootSpan, &loaded)) {
+			fail("rescan", "couldn't rescan");
+			return;
+		}
+
+		const auto& dirs = rescan.getDirectories();
+		auto changed = std::find_if(dirs.begin(), dirs.end(), [](const ScanDir& dir) { return dir.path == "Folder0/Sub0"; });
+		bool added = changed != dirs.end() && std::any_of(changed->items.begin(), changed->items.end(), [](const ScanItem& item) { return item.name == "Added.txt"; });
+		if (!added || rescan.getRescannedCount() != 1) {
+			fail("rescan", "changed directory wasn't picked up");
+			return;
+		}
+
+		//Same through the VFS, the snapshot file written by the first build is what the second one starts from
+		const std::string snapshotPath = (fs::temp_directory_path(ec) / "J-Bench-vfs.jscan").string();
+		VFS first(rootSpan, VFS::VFS_FLAG_NONE);
+		VFS second(rootSpan, VFS::VFS_FLAG_NONE);
+		bool built = first.buildFromRoot(snapshotPath.c_str()) && second.buildFromRoot(snapshotPath.c_str());
+		fs::remove(snapshotPath, ec);
+		if (!built || first.getEntryCount() != second.getEntryCount() || !second.indexOfFileEntry("Folder0/Sub0/Added.txt").isValid()) {
+			fail("build", "VFS builds differ");
+			return;
+		}
+		fs::remove_all(root, ec);
+	}
+
+	static void runDirectoryMonitor() {
+		namespace fs = std::filesystem;
+
+		//Save storm as editors and git checkout produce it, written through a temp file, renamed in place and touched again
+		std::vector<std::string> paths{};
+		for (int32_t i = 0; i < DIRMON_PATHS; i++) {
+			paths.push_back("Assets/Folder" + std::to_string(i % 16) + "/Entry" + std::to_string(i) + ".png");
+		}
+
+		std::vector<DirectoryChange> changes{};
+		run("dirmon", "storm", "coalesce", 0, [&]() {
+			DirectoryChangeCoalescer coalescer{};
+			coalescer.setDebounce(DIRMON_DEBOUNCE_MS);
+			for (uint64_t time = 0; time < 3; time++) {
+				for (const auto& path : paths) {
+					std::string temp = path + ".tmp";
+					coalescer.push(DirectoryChange(DirectoryChange::TYPE_CREATE, temp), time);
+					coalescer.push(DirectoryChange(DirectoryChange::TYPE_MODIFIED, temp), time);
+					coalescer.push(DirectoryChange(DirectoryChange::TYPE_DELETE, path), time);
+					coalescer.push(DirectoryChange(temp, path), time);
+					coalescer.push(DirectoryChange(DirectoryChange::TYPE_MODIFIED, path), time);
+				}
+			}
+
+			//Nothing is handed out while the paths are still changing
+			changes.clear();
+			if (coalescer.flush(changes, DIRMON_DEBOUNCE_MS) > 0) { return false; }
+
+			coalescer.flush(changes, 2 + DIRMON_DEBOUNCE_MS);
+			if (changes.size() != paths.size()) { return false; }
+			for (const auto& change : changes) {
+				if (change.type != DirectoryChange::TYPE_MODIFIED) { return false; }
+			}
+			return true;
+		});
+
+		//Real files in a scratch folder, every path should be reported once with its net change
+		if (!isSelected("dirmon", "tempdir", "settle")) { return; }
+
+		std::error_code ec{};
+		fs::path root = fs::temp_directory_path(ec) / "J-Bench-dirmon";
+		fs::remove_all(root, ec);
+		fs::create_directories(root, ec);
+
+		auto fail = [&](const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "dirmon", "tempdir", "settle", reason);
+			s_failures++;
+			fs::remove_all(root, ec);
+		};
+
+		if (!writeText(root / "keep.txt", "keep") || !writeText(root / "old.txt", "old") || !writeText(root / "gone.txt", "gone")) {
+			fail("couldn't create scratch files");
+			return;
+		}
+
+		DirectoryMonitor monitor{};
+		monitor.setDebounce(DIRMON_DEBOUNCE_MS);
+		if (!monitor.tryOpen(root.string())) {
+			fail("couldn't open monitor");
+			return;
+		}
+
+		std::map<std::string, DirectoryChange::ChangeType> expected{};
+		fs::create_directories(root / "New", ec);
+		expected["New"] = DirectoryChange::TYPE_CREATE;
+		for (int32_t i = 0; i < DIRMON_FILES; i++) {
+			std::string name = "New/File" + std::to_string(i) + ".txt";
+			for (int32_t j = 0; j < 4; j++) {
+				writeText(root / name, j & 1 ? "odd" : "even");
+			}
+			expected[name] = DirectoryChange::TYPE_CREATE;
+		}
+
+		//Atomic save replacing a file the monitor had no pending change for comes out as a create or a modification
+		writeText(root / "keep.txt.tmp", "kept");
+		fs::rename(root / "keep.txt.tmp", root / "keep.txt", ec);
+		expected["keep.txt"] = DirectoryChange::TYPE_MODIFIED;
+
+		fs::rename(root / "old.txt", root / "moved.txt", ec);
+		expected["moved.txt"] = DirectoryChange::TYPE_RENAME;
+
+		fs::remove(root / "gone.txt", ec);
+		expected["gone.txt"] = DirectoryChange::TYPE_DELETE;
+
+		writeText(root / "temp.txt", "temp");
+		fs::remove(root / "temp.txt", ec);
+
+		std::map<std::string, DirectoryChange> received{};
+		bool duplicates = false;
+		uint32_t elapsed = settleChanges(monitor, expected.size(), received, duplicates);
+		monitor.close();
+
+		bool matching = received.size() == expected.size();
+		for (const auto& item : expected) {
+			auto find = received.find(item.first);
+			if (find == received.end()) {
+				matching = false;
+				break;
+			}
+
+			const DirectoryChange& change = find->second;
+			bool keep = item.first == "keep.txt" && change.type == DirectoryChange::TYPE_CREATE;
+			if ((change.type != item.second && !keep) || (change.type == DirectoryChange::TYPE_RENAME && change.pathFrom != "old.txt")) {
+				matching = false;
+				break;
+			}
+		}
+
+		if (duplicates || !matching) {
+			fail(duplicates ? "path reported more than once" : "unexpected changes");
+			return;
+		}
+
+		printf("%-14s %-9s %-15s %10u ms %10zu changes %6zu overflows\n", "dirmon", "tempdir", "settle", elapsed, received.size(), monitor.getOverflowCount());
+		fs::remove_all(root, ec);
+	}
+
+	//Enough files to overflow the OS change queue (inotify's 'max_queued_events', ReadDirectoryChangesW's buffer)
+	static size_t getOverflowFileCount() {
+		size_t queued = 16384;
+#ifndef _WIN32
+		FILE* file = fopen("/proc/sys/fs/inotify/max_queued_events", "rb");
+		if (file) {
+			unsigned long value = 0;
+			if (fscanf(file, "%lu", &value) == 1 && value > 0) {
+				queued = size_t(value);
+			}
+			fclose(file);
+		}
+#endif
+		//Every write is at least a create and a modification
+		return queued / 2 + DIRMON_FILES;
+	}
+
+	static void runDirectoryOverflow() {
+		namespace fs = std::filesystem;
+		if (!isSelected("dirmon", "overflow", "net")) { return; }
+
+		//Files the listener already heard about through events have to come out of the rescan as their net change only
+		std::error_code ec{};
+		fs::path root = fs::temp_directory_path(ec) / "J-Bench-dirmon-overflow";
+		fs::remove_all(root, ec);
+		fs::create_directories(root, ec);
+
+		auto fail = [&](const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "dirmon", "overflow", "net", reason);
+			s_failures++;
+			fs::remove_all(root, ec);
+		};
+
+		const size_t burstFiles = getOverflowFileCount();
+		if (burstFiles > DIRMON_OVERFLOW_MAX_FILES) {
+			printf("%-14s %-9s %-15s skipped (change queue fits %zu files)\n", "dirmon", "overflow", "net", burstFiles);
+			fs::remove_all(root, ec);
+			return;
+		}
+
+		DirectoryMonitor monitor{};
+		monitor.setDebounce(DIRMON_DEBOUNCE_MS);
+		if (!monitor.tryOpen(root.string())) {
+			fail("couldn't open monitor");
+			return;
+		}
+
+		std::map<std::string, DirectoryChange> received{};
+		bool duplicates = false;
+		fs::create_directories(root / "Old", ec);
+		for (int32_t i = 0; i < DIRMON_FILES; i++) {
+			writeText(root / ("Old/File" + std::to_string(i) + ".txt"), "old");
+		}
+
+		settleChanges(monitor, size_t(DIRMON_FILES) + 1, received, duplicates);
+		if (duplicates || received.size() != size_t(DIRMON_FILES) + 1 || monitor.getOverflowCount() > 0) {
+			monitor.close();
+			fail("initial files weren't reported once each");
+			return;
+		}
+
+		//The queue overflows during the creates, the old files change after that and only the rescan sees them
+		std::map<std::string, DirectoryChange::ChangeType> expected{};
+		for (size_t i = 0; i < burstFiles; i++) {
+			std::string name = "Burst" + std::to_string(i) + ".txt";
+			writeText(root / name, "burst");
+			expected[name] = DirectoryChange::TYPE_CREATE;
+		}
+
+		for (int32_t i = 0; i < DIRMON_FILES; i++) {
+			std::string name = "Old/File" + std::to_string(i) + ".txt";
+			switch (i & 3) {
+				case 0:
+					writeText(root / name, "modified");
+					expected[name] = DirectoryChange::TYPE_MODIFIED;
+					break;
+				case 1:
+					fs::remove(root / name, ec);
+					expected[name] = DirectoryChange::TYPE_DELETE;
+					break;
+				default: break;
+			}
+		}
+
+		received.clear();
+		uint32_t elapsed = settleChanges(monitor, expected.size(), received, duplicates);
+		size_t overflows = monitor.getOverflowCount();
+		monitor.close();
+
+		if (overflows < 1) {
+			fail("change queue didn't overflow");
+			return;
+		}
+
+		bool matching = received.size() == expected.size();
+		for (const auto& item : expected) {
+			auto find = received.find(item.first);
+			if (find == received.end() || find->second.type != item.second) {
+				matching = false;
+				break;
+			}
+		}
+
+		if (duplicates || !matching) {
+			fail(duplicates ? "path reported more than once" : "changes already reported came out again");
+			return;
+		}
+
+		printf("%-14s %-9s %-15s %10u ms %10zu changes %6zu overflows\n", "dirmon", "overflow", "net", elapsed, received.size(), overflows);
+		fs::remove_all(root, ec);
+	}
+
+	static void runDirectoryRootMoved() {
+		namespace fs = std::filesystem;
+		if (!isSelected("dirmon", "root", "moved")) { return; }
+
+		//Moving the monitored folder itself away has to report everything in it deleted and close the monitor
+		std::error_code ec{};
+		fs::path root = fs::temp_directory_path(ec) / "J-Bench-dirmon-root";
+		fs::path moved = fs::temp_directory_path(ec) / "J-Bench-dirmon-root-moved";
+		fs::remove_all(root, ec);
+		fs::remove_all(moved, ec);
+		fs::create_directories(root / "Sub", ec);
+
+		auto fail = [&](const char* reason) {
+			printf("%-14s %-9s %-15s FAILED (%s)\n", "dirmon", "root", "moved", reason);
+			s_failures++;
+			fs::remove_all(root, ec);
+			fs::remove_all(moved, ec);
+		};
+
+		std::map<std::string, DirectoryChange::ChangeType> expected{};
+		expected["Sub"] = DirectoryChange::TYPE_DELETE;
+		for (int32_t i = 0; i < DIRMON_FILES; i++) {
+			std::string name = (i & 1 ? "Sub/File" : "File") + std::to_string(i) + ".txt";
+			if (!writeText(root / name, "file")) {
+				fail("couldn't create scratch files");
+				return;
+			}
+			expected[name] = DirectoryChange::TYPE_DELETE;
+		}
+
+		DirectoryMonitor monitor{};
+		monitor.setDebounce(DIRMON_DEBOUNCE_MS);
+		if (!monitor.tryOpen(root.string())) {
+			fail("couldn't open monitor");
+			return;
+		}
+
+		fs::rename(root, moved, ec);
+		if (ec) {
+			monitor.close();
+			fail("couldn't move the monitored folder");
+			return;
+		}
+
+		std::map<std::string, DirectoryChange> received{};
+		bool duplicates = false;
+		uint32_t elapsed = settleChanges(monitor, expected.size(), received, duplicates);
+		bool closed = !monitor.isOpen();
+		monitor.close();
+
+		bool matching = received.size() == expected.size();
+		for (const auto& item : expected) {
+			auto find = received.find(item.first);
+			if (find == received.end() || find->second.type != item.second) {
+				matching = false;
+				break;
+			}
+		}
+
+		if (duplicates || !matching || !closed) {
+			fail(duplicates ? "path reported more than once" : !matching ? "contents weren't reported deleted" : "monitor stayed open");
+			return;
+		}
+
+		printf("%-14s %-9s %-15s %10u ms %10zu changes\n", "dirmon", "root", "moved", elapsed, received.size());
+		fs::remove_all(moved, ec);
+	}
+
+	static void parseArgs(int argc, char** argv) {
+		for (int i = 1; i < argc; i++) {
+			const char* arg = argv[i];
+			if (strncmp(arg, "--size=", 7) == 0) {
+				s_options.size = std::max(atoi(arg + 7), 4);
+			}
+			else if (strncmp(arg, "--iters=", 8) == 0) {
+				s_options.iterations = std::max(atoi(arg + 8), 1);
+			}
+			else if (strncmp(arg, "--only=", 7) == 0) {
+				s_options.only = arg + 7;
+			}
+			else {
+				printf("Unknown argument '%s'\nUsage: J-Bench [--size=N] [--iters=N] [--only=substring]\n", arg);
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace JEngine::Bench;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+	_CrtSetAllocHook(allocHook);
+#endif
+	Log::init();
+	parseArgs(argc, argv);
+
+	printf("J-Bench: %dx%d images, %d iterations per case\n\n", s_options.size, s_options.size, s_options.iterations);
+
+	SourceImage sources[] = {
+		{ "gradient", makeGradient(s_options.size) },
+		{ "noise", makeNoise(s_options.size) },
+		{ "indexed", makeIndexed(s_options.size) },
+		{ "sprite", makeSprite(s_options.size) },
+	};
+
+	std::vector<Codec> codecs = getCodecs();
+	for (const auto& codec : codecs) {
+		for (const auto& source : sources) {
+			runCodec(codec, source);
+		}
+		printf("\n");
+	}
+
+	for (const auto& source : sources) {
+		runPixelOps(source);
+	}
+	printf("\n");
+
+	runDxtDecode();
+	printf("\n");
+
+	runDxtQuality();
+	printf("\n");
+
+	runStreams();
+	printf("\n");
+
+	runBitStream();
+	printf("\n");
+
+	runWav();
+	printf("\n");
+
+	runResampler();
+	printf("\n");
+
+	runMixer();
+	printf("\n");
+
+	runAudioDevice();
+	runAudioEngine();
+	printf("\n");
+
+	runPak();
+	printf("\n");
+
+	runDeflate();
+	printf("\n");
+
+	runVFS();
+	runVfsScan();
+	printf("\n");
+
+	runLoader();
+	printf("\n");
+
+	runResidency();
+	runAssetDB();
+	printf("\n");
+
+	runXXHash();
+	runDependencies();
+	printf("\n");
+
+	runDirectoryMonitor();
+	runDirectoryOverflow();
+	runDirectoryRootMoved();
+
+	for (auto& source : sources) {
+		source.image.clear(true);
+	}
+
+	printf("\n%d failure(s)\n", s_failures);
+	return s_failures > 0 ? 1 : 0;
+}
@@ -22,6 +22,7 @@ namespace JEngine::Editor {
 
 			if (shouldBreak) { break; }
 			getTime().tick();
+			getAssetDB().update();
 
 			bool windowHasFocus = this->hasFocus();
 			bool editorFocus = _editorWin.isEditorFocused();
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <JEngine/IO/Stream.h>
+#include <JEngine/Utility/Span.h>
+
+namespace JEngine {
+    /// <summary>
+    /// Persistent graph of which assets are built from which, so a change only reimports what it actually affects.
+    /// Nodes are source relative paths, an edge from an asset to a dependency means the asset is imported after it.
+    /// <para>Every node remembers a key made from its content hash, import settings hash and the keys of its dependencies
+    /// at its last successful import. A node whose key no longer matches is dirty, along with everything depending on it.</para>
+    /// </summary>
+    class AssetDependencies {
+    public:
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        //Runs on a worker thread, fills 'dependencies' with the paths the asset references.
+        //Imports running at the same time never depend on each other.
+        typedef std::function<bool(const std::string& path, std::vector<std::string>& dependencies)> ImportFunc;
+
+        struct Node {
+            std::string path{};
+            uint64_t contentHash{ 0 };
+            uint64_t settingsHash{ 0 };
+            uint64_t importKey{ 0 };
+
+            //Kept sorted, the key doesn't depend on the order dependencies were declared in
+            std::vector<uint32_t> dependencies{};
+            std::vector<uint32_t> dependents{};
+
+            bool isValid() const { return path.length() > 0; }
+        };
+
+        AssetDependencies() : _nodes(), _freeNodes(), _index() {}
+
+        uint32_t addAsset(ConstSpan<char> path);
+        uint32_t indexOf(ConstSpan<char> path) const;
+
+        //Dependents of a removed asset lose the edge and become dirty
+        bool removeAsset(ConstSpan<char> path);
+        bool renameAsset(ConstSpan<char> from, ConstSpan<char> to);
+
+        //Both assets are added if they don't exist yet, returns false if the edge would form a cycle
+        bool addDependency(ConstSpan<char> asset, ConstSpan<char> dependency);
+        void clearDependencies(ConstSpan<char> asset);
+
+        bool setContentHash(ConstSpan<char> path, uint64_t hash);
+        bool setSettingsHash(ConstSpan<char> path, uint64_t hash);
+
+        //Rehashes 'root/path' with xxHash64, adding the asset if needed. Returns false if the file can't be read.
+        bool updateContentHash(ConstSpan<char> root, ConstSpan<char> path);
+        static bool hashFile(ConstSpan<char> path, uint64_t& hash);
+
+        bool isDirty(uint32_t node) const;
+
+        //Dirty assets and everything that transitively depends on them, dependencies always come before their dependents.
+        //Returns false if some of them form a cycle, those are left out.
+        bool collectReimports(std::vector<uint32_t>& order) const;
+
+        //Imports what 'collectReimports' would return one topological level at a time, each level in parallel.
+        //Declared dependencies replace the old ones. Dependents of a failed import are skipped and stay dirty.
+        //Returns the amount of successful imports.
+        size_t reimport(const ImportFunc& import, uint32_t threads = 0);
+
+        bool save(const Stream& stream) const;
+        bool load(const Stream& stream);
+        void clear();
+
+        const Node* getNode(uint32_t index) const { return index < _nodes.size() && _nodes[index].isValid() ? &_nodes[index] : nullptr; }
+        size_t getNodeCount() const { return _nodes.size() - _freeNodes.size(); }
+
+    private:
+        std::vector<Node> _nodes;
+        std::vector<uint32_t> _freeNodes;
+
+        //Lower case and '/' separated, the same file can be reported with different casing
+        std::unordered_map<std::string, uint32_t> _index;
+
+        static std::string toKey(ConstSpan<char> path);
+
+        uint64_t computeKey(const Node& node) const;
+        bool dependsOn(uint32_t node, uint32_t dependency) const;
+        void unlinkDependencies(uint32_t node);
+        bool collectLevels(std::vector<std::vector<uint32_t>>& levels) const;
+    };
+}
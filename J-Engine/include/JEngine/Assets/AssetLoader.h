@@ -0,0 +1,145 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <JEngine/IO/ImageUtils.h>
+#include <JEngine/IO/AudioUtils.h>
+#include <JEngine/Utility/Span.h>
+
+namespace JEngine {
+    enum class LoadPriority : uint8_t {
+        //Waited on right away, ignores the byte budget
+        Blocking,
+        //Needed for something on screen
+        Visible,
+        //Speculative, only runs when nothing more important is queued
+        Prefetch,
+
+        Count
+    };
+
+    enum class LoadType : uint8_t {
+        Raw,
+        Image,
+        Audio,
+        Serialized,
+    };
+
+    enum class LoadState : uint8_t {
+        Queued,
+        Loading,
+        Done,
+        Failed,
+        Cancelled,
+    };
+
+    struct LoadResult {
+        uint64_t id{ 0 };
+        LoadType type{ LoadType::Raw };
+        LoadState state{ LoadState::Queued };
+        std::string path{};
+
+        //File contents for 'Raw', released after decoding for every other type
+        std::vector<uint8_t> bytes{};
+
+        //Callbacks can take ownership of these, whatever is left is freed after the callback returns
+        ImageData image{};
+        AudioData audio{};
+        nlohmann::json serialized{};
+
+        LoadResult() = default;
+        LoadResult(const LoadResult& other) = delete;
+        LoadResult& operator=(const LoadResult& other) = delete;
+
+        bool succeeded() const { return state == LoadState::Done; }
+        size_t getMemorySize() const;
+    };
+
+    //What a reader hands to the decoder, either owned 'bytes' or a 'view' that 'keepAlive' keeps valid (e.g. a file mapping).
+    //Both are released once the request is decoded.
+    struct LoadSource {
+        std::vector<uint8_t> bytes{};
+        ConstSpan<uint8_t> view{};
+        std::shared_ptr<const void> keepAlive{};
+
+        ConstSpan<uint8_t> getData() const { return view.get() ? view : ConstSpan<uint8_t>(bytes.data(), bytes.size()); }
+    };
+
+    /// <summary>
+    /// Reads and decodes assets on a pool of worker threads, results are handed back on the main thread through 'update'.
+    /// Requests are served by priority (FIFO within a priority) and the bytes held by requests that are loading
+    /// or waiting for their callback are kept under a budget, a single request larger than the budget still runs on its own.
+    /// </summary>
+    class AssetLoader {
+    public:
+        typedef std::function<bool(LoadSource&)> Reader;
+        typedef std::function<void(LoadResult&)> Callback;
+
+        static constexpr uint64_t INVALID_ID = 0;
+        static constexpr size_t DEFAULT_BUDGET = 256ULL * 1024 * 1024;
+
+        AssetLoader();
+        AssetLoader(uint32_t threads, size_t byteBudget = DEFAULT_BUDGET);
+        ~AssetLoader();
+
+        AssetLoader(const AssetLoader& other) = delete;
+        AssetLoader& operator=(const AssetLoader& other) = delete;
+
+        //'threads' of 0 uses every core but one, the main thread is expected to stay busy
+        bool start(uint32_t threads = 0, size_t byteBudget = DEFAULT_BUDGET);
+        void stop();
+        bool isRunning() const { return _workers.size() > 0; }
+
+        //'sizeHint' is what's reserved from the budget before reading, the reservation is corrected once the data is in
+        uint64_t load(ConstSpan<char> path, LoadType type, LoadPriority priority, Callback callback);
+        uint64_t load(ConstSpan<char> path, Reader reader, size_t sizeHint, LoadType type, LoadPriority priority, Callback callback);
+
+        //Queued requests are dropped right away, ones already loading skip decoding.
+        //Either way the callback still runs with 'LoadState::Cancelled' so owners can clean up.
+        bool cancel(uint64_t id);
+
+        //Blocks until the request is finished and runs its callback, returns false if the ID isn't pending
+        bool wait(uint64_t id);
+
+        //Delivers finished requests, call from the main thread. Returns the amount of callbacks run.
+        size_t update(size_t maxCallbacks = SIZE_MAX);
+
+        //IDs that were already delivered (or never existed) report 'LoadState::Cancelled'
+        LoadState getState(uint64_t id) const;
+        size_t getPendingCount() const;
+        size_t getInFlightBytes() const;
+        size_t getByteBudget() const { return _byteBudget; }
+
+    private:
+        struct Request;
+
+        mutable std::mutex _mutex;
+        std::condition_variable _workCV;
+        std::condition_variable _doneCV;
+
+        std::vector<std::thread> _workers;
+        bool _running;
+
+        uint64_t _nextID;
+        size_t _byteBudget;
+        size_t _inFlightBytes;
+
+        std::unordered_map<uint64_t, std::unique_ptr<Request>> _requests;
+        std::deque<Request*> _queues[size_t(LoadPriority::Count)];
+        std::vector<Request*> _completed;
+
+        Request* popNext();
+        void workerLoop();
+        void process(Request& request);
+        void deliver(Request* request);
+    };
+}
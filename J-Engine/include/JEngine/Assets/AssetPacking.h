@@ -1,12 +1,148 @@
 #pragma once
 #include <string>
-#include <fstream>
-#include <JEngine/IO/VFS/FileEntry.h>
+#include <vector>
+#include <JEngine/Platform.h>
+#include <JEngine/IO/Stream.h>
+#include <JEngine/IO/MappedFile.h>
+#include <JEngine/Utility/Span.h>
 #include <JEngine/Utility/Version.h>
 
 namespace JEngine::AssetPacking {
     static constexpr const char* PakExtension = ".jpak";
-    static const JVersion PakVersion = JVersion(0, 0, 0);
+    //Readers only accept their own major version, entry codecs older readers don't know about need a new one
+    static const JVersion PakVersion = JVersion(2, 0, 0);
 
-    //const bool packAssets(const FileEntry& folder, std::ofstream& stream, const uint32_t flags = 0U);
+    //Payloads start on this boundary (relative to the pak start) so raw entries can be used straight from a mapping
+    static constexpr uint32_t PakAlignment = 4096;
+
+    enum : uint32_t {
+        PAK_FLAG_NONE        = 0x00,
+        PAK_FLAG_COMPRESS    = 0x01,
+        PAK_FLAG_MULTITHREAD = 0x02,
+        //Entries are compressed with LZ4 instead of zlib, bigger but a lot faster to load
+        PAK_FLAG_FAST        = 0x04,
+    };
+
+    enum : uint16_t {
+        PAK_ENTRY_RAW  = 0x00,
+        PAK_ENTRY_ZLIB = 0x01,
+        PAK_ENTRY_LZ4  = 0x02,
+
+        PAK_ENTRY_CODEC_MASK = PAK_ENTRY_ZLIB | PAK_ENTRY_LZ4,
+    };
+
+JE_BEG_PACK
+    struct PakHeader {
+        uint32_t signature;
+        JVersion version;
+        uint32_t entryCount;
+        uint32_t alignment;
+        uint64_t tocOffset;
+        uint64_t namesOffset;
+        uint64_t namesSize;
+    };
+
+    //The table is sorted by 'hash' (IO::hashPath, case insensitive), names are '/' separated without a terminator.
+    //'crc' is the CRC32 of the uncompressed data.
+    struct PakEntry {
+        uint64_t hash;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t rawSize;
+        uint32_t crc;
+        uint32_t nameOffset;
+        uint16_t nameLength;
+        uint16_t flags;
+        uint32_t reserved;
+
+        bool isCompressed() const { return (flags & PAK_ENTRY_CODEC_MASK) != 0; }
+    };
+JE_END_PACK
+
+    struct PakSource {
+        std::string name{};
+        std::string path{};
+
+        PakSource() = default;
+        PakSource(ConstSpan<char> name, ConstSpan<char> path) : name(name.get(), name.length()), path(path.get(), path.length()) {}
+    };
+
+    //Writes payloads as they're added and the table of contents in 'end',
+    //the header is patched last so the target stream has to be seekable.
+    class PakWriter {
+    public:
+        PakWriter();
+
+        PakWriter(const PakWriter& other) = delete;
+        PakWriter& operator=(const PakWriter& other) = delete;
+
+        bool begin(const Stream& stream, uint32_t flags = PAK_FLAG_COMPRESS, int32_t compression = 6);
+        bool end();
+
+        bool addEntry(ConstSpan<char> name, const void* data, size_t size);
+        bool addFile(ConstSpan<char> name, ConstSpan<char> path);
+
+        //Files are read and compressed in batches, on multiple threads if 'PAK_FLAG_MULTITHREAD' is set
+        bool addFiles(const std::vector<PakSource>& files);
+
+        size_t getEntryCount() const { return _entries.size(); }
+
+    private:
+        struct Payload;
+
+        const Stream* _stream;
+        size_t _start;
+        uint32_t _flags;
+        int32_t _compression;
+        std::vector<PakEntry> _entries;
+        std::string _names;
+
+        bool prepare(const void* data, size_t size, Payload& payload) const;
+        bool writePayload(ConstSpan<char> name, const Payload& payload);
+    };
+
+    //Read-only pak, the file is mapped and the table is used in place so lookups cost no IO
+    //and raw entries can be viewed without copying.
+    class PakFile {
+    public:
+        PakFile();
+        PakFile(const char* path);
+
+        PakFile(const PakFile& other) = delete;
+        PakFile(PakFile&& other) noexcept;
+
+        PakFile& operator=(const PakFile& other) = delete;
+        PakFile& operator=(PakFile&& other) noexcept;
+
+        bool open(const char* path);
+        void close();
+
+        bool isOpen() const { return _file.isOpen(); }
+        const std::string& getFilePath() const { return _path; }
+
+        size_t getEntryCount() const { return _entryCount; }
+        const PakEntry* getEntry(size_t index) const { return index < _entryCount ? _entries + index : nullptr; }
+        ConstSpan<char> getName(const PakEntry& entry) const { return ConstSpan<char>(_names + entry.nameOffset, entry.nameLength); }
+
+        //Returns SIZE_MAX if the path isn't in the pak, a leading '/' is ignored
+        size_t indexOf(ConstSpan<char> path) const;
+        const PakEntry* find(ConstSpan<char> path) const { return getEntry(indexOf(path)); }
+
+        //Stored bytes of the entry (still deflated if compressed), valid until the pak is closed
+        Span<const uint8_t> view(const PakEntry& entry) const;
+
+        bool read(const PakEntry& entry, void* buffer, size_t bufferSize, bool verifyCRC = false) const;
+        bool read(const PakEntry& entry, std::vector<uint8_t>& data, bool verifyCRC = false) const;
+        bool verify(const PakEntry& entry) const;
+
+    private:
+        MappedFile _file;
+        std::string _path;
+        const PakEntry* _entries;
+        const char* _names;
+        size_t _entryCount;
+    };
+
+    bool packAssets(ConstSpan<char> root, const Stream& stream, uint32_t flags = PAK_FLAG_COMPRESS, int32_t compression = 6);
+    bool packAssets(ConstSpan<char> root, ConstSpan<char> path, uint32_t flags = PAK_FLAG_COMPRESS, int32_t compression = 6);
 }
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <JEngine/Core/Ref.h>
+
+namespace JEngine {
+    struct ResidencyStats {
+        //Matches the 7 bit source and 8 bit type fields of 'AssetRef'
+        static constexpr size_t MAX_SOURCES = 128;
+        static constexpr size_t MAX_TYPES = 256;
+
+        size_t residentBytes{ 0 };
+        size_t residentCount{ 0 };
+
+        //Resident assets something still holds a reference to, these can't be evicted
+        size_t referencedBytes{ 0 };
+        size_t referencedCount{ 0 };
+
+        size_t evictedBytes{ 0 };
+        size_t evictedCount{ 0 };
+
+        size_t sourceBytes[MAX_SOURCES]{};
+        uint32_t sourceCount[MAX_SOURCES]{};
+        size_t typeBytes[MAX_TYPES]{};
+        uint32_t typeCount[MAX_TYPES]{};
+    };
+
+    /// <summary>
+    /// Reference counts and byte accounting for loaded assets, unreferenced ones are evicted least recently used first
+    /// once the total or a per source budget is exceeded. Not thread safe, meant to be driven from the main thread by 'AssetDB'.
+    /// </summary>
+    class AssetResidency {
+    public:
+        //Returns false if the asset couldn't be unloaded, it's then kept around as if it was just used.
+        //Without a callback nothing is ever evicted.
+        typedef std::function<bool(AssetRef)> EvictCallback;
+
+        static constexpr size_t NO_BUDGET = SIZE_MAX;
+
+        AssetResidency();
+
+        void setEvictCallback(EvictCallback callback) { _evict = std::move(callback); }
+
+        void setBudget(size_t bytes);
+        size_t getBudget() const { return _budget; }
+
+        void setSourceBudget(uint8_t source, size_t bytes);
+        size_t getSourceBudget(uint8_t source) const { return source < ResidencyStats::MAX_SOURCES ? _sourceBudgets[source] : NO_BUDGET; }
+
+        //Called once an asset is loaded or its size changes, may evict other assets to stay in budget
+        void setResident(AssetRef ref, size_t bytes);
+        //Called when an asset was unloaded by something other than eviction
+        void setUnloaded(AssetRef ref);
+        bool isResident(AssetRef ref) const;
+
+        //Assets can be referenced before they're resident, the count is kept through the load
+        uint32_t acquire(AssetRef ref);
+        uint32_t release(AssetRef ref);
+        uint32_t getRefCount(AssetRef ref) const;
+
+        //Marks an unreferenced asset as the most recently used one
+        void touch(AssetRef ref);
+
+        //Evicts until every budget is met, returns the amount of bytes freed
+        size_t trim();
+        //Evicts every unreferenced asset
+        size_t evictUnreferenced();
+
+        const ResidencyStats& getStats() const { return _stats; }
+        void clear();
+
+    private:
+        struct Entry {
+            size_t bytes{ 0 };
+            uint32_t refs{ 0 };
+            bool resident{ false };
+
+            //When the asset was last linked, used to pick the oldest one between sources
+            uint64_t stamp{ 0 };
+
+            //Only unreferenced resident assets are linked, ordered from least to most recently used per source
+            uint64_t prev{ detail::NULL_ASSET };
+            uint64_t next{ detail::NULL_ASSET };
+        };
+
+        struct LRUList {
+            uint64_t head{ detail::NULL_ASSET };
+            uint64_t tail{ detail::NULL_ASSET };
+            size_t count{ 0 };
+        };
+
+        std::unordered_map<uint64_t, Entry> _entries;
+        LRUList _lru[ResidencyStats::MAX_SOURCES];
+        uint64_t _tick;
+
+        size_t _budget;
+        size_t _sourceBudgets[ResidencyStats::MAX_SOURCES];
+        ResidencyStats _stats;
+        EvictCallback _evict;
+        bool _evicting;
+
+        void link(uint64_t key, Entry& entry);
+        void unlink(uint64_t key, Entry& entry);
+
+        void addBytes(uint64_t key, const Entry& entry, bool add);
+        void addReferenced(const Entry& entry, bool add);
+
+        uint64_t pickOldest() const;
+        bool evict(uint64_t key);
+    };
+}
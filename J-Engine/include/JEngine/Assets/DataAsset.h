@@ -14,6 +14,7 @@ namespace JEngine {
 
         virtual ~DataAsset() override;
         virtual bool unload() override;
+        virtual size_t getMemorySize() const override { return _length; }
 
         DataType getDataType() const { return _type; }
         size_t getDataLength() const { return _length; }
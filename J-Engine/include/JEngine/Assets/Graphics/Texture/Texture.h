@@ -5,6 +5,9 @@
 #include <JEngine/Utility/Flags.h>
 #include <JEngine/Math/Units/JVector.h>
 #include <JEngine/IO/ImageUtils.h>
+#include <JEngine/Assets/AssetLoader.h>
+#include <functional>
+#include <memory>
 
 namespace JEngine {
     class Texture : public IAsset {
@@ -20,6 +23,8 @@ namespace JEngine {
         Texture(Texture&& other) noexcept;
         ~Texture() noexcept;
 
+        size_t getMemorySize() const override { return calculateTextureSize(_width, _height, _format, _paletteSize); }
+
         TextureFormat getFormat() const { return _format; }
         FilterMode getFilter() const { return _filter; }
 
@@ -77,23 +82,9 @@ namespace JEngine {
         void releasePalette();
     };
 
-    enum : uint8_t {
-        TEX_GEN_FREE,
-        TEX_GEN_IDLE,
-        TEX_GEN_WAIT,
-        TEX_GEN_PROCESSING,
-    };
-
-    static constexpr size_t MAX_TEXTURES_QUEUED{ 16 };
-    struct TextureGenState {
-        std::shared_ptr<Texture>* texture{};
-        ImageData data{};
-        uint8_t state{ TEX_GEN_IDLE };
-    };
-
-    void waitForTexGen(int32_t index, size_t sleepFor = 100);
-    bool shouldWaitForTexGen(int32_t index);
-
-    int32_t setupTexGen(std::shared_ptr<Texture>& texture, const ImageData& data);
-    void updateTexGen();
+    /// <summary>
+    /// Decodes the image on the loader's workers, the texture itself is created on the main thread when 'AssetLoader::update' delivers it.
+    /// 'onLoaded' gets a null texture if loading failed or was cancelled.
+    /// </summary>
+    uint64_t loadTextureAsync(AssetLoader& loader, ConstSpan<char> path, LoadPriority priority, std::function<void(std::shared_ptr<Texture>)> onLoaded);
 }
\ No newline at end of file
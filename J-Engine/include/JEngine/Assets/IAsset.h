@@ -16,6 +16,9 @@ namespace JEngine {
             }
             return false;
         }
+
+        //Bytes held while loaded, used for residency budgets
+        virtual size_t getMemorySize() const { return 0; }
     protected:
         friend class AssetDB;
 
@@ -3,6 +3,7 @@
 #include <JEngine/Assets/Import/ImportSettings.h>
 #include <JEngine/Audio/BeatMap.h>
 #include <JEngine/Audio/AudioClip.h>
+#include <JEngine/Audio/Resampler.h>
 
 namespace JEngine {
     struct BeatMapSettings {
@@ -26,9 +27,17 @@ namespace JEngine {
             F_USE_BEATS = 0x8,
         };
 
+        //Sample rate clips are stored at when F_CONVERT_SAMPLE_RATE is set, the engine mixes at 48 kHz
+        static constexpr uint32_t DEFAULT_SAMPLE_RATE = 48000;
+
         UI8Flags flags{};
+        uint32_t sampleRate{ DEFAULT_SAMPLE_RATE };
+        ResampleQuality quality{ ResampleQuality::Sinc };
         AudioSection sections[AudioClip::MAX_SECTION_COUNT];
 
+        //Resamples 'audio' in place if the settings ask for it, so clips don't have to be converted during playback
+        bool convertSampleRate(AudioData& audio) const;
+
         bool deserialize(const yamlNode& node) override;
         bool serialize(yamlEmit& node) const override;
 
@@ -37,14 +46,18 @@ namespace JEngine {
 
         void reset() override {
             flags = F_NONE;
+            sampleRate = DEFAULT_SAMPLE_RATE;
+            quality = ResampleQuality::Sinc;
         }
 
         void copyFrom(const AudioImportSettings& other) override { 
             flags = other.flags;
+            sampleRate = other.sampleRate;
+            quality = other.quality;
             memcpy(sections, other.sections, sizeof(sections));
         }
         bool hasChanged(const AudioImportSettings& other) const override { 
-            return other.flags != flags;
+            return other.flags != flags || other.sampleRate != sampleRate || other.quality != quality;
         }
     };
 }
\ No newline at end of file
@@ -37,6 +37,7 @@ JE_END_PACK
 
         ~AudioClip();
         bool unload() override;
+        size_t getMemorySize() const override { return _audioData.data ? _audioData.calculateSize() : 0; }
 
         uint32_t getSampleRate() const {
             return _audioData.sampleRate;
@@ -66,6 +67,9 @@ JE_END_PACK
 
         const AudioData& getAudioData() const { return _audioData; }
 
+        //Takes over the buffer of audio decoded or generated at runtime, 'data' is left empty
+        void setAudioData(AudioData& data);
+
         bool isLayered() const { return (_counts.data & 0xF) != 0; }
         bool isSectioned() const { return (_counts.data & 0xF0) != 0; }
 
@@ -0,0 +1,126 @@
+#pragma once
+#ifdef _WIN32
+#include <xaudio2.h>
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <JEngine/IO/Audio.h>
+
+namespace JEngine {
+    //Where the mixer thread sends audio, always interleaved stereo floats. The mixer thread waits in 'waitForBuffer'
+    //until the device can take another 'getBufferFrames' frames, mixes them and hands them to 'submit'.
+    //Only the mixer thread touches a device while it's running.
+    class IAudioDevice {
+    public:
+        static constexpr uint32_t CHANNELS = 2;
+
+        virtual ~IAudioDevice() {}
+
+        virtual bool open(uint32_t sampleRate, uint32_t bufferFrames) = 0;
+        virtual void close() = 0;
+        bool isOpen() const { return _isOpen; }
+
+        //Blocks until another buffer can be submitted, returns false once the device won't take any more audio
+        virtual bool waitForBuffer() = 0;
+
+        //Returns the frames the device took, 0 if it's still full and the same block has to be offered again.
+        //A device that fails closes itself.
+        virtual size_t submit(const float* samples, size_t frames) = 0;
+
+        uint32_t getSampleRate() const { return _sampleRate; }
+        uint32_t getBufferFrames() const { return _bufferFrames; }
+
+        //Safe to read from other threads
+        uint64_t getFramesSubmitted() const { return _framesSubmitted.load(std::memory_order_relaxed); }
+
+    protected:
+        bool _isOpen{ false };
+        uint32_t _sampleRate{ 0 };
+        uint32_t _bufferFrames{ 0 };
+        std::atomic<uint64_t> _framesSubmitted{ 0 };
+
+        void begin(uint32_t sampleRate, uint32_t bufferFrames) {
+            _isOpen = true;
+            _sampleRate = sampleRate;
+            _bufferFrames = bufferFrames;
+            _framesSubmitted.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    //Takes audio at the rate real hardware would and throws it away, for servers and machines without audio.
+    //Keeps one buffer ahead of the clock like a device's queue would.
+    class NullAudioDevice : public IAudioDevice {
+    public:
+        bool open(uint32_t sampleRate, uint32_t bufferFrames) override;
+        void close() override;
+
+        bool waitForBuffer() override;
+        size_t submit(const float* samples, size_t frames) override;
+
+    private:
+        std::chrono::steady_clock::time_point _start{};
+    };
+
+    //Renders as fast as the mixer can go into a WAV file on 'stream', which has to stay valid until the device closes.
+    //Stops taking audio after 'frameLimit' frames.
+    class OfflineAudioDevice : public IAudioDevice {
+    public:
+        OfflineAudioDevice(const Stream& stream, uint64_t frameLimit, AudioSampleType type = AudioSampleType::Float, uint8_t depth = 32);
+        ~OfflineAudioDevice();
+
+        bool open(uint32_t sampleRate, uint32_t bufferFrames) override;
+        void close() override;
+
+        bool waitForBuffer() override;
+        size_t submit(const float* samples, size_t frames) override;
+
+    private:
+        const Stream* _stream;
+        uint64_t _frameLimit;
+        AudioSampleType _type;
+        uint8_t _depth;
+        Wav::WavWriter _writer;
+    };
+
+#ifdef _WIN32
+    //Streams into a single XAudio2 source voice through a small ring of buffers
+    class XAudio2Device : public IAudioDevice {
+    public:
+        static constexpr uint32_t BUFFER_COUNT = 3;
+
+        XAudio2Device();
+        ~XAudio2Device();
+
+        bool open(uint32_t sampleRate, uint32_t bufferFrames) override;
+        void close() override;
+
+        bool waitForBuffer() override;
+        size_t submit(const float* samples, size_t frames) override;
+
+    private:
+        struct VoiceCallback : IXAudio2VoiceCallback {
+            HANDLE bufferEnd{ nullptr };
+
+            void STDMETHODCALLTYPE OnBufferEnd(void* bufferContext) override { SetEvent(bufferEnd); }
+
+            void STDMETHODCALLTYPE OnBufferStart(void* bufferContext) override {}
+            void STDMETHODCALLTYPE OnLoopEnd(void* bufferContext) override {}
+            void STDMETHODCALLTYPE OnVoiceError(void* bufferContext, HRESULT error) override {}
+            void STDMETHODCALLTYPE OnStreamEnd() override {}
+            void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 samplesReq) override {}
+            void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+        };
+
+        IXAudio2* _xEngine;
+        IXAudio2MasteringVoice* _xMaster;
+        IXAudio2SourceVoice* _xSource;
+        VoiceCallback _callback;
+        bool _comInit;
+
+        std::vector<float> _buffers;
+        uint32_t _nextBuffer;
+    };
+#endif
+}
@@ -1,76 +1,116 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
-#include <xaudio2.h>
+#include <thread>
 #include <vector>
 #include <JEngine/Audio/IAudioSource.h>
-#include <JEngine/Collections/PoolAllocator.h>
+#include <JEngine/Audio/AudioMixer.h>
+#include <JEngine/Audio/AudioDevice.h>
+#include <JEngine/Collections/SPSCQueue.h>
 
 namespace JEngine {
+    //Mixes every playing source on its own thread into an IAudioDevice a few milliseconds at a time.
+    //The game thread never touches the mixer's voices, 'play', 'stop' and 'update' send commands through a lock-free
+    //queue and read positions back from atomics. Clips have to stay loaded while a source plays them.
     class AudioEngine {
     public:
         static constexpr uint32_t AUDIO_SAMPLE_RATE = 48000;
-        static constexpr uint32_t AUDIO_CHANNELS = 2;
+        static constexpr uint32_t AUDIO_CHANNELS = IAudioDevice::CHANNELS;
         static constexpr uint32_t AUDIO_BIT_DEPTH = 32;
-        static constexpr uint16_t AUDIO_FORMAT = WAVE_FORMAT_IEEE_FLOAT;
         static constexpr int32_t MAX_VOICES = 64;
-        static constexpr size_t AUDIO_BUFFER_SIZE = (AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * (AUDIO_BIT_DEPTH >> 3));
 
-    private:
+        //One mixer block, ~5.3 ms at 48 kHz
+        static constexpr uint32_t AUDIO_BUFFER_FRAMES = uint32_t(AudioMixer::BLOCK_FRAMES);
+        static constexpr size_t COMMAND_CAPACITY = 256;
 
-        struct VoiceBuffer {
-            uint8_t buffer[AUDIO_BUFFER_SIZE]{};
-        };
+        AudioEngine();
+        ~AudioEngine();
 
-        typedef PoolAllocator<VoiceBuffer, 1> VoiceBufferAllocator;
+        AudioEngine(const AudioEngine& other) = delete;
+        AudioEngine& operator=(const AudioEngine& other) = delete;
 
-        struct VoiceCallback : IXAudio2VoiceCallback { 
-            void STDMETHODCALLTYPE OnBufferStart(void* bufferContext) override;
-            void STDMETHODCALLTYPE OnBufferEnd(void* bufferContext) override;
+        //Opens 'device' and starts the mixer thread, the device has to outlive the engine or the next 'stop'
+        bool start(IAudioDevice& device, uint32_t bufferFrames = AUDIO_BUFFER_FRAMES);
 
-            void STDMETHODCALLTYPE OnLoopEnd(void* bufferContext) override {};
+        //Stops the mixer thread and closes the device
+        void stop();
 
-            void STDMETHODCALLTYPE OnVoiceError(void* bufferContext, HRESULT error) override {};
-            void STDMETHODCALLTYPE OnStreamEnd() override {};
-            void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 samplesReq) override {};
-            void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {};
-        };
+        //Waits until the device stops taking audio on its own (an offline device reaching its frame limit), then closes it
+        void finish();
 
-        struct Voice {
-        public:
-            Voice() : _xBuffer{}, _dBuffer{} {
-                static VoiceCallback vcb;
-                _xBuffer.pContext = this;
-                _xBuffer.PlayBegin = 0;
-            }
+        bool isRunning() const { return _running.load(std::memory_order_acquire); }
+        IAudioDevice* getDevice() const { return _device; }
 
-            bool play(IAudioSource* aSource, VoiceBufferAllocator& allocator);
-            bool update();
+        //Game thread only. Commands sent before 'start' are picked up by the first buffer.
+        bool play(IAudioSource& source);
+        bool stop(IAudioSource& source);
+        bool isPlaying(const IAudioSource& source) const;
 
-        private:
-            friend struct VoiceCallback;
+        //Sends volume/pan/pitch/time changes of playing sources and reads their positions back
+        void update();
 
-            VoiceBuffer* _dBuffer{nullptr};
-            XAUDIO2_BUFFER _xBuffer{};
-            IXAudio2SourceVoice* _source{ nullptr };
-            IAudioSource* _aSource{nullptr};
+    private:
+        static constexpr uint8_t NO_VOICE = 0xFF;
+        static constexpr uint8_t SOURCE_CHANGED_FLAGS =
+            IAudioSource::AS_FLAG_CHANGED_TIME | IAudioSource::AS_FLAG_CHANGED_PITCH | IAudioSource::AS_FLAG_CHANGED_VOLUME;
+
+        enum class CommandType : uint8_t {
+            Play,
+            Stop,
+            Params,
+        };
 
-            int64_t _currentSample{};
-            int64_t _currentLength{};
+        struct Command {
+            CommandType type{ CommandType::Play };
+            uint8_t voice{ 0 };
+            uint8_t layers{ 1 };
+            bool seek{ false };
+            uint32_t playId{ 0 };
+            const AudioData* data{ nullptr };
+            uint64_t position{ 0 };
+            float pitch{ 1.0f };
+            float targets[MixVoice::MAX_LAYERS * 2]{};
+        };
+
+        //Written by the mixer thread, 'started'/'ended' hold the play id the mixer last started/finished on the voice
+        struct VoiceState {
+            std::atomic<uint64_t> position{ 0 };
+            std::atomic<uint32_t> started{ 0 };
+            std::atomic<uint32_t> ended{ 0 };
+        };
 
-            void mixAudioSource();
-            void submitBuffer(float time);
+        //Game thread side of a voice
+        struct VoiceSlot {
+            IAudioSource* source{ nullptr };
+            uint32_t playId{ 0 };
         };
 
-        WAVEFORMATEX _format;
-        IXAudio2* _xEngine;
-        IXAudio2MasteringVoice* _xMaster;
+        IAudioDevice* _device;
+        std::thread _thread;
+        std::atomic<bool> _running;
+        std::atomic<bool> _stopRequested;
 
-        Voice _allVoices[MAX_VOICES]{};
+        SPSCQueue<Command, COMMAND_CAPACITY> _commands;
+
+        VoiceSlot _slots[MAX_VOICES]{};
+        VoiceState _states[MAX_VOICES]{};
         std::vector<uint8_t> _idleVoices{};
         std::vector<uint8_t> _activeVoices{};
-        VoiceBufferAllocator _buffers{};
 
-        AudioEngine();
-        ~AudioEngine();
+        //Mixer thread only
+        AudioMixer _mixer;
+        MixVoice _voices[MAX_VOICES]{};
+        uint32_t _voiceIds[MAX_VOICES]{};
+        std::vector<uint8_t> _mixing{};
+        std::vector<float> _bus{};
+
+        bool send(const Command& command);
+        void releaseVoice(size_t index);
+        static bool setupCommand(const IAudioSource& source, Command& command);
+
+        void mixerLoop();
+        void processCommands();
+        void mixBuffer(size_t frames);
+        void join();
     };
-}
\ No newline at end of file
+}
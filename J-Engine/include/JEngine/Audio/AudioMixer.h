@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <JEngine/IO/AudioUtils.h>
+#include <JEngine/Audio/Resampler.h>
+
+namespace JEngine {
+
+    //Playback state of one source, the mixer reads 'data' from 'position' and moves it forward.
+    //A clip's channels are split evenly between its layers, so every layer is either mono or stereo.
+    //Clips at another sample rate than the mixer or with a pitch other than 1 go through the resampler,
+    //'fraction' is how far past 'position' the voice is in 1/2^32ths of a frame.
+    struct MixVoice {
+        static constexpr size_t MAX_LAYERS = 16;
+
+        const AudioData* data{ nullptr };
+        uint64_t position{ 0 };
+        uint32_t fraction{ 0 };
+        float pitch{ 1.0f };
+        ResampleQuality quality{ ResampleQuality::Sinc };
+        uint8_t layers{ 1 };
+
+        //Left/right gain pairs per layer, 'gains' ramps to 'targets' over the next block so changes don't click
+        float gains[MAX_LAYERS * 2]{};
+        float targets[MAX_LAYERS * 2]{};
+
+        void setTarget(size_t layer, float left, float right) {
+            targets[layer * 2 + 0] = left;
+            targets[layer * 2 + 1] = right;
+        }
+
+        //Jumps straight to the targets, for voices that should start at full volume
+        void snapGains() {
+            memcpy(gains, targets, sizeof(gains));
+        }
+    };
+
+    //Mixes sources into an interleaved stereo float bus a block at a time. Each block of a source is converted
+    //to floats in one call, resampled if needed and then scaled and accumulated with the SIMD kernels from AudioUtils,
+    //instead of going through a conversion per sample. Holds the scratch buffers, so use one per mixing thread.
+    class AudioMixer {
+    public:
+        static constexpr size_t BLOCK_FRAMES = 256;
+        static constexpr size_t MAX_CHANNELS = MixVoice::MAX_LAYERS * 2;
+
+        //Source frames converted per block, high pitches get shorter blocks to stay within this
+        static constexpr size_t INPUT_FRAMES = BLOCK_FRAMES * 4 + Resampler::TAPS;
+
+        AudioMixer(uint32_t sampleRate = 48000);
+
+        uint32_t getSampleRate() const { return _sampleRate; }
+
+        //Whether the sample format and channel layout of 'data' can be mixed
+        static bool isSupported(const AudioData& data, uint8_t layers = 1);
+
+        //Adds up to 'frames' frames of 'voice' to 'output' and advances it, returns the number of frames mixed.
+        //Less than 'frames' means the voice reached the end of its data.
+        size_t mix(MixVoice& voice, float* output, size_t frames);
+
+    private:
+        uint32_t _sampleRate;
+        Resampler _resampler;
+        std::vector<float> _samples;
+        std::vector<float> _layer;
+        std::vector<float> _resampled;
+
+        static bool isAudible(const MixVoice& voice);
+
+        void mixDirect(MixVoice& voice, float* output, size_t frames);
+        size_t mixResampled(MixVoice& voice, float* output, size_t frames, uint64_t step);
+
+        //Scales and adds every layer of 'inputFrames' converted frames, resampling them from 'position' if 'resample' is set
+        void mixLayers(MixVoice& voice, size_t inputFrames, uint64_t position, bool resample, float* output, size_t frames);
+    };
+}
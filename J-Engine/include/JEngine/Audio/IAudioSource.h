@@ -59,19 +59,27 @@ namespace JEngine {
         }
         float getPitch() const { return _pitch; }
 
-        void setVolume(float volume) { _volume = volume > 1.0f ? 1.0f : volume < 0.0f ? 0.0f : volume; }
+        void setVolume(float volume) {
+            _volume = volume > 1.0f ? 1.0f : volume < 0.0f ? 0.0f : volume;
+            _asFlags |= AS_FLAG_CHANGED_VOLUME;
+        }
         float getVolume() const { return _volume; }  
         
-        void setPan(float pan) { _pan = pan > 1.0f ? 1.0f : pan < -1.0f ? -1.0f : pan; }
+        void setPan(float pan) {
+            _pan = pan > 1.0f ? 1.0f : pan < -1.0f ? -1.0f : pan;
+            _asFlags |= AS_FLAG_CHANGED_VOLUME;
+        }
         float getPan() const { return _pan; }
 
         void setLayerVolume(int32_t index, float volume) {
             _layers[index].volume = volume > 1.0f ? 1.0f : volume < 0.0f ? 0.0f : volume;
+            _asFlags |= AS_FLAG_CHANGED_VOLUME;
         }
         float getLayerVolume(int32_t index) const { return _layers[index].volume; }
 
         void setLayerPan(int32_t index, float pan) {
             _layers[index].pan = pan > 1.0f ? 1.0f : pan < -1.0f ? -1.0f : pan;
+            _asFlags |= AS_FLAG_CHANGED_VOLUME;
         }
         float getLayerPan(int32_t index) const { return _layers[index].pan; }
 
@@ -100,7 +108,7 @@ namespace JEngine {
         LayerInfo _layers[AudioClip::MAX_AUDIO_LAYERS]{LayerInfo()};
 
         uint8_t _currentSection{};
-        uint8_t _currentVoice{};
+        uint8_t _currentVoice{ 0xFF };
         int64_t _timeSamples{};
 
         int32_t _currentMeasure{};
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <JEngine/IO/AudioUtils.h>
+
+namespace JEngine {
+    enum class ResampleQuality : uint8_t {
+        Linear,
+        Sinc,
+    };
+
+    //Polyphase windowed-sinc resampler with a linear fallback. Positions and steps are 32.32 fixed point frames,
+    //so a sample rate ratio and a pitch are the same thing: the step between two output frames in input frames.
+    //Stateless between calls, the caller hands in enough input around the read positions ('getLead'/'getTrail').
+    //
+    //The sinc filter uses TAPS taps and PHASES phases with the coefficients blended between the two nearest phases.
+    //When downsampling the cutoff follows the ratio, tables for each cutoff are built once and shared.
+    class Resampler {
+    public:
+        static constexpr uint32_t TAPS = 32;
+        static constexpr uint32_t PHASE_BITS = 8;
+        static constexpr uint32_t PHASES = 1U << PHASE_BITS;
+
+        static constexpr uint32_t FRACTION_BITS = 32;
+        static constexpr uint64_t ONE = uint64_t(1) << FRACTION_BITS;
+
+        //Steps are clamped to this many input frames per output frame
+        static constexpr uint32_t MAX_STEP = 8;
+
+        Resampler(ResampleQuality quality = ResampleQuality::Sinc);
+
+        ResampleQuality getQuality() const { return _quality; }
+        void setQuality(ResampleQuality quality);
+
+        uint64_t getStep() const { return _step; }
+        void setStep(uint64_t step);
+
+        static uint64_t getStep(double ratio);
+        static uint64_t getStep(uint32_t inputRate, uint32_t outputRate, float pitch = 1.0f) {
+            return getStep(double(inputRate) / double(outputRate) * pitch);
+        }
+
+        //Input frames read before and after the frame a position falls on
+        static constexpr uint32_t getLead(ResampleQuality quality) { return quality == ResampleQuality::Sinc ? TAPS / 2 - 1 : 0; }
+        static constexpr uint32_t getTrail(ResampleQuality quality) { return quality == ResampleQuality::Sinc ? TAPS / 2 : 1; }
+
+        uint32_t getLead() const { return getLead(_quality); }
+        uint32_t getTrail() const { return getTrail(_quality); }
+
+        //Writes 'frames' interleaved frames to 'output', frame 'i' is read at 'position + i * step' from 'input'.
+        //'input' has to have 'getLead' frames before the first position and 'getTrail' after the last.
+        void process(const float* input, uint32_t channels, uint64_t position, float* output, size_t frames) const;
+
+        //Input frames 'process' reads for 'frames' output frames from 'position', lead and trail included
+        size_t getInputFrames(uint64_t position, size_t frames) const {
+            return frames < 1 ? 0 : size_t((position + (frames - 1) * _step) >> FRACTION_BITS) - size_t(position >> FRACTION_BITS) + 1 + getLead() + getTrail();
+        }
+
+        //Output frames produced from 'frames' input frames
+        static size_t getOutputFrames(size_t frames, uint64_t step) {
+            return size_t(((uint64_t(frames) << FRACTION_BITS) + step - 1) / step);
+        }
+
+        //Converts frames 'start' to 'start + frames' of 'data' to interleaved floats, frames outside of the data are zeros
+        static void loadFrames(const AudioData& data, int64_t start, size_t frames, float* output);
+
+        //Offline conversion of a whole clip, for importing. 'output' gets the same format as 'input' at 'sampleRate'.
+        static bool convert(const AudioData& input, AudioData& output, uint32_t sampleRate, ResampleQuality quality = ResampleQuality::Sinc);
+
+    private:
+        ResampleQuality _quality;
+        uint64_t _step;
+        const float* _table;
+
+        static const float* getTable(uint64_t step);
+    };
+}
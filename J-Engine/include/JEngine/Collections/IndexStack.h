@@ -16,11 +16,11 @@ namespace JEngine {
             constexpr Index(uint64_t index, int32_t bit) : index(index), bit(bit) {}
 
             constexpr bool operator==(const Index& other) const {
-                return index == other.index && bit == other.index;
+                return index == other.index && bit == other.bit;
             }
 
             constexpr bool operator!=(const Index& other) const {
-                return index != other.index || bit != other.index;
+                return index != other.index || bit != other.bit;
             }
         };
 
@@ -84,10 +84,10 @@ namespace JEngine {
             if (ret == detail::INVALID_INDEX) {
                 if(!allowReserve) { return detail::INVALID_INDEX.index; }
                 uint64_t oldCap = _capacity;
-                if (reserve(detail::getExpandedSize(_capacity))) {
-                    ret = detail::extractIndex(oldCap);
-                    if (ret == detail::INVALID_INDEX) { return detail::INVALID_INDEX.index; }
-                }
+                if (!reserve(detail::getExpandedSize(uint32_t(_capacity)))) { return detail::INVALID_INDEX.index; }
+
+                //First bit of the first new chunk
+                ret = detail::Index(oldCap, 0);
             }
             _availMask[ret.index] |= (1ULL << ret.bit);
             return detail::to1DIndex(ret);
@@ -139,15 +139,15 @@ namespace JEngine {
 
         bool reserve(uint32_t count) {
             if (_availMask == nullptr) {
-                _availMask = reinterpret_cast<uint64_t*>(malloc(count * sizeof(uint64_t)));
-                _capacity = count;
+                _availMask = reinterpret_cast<uint64_t*>(calloc(count, sizeof(uint64_t)));
+                _capacity = _availMask ? count : 0;
                 return _availMask != nullptr;
             }
             if (_capacity >= count) { return true; }
 
             uint64_t* reall = reinterpret_cast<uint64_t*>(realloc(_availMask, count * sizeof(uint64_t)));
             if (reall) {
-                memset(reall + _capacity, 0, size_t(count) - _capacity);
+                memset(reall + _capacity, 0, (size_t(count) - _capacity) * sizeof(uint64_t));
                 _availMask = reall;
                 _capacity = count;
                 return true;
@@ -387,12 +387,14 @@ namespace JEngine {
         }
 
         uint64_t getNext(T** outValue = nullptr) {
-            uint64_t ind = _indexStack.popNextFree(nullptr, false);
+            uint64_t ind = _indexStack.popNextFree(nullptr, true);
             if (ind == detail::INVALID_INDEX.index) { return detail::INVALID_INDEX.index; }
 
-            if (ind >= _capacity) {
-                reserve(detail::getExpandedSize(ind + 1));
+            if (ind >= _capacity && !reserve(detail::getExpandedSize(uint32_t(ind + 1)))) {
+                _indexStack.markAsFree(ind);
+                return detail::INVALID_INDEX.index;
             }
+            _count = std::max(_count, ind + 1);
 
             T* val = &_items[ind];
             val = new (val) T();
@@ -404,7 +406,7 @@ namespace JEngine {
 
         bool markFree(uint64_t index) {
             if (_indexStack.markAsFree(index)) {
-                if (!_items || _count >= index) { return true; }
+                if (!_items || index >= _count) { return true; }
                 _items[index].~T();
                 return true;
             }
@@ -445,13 +447,30 @@ namespace JEngine {
             }
 
             if (_capacity >= count) { return true; }
-            T* reall = reinterpret_cast<T*>(realloc(_items, sizeof(T) * count));
-            if (reall) {
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                T* reall = reinterpret_cast<T*>(realloc(_items, sizeof(T) * count));
+                if (reall) {
+                    _capacity = count;
+                    _items = reall;
+                    return true;
+                }
+                return false;
+            }
+            else {
+                //Strings and vectors can't be relocated with a plain realloc, live items are moved over
+                T* newItems = reinterpret_cast<T*>(malloc(sizeof(T) * count));
+                if (!newItems) { return false; }
+                for (uint64_t i = 0; i < _count; i++) {
+                    if (_indexStack.getChunkMask(uint32_t(i >> 6)) & (1ULL << (i & 63))) {
+                        new (newItems + i) T(std::move(_items[i]));
+                        _items[i].~T();
+                    }
+                }
+                free(_items);
                 _capacity = count;
-                _items = reall;
+                _items = newItems;
                 return true;
             }
-            return false;
         }
 
         void release() {
@@ -465,6 +484,7 @@ namespace JEngine {
             _indexStack.release();
             if (_items) {
                 free(_items);
+                _items = nullptr;
             }
             _capacity = 0;
             _count = 0;
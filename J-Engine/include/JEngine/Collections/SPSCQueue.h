@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <JEngine/Platform.h>
+
+namespace JEngine {
+    //Lock-free ring buffer for exactly one producer and one consumer thread, neither side ever blocks.
+    //Each side caches the other's index so the shared cache lines are only touched when the cache runs out.
+    template<typename T, size_t CAPACITY>
+    class SPSCQueue {
+    public:
+        static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "SPSCQueue capacity has to be a power of two!");
+
+        SPSCQueue() : _head(0), _tailCache(0), _tail(0), _headCache(0), _items{} {}
+
+        SPSCQueue(const SPSCQueue& other) = delete;
+        SPSCQueue& operator=(const SPSCQueue& other) = delete;
+
+        static constexpr size_t capacity() { return CAPACITY; }
+
+        //Producer side, returns false if the queue is full
+        bool push(const T& value) {
+            const size_t tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _headCache >= CAPACITY) {
+                _headCache = _head.load(std::memory_order_acquire);
+                if (tail - _headCache >= CAPACITY) { return false; }
+            }
+
+            _items[tail & (CAPACITY - 1)] = value;
+            _tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        //Consumer side, returns false if the queue is empty
+        bool pop(T& value) {
+            const size_t head = _head.load(std::memory_order_relaxed);
+            if (head == _tailCache) {
+                _tailCache = _tail.load(std::memory_order_acquire);
+                if (head == _tailCache) { return false; }
+            }
+
+            value = _items[head & (CAPACITY - 1)];
+            _head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        //Only a snapshot while the other side is running
+        size_t size() const {
+            return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        }
+        bool isEmpty() const { return size() == 0; }
+
+    private:
+        //Consumer and producer state on their own cache lines so the two threads don't fight over them
+        ALIGNAS(64) std::atomic<size_t> _head;
+        size_t _tailCache;
+
+        ALIGNAS(64) std::atomic<size_t> _tail;
+        size_t _headCache;
+
+        ALIGNAS(64) T _items[CAPACITY];
+    };
+}
@@ -4,10 +4,13 @@
 #include <JEngine/Core/Ref.h>
 #include <JEngine/Assets/IAsset.h>
 #include <JEngine/Assets/IAssetSerializer.h>
+#include <JEngine/Assets/AssetDependencies.h>
+#include <JEngine/Assets/AssetLoader.h>
+#include <JEngine/Assets/AssetResidency.h>
 #include <JEngine/IO/VFS/VFS.h>
 
 #ifdef JE_EDITOR
-#include <Editor/IO/DirectoryMonitor.h>
+#include <JEngine/IO/DirectoryMonitor.h>
 #endif
 
 
@@ -34,6 +37,11 @@ namespace JEngine {
 
         uint32_t packAssets(uint32_t sources, ConstSpan<char> destination);
         IAsset* getAssetByUUID(AssetRef uuid, bool fromDB);
+
+        AssetDependencies* getDependencies(uint8_t source) { return source < SRC_COUNT ? &_allSources[source].dependencies : nullptr; }
+
+        //Reimports whatever the changes picked up by 'update' affect and saves the dependency graph back to the DB root
+        size_t reimportChanged(uint8_t source, const AssetDependencies::ImportFunc& import, uint32_t threads = 0);
 #else
         void initialize(const ConstSpan<char> roots[SRC_COUNT]);
         IAsset* getAssetByUUID(AssetRef uuid);
@@ -41,6 +49,39 @@ namespace JEngine {
         VFS* getVFS(uint8_t index);
         const VFS* getVFS(uint8_t index) const;
 
+        uint32_t mountPak(uint8_t source, ConstSpan<char> path);
+        bool readAsset(ConstSpan<char> path, uint8_t source, std::vector<uint8_t>& data) const;
+
+        //Path is resolved right away, the entry must stay in the VFS until the callback has run.
+        //Starts the loader with default settings if it isn't running yet, callbacks are delivered by 'update'.
+        uint64_t loadAsync(ConstSpan<char> path, uint8_t source, LoadType type, LoadPriority priority, AssetLoader::Callback callback);
+
+        AssetLoader& getLoader() { return _loader; }
+        const AssetLoader& getLoader() const { return _loader; }
+
+        //Runs the callbacks of finished async loads, the app's main loop calls this once per frame
+        void update() { _loader.update(); }
+
+        //Registers an asset created outside of 'createAsset' under 'source', 'entry' is the file 'loadAsync' reads it from
+        AssetRef addAsset(IAsset* asset, uint8_t source, FileEntry* entry);
+
+        //Reads the asset's file on the loader, once 'callback' has filled the asset in (and marked it loaded) it's reported to residency tracking
+        uint64_t loadAsync(AssetRef ref, LoadType type, LoadPriority priority, AssetLoader::Callback callback);
+
+        //Unloads the asset and takes it out of residency tracking
+        bool unloadAsset(AssetRef ref);
+
+        //Reports a loaded (or resized) asset to residency tracking, its size comes from 'IAsset::getMemorySize'.
+        //Unreferenced assets are unloaded least recently used first once a budget set on 'getResidency()' is exceeded.
+        void markLoaded(AssetRef ref);
+        void markUnloaded(AssetRef ref);
+
+        uint32_t acquireAsset(AssetRef ref) { return _residency.acquire(ref); }
+        uint32_t releaseAsset(AssetRef ref) { return _residency.release(ref); }
+
+        AssetResidency& getResidency() { return _residency; }
+        const AssetResidency& getResidency() const { return _residency; }
+
         void refresh(uint8_t source, uint8_t refreshMode);
         void buildVFS(uint32_t types);
 
@@ -97,13 +138,18 @@ namespace JEngine {
             VFS vfsDB{};
             ChunkedLUT<AssetInfo> assetsDB{};
             DirectoryMonitor dirMonitor{};
+            AssetDependencies dependencies{};
 
             void setup(ConstSpan<char> source, ConstSpan<char> db) {
                 vfs.changeRoot(source);
                 vfsDB.changeRoot(db);
+                loadDependencies();
             }
             void selectPackableAssets(std::vector<uint32_t>& indices);
 
+            bool loadDependencies();
+            bool saveDependencies() const;
+
             void update();
 #else
             void setup(ConstSpan<char> source) {
@@ -116,5 +162,10 @@ namespace JEngine {
         private:
         };
         VFSSource _allSources[AssetSourceType::SRC_COUNT];
+        AssetLoader _loader;
+        AssetResidency _residency;
+
+        IAsset* findAsset(AssetRef ref) const;
+        uint64_t queueLoad(const FileEntry& entry, uint8_t source, ConstSpan<char> path, LoadType type, LoadPriority priority, AssetLoader::Callback callback);
     };
 }
\ No newline at end of file
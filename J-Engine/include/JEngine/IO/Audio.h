@@ -5,6 +5,96 @@
 namespace JEngine {
 
     namespace Wav {
+        enum : uint16_t {
+            WAVE_FORMAT_PCM = 0x0001,
+            WAVE_FORMAT_IEEE_FLOAT = 0x0003,
+            WAVE_FORMAT_EXTENSIBLE = 0xFFFE,
+        };
+
+        //Frames converted per call to the wrapped stream by the float paths
+        static constexpr size_t BLOCK_FRAMES = 4096;
+
+        //Streams frames out of a RIFF/WAVE file, only the chunk headers are read when opening so memory use
+        //doesn't depend on the length of the file. Handles PCM, IEEE float and their WAVE_FORMAT_EXTENSIBLE forms.
+        //The stream isn't owned and is left at the current frame between calls.
+        class WavReader {
+        public:
+            WavReader();
+            WavReader(const Stream& stream);
+
+            WavReader(const WavReader& other) = delete;
+            WavReader& operator=(const WavReader& other) = delete;
+
+            bool open(const Stream& stream);
+            void close();
+            bool isOpen() const { return _stream != nullptr; }
+
+            AudioSampleType getSampleType() const { return _sampleType; }
+            uint8_t getDepth() const { return _depth; }
+            uint8_t getChannels() const { return _channels; }
+            uint32_t getSampleRate() const { return _sampleRate; }
+            uint16_t getBlockAlign() const { return _blockAlign; }
+
+            uint64_t getFrameCount() const { return _frameCount; }
+            uint64_t getFramePosition() const { return _frame; }
+
+            //Fills the format fields of 'audio' without allocating anything
+            void getFormat(AudioData& audio) const;
+
+            //Reads up to 'frames' frames as they're stored, returns the number of frames read
+            size_t read(void* buffer, size_t frames);
+
+            //Reads up to 'frames' interleaved frames converted to floats, returns the number of frames read
+            size_t readFloat(float* buffer, size_t frames);
+
+            //Moves to 'frame', clamped to the end of the data
+            bool seek(uint64_t frame);
+
+        private:
+            const Stream* _stream;
+            size_t _dataStart;
+            uint64_t _frameCount;
+            uint64_t _frame;
+            uint32_t _sampleRate;
+            uint16_t _blockAlign;
+            uint8_t _channels;
+            uint8_t _depth;
+            AudioSampleType _sampleType;
+            std::vector<uint8_t> _scratch;
+        };
+
+        //Writes frames as they come and patches the RIFF and data sizes in 'close', so the stream has to be seekable.
+        //Anything that isn't 8/16-bit PCM with up to two channels is written as WAVE_FORMAT_EXTENSIBLE.
+        class WavWriter {
+        public:
+            WavWriter();
+            WavWriter(const WavWriter& other) = delete;
+            WavWriter& operator=(const WavWriter& other) = delete;
+            ~WavWriter();
+
+            bool open(const Stream& stream, AudioSampleType type, uint8_t depth, uint8_t channels, uint32_t sampleRate);
+            bool close();
+            bool isOpen() const { return _stream != nullptr; }
+
+            uint64_t getFrameCount() const { return _frameCount; }
+
+            //Writes 'frames' frames in the format given to 'open', returns the number of frames written
+            size_t write(const void* buffer, size_t frames);
+
+            //Converts interleaved floats to the target format in blocks, returns the number of frames written
+            size_t writeFloat(const float* buffer, size_t frames);
+
+        private:
+            const Stream* _stream;
+            size_t _start;
+            size_t _dataStart;
+            uint64_t _frameCount;
+            uint16_t _blockAlign;
+            uint8_t _channels;
+            uint8_t _depth;
+            AudioSampleType _sampleType;
+            std::vector<uint8_t> _scratch;
+        };
 
         bool decode(const char* path, AudioData& audio);
         bool decode(const Stream& stream, AudioData& audio);
@@ -13,4 +103,4 @@ namespace JEngine {
         bool encode(const Stream& stream, const AudioData& audio);
 
     }
-}
\ No newline at end of file
+}
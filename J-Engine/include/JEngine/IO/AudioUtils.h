@@ -234,6 +234,16 @@ namespace JEngine {
         float sampleU16ToF_T(uint16_t sample);
         float sampleI16ToF_T(int16_t sample);
 
+        //Block conversions between interleaved samples and floats, integer samples are scaled by 2^(depth - 1).
+        //Supports unsigned 8-bit, signed 16/24/32-bit and 32/64-bit float, returns false for anything else.
+        bool samplesToFloat(const void* samples, AudioSampleType type, uint8_t depth, float* output, size_t count);
+        bool floatToSamples(const float* input, AudioSampleType type, uint8_t depth, void* samples, size_t count);
+
+        //Mixing kernels, adds 'frames' frames of 'input' to interleaved stereo 'output'. The gains ramp linearly,
+        //frame 'i' is scaled by 'gain + step * i', so a constant gain is just a step of 0.
+        void mixMonoToStereo(const float* input, float* output, size_t frames, float gainL, float gainR, float stepL, float stepR);
+        void mixStereo(const float* input, float* output, size_t frames, float gainL, float gainR, float stepL, float stepR);
+
         inline constexpr double fromSampleI8D(int8_t wave) {
             return wave < 0 ? double(wave) / INT8_MIN : double(wave) / INT8_MAX;
         }
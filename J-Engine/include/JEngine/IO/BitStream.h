@@ -1,55 +1,189 @@
 #pragma once
 #include <JEngine/IO/Stream.h>
 
-//TODO: Finish writing this bitstream class.
-
+//Bit level reader/writer over another stream, bits are packed LSB first into little endian 64-bit words.
+//Reads and writes go through a 64-bit accumulator that's refilled and flushed a whole word at a time
+//from a byte buffer, so the wrapped stream only sees large calls. Like BufferedStream the wrapped stream
+//isn't owned and must not be used directly while attached. Byte reads/writes align to the next byte first.
+//
+//Reads past the end return zeros and set 'hasOverrun', so a decoder can check once after reading a whole record.
 class BitStream : public Stream {
 public:
+    static constexpr size_t BUFFER_SIZE = 8192;
 
     BitStream();
     BitStream(const Stream& stream);
+
+    BitStream(const BitStream& other) = delete;
+    BitStream& operator=(const BitStream& other) = delete;
+
     ~BitStream();
 
-    void setStream(const Stream* stream) const {
-        _stream = stream;
+    bool setStream(const Stream* stream) const;
+    const Stream* getStream() const { return _stream; }
 
-        if (_stream) {
-            _capacity = _stream->capacity();
-            _length = _stream->size();
-            _position = _stream->tell();
-            return;
-        }
+    bool isOpen() const override { return _stream && _stream->isOpen(); }
+    bool canWrite() const override { return isOpen() && _stream->canWrite(); }
+    bool canRead()  const override { return isOpen() && _stream->canRead(); }
 
-        _capacity = 0;
-        _length = 0;
-        _position = 0;
-    }
+    //Byte position, a partially used byte counts as not reached yet
+    size_t tell() const override { return size_t(_bitPos >> 3); }
+    size_t size() const override;
+    uint64_t tellBits() const { return _bitPos; }
 
-    void byteAlign() const;
+    bool isByteAligned() const { return (_bitPos & 0x7) == 0; }
+    bool hasOverrun() const { return _overrun; }
 
-    const Stream* getStream() const { return _stream; }
+    //Skips to the next byte boundary when reading, pads with zero bits when writing
+    void byteAlign() const;
 
-    size_t tell() const override { return _bitPos; }
+    using Stream::read;
+    using Stream::write;
+
+    size_t read(void* buffer, size_t elementSize, size_t count, const bool bigEndian = false) const override;
+    size_t write(const void* buffer, const size_t elementSize, const size_t count, const bool bigEndian = false) const override;
+
+    //Reads/writes 0 to 64 bits
+    uint64_t readBits(uint32_t bits) const {
+        if (_mode == MODE_READ) {
+            if (bits <= _accBits) {
+                uint64_t value = _acc & bitMask(bits);
+                _acc >>= bits;
+                _accBits -= bits;
+                _bitPos += bits;
+                return value;
+            }
+
+            if (_bufferLen - _bufferPos >= 8) {
+                uint64_t word;
+                memcpy(&word, _buffer + _bufferPos, 8);
+                _bufferPos += 8;
+                return takeBits(word, 64, bits);
+            }
+        }
+        return readBitsSlow(bits);
+    }
 
-    virtual bool isOpen() const override { return _stream && _stream->isOpen(); }
-    virtual size_t read(void* buffer, size_t elementSize, size_t count, const bool bigEndian = false) const override;
-    virtual size_t write(const void* buffer, const size_t elementSize, const size_t count, const bool bigEndian = false) const override;
+    bool writeBits(uint64_t value, uint32_t bits) const {
+        if (_mode == MODE_WRITE && BUFFER_SIZE - _bufferLen >= 8) {
+            value &= bitMask(bits);
+            uint32_t total = _accBits + bits;
+            if (total < 64) {
+                _acc |= value << _accBits;
+                _accBits = total;
+            }
+            else {
+                uint64_t word = _acc | (value << _accBits);
+                memcpy(_buffer + _bufferLen, &word, 8);
+                _bufferLen += 8;
+                _acc = _accBits > 0 ? value >> (64 - _accBits) : 0;
+                _accBits = total - 64;
+            }
+            _bitPos += bits;
+            return true;
+        }
+        return writeBitsSlow(value, bits);
+    }
 
+    //Bulk bit copies, whole bytes go through the byte path when the stream is aligned.
+    //Returns the number of bits read/written.
     size_t readBits(void* buffer, size_t bits) const;
     size_t writeBits(const void* buffer, const size_t bits) const;
 
-    virtual bool flush() const override;
-    virtual bool close() const override;
+    bool readBool() const { return readBits(1) != 0; }
+    bool writeBool(bool value) const { return writeBits(value ? 1 : 0, 1); }
 
-    virtual size_t seek(int64_t offset, int origin) const override;
+    //LEB128 style, 7 bits per group with the top bit marking that more follow. Signed values are zigzag encoded.
+    uint64_t readVarUInt() const;
+    bool writeVarUInt(uint64_t value) const;
+
+    int64_t readVarInt() const { return unZigZag(readVarUInt()); }
+    bool writeVarInt(int64_t value) const { return writeVarUInt(zigZag(value)); }
+
+    //Fixed width arrays, every value takes 'bits' bits. Returns the number of values read/written.
+    template<typename T>
+    size_t readPacked(T* values, size_t count, uint32_t bits) const {
+        for (size_t i = 0; i < count; i++) {
+            values[i] = T(readBits(bits));
+        }
+        return _overrun ? 0 : count;
+    }
+
+    template<typename T>
+    size_t writePacked(const T* values, size_t count, uint32_t bits) const {
+        for (size_t i = 0; i < count; i++) {
+            if (!writeBits(uint64_t(values[i]), bits)) { return i; }
+        }
+        return count;
+    }
+
+    //Maps small negative and positive values to small unsigned values, 0, -1, 1, -2 -> 0, 1, 2, 3
+    static constexpr uint64_t zigZag(int64_t value) {
+        return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+    }
+
+    static constexpr int64_t unZigZag(uint64_t value) {
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    //Bits needed to store values up to 'maxValue' with 'writePacked'
+    static constexpr uint32_t bitWidth(uint64_t maxValue) {
+        uint32_t bits = 0;
+        while (maxValue) {
+            bits++;
+            maxValue >>= 1;
+        }
+        return bits;
+    }
+
+    //Writes out whole bytes, up to 7 bits stay pending until the next write, 'byteAlign' or 'close'
+    bool flush() const override;
+    bool close() const override;
+
+    //Byte positions, seeking drops any partially read byte and pads a partially written one
+    size_t seek(int64_t offset, int origin) const override;
 
 private:
-    static constexpr uint32_t BIT_BUFFER_SIZE = 8192;
-    static constexpr uint8_t FLAG_NEED_READ = 0x80;
+    enum : uint8_t {
+        MODE_NONE,
+        MODE_READ,
+        MODE_WRITE,
+    };
 
-    mutable size_t _bitPos;
-    mutable uint8_t _bitBuffer[BIT_BUFFER_SIZE]{0};
     mutable const Stream* _stream;
+    mutable uint64_t _bitPos;
+
+    //Read mode: '_accBits' unread bits are in the low end of '_acc', the buffer holds the bytes after them.
+    //Write mode: '_accBits' pending bits, whole words are moved to the buffer and the buffer to the stream.
+    mutable uint64_t _acc;
+    mutable uint32_t _accBits;
+    mutable uint8_t _buffer[BUFFER_SIZE]{ 0 };
+    mutable size_t _bufferPos;
+    mutable size_t _bufferLen;
+    mutable uint8_t _mode;
+    mutable bool _overrun;
+
+    static constexpr uint64_t bitMask(uint32_t bits) {
+        return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+
+    //Combines the accumulator with the next 'wordBits' bits, 'bits' has to be more than what's left in the accumulator
+    uint64_t takeBits(uint64_t word, uint32_t wordBits, uint32_t bits) const {
+        uint32_t need = bits - _accBits;
+        uint64_t value = (_acc | (word << _accBits)) & bitMask(bits);
+        _acc = need < 64 ? word >> need : 0;
+        _accBits = wordBits - need;
+        _bitPos += bits;
+        return value;
+    }
+
+    uint64_t readBitsSlow(uint32_t bits) const;
+    bool writeBitsSlow(uint64_t value, uint32_t bits) const;
 
-    void checkBitBuffer() const;
+    bool beginRead() const;
+    bool beginWrite() const;
+    bool fill() const;
+    void flushBytes() const;
+    bool flushWrites() const;
+    void dropReadAhead() const;
 };
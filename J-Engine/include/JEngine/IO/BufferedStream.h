@@ -0,0 +1,111 @@
+#pragma once
+#include <JEngine/IO/Stream.h>
+
+//Wraps another stream with a read-ahead/write-behind buffer so lots of small reads and writes
+//turn into a few large calls on the wrapped stream. The wrapped stream isn't owned or closed,
+//but must not be used directly while it's attached, pending writes go out on 'flush', 'setStream' or 'close'.
+class BufferedStream : public Stream {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    BufferedStream();
+    BufferedStream(const Stream& stream, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    BufferedStream(const BufferedStream& other) = delete;
+    BufferedStream& operator=(const BufferedStream& other) = delete;
+
+    ~BufferedStream();
+
+    bool setStream(const Stream* stream, size_t bufferSize = DEFAULT_BUFFER_SIZE) const;
+    const Stream* getStream() const { return _stream; }
+    size_t getBufferSize() const { return _bufferSize; }
+
+    bool isOpen() const override { return _stream && _buffer && _stream->isOpen(); }
+    bool canWrite() const override { return isOpen() && _stream->canWrite(); }
+    bool canRead()  const override { return isOpen() && _stream->canRead(); }
+
+    using Stream::read;
+    using Stream::write;
+
+    size_t read(void* buffer, size_t elementSize, size_t count, const bool bigEndian = false) const override;
+    size_t write(const void* buffer, const size_t elementSize, const size_t count, const bool bigEndian = false) const override;
+    size_t writeZero(const size_t count) const override;
+
+    bool flush() const override;
+    bool close() const override;
+
+    size_t seek(int64_t offset, int origin) const override;
+
+    size_t readCString(char* str, size_t maxLen) const;
+
+    //The value helpers are shadowed so reads and writes that fit the buffer skip the virtual calls
+    //and swap endianess in place, anything else falls back to the Stream versions.
+    template<typename T>
+    size_t readValue(T* data, const size_t count = 1, const bool bigEndian = false) const {
+        const size_t size = sizeof(T) * count;
+        if (_mode == MODE_READ && count > 0 && _bufferLen - _bufferPos >= size) {
+            memcpy(data, _buffer + _bufferPos, size);
+            if (bigEndian) {
+                JEngine::Data::reverseEndianess(data, sizeof(T), count);
+            }
+            _bufferPos += size;
+            _position += size;
+            return size;
+        }
+        return Stream::readValue<T>(data, count, bigEndian);
+    }
+
+    template<typename T>
+    size_t readValue(T& data, const bool bigEndian) const {
+        return this->readValue<T>(&data, 1, bigEndian);
+    }
+
+    template<typename T>
+    T readValue(const bool bigEndian) const {
+        T temp = {};
+        this->readValue<T>(&temp, 1, bigEndian);
+        return temp;
+    }
+
+    template<typename T>
+    size_t writeValue(const T& value, const size_t count = 1, const bool bigEndian = false) const {
+        const size_t size = sizeof(T) * count;
+        if (_mode == MODE_WRITE && count > 0 && _bufferSize - _bufferLen >= size) {
+            uint8_t* target = _buffer + _bufferLen;
+            for (size_t i = 0, j = 0; i < count; i++, j += sizeof(T)) {
+                memcpy(target + j, &value, sizeof(T));
+            }
+
+            if (bigEndian) {
+                JEngine::Data::reverseEndianess(target, sizeof(T), count);
+            }
+            _bufferLen += size;
+            _position += size;
+            _length = _position > _length ? _position : _length;
+            return size;
+        }
+        return Stream::writeValue<T>(value, count, bigEndian);
+    }
+
+private:
+    enum : uint8_t {
+        MODE_NONE,
+        MODE_READ,
+        MODE_WRITE,
+    };
+
+    mutable const Stream* _stream;
+    mutable uint8_t* _buffer;
+    mutable size_t _bufferSize;
+
+    //Read mode: '_bufferPos' is the cursor into '_bufferLen' bytes read ahead from the stream.
+    //Write mode: '_bufferLen' bytes are pending and '_bufferPos' is unused.
+    //Either way '_position' is the logical position, the wrapped stream sits at the end of the buffered range.
+    mutable size_t _bufferPos;
+    mutable size_t _bufferLen;
+    mutable uint8_t _mode;
+
+    bool fill() const;
+    bool flushWrites() const;
+    void dropReadAhead() const;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <JEngine/IO/Stream.h>
+
+// Byte oriented LZ77 codec using the LZ4 block format, trades ratio for decoding at memory speed.
+// Raw buffer calls produce a single block, streams are framed as independent blocks of up to 'BLOCK_SIZE' bytes.
+namespace JEngine::LZ4 {
+    enum : int32_t {
+        LZ4_OK = 0,
+        LZ4_STREAM_END = 1,
+        LZ4_STREAM_ERROR = -2,
+        LZ4_DATA_ERROR = -3,
+        LZ4_BUF_ERROR = -5,
+    };
+
+    static constexpr int32_t MIN_LEVEL = 1;
+    static constexpr int32_t MAX_LEVEL = 9;
+    static constexpr int32_t DEFAULT_LEVEL = 1;
+
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    struct LZ4Context {
+        const Stream* stream{ nullptr };
+        std::vector<uint8_t> input{};
+        std::vector<uint8_t> output{};
+        int32_t level{ DEFAULT_LEVEL };
+        bool hasSignature{ false };
+        bool finished{ false };
+        bool initialized{ false };
+    };
+
+    // Worst case size of a block holding 'length' bytes
+    constexpr size_t compressBound(const size_t length) {
+        return length + length / 255 + 16;
+    }
+
+    // Level 1 is a single probe greedy parser, higher levels search a hash chain twice as deep per level (same range as zlib).
+    // Returns the size written to 'dataOut' or -1 if it didn't fit.
+    int32_t compressData(const void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level = DEFAULT_LEVEL);
+
+    // Returns the decompressed size or -1 if the data is malformed or doesn't fit in 'dataOut'.
+    int32_t decompressData(const void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut);
+
+    int32_t compressData(const Stream& streamIn, const Stream& target, const int32_t level = DEFAULT_LEVEL);
+    int32_t decompressData(const Stream& streamIn, const Stream& target);
+
+    // Segmented framing, data can be fed in pieces of any size and full blocks are written to 'target' as they fill up
+    int32_t compressBegin(LZ4Context& context, const Stream& target, const int32_t level = DEFAULT_LEVEL);
+    int32_t compressSegment(LZ4Context& context, const void* dataIn, const size_t lenIn);
+    int32_t compressEnd(LZ4Context& context);
+
+    // Returns 'LZ4_STREAM_END' once the end of the frame has been reached, bytes after it are ignored
+    int32_t decompressBegin(LZ4Context& context, const Stream& target);
+    int32_t decompressSegment(LZ4Context& context, const void* dataIn, const size_t lenIn);
+    int32_t decompressEnd(LZ4Context& context);
+
+    static inline constexpr const char* lzerr(const int32_t ret) {
+        switch (ret) {
+            default:               return "";
+            case LZ4_STREAM_ERROR: return "LZ4 stream error!";
+            case LZ4_DATA_ERROR:   return "Invalid or incomplete LZ4 data!";
+            case LZ4_BUF_ERROR:    return "LZ4 buffer too small!";
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include <zlib.h>
 #include <cstdint>
+#include <vector>
 #include <JEngine/IO/Stream.h>
 
 namespace JEngine::ZLib {
@@ -36,10 +37,17 @@ namespace JEngine::ZLib {
     };
 
     static constexpr int32_t CHUNK = 16384;
-    int32_t deflateData(const Stream& streamIn, Stream& target, const int32_t level);
+
+    // Input is deflated in blocks of this size on multiple threads, each block primed with the 32 KiB of input before it.
+    static constexpr size_t PARALLEL_BLOCK_SIZE = 128 * 1024;
+    static constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+
+    // Reads 'threads' blocks at a time, 0 uses every worker. The output is a regular zlib stream either way.
+    int32_t deflateData(const Stream& streamIn, Stream& target, const int32_t level, const uint32_t threads = 0);
     int32_t inflateData(const Stream& streamIn, Stream& target);
 
-    int32_t deflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level);
+    // Returns the size of the zlib stream written to 'dataOut' or -1 if it didn't fit/failed.
+    int32_t deflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level, const uint32_t threads = 1);
     int32_t inflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut);
 
     int32_t deflateBegin(ZLibContext& context, uint32_t level, void* buffer, const size_t bufferSize);
@@ -50,6 +58,16 @@ namespace JEngine::ZLib {
     int32_t inflateSegment(ZLibContext& context, void* dataIn, const size_t lenIn, int32_t& dataOut, const bool isLast);
     int32_t inflateEnd(ZLibContext& context, int32_t& dataOut);
 
+    // Blocks are raw deflate data meant to be stitched into a single zlib stream:
+    // a header from 'getHeader', every block in order and finally the big endian adler32 of the input.
+    // Blocks that aren't the last one end on a sync flush, 'dictionary' primes the window with the preceding input.
+    uint16_t getHeader(const int32_t level);
+    int32_t deflateBlock(const void* dataIn, const size_t lenIn, const void* dictionary, const size_t dictLen, const bool isLast, const int32_t level, std::vector<uint8_t>& dataOut);
+
+    // Appends a complete zlib stream deflated pigz style from 'blockSize' blocks, see 'deflateBlock'.
+    // Costs a few bytes per block over a single threaded deflate, with one worker the input is deflated as one block.
+    int32_t deflateParallel(const void* dataIn, const size_t lenIn, std::vector<uint8_t>& dataOut, const int32_t level, const uint32_t threads = 0, const size_t blockSize = PARALLEL_BLOCK_SIZE);
+
     static inline constexpr const char* zerr(const int32_t ret) {
         switch (ret) {
             default:              return "";
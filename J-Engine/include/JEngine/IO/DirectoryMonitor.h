@@ -1,8 +1,13 @@
 #pragma once
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <cstdint>
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include <JEngine/IO/VFS/DirectoryScan.h>
 
 namespace JEngine {
     struct DirectoryChange {
@@ -21,10 +26,53 @@ namespace JEngine {
         DirectoryChange() : type{}, pathFrom{}, pathTo{}{}
         DirectoryChange(ChangeType type, const std::string& path) : type(type), pathFrom(path), pathTo{}{}
         DirectoryChange(const std::string& from, const std::string& to) : type(TYPE_RENAME), pathFrom(from), pathTo(to) {}
+
+        //Path the change ends up at
+        const std::string& getPath() const { return type == TYPE_RENAME ? pathTo : pathFrom; }
+    };
+
+    /// <summary>
+    /// Merges bursts of changes (git checkout, editors saving through temp files etc) into one change per path.
+    /// A path is only handed out once it has been quiet for the debounce window.
+    /// <para>Paths are merged independently, changes to different paths may come out in a different order than they happened.</para>
+    /// </summary>
+    class DirectoryChangeCoalescer {
+    public:
+        DirectoryChangeCoalescer() : _pending(), _debounce(0) {}
+
+        void setDebounce(uint32_t ms) { _debounce = ms; }
+        uint32_t getDebounce() const { return _debounce; }
+
+        void push(const DirectoryChange& change, uint64_t timeMs);
+
+        //Appends settled changes to 'changes', 'force' ignores the debounce window
+        size_t flush(std::vector<DirectoryChange>& changes, uint64_t nowMs, bool force = false);
+
+        size_t getPendingCount() const { return _pending.size(); }
+        void clear() { _pending.clear(); }
+
+    private:
+        struct Pending {
+            DirectoryChange::ChangeType type{};
+
+            //Where the path was before it got renamed, empty if it wasn't
+            std::string origin{};
+            bool modified{ false };
+            uint64_t time{ 0 };
+        };
+
+        //Ordered so the changes inside a renamed folder are one range
+        std::map<std::string, Pending> _pending;
+        uint32_t _debounce;
+
+        //The file that was at 'origin' when the window started is gone
+        void removeOrigin(const std::string& origin, uint64_t timeMs);
     };
 
     class DirectoryMonitor {
     public:
+        static constexpr uint32_t DEFAULT_DEBOUNCE_MS = 100;
+
         DirectoryMonitor();
         ~DirectoryMonitor();
 
@@ -32,18 +80,60 @@ namespace JEngine {
         bool tryOpen(const std::string& path);
         bool isOpen() const { return (_flags & FLAG_OPEN) != 0; }
 
+        //Returns changes that have settled for the debounce window, one per path (a rename that also changed contents reports both).
+        //Paths are relative to the monitored directory. If the directory itself is deleted or moved away,
+        //every path under it is reported deleted right away and the monitor closes.
         bool poll(std::vector<DirectoryChange>& changes);
 
-    private:
-        static constexpr size_t CHANGE_BUFFER_SIZE = 2048;
+        //Hands out everything still waiting for its debounce window
+        bool flush(std::vector<DirectoryChange>& changes);
+
+        void setDebounce(uint32_t ms) { _coalescer.setDebounce(ms); }
+        uint32_t getDebounce() const { return _coalescer.getDebounce(); }
 
+        //Times events were dropped by the OS and recovered by rescanning the directory
+        size_t getOverflowCount() const { return _overflows; }
+
+    private:
         enum : uint8_t {
             FLAG_NONE = 0x00,
             FLAG_OPEN = 0x01,
+            FLAG_ROOT_LOST = 0x02,
         };
         uint8_t _flags;
+        std::string _root;
+        DirectoryChangeCoalescer _coalescer;
+        std::vector<DirectoryChange> _raw;
+
+        //Every path as the listener last heard of it, kept current from the changes handed out.
+        //Diffed against a fresh scan to recover lost events.
+        std::unordered_map<std::string, ScanItem> _known;
+        size_t _overflows;
+
+#ifdef _WIN32
+        static constexpr size_t CHANGE_BUFFER_SIZE = 64 * 1024;
+
         HANDLE _handle;
         OVERLAPPED _overlapped;
-        char _changeBuffer[CHANGE_BUFFER_SIZE];
+        DWORD* _changeBuffer;
+#else
+        static constexpr size_t CHANGE_BUFFER_SIZE = 64 * 1024;
+
+        int _fd;
+        std::unordered_map<int, std::string> _watches;
+        uint8_t* _changeBuffer;
+
+        bool addWatches(const std::string& dir, bool reportContents);
+        void removeWatches(const std::string& dir);
+        //Returns false if 'from' itself wasn't watched
+        bool moveWatches(const std::string& from, const std::string& to);
+#endif
+
+        //Returns false if the OS dropped events
+        bool readEvents();
+        void rescan();
+
+        void setKnown(const DirectoryScan& scan);
+        void applyKnown(const DirectoryChange& change);
     };
-}
\ No newline at end of file
+}
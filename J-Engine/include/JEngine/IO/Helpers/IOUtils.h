@@ -77,6 +77,14 @@ namespace JEngine::IO {
     }
 
     void fixPath(Span<char> path);
-    bool pathsAreEqual(ConstSpan<char> lhs, ConstSpan<char> rhs);
+    bool pathsAreEqual(ConstSpan<char> lhs, ConstSpan<char> rhs, bool ignoreCase = true);
+
+    static constexpr uint64_t PATH_HASH_SEED = 0xCBF29CE484222325ULL;
+
+    //64-bit FNV-1a of the path with '\\' hashed as '/', paths equal by 'pathsAreEqual' hash the same when 'ignoreCase' is set
+    uint64_t hashPath(ConstSpan<char> path, bool ignoreCase = true);
+
+    //Continues 'hash' with 'part', hashing "a/" and then "b" gives the same result as hashing "a/b"
+    uint64_t appendPathHash(uint64_t hash, ConstSpan<char> part, bool ignoreCase = true);
 
 }
\ No newline at end of file
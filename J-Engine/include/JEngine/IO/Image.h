@@ -1,10 +1,19 @@
 #pragma once
 #include <cstdint>
 #include <JEngine/IO/FileStream.h>
+#include <JEngine/IO/MappedFile.h>
 #include <JEngine/IO/ImageUtils.h>
 #include <JEngine/Utility/DataFormatUtils.h>
 static constexpr uint8_t F_IMG_BUILD_PALETTE = 0x1;
 
+static constexpr uint8_t F_IMG_ENC_FAST_FILTER = 0x1;
+static constexpr uint8_t F_IMG_ENC_MULTITHREAD = 0x2;
+static constexpr uint8_t F_IMG_ENC_DXT_CLUSTER_FIT = 0x4;
+static constexpr uint8_t F_IMG_ENC_MIPMAPS = 0x8;
+static constexpr uint8_t F_IMG_ENC_ZLIB = 0x10;
+//JTEX payloads are compressed with LZ4 instead of zlib, takes precedence over 'F_IMG_ENC_ZLIB'
+static constexpr uint8_t F_IMG_ENC_LZ4 = 0x20;
+
 namespace JEngine {
     struct ImageDecodeParams {
         uint8_t flags{ 0 };
@@ -13,6 +22,16 @@ namespace JEngine {
     struct ImageEncodeParams {
         uint32_t dpi{ 96 };
         int32_t compression{ 6 };
+        uint8_t flags{ 0 };
+
+        //Worker threads used with 'F_IMG_ENC_MULTITHREAD', 0 picks the hardware thread count
+        uint32_t threads{ 0 };
+
+        //DXT1/DXT5 block compresses DDS and JTEX output, Unknown keeps the source format
+        TextureFormat targetFormat{ TextureFormat::Unknown };
+
+        //Filter used for the JTEX mip chain written with 'F_IMG_ENC_MIPMAPS'
+        ResampleFilter mipFilter{ ResampleFilter::Box };
     };
 
     namespace Png {
@@ -27,6 +46,10 @@ namespace JEngine {
         bool encode(const std::string& path, const ImageData& imgData, const uint32_t compression = 6);
         bool encode(const char* path, const ImageData& imgData, const uint32_t compression = 6);
         bool encode(const Stream& stream, const ImageData& imgData, const uint32_t compression = 6);
+
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params);
     }
 
     namespace Bmp {
@@ -48,17 +71,24 @@ namespace JEngine {
         bool decodeDxt1(const char* path, ImageData& imgData, const ImageDecodeParams params = {});
         bool decodeDxt1(const Stream& stream, ImageData& imgData, const ImageDecodeParams params = {});
 
-        bool encodeDxt1(const std::string& path, const ImageData& imgData);
-        bool encodeDxt1(const char* path, const ImageData& imgData);
-        bool encodeDxt1(const Stream& stream, const ImageData& imgData);
+        bool encodeDxt1(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params = {});
+        bool encodeDxt1(const char* path, const ImageData& imgData, const ImageEncodeParams& params = {});
+        bool encodeDxt1(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params = {});
 
         bool decodeDxt5(const std::string& path, ImageData& imgData, const ImageDecodeParams params = {});
         bool decodeDxt5(const char* path, ImageData& imgData, const ImageDecodeParams params = {});
         bool decodeDxt5(const Stream& stream, ImageData& imgData, const ImageDecodeParams params = {});
 
-        bool encodeDxt5(const std::string& path, const ImageData& imgData);
-        bool encodeDxt5(const char* path, const ImageData& imgData);
-        bool encodeDxt5(const Stream& stream, const ImageData& imgData);
+        bool encodeDxt5(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params = {});
+        bool encodeDxt5(const char* path, const ImageData& imgData, const ImageEncodeParams& params = {});
+        bool encodeDxt5(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params = {});
+
+        //Block compresses 'source' into 'target' as DXT1 (BC1) or DXT5 (BC3)
+        bool compress(const ImageData& source, ImageData& target, TextureFormat format, const ImageEncodeParams& params = {});
+
+        //Decodes one row of 4x4 blocks straight into 'imgData', which has to be RGB24 or RGBA32
+        void decodeDxt1Row(const uint8_t* blocks, ImageData& imgData, int32_t blockY);
+        void decodeDxt5Row(const uint8_t* blocks, ImageData& imgData, int32_t blockY);
     }
 
     namespace DDS {
@@ -73,6 +103,10 @@ namespace JEngine {
         bool encode(const std::string& path, const ImageData& imgData);
         bool encode(const char* path, const ImageData& imgData);
         bool encode(const Stream& stream, const ImageData& imgData);
+
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params);
     }
 
     namespace JTEX {
@@ -87,6 +121,18 @@ namespace JEngine {
         bool encode(const std::string& path, const ImageData& imgData);
         bool encode(const char* path, const ImageData& imgData);
         bool encode(const Stream& stream, const ImageData& imgData);
+
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params);
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params);
+
+        //Decodes every mip level, level 0 first. The caller owns the buffers.
+        bool decodeLevels(const Stream& stream, std::vector<ImageData>& levels);
+
+        //Uncompressed levels are handed out as views into 'file' and stay valid for as long as it's open,
+        //zlib compressed levels get inflated into their own buffers.
+        bool decode(const MappedFile& file, ImageData& imgData, uint32_t level = 0);
+        bool decodeLevels(const MappedFile& file, std::vector<ImageData>& levels);
     }
 
     namespace Image {
@@ -7,18 +7,24 @@
 #include <JEngine/Math/Graphics/JColor565.h>
 #include <JEngine/Math/Graphics/JColor.h>
 #include <unordered_map>
+#include <vector>
 #include <functional>
 
 namespace JEngine {
-    template<typename T>
-    using PixelConvert = std::function<void(const uint8_t*, const uint8_t*, T*)>;
-
     enum class FilterMode : uint8_t {
         Nearest,
         Linear,
         __Count,
     };
 
+    enum class ResampleFilter : uint8_t {
+        Nearest,
+        Box,
+        Triangle,
+        Lanczos3,
+        __Count,
+    };
+
     enum class WrapMode : uint8_t {
         Clamp,
         Repeat,
@@ -49,11 +55,20 @@ namespace JEngine {
 
         __Count,
 
-        //Support will be added later
+        //Block compressed (BC1/BC3), stored as 4x4 blocks 
+        //so these are left out of the per-pixel conversions.
         DXT1,
         DXT5,
     };
 
+    inline constexpr bool isBlockCompressed(const TextureFormat format) {
+        return format == TextureFormat::DXT1 || format == TextureFormat::DXT5;
+    }
+
+    inline constexpr size_t calculateBlockSize(int32_t width, int32_t height, TextureFormat format) {
+        return size_t((width + 3) >> 2) * size_t((height + 3) >> 2) * (format == TextureFormat::DXT1 ? 8 : 16);
+    }
+
     inline constexpr int32_t getBitsPerPixel(const TextureFormat format) {
         switch (format) {
             default: return 0;
@@ -102,18 +117,74 @@ namespace JEngine {
     }
 
     bool hasAlpha(const uint8_t* data, int32_t width, int32_t height, TextureFormat format, int32_t paletteSize = -1);
-    int32_t findInPalette(const JColor32 color, const JColor32* palette, uint32_t size);
+    void applyPalette(const uint8_t* pixelData, int32_t width, int32_t height, int32_t colors, TextureFormat format, uint8_t* targetPixels, TextureFormat paletteFmt, int32_t alphaClip = -1);
 
-    bool tryBuildPalette(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, std::unordered_map<uint32_t, int32_t>& paletteLut, int32_t alphaClip = -1, int32_t absoluteMax = -1);
+    //Open addressing map from RGBA32 colors to an index, used for palette building and lookups.
+    class ColorHash {
+    public:
+        ColorHash(uint32_t capacity = 0) { reserve(capacity); }
 
-    bool tryBuildPalette8(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, JColor32 buffer[32], uint32_t& bufSize, int32_t alphaClip = -1);
-    bool tryBuildPalette16(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, JColor32 buffer[256], uint32_t& bufSize, int32_t alphaClip = -1, int32_t maxSize = 256 * 256);
+        void clear();
+        void reserve(uint32_t count);
 
-    bool tryBuildPalette(const uint8_t* pixelData, int32_t start, int32_t length, int32_t& colors, TextureFormat& format, int32_t bpp, uint8_t* newPalette, int32_t alphaClip = -1);
-    void applyPalette(const uint8_t* pixelData, int32_t width, int32_t height, int32_t colors, TextureFormat format, uint8_t* targetPixels, TextureFormat paletteFmt, int32_t alphaClip = -1);
+        uint32_t size() const { return _count; }
+
+        //Returns -1 if the color isn't in the map
+        int32_t find(uint32_t color) const;
+
+        //Returns the index stored for 'color', 'value' is stored and returned if it wasn't in the map yet
+        int32_t insert(uint32_t color, int32_t value);
+
+    private:
+        std::vector<uint32_t> _keys{};
+        std::vector<int32_t> _values{};
+        uint32_t _mask{ 0 };
+        uint32_t _count{ 0 };
+
+        static uint32_t hash(uint32_t color) {
+            color *= 0x9E3779B1U;
+            return color ^ (color >> 15);
+        }
+        void grow(uint32_t capacity);
+    };
+
+    //Nearest color search over a palette, colors that have been looked up before are cached.
+    class PaletteLookup {
+    public:
+        PaletteLookup(const JColor32* palette, int32_t colors);
+        int32_t find(JColor32 color);
 
-    bool tryBuildPalette(const uint8_t* pixelData, int32_t start, int32_t length, int32_t& colors, int32_t bpp, uint8_t* newTexture, int32_t alphaClip = -1);
-    int32_t tryBuildPalette(const uint8_t* pixelData, uint32_t width, uint32_t height, TextureFormat format, uint8_t* newTexture, int32_t alphaClip = -1);
+    private:
+        struct Entry {
+            JColor32 color;
+            int32_t index;
+        };
+        std::vector<Entry> _sorted{};
+        ColorHash _cache{};
+    };
+
+    struct ImageData;
+    struct QuantizeParams {
+        //256 or less produces Indexed8, anything above that Indexed16
+        int32_t maxColors{ 256 };
+        int32_t alphaClip{ -1 };
+        bool dither{ false };
+    };
+
+    //Converts any non block compressed image to Indexed8/Indexed16. If there are more than 'maxColors'
+    //unique colors the palette is reduced with median cut, optionally with Floyd-Steinberg dithering.
+    //'target' may be the same image as 'source'.
+    bool quantize(const ImageData& source, ImageData& target, const QuantizeParams& params = {});
+
+    //Separable resampling for any texture format, filtering is done on premultiplied float pixels.
+    //Indexed images are mapped back onto their own palette, block compressed ones are recompressed.
+    //'threads' of 0 uses every hardware thread, 'target' may be the same image as 'source'.
+    bool resample(const ImageData& source, ImageData& target, int32_t newWidth, int32_t newHeight, ResampleFilter filter, uint32_t threads = 0);
+
+    //Fills 'mips' with every level below 'source' down to 1x1, each level in the source format.
+    //Levels are filtered from the previous one in float so rounding errors don't stack up.
+    //The caller owns the level buffers.
+    bool generateMipChain(const ImageData& source, std::vector<ImageData>& mips, ResampleFilter filter = ResampleFilter::Box, uint32_t threads = 0);
 
     constexpr size_t calculateTextureSize(int32_t width, int32_t height, TextureFormat format, int32_t paletteSize) {
         switch (format) {
@@ -130,6 +201,9 @@ namespace JEngine {
             case TextureFormat::Indexed16:
                 paletteSize = Math::isAlignedToPalette(paletteSize) ? paletteSize : Math::alignToPalette(paletteSize);
                 return (size_t(width) * height * 2) + size_t(paletteSize) * 4;
+            case TextureFormat::DXT1:
+            case TextureFormat::DXT5:
+                return calculateBlockSize(width, height, format);
             default: return 0;
         }
     }
@@ -138,6 +212,13 @@ namespace JEngine {
         return value >> 8;
     }
 
+    //Converts 'count' pixels from 'srcFmt' to 'dstFmt', 'palette' is only used with indexed sources.
+    //Indexed and block compressed targets aren't supported, and 'src' and 'dst' may only overlap if the formats match.
+    bool convertPixels(TextureFormat srcFmt, TextureFormat dstFmt, const uint8_t* src, uint8_t* dst, size_t count, const uint8_t* palette = nullptr);
+
+    //Swaps the red and blue channels of 'count' pixels, 'bpp' is in bytes (3, 4, 6, 8 or 16).
+    void flipRB(uint8_t* data, size_t count, int32_t bpp);
+
     template<typename T>
     void convertPixel(TextureFormat format, const uint8_t* dataStart, const uint8_t* data, T& output) {
         static_assert("Not implemented for given type!");
@@ -145,109 +226,21 @@ namespace JEngine {
 
     template<>
     inline void convertPixel<JColor32>(TextureFormat format, const uint8_t* dataStart, const uint8_t* data, JColor32& output) {
-        static PixelConvert<JColor32> converts[int32_t(TextureFormat::__Count)]{
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //Unknown
-                    *output = Colors32::Clear;
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //R8
-                    memset(output, data[0], 3);
-                    output->a = 0xFF;
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RG8
-                    memcpy(output, data, 2);
-                    output->b = 0x00;
-                    output->a = 0xFF;
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGB24
-                    memcpy(output, data, 3);
-                    output->a = 0xFF;
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGBA32
-                    memcpy(output, data, 4);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //Indexed8
-                    memcpy(output, (dataStart + (size_t(*data) << 2)), 4);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //Indexed16
-                    memcpy(output, (dataStart + ((size_t(data[0]) | size_t(data[1]) << 8) << 2)), 4);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGBA4444
-                    *output = JColor32(*reinterpret_cast<const JColor4444*>(data));
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGB48
-                    const uint16_t* dataUI = reinterpret_cast<const uint16_t*>(data);
-                    output->r = remapUI16ToUI8(*dataUI++);
-                    output->g = remapUI16ToUI8(*dataUI++);
-                    output->b = remapUI16ToUI8(*dataUI++);
-                    output->a = 0xFF;
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGBA64
-                    const uint16_t* dataUI = reinterpret_cast<const uint16_t*>(data);
-                    output->r = remapUI16ToUI8(*dataUI++);
-                    output->g = remapUI16ToUI8(*dataUI++);
-                    output->b = remapUI16ToUI8(*dataUI++);
-                    output->a = remapUI16ToUI8(*dataUI++);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor32* output) {      //RGBAF
-                   const JColor* pix = reinterpret_cast<const JColor*>(data);
-                    *output = JColor32(pix[0]);
-               }
-        };
-
-        int32_t fmt = int32_t(format);
-        if (fmt < 0 || format >= TextureFormat::__Count) { output = Colors32::Clear; return; }
-        converts[fmt](dataStart, data, &output);
+        if (!convertPixels(format, TextureFormat::RGBA32, data, reinterpret_cast<uint8_t*>(&output), 1, dataStart)) {
+            output = Colors32::Clear;
+        }
     }
 
     template<>
     inline void convertPixel<JColor4444>(TextureFormat format, const uint8_t* dataStart, const uint8_t* data, JColor4444& output) {
-        static PixelConvert<JColor4444> converts[int32_t(TextureFormat::__Count)]{
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //Unknown
-                    *output = JColor4444();
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //R8
-                    *output = JColor4444(data[0]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RG8
-                    *output = JColor4444(data[0], data[1]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //Indexed8
-                    const uint8_t* pix = (dataStart + (size_t(*data) << 2));
-                    *output = JColor4444(pix[0], pix[1], pix[2], pix[3]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //Indexed16
-                    const uint8_t* pix = (dataStart + ((size_t(data[0]) | size_t(data[1]) << 8) << 2));
-                    *output = JColor4444(pix[0], pix[1], pix[2], pix[3]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGB24
-                   *output = JColor4444(data[0], data[1], data[2]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGBA32
-                    *output = JColor4444(data[0], data[1], data[2], data[3]);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGBA4444
-                    memcpy(output, data, 2);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGB48
-                   const uint16_t* pix = reinterpret_cast<const uint16_t*>(data);
-                    *output = JColor4444(pix[0] >> 8, pix[1] >> 8, pix[2] >> 8);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGBA64
-                   const uint16_t* pix = reinterpret_cast<const uint16_t*>(data);
-                    *output = JColor4444(pix[0] >> 8, pix[1] >> 8, pix[2] >> 8, pix[3] >> 8);
-               },
-               [](const uint8_t* dataStart, const uint8_t* data, JColor4444* output) {      //RGBAF
-                   const JColor* pix = reinterpret_cast<const JColor*>(data);
-                    *output = JColor4444(pix[0]);
-               }
-        };
-
-        int32_t fmt = int32_t(format);
-        if (fmt < 0 || format >= TextureFormat::__Count) { output = JColor4444(); return; }
-        converts[fmt](dataStart, data, &output);
+        if (!convertPixels(format, TextureFormat::RGBA4444, data, reinterpret_cast<uint8_t*>(&output), 1, dataStart)) {
+            output = JColor4444();
+        }
     }
+
     enum : uint8_t {
         IMG_FLAG_HAS_ALPHA = 0x1,
+        IMG_FLAG_VIEW = 0x40,
         IMG_FLAG_ALIGNED = 0x80,
     };
 
@@ -281,6 +274,7 @@ namespace JEngine {
 
         constexpr bool isIndexed() const { return format >= TextureFormat::Indexed8 && format <= TextureFormat::Indexed16; }
         constexpr bool isAligned() const { return (flags & IMG_FLAG_ALIGNED) != 0; }
+        constexpr bool isView() const { return (flags & IMG_FLAG_VIEW) != 0; }
         constexpr size_t getPaletteOffset() const { return getPaletteOffset(format, paletteSize, isAligned()); }
 
         constexpr uint8_t* getData() const { return data + getPaletteOffset(); }
@@ -361,6 +355,7 @@ namespace JEngine {
         }
 
         static constexpr size_t calculateSize(int32_t width, int32_t height, TextureFormat format, int32_t paletteSize, bool alignedPalette) {
+            if (isBlockCompressed(format)) { return calculateBlockSize(width, height, format); }
             return (size_t(width) * height) * (getBitsPerPixel(format) >> 3) + (getPaletteSize(format, paletteSize, alignedPalette) * sizeof(JColor32));
         }
 
@@ -368,7 +363,16 @@ namespace JEngine {
             return getPaletteSize(format, paletteSize, alignedPalette) * sizeof(JColor32);
         }
 
+        //Points the image at memory it doesn't own (e.g. a mapped file), views are read-only and never freed.
+        //Allocating on a view detaches it and gives the image a fresh buffer.
+        void setView(uint8_t* view, size_t size) {
+            data = view;
+            _bufferSize = size;
+            flags |= IMG_FLAG_VIEW;
+        }
+
         bool doAllocate() {
+            detachView();
             size_t required = getSize();
             if (data) {
                 if (required <= _bufferSize) { return true; }
@@ -389,6 +393,7 @@ namespace JEngine {
         }
 
         bool doAllocate(size_t size, bool clear = true) {
+            detachView();
             size_t required = size;
             if (data) {
                 if (required <= _bufferSize)
@@ -428,11 +433,20 @@ namespace JEngine {
         }
 
         void resize(int32_t newWidth, int32_t newHeight, bool linear, ImageData* tempBuffer = nullptr);
+        void resize(int32_t newWidth, int32_t newHeight, ResampleFilter filter, ImageData* tempBuffer = nullptr);
 
         void replaceData(uint8_t* newData, bool destroy);
         void clear(bool destroy);
     private:
         size_t _bufferSize{ 0 };
+
+        void detachView() {
+            if (isView()) {
+                data = nullptr;
+                _bufferSize = 0;
+                flags &= ~IMG_FLAG_VIEW;
+            }
+        }
     };
 
     struct ImageBuffers {
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+//Read-only memory mapping of a whole file, the mapped bytes stay valid until the file is closed.
+class MappedFile {
+public:
+    MappedFile();
+    MappedFile(const char* filepath);
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+
+    ~MappedFile();
+
+    MappedFile& operator=(const MappedFile& other) = delete;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const char* filepath);
+    void close();
+
+    bool isOpen() const { return _data != nullptr; }
+
+    const uint8_t* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _file;
+#endif
+    const uint8_t* _data;
+    size_t _size;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <JEngine/IO/Stream.h>
+#include <JEngine/IO/MappedFile.h>
+#include <JEngine/Utility/Span.h>
+
+//Read-only Stream over a memory mapped file, reads are plain copies out of the mapping
+//and 'view' hands out the mapped bytes directly so readers can parse them in place.
+class MappedFileStream : public Stream {
+public:
+    MappedFileStream();
+    MappedFileStream(const char* filepath);
+
+    MappedFileStream(const MappedFileStream& other) = delete;
+    MappedFileStream(MappedFileStream&& other) noexcept;
+
+    ~MappedFileStream();
+
+    MappedFileStream& operator=(const MappedFileStream& other) = delete;
+    MappedFileStream& operator=(MappedFileStream&& other) noexcept;
+
+    bool open(const char* filepath) const;
+
+    bool isOpen() const override { return _file.isOpen(); }
+    bool canWrite() const override { return false; }
+    bool canRead()  const override { return _file.isOpen(); }
+
+    bool flush() const override { return isOpen(); }
+    bool close() const override;
+
+    using Stream::read;
+    using Stream::write;
+
+    size_t read(void* buffer, size_t elementSize, size_t count, const bool bigEndian = false) const override;
+    size_t write(const void*, const size_t, const size_t, const bool = false) const override { return 0; }
+
+    size_t seek(int64_t offset, int origin) const override;
+
+    //Returns up to 'size' bytes starting at 'offset', the span stays valid until the stream is closed
+    JEngine::Span<const uint8_t> view(size_t offset, size_t size) const;
+
+    const uint8_t* data() const { return _file.data(); }
+    const MappedFile& getFile() const { return _file; }
+
+private:
+    mutable MappedFile _file;
+};
@@ -47,12 +47,15 @@ public:
 
     virtual size_t writeZero(const size_t count) const {
         if (!canWrite()) { return 0; }
-        void* buffer = _malloca(count);
-        if (!buffer) { return 0; }
-
-        memset(buffer, 0, count);
-        size_t ret = write(buffer, 1, count);
-        _freea(buffer);
+        uint8_t buffer[256]{ 0 };
+
+        size_t ret = 0;
+        while (ret < count) {
+            size_t toWrite = count - ret < sizeof(buffer) ? count - ret : sizeof(buffer);
+            size_t written = write(buffer, 1, toWrite);
+            ret += written;
+            if (written < toWrite) { break; }
+        }
         return ret;
     }
 
@@ -77,21 +80,24 @@ public:
     template<typename T>
     size_t writeValue(const T& value, const size_t count = 1, const bool bigEndian = false) const {
         if (!canWrite() || count < 1) { return 0; }
-
-        uint8_t* buffer = reinterpret_cast<uint8_t*>(_malloca(count * sizeof(T)));
-        if (!buffer) { return 0; }
-
-        if (bigEndian) {
-            memcpy(buffer, &value, sizeof(T));
-            JEngine::Data::reverseEndianess(buffer, sizeof(T), 1);
+        if (count == 1) {
+            return write(&value, sizeof(T), 1, bigEndian);
         }
 
-        for (size_t i = 1, j = sizeof(T); i < count; i++ ,j+= sizeof(T)) {
-            memcpy(buffer + j, buffer, sizeof(T));
+        //Repeated values are written in batches from a small stack buffer
+        static constexpr size_t BATCH = sizeof(T) >= 256 ? 1 : 256 / sizeof(T);
+        uint8_t buffer[BATCH * sizeof(T)];
+        for (size_t i = 0, j = 0; i < BATCH; i++, j += sizeof(T)) {
+            memcpy(buffer + j, &value, sizeof(T));
         }
 
-        size_t ret = write(buffer, 1, count * sizeof(T));
-        _freea(buffer);
+        size_t ret = 0;
+        for (size_t i = 0; i < count; i += BATCH) {
+            size_t batch = count - i < BATCH ? count - i : BATCH;
+            size_t written = write(buffer, sizeof(T), batch, bigEndian);
+            ret += written;
+            if (written < batch * sizeof(T)) { break; }
+        }
         return ret;
     }
 
@@ -182,17 +188,25 @@ public:
             return;
         }
 
-        void* data = _malloca(remain);
+        //Copies through a bounded buffer instead of staging the whole remainder at once
+        size_t chunk = remain < COPY_CHUNK ? remain : COPY_CHUNK;
+        void* data = _malloca(chunk);
         if (!data) { return; }
 
-        this->read(data, remain, false);
-        other.write(data, remain);
+        while (remain > 0) {
+            size_t bRead = this->read(data, remain < chunk ? remain : chunk, false);
+            if (bRead < 1) { break; }
+
+            other.write(data, bRead);
+            remain -= bRead;
+        }
 
         _freea(data);
         this->seek(curPos, SEEK_SET);
     }
 
 protected:
+    static constexpr size_t COPY_CHUNK = 64 * 1024;
 
     mutable uint8_t _flags;
     mutable size_t _position;
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <JEngine/IO/Stream.h>
+#include <JEngine/IO/Helpers/IOUtils.h>
+#include <JEngine/Utility/Span.h>
+
+namespace JEngine {
+    struct ScanItem {
+        static constexpr uint32_t NO_DIR = UINT32_MAX;
+
+        std::string name{};
+        uint8_t type{ IO::F_TYPE_FILE };
+        uint64_t size{ 0 };
+        uint64_t modTime{ 0 };
+
+        //Index of the folder's own 'ScanDir', only valid after a scan
+        uint32_t dir{ NO_DIR };
+
+        bool isFolder() const { return type == IO::F_TYPE_FOLDER; }
+    };
+
+    struct ScanDir {
+        //Relative to the scan root, '/' separated and empty for the root itself
+        std::string path{};
+        uint64_t modTime{ 0 };
+        std::vector<ScanItem> items{};
+    };
+
+    /// <summary>
+    /// Walks a directory tree one level at a time, every directory of a level is listed in parallel.
+    /// Directories end up in breadth first order and items are sorted by name so the result doesn't depend on thread timing.
+    /// </summary>
+    class DirectoryScan {
+    public:
+        DirectoryScan() : _root(), _dirs(), _rescanned(0) {}
+
+        /// <summary>
+        /// If 'previous' was taken from the same root, directories whose modification time still matches reuse its listing
+        /// instead of being iterated again (files edited in place keep their old size and time until their directory changes).
+        /// </summary>
+        bool scan(ConstSpan<char> root, const DirectoryScan* previous = nullptr, uint32_t threads = 0);
+
+        bool save(const Stream& stream) const;
+        bool load(const Stream& stream);
+
+        void clear();
+
+        const std::string& getRoot() const { return _root; }
+        const std::vector<ScanDir>& getDirectories() const { return _dirs; }
+
+        //Directories that had to be listed during the last scan
+        size_t getRescannedCount() const { return _rescanned; }
+
+    private:
+        std::string _root;
+        std::vector<ScanDir> _dirs;
+        size_t _rescanned;
+    };
+}
@@ -2,11 +2,14 @@
 #include <cstdint>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <JEngine/Collections/IndexStack.h>
 #include <JEngine/IO/Helpers/IOUtils.h>
 #include <JEngine/IO/FileStream.h>
+#include <JEngine/IO/VFS/DirectoryScan.h>
 #include <JEngine/Utility/Span.h>
 #include <JEngine/Utility/DataFormatUtils.h>
+#include <JEngine/Assets/AssetPacking.h>
 
 namespace JEngine {
     struct EntryInfo {
@@ -21,8 +24,8 @@ namespace JEngine {
         constexpr bool isFolder() const { return (position & size) == NPOS; }
         constexpr bool isFile() const { return (position != NPOS && size == NPOS); }
 
-        constexpr bool operator==(const EntryInfo & other) const { return position == other.position && size == other.position; }
-        constexpr bool operator!=(const EntryInfo & other) const { return position != other.position || size != other.position; }
+        constexpr bool operator==(const EntryInfo & other) const { return position == other.position && size == other.size; }
+        constexpr bool operator!=(const EntryInfo & other) const { return position != other.position || size != other.size; }
     };
     static constexpr EntryInfo FOLDER_EINF(EntryInfo::NPOS, EntryInfo::NPOS);
     static constexpr EntryInfo FILE_EINF(0, EntryInfo::NPOS);
@@ -83,8 +86,8 @@ namespace JEngine {
             children.clear();
         }
 
-        bool isSame(ConstSpan<char> span) const {
-            return IO::pathsAreEqual(span, ConstSpan<char>(name));
+        bool isSame(ConstSpan<char> span, bool ignoreCase = true) const {
+            return IO::pathsAreEqual(span, ConstSpan<char>(name), ignoreCase);
         }
 
         FileID findInChild(const VFS& vfs, ConstSpan<char> span) const;
@@ -93,7 +96,7 @@ namespace JEngine {
         bool isSubFile(const VFS& vfs) const;
 
         /// <summary>
-        /// This mehod will also remove this item from it's parent
+        /// This mehod will also remove this item from it's parent and the path index
         /// </summary>
         void remove(VFS& vfs);
 
@@ -111,6 +114,7 @@ namespace JEngine {
         enum : uint32_t {
             VFS_FLAG_NONE = 0x00,
             VFS_FLAG_IS_VIRTUAL = 0x01,
+            VFS_FLAG_CASE_SENSITIVE = 0x02,
         };
 
         enum : uint8_t {
@@ -125,6 +129,7 @@ namespace JEngine {
 
         void changeRoot(ConstSpan<char> root, uint32_t flags = VFS_FLAG_NONE);
         ConstSpan<char> getRootPath() const { return _rootPath; }
+        bool ignoresCase() const { return (_flags & VFS_FLAG_CASE_SENSITIVE) == 0; }
 
         FileEntry* getRoot() { return getEntryByRef(_root); }
         const FileEntry* getRoot() const { return getEntryByRef(_root); }
@@ -132,7 +137,11 @@ namespace JEngine {
         size_t getEntryCount() const { return _entries.size(); }
         size_t getSourceCount() const { return _sources.size(); }
 
-        bool buildFromRoot();
+        /// <summary>
+        /// Directories are listed on 'threads' workers (0 uses every core) and merged in a fixed order, so entry IDs don't depend on timing.
+        /// With a snapshot path, directories that haven't changed since the snapshot reuse its listing and the refreshed snapshot is written back.
+        /// </summary>
+        bool buildFromRoot(const char* snapshotPath = nullptr, uint32_t threads = 0);
 
         FileID addEntry(uint32_t source, ConstSpan<char> path, EntryInfo dataInfo = EntryInfo(), bool* addedNew = nullptr);
 
@@ -147,6 +156,18 @@ namespace JEngine {
         void openSourceFile(uint32_t index, const char* mode);
         void closeSourceFile(uint32_t index);
 
+        /// <summary>
+        /// Mounts a JPAK as a source, every entry in it gets added under the root.
+        /// Pak entries keep their table index in 'EntryInfo::position' and their unpacked size in 'EntryInfo::size'.
+        /// </summary>
+        uint32_t addPakFile(ConstSpan<char> path);
+        const AssetPacking::PakFile* getPakFile(uint32_t source) const;
+
+        bool readEntry(FileID entry, std::vector<uint8_t>& data) const;
+
+        /// <summary>
+        /// Paths are looked up from a hash of the root relative path so the cost doesn't depend on the amount of siblings.
+        /// </summary>
         FileID indexOfFileEntry(ConstSpan<char> path) const;
         uint32_t indexOfSourceFile(ConstSpan<char> path) const;
  
@@ -169,7 +190,35 @@ namespace JEngine {
         std::string _rootPath;
         FileID _root;
 
+        struct MountedPak {
+            uint32_t source{ FileEntry::NULL_SOURCE };
+            AssetPacking::PakFile pak{};
+        };
+
         IndexedLUT<FileEntry> _entries;
         IndexedLUT<FileStream> _sources;
+        std::vector<MountedPak> _paks;
+
+        //Keyed by the hash of "/Dir/File" relative to the root, hashes that collide are only counted
+        //and resolved by walking the tree
+        std::unordered_map<uint64_t, FileID> _pathIndex;
+        size_t _pathCollisions;
+
+        //Keyed by 'IO::hashPath' of the full source path
+        std::unordered_multimap<uint64_t, uint32_t> _sourceIndex;
+
+        ConstSpan<char> toRelative(ConstSpan<char> path) const;
+        uint64_t hashEntry(const FileEntry& entry) const;
+        uint64_t hashChild(uint64_t parentHash, ConstSpan<char> name) const;
+        FileID findIndexed(uint64_t hash, FileID parent, ConstSpan<char> name) const;
+        FileID addChild(FileID parent, uint64_t hash, ConstSpan<char> name, uint32_t source, EntryInfo dataInfo, bool* addedNew = nullptr);
+        void mergeScan(const DirectoryScan& scan, size_t dirIndex, FileID parent, uint64_t hash, std::string& path);
+        void rebuildSourceIndex();
+
+        void indexEntry(uint64_t hash, FileID id);
+        void indexTree(FileID id, uint64_t hash);
+        void rebuildIndex();
+        void releaseEntry(FileID id, uint64_t hash);
+        void removePakEntries(uint32_t source);
     };
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <algorithm>
+#include <type_traits>
+
+namespace JEngine::Parallel {
+    inline uint32_t getWorkerCount(uint32_t requested = 0) {
+        if (requested > 0) { return requested; }
+        uint32_t hw = std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    namespace detail {
+        using IndexFunc = void(*)(void* context, size_t index);
+
+        // Hands [0, count) to up to 'workers - 1' threads of the shared pool, the calling thread works on it too
+        void run(size_t count, uint32_t workers, IndexFunc func, void* context);
+    }
+
+    // Runs 'func(index)' for every index in [0, count) on up to 'threads' threads,
+    // the calling thread included. Indices are handed out one by one so uneven work
+    // balances itself out. Returns once every index has been processed.
+    // Helpers come from one pool started on first use, sized to the hardware's thread count.
+    template<typename Func>
+    void forEach(size_t count, uint32_t threads, Func&& func) {
+        if (count < 1) { return; }
+
+        size_t workers = std::min<size_t>(getWorkerCount(threads), count);
+        if (workers <= 1) {
+            for (size_t i = 0; i < count; i++) {
+                func(i);
+            }
+            return;
+        }
+
+        using FuncType = std::remove_reference_t<Func>;
+        detail::run(count, uint32_t(workers), [](void* context, size_t index) {
+            (*reinterpret_cast<FuncType*>(context))(index);
+        }, const_cast<void*>(reinterpret_cast<const void*>(&func)));
+    }
+}
@@ -5,6 +5,16 @@
 
 #define SIMD_ALIGN ALIGNAS(16)
 
+// SSE2 is always there on x64, SSSE3 only when the compiler
+// is allowed to emit it (/arch:AVX and up on MSVC).
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JE_SIMD_SSE2 1
+#endif
+
+#if defined(JE_SIMD_SSE2) && (defined(__AVX__) || defined(__SSSE3__))
+#define JE_SIMD_SSSE3 1
+#endif
+
 namespace JEngine {
     struct SIMDIndex {
         size_t byteIdx{};
@@ -58,7 +58,7 @@ namespace JEngine {
         size_t indexOfLast(const T& find) const {
             if (_length < 1) { return SIZE_MAX; }
 
-            for (size_t i = _length - 1; i >= 0; i--) {
+            for (size_t i = _length; i-- > 0;) {
                 if (_ptr[i] == find) { return i; }
             }
             return SIZE_MAX;
@@ -77,7 +77,7 @@ namespace JEngine {
         size_t indexOfAnyLast(T const* find, size_t count) const {
             if (_length < 1) { return SIZE_MAX; }
 
-            for (size_t i = _length - 1; i >= 0; i--) {
+            for (size_t i = _length; i-- > 0;) {
                 const auto& val = _ptr[i];
                 for (size_t k = 0; k < count; k++) {
                     if (val == find[k]) { return i; }
@@ -389,7 +389,7 @@ namespace JEngine {
         size_t indexOfLast(const T& find) const {
             if (_length < 1) { return SIZE_MAX; }
 
-            for (size_t i = _length - 1; i >= 0; i--) {
+            for (size_t i = _length; i-- > 0;) {
                 if (_ptr[i] == find) { return int32_t(i); }
             }
             return SIZE_MAX;
@@ -405,7 +405,7 @@ namespace JEngine {
         size_t indexNotOfLast(const T& find) const {
             if (_length < 1) { return SIZE_MAX; }
 
-            for (size_t i = _length - 1; i >= 0; i--) {
+            for (size_t i = _length; i-- > 0;) {
                 if (_ptr[i] != find) { return int32_t(i); }
             }
             return SIZE_MAX;
@@ -425,7 +425,7 @@ namespace JEngine {
         size_t indexOfAnyLast(T const* find, size_t count) const {
             if (_length < 1) { return SIZE_MAX; }
 
-            for (size_t i = _length - 1; i >= 0; i--) {
+            for (size_t i = _length; i-- > 0;) {
                 const auto& val = _ptr[i];
                 for (size_t k = 0; k < count; k++) {
                     if (val == find[k]) { return i; }
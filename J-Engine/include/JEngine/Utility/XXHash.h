@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace JEngine {
+    namespace Data {
+        //One-shot XXH64, matches the reference implementation
+        uint64_t xxHash64(const void* data, size_t length, uint64_t seed = 0);
+
+        /// <summary>
+        /// Streaming XXH64 for data that doesn't fit in memory at once, feeding it in any split gives the same digest as 'xxHash64'.
+        /// </summary>
+        class XXHash64 {
+        public:
+            XXHash64(uint64_t seed = 0) { reset(seed); }
+
+            void reset(uint64_t seed = 0);
+            void update(const void* data, size_t length);
+            uint64_t digest() const;
+
+        private:
+            uint64_t _acc[4];
+            uint64_t _seed;
+            uint64_t _total;
+            uint8_t _buffer[32];
+            uint32_t _buffered;
+        };
+    }
+}
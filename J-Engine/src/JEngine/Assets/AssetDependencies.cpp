@@ -0,0 +1,455 @@
+#include <JEngine/Assets/AssetDependencies.h>
+#include <JEngine/Core/Log.h>
+#include <JEngine/IO/FileStream.h>
+#include <JEngine/IO/Helpers/IOUtils.h>
+#include <JEngine/Utility/Parallel.h>
+#include <JEngine/Utility/XXHash.h>
+#include <algorithm>
+#include <cctype>
+
+namespace JEngine {
+    static constexpr uint32_t DEPS_SIG = 0x5045444AU;
+    static constexpr uint32_t DEPS_VERSION = 1;
+    static constexpr uint32_t DEPS_MAX_NODES = 1U << 24;
+    static constexpr uint32_t DEPS_MAX_PATH = 4096;
+
+    static constexpr size_t HASH_CHUNK_SIZE = 64 * 1024;
+
+    static std::string toPath(ConstSpan<char> path) {
+        std::string str(path.get(), path.length());
+        std::replace(str.begin(), str.end(), '\\', '/');
+
+        size_t start = str.find_first_not_of('/');
+        return start == std::string::npos ? std::string() : str.substr(start);
+    }
+
+    std::string AssetDependencies::toKey(ConstSpan<char> path) {
+        std::string key = toPath(path);
+        for (auto& c : key) {
+            c = char(tolower(uint8_t(c)));
+        }
+        return key;
+    }
+
+    uint32_t AssetDependencies::addAsset(ConstSpan<char> path) {
+        std::string key = toKey(path);
+        if (key.length() < 1) { return NO_NODE; }
+
+        auto it = _index.find(key);
+        if (it != _index.end()) { return it->second; }
+
+        uint32_t index = uint32_t(_nodes.size());
+        if (_freeNodes.size() > 0) {
+            index = _freeNodes.back();
+            _freeNodes.pop_back();
+        }
+        else {
+            _nodes.emplace_back();
+        }
+
+        _nodes[index] = Node();
+        _nodes[index].path = toPath(path);
+        _index.emplace(std::move(key), index);
+        return index;
+    }
+
+    uint32_t AssetDependencies::indexOf(ConstSpan<char> path) const {
+        auto it = _index.find(toKey(path));
+        return it != _index.end() ? it->second : NO_NODE;
+    }
+
+    bool AssetDependencies::removeAsset(ConstSpan<char> path) {
+        uint32_t index = indexOf(path);
+        if (index == NO_NODE) { return false; }
+
+        unlinkDependencies(index);
+        for (uint32_t dependent : _nodes[index].dependents) {
+            auto& deps = _nodes[dependent].dependencies;
+            deps.erase(std::find(deps.begin(), deps.end(), index));
+        }
+
+        _index.erase(toKey(path));
+        _nodes[index] = Node();
+        _freeNodes.push_back(index);
+        return true;
+    }
+
+    bool AssetDependencies::renameAsset(ConstSpan<char> from, ConstSpan<char> to) {
+        uint32_t index = indexOf(from);
+        if (index == NO_NODE) { return false; }
+
+        std::string key = toKey(to);
+        if (key.length() < 1 || _index.find(key) != _index.end()) {
+            JE_CORE_WARN("[AssetDependencies] Warning: Can't rename '{0}' to '{1}', the name is empty or taken!", from, to);
+            return false;
+        }
+
+        //Keys don't include paths, a rename alone doesn't make anything dirty
+        _index.erase(toKey(from));
+        _index.emplace(std::move(key), index);
+        _nodes[index].path = toPath(to);
+        return true;
+    }
+
+    bool AssetDependencies::addDependency(ConstSpan<char> asset, ConstSpan<char> dependency) {
+        uint32_t assetI = addAsset(asset);
+        uint32_t depI = addAsset(dependency);
+        if (assetI == NO_NODE || depI == NO_NODE) { return false; }
+
+        if (assetI == depI || dependsOn(depI, assetI)) {
+            JE_CORE_WARN("[AssetDependencies] Warning: '{0}' can't depend on '{1}', it would form a cycle!", asset, dependency);
+            return false;
+        }
+
+        auto& deps = _nodes[assetI].dependencies;
+        auto pos = std::lower_bound(deps.begin(), deps.end(), depI);
+        if (pos != deps.end() && *pos == depI) { return true; }
+
+        deps.insert(pos, depI);
+        _nodes[depI].dependents.push_back(assetI);
+        return true;
+    }
+
+    void AssetDependencies::clearDependencies(ConstSpan<char> asset) {
+        uint32_t index = indexOf(asset);
+        if (index != NO_NODE) {
+            unlinkDependencies(index);
+        }
+    }
+
+    bool AssetDependencies::setContentHash(ConstSpan<char> path, uint64_t hash) {
+        uint32_t index = addAsset(path);
+        if (index == NO_NODE) { return false; }
+        _nodes[index].contentHash = hash;
+        return true;
+    }
+
+    bool AssetDependencies::setSettingsHash(ConstSpan<char> path, uint64_t hash) {
+        uint32_t index = addAsset(path);
+        if (index == NO_NODE) { return false; }
+        _nodes[index].settingsHash = hash;
+        return true;
+    }
+
+    bool AssetDependencies::updateContentHash(ConstSpan<char> root, ConstSpan<char> path) {
+        std::string full(root.get(), root.length());
+        if (full.length() > 0 && full.back() != '/' && full.back() != '\\') {
+            full.push_back('/');
+        }
+        full.append(toPath(path));
+
+        //Directory changes get reported too, only files have content
+        if (IO::isDir(full)) { return false; }
+
+        uint64_t hash = 0;
+        if (!hashFile(full, hash)) { return false; }
+        return setContentHash(path, hash);
+    }
+
+    bool AssetDependencies::hashFile(ConstSpan<char> path, uint64_t& hash) {
+        std::string pathStr(path.get(), path.length());
+        FileStream stream(pathStr.c_str(), "rb");
+        if (!stream.isOpen()) {
+            JE_CORE_WARN("[AssetDependencies] Warning: Couldn't open '{0}' for hashing!", pathStr);
+            return false;
+        }
+
+        uint8_t* buffer = reinterpret_cast<uint8_t*>(malloc(HASH_CHUNK_SIZE));
+        if (!buffer) { return false; }
+
+        Data::XXHash64 hasher{};
+        size_t read = 0;
+        while ((read = stream.read(buffer, 1, HASH_CHUNK_SIZE, false)) > 0) {
+            hasher.update(buffer, read);
+        }
+        free(buffer);
+
+        hash = hasher.digest();
+        return true;
+    }
+
+    bool AssetDependencies::isDirty(uint32_t node) const {
+        const Node* ptr = getNode(node);
+        return ptr && computeKey(*ptr) != ptr->importKey;
+    }
+
+    bool AssetDependencies::collectReimports(std::vector<uint32_t>& order) const {
+        std::vector<std::vector<uint32_t>> levels{};
+        bool acyclic = collectLevels(levels);
+
+        order.clear();
+        for (const auto& level : levels) {
+            order.insert(order.end(), level.begin(), level.end());
+        }
+        return acyclic;
+    }
+
+    size_t AssetDependencies::reimport(const ImportFunc& import, uint32_t threads) {
+        std::vector<std::vector<uint32_t>> levels{};
+        collectLevels(levels);
+
+        size_t imported = 0;
+        std::vector<uint8_t> blocked(_nodes.size(), 0);
+        std::vector<uint32_t> batch{};
+        std::vector<uint8_t> results{};
+        std::vector<std::vector<std::string>> declared{};
+
+        for (const auto& level : levels) {
+            batch.clear();
+            for (uint32_t node : level) {
+                bool skip = false;
+                for (uint32_t dep : _nodes[node].dependencies) {
+                    skip |= blocked[dep] != 0;
+                }
+
+                if (skip) {
+                    blocked[node] = 1;
+                    continue;
+                }
+                batch.push_back(node);
+            }
+
+            results.assign(batch.size(), 0);
+            declared.clear();
+            declared.resize(batch.size());
+            Parallel::forEach(batch.size(), threads, [&](size_t i) {
+                results[i] = import(_nodes[batch[i]].path, declared[i]) ? 1 : 0;
+            });
+
+            //The graph is only touched between levels, importers never see it change under them
+            for (size_t i = 0; i < batch.size(); i++) {
+                uint32_t node = batch[i];
+                if (!results[i]) {
+                    JE_CORE_WARN("[AssetDependencies] Warning: Failed to import '{0}', its dependents are skipped!", _nodes[node].path);
+                    blocked[node] = 1;
+                    continue;
+                }
+
+                //Copied since adding a dependency can add nodes and move '_nodes'
+                std::string path = _nodes[node].path;
+                unlinkDependencies(node);
+                for (const auto& dep : declared[i]) {
+                    addDependency(path, dep);
+                }
+
+                if (blocked.size() < _nodes.size()) {
+                    blocked.resize(_nodes.size(), 0);
+                }
+
+                _nodes[node].importKey = computeKey(_nodes[node]);
+                imported++;
+            }
+        }
+        return imported;
+    }
+
+    bool AssetDependencies::save(const Stream& stream) const {
+        if (!stream.canWrite()) {
+            JE_CORE_ERROR("[AssetDependencies] Error: Can't save dependencies, given stream isn't writable!");
+            return false;
+        }
+
+        //Removed nodes leave holes, those are compacted out
+        std::vector<uint32_t> remap(_nodes.size(), NO_NODE);
+        uint32_t count = 0;
+        for (size_t i = 0; i < _nodes.size(); i++) {
+            if (_nodes[i].isValid()) {
+                remap[i] = count++;
+            }
+        }
+
+        stream.writeValue(DEPS_SIG);
+        stream.writeValue(DEPS_VERSION);
+        stream.writeValue(count);
+        for (const auto& node : _nodes) {
+            if (!node.isValid()) { continue; }
+
+            stream.writeString(node.path);
+            stream.writeValue(node.contentHash);
+            stream.writeValue(node.settingsHash);
+            stream.writeValue(node.importKey);
+            stream.writeValue(uint32_t(node.dependencies.size()));
+            for (uint32_t dep : node.dependencies) {
+                stream.writeValue(remap[dep]);
+            }
+        }
+        return stream.flush();
+    }
+
+    bool AssetDependencies::load(const Stream& stream) {
+        clear();
+
+        uint32_t sig = 0;
+        uint32_t version = 0;
+        if (!stream.canRead() || stream.readValue(sig, false) != sizeof(sig) || sig != DEPS_SIG) {
+            JE_CORE_ERROR("[AssetDependencies] Error: Given stream isn't a dependency graph!");
+            return false;
+        }
+
+        stream.readValue(version, false);
+        if (version != DEPS_VERSION) {
+            JE_CORE_WARN("[AssetDependencies] Warning: Dependency graph version {0} isn't supported, everything will be reimported!", version);
+            return false;
+        }
+
+        uint32_t count = 0;
+        if (stream.readValue(count, false) != sizeof(count) || count > DEPS_MAX_NODES) {
+            goto invalid;
+        }
+
+        _nodes.resize(count);
+        for (auto& node : _nodes) {
+            uint32_t len = 0;
+            uint32_t depCount = 0;
+            if (stream.readValue(len, false) != sizeof(len) || len < 1 || len > DEPS_MAX_PATH || stream.isEOF(len)) {
+                goto invalid;
+            }
+            node.path = stream.readString(len);
+
+            if (stream.readValue(node.contentHash, false) != sizeof(node.contentHash) ||
+                stream.readValue(node.settingsHash, false) != sizeof(node.settingsHash) ||
+                stream.readValue(node.importKey, false) != sizeof(node.importKey) ||
+                stream.readValue(depCount, false) != sizeof(depCount) || depCount > count) {
+                goto invalid;
+            }
+
+            node.dependencies.resize(depCount);
+            for (auto& dep : node.dependencies) {
+                if (stream.readValue(dep, false) != sizeof(dep) || dep >= count) {
+                    goto invalid;
+                }
+            }
+            std::sort(node.dependencies.begin(), node.dependencies.end());
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            if (!_index.emplace(toKey(_nodes[i].path), i).second) {
+                goto invalid;
+            }
+
+            for (uint32_t dep : _nodes[i].dependencies) {
+                _nodes[dep].dependents.push_back(i);
+            }
+        }
+
+        //A cycle can only come from a corrupted file, 'addDependency' never lets one in
+        {
+            std::vector<std::vector<uint32_t>> levels{};
+            if (!collectLevels(levels)) {
+                goto invalid;
+            }
+        }
+        return true;
+
+    invalid:
+        JE_CORE_ERROR("[AssetDependencies] Error: Dependency graph is truncated or corrupted!");
+        clear();
+        return false;
+    }
+
+    void AssetDependencies::clear() {
+        _nodes.clear();
+        _freeNodes.clear();
+        _index.clear();
+    }
+
+    uint64_t AssetDependencies::computeKey(const Node& node) const {
+        Data::XXHash64 hasher{};
+        hasher.update(&node.contentHash, sizeof(node.contentHash));
+        hasher.update(&node.settingsHash, sizeof(node.settingsHash));
+        for (uint32_t dep : node.dependencies) {
+            hasher.update(&_nodes[dep].importKey, sizeof(uint64_t));
+        }
+
+        //0 is reserved for never imported
+        uint64_t key = hasher.digest();
+        return key ? key : 1;
+    }
+
+    bool AssetDependencies::dependsOn(uint32_t node, uint32_t dependency) const {
+        std::vector<uint32_t> stack{ node };
+        std::vector<uint8_t> visited(_nodes.size(), 0);
+        while (stack.size() > 0) {
+            uint32_t current = stack.back();
+            stack.pop_back();
+            if (current == dependency) { return true; }
+            if (visited[current]) { continue; }
+
+            visited[current] = 1;
+            stack.insert(stack.end(), _nodes[current].dependencies.begin(), _nodes[current].dependencies.end());
+        }
+        return false;
+    }
+
+    void AssetDependencies::unlinkDependencies(uint32_t node) {
+        for (uint32_t dep : _nodes[node].dependencies) {
+            auto& dependents = _nodes[dep].dependents;
+            dependents.erase(std::find(dependents.begin(), dependents.end(), node));
+        }
+        _nodes[node].dependencies.clear();
+    }
+
+    bool AssetDependencies::collectLevels(std::vector<std::vector<uint32_t>>& levels) const {
+        levels.clear();
+
+        //Dirty nodes and everything downstream of them
+        std::vector<uint8_t> affected(_nodes.size(), 0);
+        std::vector<uint32_t> stack{};
+        for (uint32_t i = 0; i < uint32_t(_nodes.size()); i++) {
+            if (_nodes[i].isValid() && computeKey(_nodes[i]) != _nodes[i].importKey) {
+                affected[i] = 1;
+                stack.push_back(i);
+            }
+        }
+
+        size_t total = 0;
+        while (stack.size() > 0) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            total++;
+
+            for (uint32_t dependent : _nodes[node].dependents) {
+                if (!affected[dependent]) {
+                    affected[dependent] = 1;
+                    stack.push_back(dependent);
+                }
+            }
+        }
+
+        //Kahn's algorithm over the affected part of the graph, one level at a time
+        std::vector<uint32_t> pending(_nodes.size(), 0);
+        std::vector<uint32_t> level{};
+        for (uint32_t i = 0; i < uint32_t(_nodes.size()); i++) {
+            if (!affected[i]) { continue; }
+
+            for (uint32_t dep : _nodes[i].dependencies) {
+                pending[i] += affected[dep];
+            }
+            if (pending[i] == 0) {
+                level.push_back(i);
+            }
+        }
+
+        size_t placed = 0;
+        while (level.size() > 0) {
+            placed += level.size();
+            levels.emplace_back(std::move(level));
+            level.clear();
+
+            for (uint32_t node : levels.back()) {
+                for (uint32_t dependent : _nodes[node].dependents) {
+                    if (affected[dependent] && --pending[dependent] == 0) {
+                        level.push_back(dependent);
+                    }
+                }
+            }
+            std::sort(level.begin(), level.end());
+        }
+
+        if (placed < total) {
+            JE_CORE_ERROR("[AssetDependencies] Error: {0} asset(s) are part of a dependency cycle and can't be imported!", total - placed);
+            return false;
+        }
+        return true;
+    }
+}
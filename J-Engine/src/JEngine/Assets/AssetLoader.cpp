@@ -0,0 +1,340 @@
+#include <JEngine/Assets/AssetLoader.h>
+#include <JEngine/Core/Log.h>
+#include <JEngine/IO/Audio.h>
+#include <JEngine/IO/FileStream.h>
+#include <JEngine/IO/MappedFileStream.h>
+#include <JEngine/IO/Image.h>
+#include <JEngine/IO/MemoryStream.h>
+#include <JEngine/IO/Helpers/IOUtils.h>
+#include <JEngine/Utility/Parallel.h>
+#include <algorithm>
+
+namespace JEngine {
+    struct AssetLoader::Request {
+        Reader reader{};
+        Callback callback{};
+        LoadPriority priority{ LoadPriority::Visible };
+        size_t reserved{ 0 };
+        std::atomic<bool> cancelled{ false };
+        LoadResult result{};
+
+        ~Request() {
+            result.image.clear(true);
+        }
+    };
+
+    size_t LoadResult::getMemorySize() const {
+        return bytes.size() + (image.data ? image.getBufferSize() : 0) + (audio.data ? audio.calculateSize() : 0);
+    }
+
+    AssetLoader::AssetLoader() : _mutex(), _workCV(), _doneCV(), _workers(), _running(false), _nextID(INVALID_ID + 1),
+        _byteBudget(DEFAULT_BUDGET), _inFlightBytes(0), _requests(), _queues(), _completed() {}
+
+    AssetLoader::AssetLoader(uint32_t threads, size_t byteBudget) : AssetLoader() {
+        start(threads, byteBudget);
+    }
+
+    AssetLoader::~AssetLoader() {
+        stop();
+
+        //Undelivered results are dropped without running their callbacks
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& queue : _queues) {
+            queue.clear();
+        }
+        _completed.clear();
+        _requests.clear();
+        _inFlightBytes = 0;
+    }
+
+    bool AssetLoader::start(uint32_t threads, size_t byteBudget) {
+        if (isRunning()) {
+            JE_CORE_WARN("[AssetLoader] Warning: Loader is already running!");
+            return false;
+        }
+
+        if (threads < 1) {
+            threads = std::max(Parallel::getWorkerCount() - 1, 1U);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = true;
+            _byteBudget = std::max<size_t>(byteBudget, 1);
+        }
+
+        _workers.reserve(threads);
+        for (uint32_t i = 0; i < threads; i++) {
+            _workers.emplace_back(&AssetLoader::workerLoop, this);
+        }
+        return true;
+    }
+
+    void AssetLoader::stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _workCV.notify_all();
+
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+        _workers.clear();
+    }
+
+    uint64_t AssetLoader::load(ConstSpan<char> path, LoadType type, LoadPriority priority, Callback callback) {
+        std::string pathStr(path.get(), path.length());
+
+        std::error_code ec{};
+        size_t size = size_t(fs::file_size(fs::path(pathStr), ec));
+        if (ec) {
+            size = 0;
+        }
+
+        Reader reader = [pathStr](LoadSource& source) {
+            //Decoders parse straight out of the mapping, empty files can't be mapped and take the regular path
+            auto mapped = std::make_shared<MappedFileStream>(pathStr.c_str());
+            if (mapped->isOpen()) {
+                Span<const uint8_t> bytes = mapped->view(0, mapped->size());
+                source.view = ConstSpan<uint8_t>(bytes.get(), bytes.length());
+                source.keepAlive = std::move(mapped);
+                return true;
+            }
+
+            FileStream stream(pathStr.c_str(), "rb");
+            if (!stream.isOpen()) { return false; }
+
+            source.bytes.resize(stream.size());
+            return stream.read(source.bytes.data(), 1, source.bytes.size(), false) == source.bytes.size();
+        };
+        return load(path, std::move(reader), size, type, priority, std::move(callback));
+    }
+
+    uint64_t AssetLoader::load(ConstSpan<char> path, Reader reader, size_t sizeHint, LoadType type, LoadPriority priority, Callback callback) {
+        if (!reader || priority >= LoadPriority::Count) { return INVALID_ID; }
+
+        auto request = std::make_unique<Request>();
+        request->reader = std::move(reader);
+        request->callback = std::move(callback);
+        request->priority = priority;
+        request->reserved = sizeHint;
+        request->result.type = type;
+        request->result.path = std::string(path.get(), path.length());
+
+        uint64_t id = INVALID_ID;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            id = _nextID++;
+            request->result.id = id;
+
+            Request* ptr = request.get();
+            _requests.emplace(id, std::move(request));
+            _queues[size_t(priority)].push_back(ptr);
+        }
+        _workCV.notify_one();
+        return id;
+    }
+
+    bool AssetLoader::cancel(uint64_t id) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _requests.find(id);
+        if (it == _requests.end()) { return false; }
+
+        Request* request = it->second.get();
+        switch (request->result.state) {
+            case LoadState::Queued: {
+                auto& queue = _queues[size_t(request->priority)];
+                queue.erase(std::find(queue.begin(), queue.end(), request));
+                request->result.state = LoadState::Cancelled;
+                request->reserved = 0;
+                _completed.push_back(request);
+                _doneCV.notify_all();
+                return true;
+            }
+            case LoadState::Loading:
+                request->cancelled = true;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool AssetLoader::wait(uint64_t id) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto it = _requests.find(id);
+        if (it == _requests.end()) { return false; }
+
+        Request* request = it->second.get();
+        if (request->result.state == LoadState::Queued) {
+            //Jumps the queue, the caller is stalled on it
+            auto& queue = _queues[size_t(request->priority)];
+            queue.erase(std::find(queue.begin(), queue.end(), request));
+
+            if (_workers.size() < 1) {
+                request->result.state = LoadState::Loading;
+                _inFlightBytes += request->reserved;
+                lock.unlock();
+                process(*request);
+                lock.lock();
+            }
+            else {
+                request->priority = LoadPriority::Blocking;
+                _queues[size_t(LoadPriority::Blocking)].push_front(request);
+                _workCV.notify_all();
+            }
+        }
+
+        _doneCV.wait(lock, [&]() { return std::find(_completed.begin(), _completed.end(), request) != _completed.end(); });
+        _completed.erase(std::find(_completed.begin(), _completed.end(), request));
+        lock.unlock();
+
+        deliver(request);
+        return true;
+    }
+
+    size_t AssetLoader::update(size_t maxCallbacks) {
+        std::vector<Request*> ready{};
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            size_t count = std::min(maxCallbacks, _completed.size());
+            ready.assign(_completed.begin(), _completed.begin() + count);
+            _completed.erase(_completed.begin(), _completed.begin() + count);
+        }
+
+        //Callbacks run without the lock so they're free to queue more loads
+        for (Request* request : ready) {
+            deliver(request);
+        }
+        return ready.size();
+    }
+
+    LoadState AssetLoader::getState(uint64_t id) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _requests.find(id);
+        return it != _requests.end() ? it->second->result.state : LoadState::Cancelled;
+    }
+
+    size_t AssetLoader::getPendingCount() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _requests.size();
+    }
+
+    size_t AssetLoader::getInFlightBytes() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _inFlightBytes;
+    }
+
+    AssetLoader::Request* AssetLoader::popNext() {
+        //Only the front of the most important non-empty queue is considered,
+        //a big request waiting for budget holds back everything less important than it
+        for (auto& queue : _queues) {
+            if (queue.size() < 1) { continue; }
+
+            Request* request = queue.front();
+            bool fits = request->priority == LoadPriority::Blocking || _inFlightBytes < 1 || _inFlightBytes + request->reserved <= _byteBudget;
+            if (!fits) { return nullptr; }
+
+            queue.pop_front();
+            request->result.state = LoadState::Loading;
+            _inFlightBytes += request->reserved;
+            return request;
+        }
+        return nullptr;
+    }
+
+    void AssetLoader::workerLoop() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            Request* request = nullptr;
+            _workCV.wait(lock, [&]() { return !_running || (request = popNext()) != nullptr; });
+            if (!request) { break; }
+
+            lock.unlock();
+            process(*request);
+            lock.lock();
+        }
+    }
+
+    void AssetLoader::process(Request& request) {
+        LoadResult& result = request.result;
+        LoadState state = LoadState::Failed;
+        size_t sourceSize = 0;
+        LoadSource source{};
+
+        if (request.cancelled) {
+            state = LoadState::Cancelled;
+        }
+        else if (!request.reader(source)) {
+            JE_CORE_WARN("[AssetLoader] Warning: Failed to read '{0}'!", result.path);
+        }
+        else if (request.cancelled) {
+            state = LoadState::Cancelled;
+        }
+        else {
+            ConstSpan<uint8_t> data = source.getData();
+            sourceSize = data.length();
+            MemoryStream stream(data.get(), data.length(), data.length());
+            bool decoded = true;
+            switch (result.type) {
+                case LoadType::Image: {
+                    DataFormat format{};
+                    decoded = Image::tryDecode(stream, result.image, format);
+                    break;
+                }
+                case LoadType::Audio:
+                    decoded = Wav::decode(stream, result.audio);
+                    break;
+                case LoadType::Serialized:
+                    result.serialized = nlohmann::json::parse(data.get(), data.get() + data.length(), nullptr, false);
+                    decoded = !result.serialized.is_discarded();
+                    break;
+                default:
+                    //'bytes' outlives the request, so a mapped view has to be copied out
+                    if (source.view.get()) {
+                        result.bytes.assign(data.get(), data.get() + data.length());
+                    }
+                    else {
+                        result.bytes = std::move(source.bytes);
+                    }
+                    break;
+            }
+
+            if (decoded) {
+                state = LoadState::Done;
+            }
+            else {
+                JE_CORE_WARN("[AssetLoader] Warning: Failed to decode '{0}'!", result.path);
+            }
+        }
+
+        //Unmaps or frees the source before the reservation is corrected
+        source = LoadSource();
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        //The reservation follows what the result actually holds until it's delivered,
+        //parsed documents have no cheap size so their source size stands in
+        size_t actual = result.type == LoadType::Serialized ? sourceSize : result.getMemorySize();
+        _inFlightBytes = _inFlightBytes - request.reserved + actual;
+        request.reserved = actual;
+
+        result.state = state;
+        _completed.push_back(&request);
+        _doneCV.notify_all();
+    }
+
+    void AssetLoader::deliver(Request* request) {
+        if (request->callback) {
+            request->callback(request->result);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _inFlightBytes -= std::min(_inFlightBytes, request->reserved);
+            _requests.erase(request->result.id);
+        }
+
+        //Freed budget can let a queued request start
+        _workCV.notify_all();
+    }
+}
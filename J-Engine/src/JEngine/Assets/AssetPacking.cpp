@@ -1,13 +1,457 @@
-#include <JEngine/assets/AssetPacking.h>
-#include <JEngine/Utility/DataFormatUtils.h>
-#include <JEngine/IO/Serialization/Serializable.h>
-#include <vector>
+#include <JEngine/Assets/AssetPacking.h>
+#include <JEngine/Core/Log.h>
+#include <JEngine/IO/FileStream.h>
+#include <JEngine/IO/Helpers/IOUtils.h>
+#include <JEngine/IO/Compression/ZLib.h>
+#include <JEngine/IO/Compression/LZ4.h>
+#include <JEngine/Utility/DataUtilities.h>
+#include <JEngine/Utility/Parallel.h>
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <utility>
 
 namespace JEngine::AssetPacking {
+    static constexpr uint32_t PAK_SIG = 0x4B41504AU;
 
-    //const bool packAssets(const FileEntry& folder, const Stream& stream, const uint32_t flags) {
-    //    stream.writeValue(DataHeader<FMT_JPAK>::Value);
-    //    Serialization::serialize(PakVersion, stream);
-    //    return true;
-    //}
-}
\ No newline at end of file
+    //Entries smaller than this aren't worth compressing, the 4 KiB padding dwarfs any savings anyway
+    static constexpr size_t PAK_MIN_COMPRESS = 256;
+
+    //How many files are read & compressed at once per worker in 'addFiles'
+    static constexpr size_t PAK_BATCH_PER_THREAD = 4;
+
+    struct PakWriter::Payload {
+        std::vector<uint8_t> data{};
+        std::vector<uint8_t> packed{};
+        const uint8_t* stored{ nullptr };
+        size_t storedSize{ 0 };
+        uint64_t rawSize{ 0 };
+        uint32_t crc{ 0 };
+        uint16_t flags{ PAK_ENTRY_RAW };
+        bool valid{ false };
+    };
+
+    static size_t alignOffset(size_t offset, size_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    static uint32_t calculateCRC(const void* data, size_t size) {
+        return Data::updateCRC(0xFFFFFFFFU, data, size) ^ 0xFFFFFFFFU;
+    }
+
+    static ConstSpan<char> trimPath(ConstSpan<char> path) {
+        while (path.length() > 0 && (path[0] == '/' || path[0] == '\\')) {
+            path = path.slice(1);
+        }
+        return path;
+    }
+
+    static int32_t compareNames(ConstSpan<char> lhs, ConstSpan<char> rhs) {
+        size_t len = std::min(lhs.length(), rhs.length());
+        for (size_t i = 0; i < len; i++) {
+            int32_t a = std::tolower(uint8_t(lhs[i] == '\\' ? '/' : lhs[i]));
+            int32_t b = std::tolower(uint8_t(rhs[i] == '\\' ? '/' : rhs[i]));
+            if (a != b) { return a < b ? -1 : 1; }
+        }
+        return lhs.length() == rhs.length() ? 0 : (lhs.length() < rhs.length() ? -1 : 1);
+    }
+
+    static bool readFile(ConstSpan<char> path, std::vector<uint8_t>& data) {
+        FileStream stream(path.get(), path.length());
+        if (!stream.open("rb")) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to open '{0}' for reading!", std::string_view(path.get(), path.length()));
+            return false;
+        }
+
+        data.resize(stream.size());
+        if (stream.read(data.data(), 1, data.size(), false) != data.size()) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to read '{0}'!", std::string_view(path.get(), path.length()));
+            return false;
+        }
+        return true;
+    }
+
+    PakWriter::PakWriter() : _stream(nullptr), _start(0), _flags(PAK_FLAG_NONE), _compression(6), _entries{}, _names{} {}
+
+    bool PakWriter::begin(const Stream& stream, uint32_t flags, int32_t compression) {
+        if (!stream.canWrite()) {
+            JE_CORE_ERROR("[AssetPacking] Error: Can't write a pak, given stream isn't writable!");
+            return false;
+        }
+
+        _stream = &stream;
+        _start = stream.tell();
+        _flags = flags;
+        _compression = compression;
+        _entries.clear();
+        _names.clear();
+
+        //Header gets filled in 'end', until then the space is just reserved
+        return stream.writeZero(sizeof(PakHeader)) == sizeof(PakHeader);
+    }
+
+    bool PakWriter::prepare(const void* data, size_t size, Payload& payload) const {
+        payload.stored = reinterpret_cast<const uint8_t*>(data);
+        payload.storedSize = size;
+        payload.rawSize = size;
+        payload.crc = calculateCRC(data, size);
+        payload.flags = PAK_ENTRY_RAW;
+        payload.valid = true;
+
+        if ((_flags & PAK_FLAG_COMPRESS) == 0 || size < PAK_MIN_COMPRESS) { return true; }
+
+        auto& packed = payload.packed;
+        packed.clear();
+
+        uint16_t codec = PAK_ENTRY_ZLIB;
+        if (_flags & PAK_FLAG_FAST) {
+            codec = PAK_ENTRY_LZ4;
+            packed.resize(LZ4::compressBound(size));
+
+            int32_t ret = LZ4::compressData(data, size, packed.data(), packed.size(), _compression);
+            if (ret < 0) {
+                JE_CORE_WARN("[AssetPacking] Warning: LZ4 compression failed, storing entry uncompressed!");
+                return true;
+            }
+            packed.resize(size_t(ret));
+        }
+        else {
+            uint16_t header = ZLib::getHeader(_compression);
+            packed.push_back(uint8_t(header >> 8));
+            packed.push_back(uint8_t(header));
+
+            int32_t ret = ZLib::deflateBlock(data, size, nullptr, 0, true, _compression, packed);
+            if (ret != Z_OK) {
+                JE_CORE_WARN("[AssetPacking] Warning: ZLib Deflate failed, storing entry uncompressed! ({0})", ZLib::zerr(ret));
+                return true;
+            }
+
+            uint32_t adler = uint32_t(adler32(adler32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(data), uInt(size)));
+            for (int32_t i = 24; i >= 0; i -= 8) {
+                packed.push_back(uint8_t(adler >> i));
+            }
+        }
+
+        //Raw entries can be used straight from the mapping, so only keep the compressed data if it actually pays off
+        if (packed.size() < size - (size >> 3)) {
+            payload.stored = packed.data();
+            payload.storedSize = packed.size();
+            payload.flags = codec;
+        }
+        return true;
+    }
+
+    bool PakWriter::writePayload(ConstSpan<char> name, const Payload& payload) {
+        if (!_stream) {
+            JE_CORE_ERROR("[AssetPacking] Error: Can't add entries before 'begin'!");
+            return false;
+        }
+
+        std::string path(name.get(), name.length());
+        IO::fixPath(Span<char>(path.data(), path.length()));
+        ConstSpan<char> trimmed = trimPath(ConstSpan<char>(path.c_str(), path.length()));
+
+        if (trimmed.length() < 1 || trimmed.length() > UINT16_MAX || _names.size() + trimmed.length() > UINT32_MAX) {
+            JE_CORE_ERROR("[AssetPacking] Error: Entry name '{0}' is either empty or too long!", path);
+            return false;
+        }
+
+        size_t current = _stream->tell() - _start;
+        size_t offset = alignOffset(current, PakAlignment);
+        if (_stream->writeZero(offset - current) != offset - current ||
+            _stream->write(payload.stored, payload.storedSize, false) != payload.storedSize) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to write entry '{0}'!", path);
+            return false;
+        }
+
+        PakEntry& entry = _entries.emplace_back();
+        entry.hash = IO::hashPath(trimmed, true);
+        entry.offset = offset;
+        entry.size = payload.storedSize;
+        entry.rawSize = payload.rawSize;
+        entry.crc = payload.crc;
+        entry.nameOffset = uint32_t(_names.size());
+        entry.nameLength = uint16_t(trimmed.length());
+        entry.flags = payload.flags;
+        entry.reserved = 0;
+
+        _names.append(trimmed.get(), trimmed.length());
+        return true;
+    }
+
+    bool PakWriter::addEntry(ConstSpan<char> name, const void* data, size_t size) {
+        Payload payload{};
+        return prepare(data, size, payload) && writePayload(name, payload);
+    }
+
+    bool PakWriter::addFile(ConstSpan<char> name, ConstSpan<char> path) {
+        Payload payload{};
+        return readFile(path, payload.data) &&
+            prepare(payload.data.data(), payload.data.size(), payload) &&
+            writePayload(name, payload);
+    }
+
+    bool PakWriter::addFiles(const std::vector<PakSource>& files) {
+        uint32_t threads = (_flags & PAK_FLAG_MULTITHREAD) ? Parallel::getWorkerCount() : 1;
+        size_t batchSize = std::max<size_t>(threads * PAK_BATCH_PER_THREAD, 1);
+
+        std::vector<Payload> payloads(std::min(batchSize, files.size()));
+        for (size_t start = 0; start < files.size(); start += batchSize) {
+            size_t count = std::min(batchSize, files.size() - start);
+            Parallel::forEach(count, threads, [&](size_t i) {
+                Payload& payload = payloads[i];
+                const auto& path = files[start + i].path;
+                payload.valid = false;
+                if (readFile(ConstSpan<char>(path.c_str(), path.length()), payload.data)) {
+                    prepare(payload.data.data(), payload.data.size(), payload);
+                }
+            });
+
+            //Written in input order so the same inputs always produce the same pak
+            for (size_t i = 0; i < count; i++) {
+                const auto& name = files[start + i].name;
+                if (!payloads[i].valid || !writePayload(ConstSpan<char>(name.c_str(), name.length()), payloads[i])) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool PakWriter::end() {
+        if (!_stream) {
+            JE_CORE_ERROR("[AssetPacking] Error: Can't end a pak that wasn't begun!");
+            return false;
+        }
+        const Stream& stream = *_stream;
+        _stream = nullptr;
+
+        std::sort(_entries.begin(), _entries.end(), [this](const PakEntry& lhs, const PakEntry& rhs) {
+            if (lhs.hash != rhs.hash) { return lhs.hash < rhs.hash; }
+            return compareNames(
+                ConstSpan<char>(_names.c_str() + lhs.nameOffset, lhs.nameLength),
+                ConstSpan<char>(_names.c_str() + rhs.nameOffset, rhs.nameLength)) < 0;
+        });
+
+        for (size_t i = 1; i < _entries.size(); i++) {
+            const PakEntry& prev = _entries[i - 1];
+            const PakEntry& cur = _entries[i];
+            ConstSpan<char> name(_names.c_str() + cur.nameOffset, cur.nameLength);
+            if (prev.hash == cur.hash && IO::pathsAreEqual(ConstSpan<char>(_names.c_str() + prev.nameOffset, prev.nameLength), name)) {
+                JE_CORE_ERROR("[AssetPacking] Error: Entry '{0}' was added more than once!", std::string_view(name.get(), name.length()));
+                return false;
+            }
+        }
+
+        PakHeader header{};
+        header.signature = PAK_SIG;
+        header.version = PakVersion;
+        header.entryCount = uint32_t(_entries.size());
+        header.alignment = PakAlignment;
+        header.namesOffset = stream.tell() - _start;
+        header.namesSize = _names.size();
+
+        size_t tocOffset = alignOffset(size_t(header.namesOffset + header.namesSize), sizeof(uint64_t));
+        header.tocOffset = tocOffset;
+
+        size_t tocSize = _entries.size() * sizeof(PakEntry);
+        if (stream.write(_names.data(), _names.size(), false) != _names.size() ||
+            stream.writeZero(size_t(tocOffset - header.namesOffset - header.namesSize)) != size_t(tocOffset - header.namesOffset - header.namesSize) ||
+            stream.write(_entries.data(), tocSize, false) != tocSize) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to write the table of contents!");
+            return false;
+        }
+
+        size_t endPos = stream.tell();
+        stream.seek(int64_t(_start), SEEK_SET);
+        bool ret = stream.writeValue(header) == sizeof(PakHeader);
+        stream.seek(int64_t(endPos), SEEK_SET);
+        stream.flush();
+        return ret;
+    }
+
+    PakFile::PakFile() : _file(), _path(), _entries(nullptr), _names(nullptr), _entryCount(0) {}
+    PakFile::PakFile(const char* path) : PakFile() {
+        open(path);
+    }
+
+    PakFile::PakFile(PakFile&& other) noexcept :
+        _file(std::move(other._file)),
+        _path(std::move(other._path)),
+        _entries(std::exchange(other._entries, nullptr)),
+        _names(std::exchange(other._names, nullptr)),
+        _entryCount(std::exchange(other._entryCount, 0)) {}
+
+    PakFile& PakFile::operator=(PakFile&& other) noexcept {
+        if (this != &other) {
+            _file = std::move(other._file);
+            _path = std::move(other._path);
+            _entries = std::exchange(other._entries, nullptr);
+            _names = std::exchange(other._names, nullptr);
+            _entryCount = std::exchange(other._entryCount, 0);
+        }
+        return *this;
+    }
+
+    bool PakFile::open(const char* path) {
+        close();
+        if (!_file.open(path)) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to map pak '{0}'!", path);
+            return false;
+        }
+
+        const uint8_t* data = _file.data();
+        size_t size = _file.size();
+
+        PakHeader header{};
+        if (size < sizeof(PakHeader)) { goto invalid; }
+        memcpy(&header, data, sizeof(PakHeader));
+
+        if (header.signature != PAK_SIG || header.version.getMajor() != PakVersion.getMajor()) {
+            JE_CORE_ERROR("[AssetPacking] Error: '{0}' isn't a supported pak! (Version {1})", path, header.version.toString());
+            close();
+            return false;
+        }
+
+        if (header.namesOffset > size || header.namesSize > size - header.namesOffset ||
+            header.tocOffset > size || uint64_t(header.entryCount) * sizeof(PakEntry) > size - header.tocOffset) {
+            goto invalid;
+        }
+
+        _entries = reinterpret_cast<const PakEntry*>(data + header.tocOffset);
+        _names = reinterpret_cast<const char*>(data + header.namesOffset);
+        _entryCount = header.entryCount;
+
+        for (size_t i = 0; i < _entryCount; i++) {
+            const PakEntry& entry = _entries[i];
+
+            //Reading an entry with a codec this build doesn't know as raw data would hand out garbage
+            if ((entry.flags & ~uint16_t(PAK_ENTRY_CODEC_MASK)) != 0 || entry.flags == PAK_ENTRY_CODEC_MASK) {
+                JE_CORE_ERROR("[AssetPacking] Error: Pak '{0}' uses unsupported entry flags '{1:x}'!", path, entry.flags);
+                close();
+                return false;
+            }
+
+            if (entry.offset > size || entry.size > size - entry.offset ||
+                uint64_t(entry.nameOffset) + entry.nameLength > header.namesSize ||
+                (!entry.isCompressed() && entry.size != entry.rawSize)) {
+                goto invalid;
+            }
+        }
+        _path = path;
+        return true;
+
+    invalid:
+        JE_CORE_ERROR("[AssetPacking] Error: Pak '{0}' is truncated or corrupted!", path);
+        close();
+        return false;
+    }
+
+    void PakFile::close() {
+        _file.close();
+        _path.clear();
+        _entries = nullptr;
+        _names = nullptr;
+        _entryCount = 0;
+    }
+
+    size_t PakFile::indexOf(ConstSpan<char> path) const {
+        path = trimPath(path);
+        uint64_t hash = IO::hashPath(path, true);
+
+        const PakEntry* end = _entries + _entryCount;
+        const PakEntry* entry = std::lower_bound(_entries, end, hash, [](const PakEntry& lhs, uint64_t rhs) {
+            return lhs.hash < rhs;
+        });
+
+        for (; entry < end && entry->hash == hash; entry++) {
+            if (IO::pathsAreEqual(getName(*entry), path)) {
+                return size_t(entry - _entries);
+            }
+        }
+        return SIZE_MAX;
+    }
+
+    Span<const uint8_t> PakFile::view(const PakEntry& entry) const {
+        if (!isOpen()) { return Span<const uint8_t>(); }
+        return Span<const uint8_t>(_file.data() + entry.offset, size_t(entry.size));
+    }
+
+    bool PakFile::read(const PakEntry& entry, void* buffer, size_t bufferSize, bool verifyCRC) const {
+        if (!isOpen()) { return false; }
+
+        if (bufferSize < entry.rawSize) {
+            JE_CORE_ERROR("[AssetPacking] Error: Buffer is too small for '{0}'! ({1} < {2} bytes)", std::string_view(getName(entry).get(), entry.nameLength), bufferSize, entry.rawSize);
+            return false;
+        }
+
+        const uint8_t* stored = _file.data() + entry.offset;
+        if (entry.isCompressed()) {
+            int32_t ret = (entry.flags & PAK_ENTRY_LZ4) ?
+                LZ4::decompressData(stored, size_t(entry.size), buffer, size_t(entry.rawSize)) :
+                ZLib::inflateData(const_cast<uint8_t*>(stored), size_t(entry.size), buffer, size_t(entry.rawSize));
+            if (ret < 0 || uint64_t(ret) != entry.rawSize) {
+                JE_CORE_ERROR("[AssetPacking] Error: Failed to decompress '{0}'!", std::string_view(getName(entry).get(), entry.nameLength));
+                return false;
+            }
+        }
+        else if (entry.rawSize > 0) {
+            memcpy(buffer, stored, size_t(entry.rawSize));
+        }
+
+        if (verifyCRC && calculateCRC(buffer, size_t(entry.rawSize)) != entry.crc) {
+            JE_CORE_ERROR("[AssetPacking] Error: CRC mismatch in '{0}'!", std::string_view(getName(entry).get(), entry.nameLength));
+            return false;
+        }
+        return true;
+    }
+
+    bool PakFile::read(const PakEntry& entry, std::vector<uint8_t>& data, bool verifyCRC) const {
+        data.resize(size_t(entry.rawSize));
+        return read(entry, data.data(), data.size(), verifyCRC);
+    }
+
+    bool PakFile::verify(const PakEntry& entry) const {
+        if (!isOpen()) { return false; }
+        if (!entry.isCompressed()) {
+            return calculateCRC(_file.data() + entry.offset, size_t(entry.rawSize)) == entry.crc;
+        }
+
+        std::vector<uint8_t> temp{};
+        return read(entry, temp, true);
+    }
+
+    bool packAssets(ConstSpan<char> root, const Stream& stream, uint32_t flags, int32_t compression) {
+        fs::path rootP(root.get(), root.get() + root.length());
+        std::vector<IO::FilePath> paths{};
+        if (!IO::exists(root) || !IO::getAll(rootP, IO::F_TYPE_FILE, paths, true)) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to collect files from '{0}'!", std::string_view(root.get(), root.length()));
+            return false;
+        }
+
+        std::vector<PakSource> files{};
+        files.reserve(paths.size());
+        for (const auto& pth : paths) {
+            std::string full = pth.path.string();
+            std::string rel = fs::relative(pth.path, rootP).string();
+            files.emplace_back(ConstSpan<char>(rel.c_str(), rel.length()), ConstSpan<char>(full.c_str(), full.length()));
+        }
+
+        //Directory iteration order isn't guaranteed, sorting keeps repeated packs byte identical
+        std::sort(files.begin(), files.end(), [](const PakSource& lhs, const PakSource& rhs) {
+            return compareNames(ConstSpan<char>(lhs.name.c_str(), lhs.name.length()), ConstSpan<char>(rhs.name.c_str(), rhs.name.length())) < 0;
+        });
+
+        PakWriter writer{};
+        return writer.begin(stream, flags, compression) && writer.addFiles(files) && writer.end();
+    }
+
+    bool packAssets(ConstSpan<char> root, ConstSpan<char> path, uint32_t flags, int32_t compression) {
+        FileStream stream(path.get(), path.length());
+        if (!stream.open("wb")) {
+            JE_CORE_ERROR("[AssetPacking] Error: Failed to open '{0}' for writing!", std::string_view(path.get(), path.length()));
+            return false;
+        }
+        return packAssets(root, stream, flags, compression);
+    }
+}
@@ -0,0 +1,294 @@
+#include <JEngine/Assets/AssetResidency.h>
+#include <JEngine/Core/Log.h>
+#include <algorithm>
+
+namespace JEngine {
+    static AssetRef toRef(uint64_t key) {
+        AssetRef ref{};
+        ref.uuid = key;
+        return ref;
+    }
+
+    AssetResidency::AssetResidency() : _entries(), _lru(), _tick(0), _budget(NO_BUDGET), _sourceBudgets(), _stats(), _evict(), _evicting(false) {
+        std::fill_n(_sourceBudgets, ResidencyStats::MAX_SOURCES, NO_BUDGET);
+    }
+
+    void AssetResidency::setBudget(size_t bytes) {
+        _budget = bytes;
+        trim();
+    }
+
+    void AssetResidency::setSourceBudget(uint8_t source, size_t bytes) {
+        if (source >= ResidencyStats::MAX_SOURCES) { return; }
+        _sourceBudgets[source] = bytes;
+        trim();
+    }
+
+    void AssetResidency::setResident(AssetRef ref, size_t bytes) {
+        if (!ref.isValid()) { return; }
+
+        Entry& entry = _entries[ref.uuid];
+        if (entry.resident) {
+            addBytes(ref.uuid, entry, false);
+            if (entry.refs > 0) {
+                addReferenced(entry, false);
+            }
+            else {
+                unlink(ref.uuid, entry);
+            }
+        }
+
+        entry.resident = true;
+        entry.bytes = bytes;
+        addBytes(ref.uuid, entry, true);
+        if (entry.refs > 0) {
+            addReferenced(entry, true);
+        }
+        else {
+            link(ref.uuid, entry);
+        }
+        trim();
+    }
+
+    void AssetResidency::setUnloaded(AssetRef ref) {
+        auto it = _entries.find(ref.uuid);
+        if (it == _entries.end() || !it->second.resident) { return; }
+
+        Entry& entry = it->second;
+        if (entry.refs > 0) {
+            addReferenced(entry, false);
+        }
+        else {
+            unlink(ref.uuid, entry);
+        }
+        addBytes(ref.uuid, entry, false);
+
+        entry.resident = false;
+        entry.bytes = 0;
+        if (entry.refs < 1) {
+            _entries.erase(it);
+        }
+    }
+
+    bool AssetResidency::isResident(AssetRef ref) const {
+        auto it = _entries.find(ref.uuid);
+        return it != _entries.end() && it->second.resident;
+    }
+
+    uint32_t AssetResidency::acquire(AssetRef ref) {
+        if (!ref.isValid()) { return 0; }
+
+        Entry& entry = _entries[ref.uuid];
+        if (entry.refs < 1 && entry.resident) {
+            unlink(ref.uuid, entry);
+            addReferenced(entry, true);
+        }
+        return ++entry.refs;
+    }
+
+    uint32_t AssetResidency::release(AssetRef ref) {
+        auto it = _entries.find(ref.uuid);
+        if (it == _entries.end() || it->second.refs < 1) {
+            JE_CORE_WARN("[AssetResidency] Warning: Released asset '{0:x}' that wasn't referenced!", ref.uuid);
+            return 0;
+        }
+
+        Entry& entry = it->second;
+        if (--entry.refs > 0) { return entry.refs; }
+
+        if (!entry.resident) {
+            _entries.erase(it);
+            return 0;
+        }
+
+        addReferenced(entry, false);
+        link(ref.uuid, entry);
+
+        //Referenced assets may have kept us over budget until now
+        trim();
+        return 0;
+    }
+
+    uint32_t AssetResidency::getRefCount(AssetRef ref) const {
+        auto it = _entries.find(ref.uuid);
+        return it != _entries.end() ? it->second.refs : 0;
+    }
+
+    void AssetResidency::touch(AssetRef ref) {
+        auto it = _entries.find(ref.uuid);
+        if (it == _entries.end() || !it->second.resident || it->second.refs > 0) { return; }
+
+        unlink(ref.uuid, it->second);
+        link(ref.uuid, it->second);
+    }
+
+    size_t AssetResidency::trim() {
+        //Evict callbacks are free to call back into us, they can't start another trim
+        if (_evicting || !_evict) { return 0; }
+        _evicting = true;
+
+        size_t before = _stats.evictedBytes;
+        for (size_t i = 0; i < ResidencyStats::MAX_SOURCES; i++) {
+            //Assets that refuse to unload go to the back, every one gets a single try per trim
+            for (size_t tries = _lru[i].count; tries > 0 && _stats.sourceBytes[i] > _sourceBudgets[i]; tries--) {
+                evict(_lru[i].head);
+            }
+        }
+
+        size_t tries = 0;
+        for (const auto& list : _lru) {
+            tries += list.count;
+        }
+
+        for (; tries > 0 && _stats.residentBytes > _budget; tries--) {
+            uint64_t key = pickOldest();
+            if (key == detail::NULL_ASSET) { break; }
+            evict(key);
+        }
+
+        _evicting = false;
+        return _stats.evictedBytes - before;
+    }
+
+    size_t AssetResidency::evictUnreferenced() {
+        if (_evicting || !_evict) { return 0; }
+        _evicting = true;
+
+        size_t before = _stats.evictedBytes;
+        for (auto& list : _lru) {
+            for (size_t tries = list.count; tries > 0; tries--) {
+                evict(list.head);
+            }
+        }
+
+        _evicting = false;
+        return _stats.evictedBytes - before;
+    }
+
+    void AssetResidency::clear() {
+        _entries.clear();
+        std::fill_n(_lru, ResidencyStats::MAX_SOURCES, LRUList());
+
+        //Eviction totals are kept, they describe the lifetime of the residency and not what's loaded
+        size_t evictedBytes = _stats.evictedBytes;
+        size_t evictedCount = _stats.evictedCount;
+        _stats = ResidencyStats();
+        _stats.evictedBytes = evictedBytes;
+        _stats.evictedCount = evictedCount;
+    }
+
+    void AssetResidency::link(uint64_t key, Entry& entry) {
+        LRUList& list = _lru[toRef(key).getSource()];
+        entry.stamp = ++_tick;
+        entry.prev = list.tail;
+        entry.next = detail::NULL_ASSET;
+
+        if (list.tail != detail::NULL_ASSET) {
+            _entries[list.tail].next = key;
+        }
+        else {
+            list.head = key;
+        }
+        list.tail = key;
+        list.count++;
+    }
+
+    void AssetResidency::unlink(uint64_t key, Entry& entry) {
+        LRUList& list = _lru[toRef(key).getSource()];
+        if (entry.prev != detail::NULL_ASSET) {
+            _entries[entry.prev].next = entry.next;
+        }
+        else {
+            list.head = entry.next;
+        }
+
+        if (entry.next != detail::NULL_ASSET) {
+            _entries[entry.next].prev = entry.prev;
+        }
+        else {
+            list.tail = entry.prev;
+        }
+
+        entry.prev = detail::NULL_ASSET;
+        entry.next = detail::NULL_ASSET;
+        list.count--;
+    }
+
+    void AssetResidency::addBytes(uint64_t key, const Entry& entry, bool add) {
+        AssetRef ref = toRef(key);
+        uint8_t source = ref.getSource();
+        uint8_t type = ref.getType();
+        if (add) {
+            _stats.residentBytes += entry.bytes;
+            _stats.residentCount++;
+            _stats.sourceBytes[source] += entry.bytes;
+            _stats.sourceCount[source]++;
+            _stats.typeBytes[type] += entry.bytes;
+            _stats.typeCount[type]++;
+            return;
+        }
+        _stats.residentBytes -= entry.bytes;
+        _stats.residentCount--;
+        _stats.sourceBytes[source] -= entry.bytes;
+        _stats.sourceCount[source]--;
+        _stats.typeBytes[type] -= entry.bytes;
+        _stats.typeCount[type]--;
+    }
+
+    void AssetResidency::addReferenced(const Entry& entry, bool add) {
+        if (add) {
+            _stats.referencedBytes += entry.bytes;
+            _stats.referencedCount++;
+            return;
+        }
+        _stats.referencedBytes -= entry.bytes;
+        _stats.referencedCount--;
+    }
+
+    uint64_t AssetResidency::pickOldest() const {
+        uint64_t oldest = detail::NULL_ASSET;
+        uint64_t stamp = UINT64_MAX;
+        for (const auto& list : _lru) {
+            if (list.head == detail::NULL_ASSET) { continue; }
+
+            uint64_t headStamp = _entries.find(list.head)->second.stamp;
+            if (headStamp < stamp) {
+                stamp = headStamp;
+                oldest = list.head;
+            }
+        }
+        return oldest;
+    }
+
+    bool AssetResidency::evict(uint64_t key) {
+        auto it = _entries.find(key);
+        if (it == _entries.end()) { return false; }
+        size_t bytes = it->second.bytes;
+
+        bool unloaded = _evict(toRef(key));
+
+        //The callback might've already reported the unload itself
+        it = _entries.find(key);
+        if (it == _entries.end() || !it->second.resident) {
+            if (unloaded) {
+                _stats.evictedBytes += bytes;
+                _stats.evictedCount++;
+            }
+            return unloaded;
+        }
+
+        //Or referenced it again, in which case it's no longer ours to evict
+        if (it->second.refs > 0) { return false; }
+
+        if (!unloaded) {
+            unlink(key, it->second);
+            link(key, it->second);
+            return false;
+        }
+
+        setUnloaded(toRef(key));
+        _stats.evictedBytes += bytes;
+        _stats.evictedCount++;
+        return true;
+    }
+}
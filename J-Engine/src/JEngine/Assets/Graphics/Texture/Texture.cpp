@@ -358,76 +358,20 @@ namespace JEngine {
         }
     }
 
-    TextureGenState* getTextureGens() {
-        static TextureGenState TEX_GEN_STATE[MAX_TEXTURES_QUEUED]{};
-        return TEX_GEN_STATE;
-    }
-
-    int32_t getFirstAvailableTexGen() {
-        auto gens = getTextureGens();
-        for (int32_t i = 0; i < MAX_TEXTURES_QUEUED; i++) {
-            if (gens[i].state == TEX_GEN_FREE) { return i; }
-        }
-        return -1;
-    }
-
-    void waitForTexGen(int32_t index, size_t sleepFor) {
-        while (shouldWaitForTexGen(index)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(sleepFor));
-        }
-    }
-
-    bool shouldWaitForTexGen(int32_t index) {
-        auto& gen = getTextureGens()[index];
-        switch (gen.state)
-        {
-            default: return true;
-            case TEX_GEN_IDLE:
-                gen.state = TEX_GEN_FREE;
-                return false;
-            case TEX_GEN_FREE:
-                return false;
-        }
-    }
-
-    int32_t setupTexGen(std::shared_ptr<Texture>& texture, const ImageData& data) {
-        int32_t nextValid = getFirstAvailableTexGen();
-
-        while (nextValid < 0) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            nextValid = getFirstAvailableTexGen();
-        }
-
-        auto& genState = getTextureGens()[nextValid];
-        genState.state = TEX_GEN_WAIT;
-        genState.texture = &texture;
-        genState.data = data;
-        return nextValid;
-    }
-
-    void updateTexGen() {
-        auto texGens = getTextureGens();
-        for (size_t i = 0; i < MAX_TEXTURES_QUEUED; i++) {
-            auto& genState = texGens[i];
-            if (genState.state == TEX_GEN_WAIT) {
-                auto& data = genState.data;
-                genState.state = TEX_GEN_PROCESSING;
-
-                if (genState.texture) {
-                    std::shared_ptr<Texture>& tex = *genState.texture;
-                    if (!tex) {
-                        tex = std::make_shared<Texture>();
-                    }
-
-                    if (tex) {
-                        tex->create(data.data, data.format, data.paletteSize, data.width, data.height, data.filter, data.flags);
-                    }
+    uint64_t loadTextureAsync(AssetLoader& loader, ConstSpan<char> path, LoadPriority priority, std::function<void(std::shared_ptr<Texture>)> onLoaded) {
+        return loader.load(path, LoadType::Image, priority, [onLoaded = std::move(onLoaded)](LoadResult& result) {
+            std::shared_ptr<Texture> texture{};
+            if (result.succeeded()) {
+                texture = std::make_shared<Texture>();
+                if (!texture->create(result.image)) {
+                    JE_CORE_WARN("[Texture] Warning: Failed to create texture from '{0}'!", result.path);
+                    texture.reset();
                 }
+            }
 
-                genState.state = TEX_GEN_IDLE;
-                genState.texture = {};
-                genState.data = {};
+            if (onLoaded) {
+                onLoaded(texture);
             }
-        }
+        });
     }
 }
\ No newline at end of file
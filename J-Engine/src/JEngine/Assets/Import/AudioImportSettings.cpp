@@ -6,6 +6,8 @@ namespace JEngine {
         flags.setBit(F_IS_MONO, Serialization::deserialize<bool>(node["isMono"]));
         flags.setBit(F_USE_SECTIONS, Serialization::deserialize<bool>(node["useSections"]));
         flags.setBit(F_USE_BEATS, Serialization::deserialize<bool>(node["useBetas"]));
+        Serialization::deserialize("sampleRate", sampleRate, node, DEFAULT_SAMPLE_RATE);
+        quality = Serialization::deserialize<bool>(node["linearResample"]) ? ResampleQuality::Linear : ResampleQuality::Sinc;
         return false;
     }
 
@@ -21,4 +23,28 @@ namespace JEngine {
     bool AudioImportSettings::serialize(const Stream& stream) const {
         return false;
     }
+
+    bool AudioImportSettings::convertSampleRate(AudioData& audio) const {
+        if (!flags.isBitSet(F_CONVERT_SAMPLE_RATE) || audio.sampleRate == sampleRate || sampleRate < 1) { return true; }
+
+        AudioData converted{};
+        if (!Resampler::convert(audio, converted, sampleRate, quality)) { return false; }
+
+        //Hands the converted buffer over without copying it
+        audio.release();
+        audio.clear(false);
+        audio.format = converted.format;
+        audio.sampleType = converted.sampleType;
+        audio.depth = converted.depth;
+        audio.channels = converted.channels;
+        audio.sampleRate = converted.sampleRate;
+        audio.blockAlign = converted.blockAlign;
+        audio.sampleCount = converted.sampleCount;
+        audio.data = converted.data;
+        audio.flags = AUD_FLAG_OWNS_BUFFER;
+
+        converted.data = nullptr;
+        converted.flags = AUD_FLAG_NONE;
+        return true;
+    }
 }
\ No newline at end of file
@@ -13,5 +13,19 @@ namespace JEngine {
         return false;
     }
 
+    void AudioClip::setAudioData(AudioData& data) {
+        unload();
+
+        _audioData = data;
+        data.data = nullptr;
+        data.clear(false);
+
+        _counts = {};
+        _sections[0] = {};
+        _sections[0].endSample = uint32_t(_audioData.sampleCount);
+        _acFlags.setBit(AC_FLAG_IS_MONO, _audioData.channels == 1);
+        getFlags() |= FLAG_IS_LOADED;
+    }
+
 
 }
\ No newline at end of file
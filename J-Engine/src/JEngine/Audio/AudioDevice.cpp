@@ -0,0 +1,184 @@
+#include <JEngine/Audio/AudioDevice.h>
+#include <JEngine/Core/Log.h>
+#include <algorithm>
+#include <thread>
+
+namespace JEngine {
+
+    bool NullAudioDevice::open(uint32_t sampleRate, uint32_t bufferFrames) {
+        if (sampleRate < 1 || bufferFrames < 1) { return false; }
+        begin(sampleRate, bufferFrames);
+        _start = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    void NullAudioDevice::close() {
+        _isOpen = false;
+    }
+
+    bool NullAudioDevice::waitForBuffer() {
+        if (!_isOpen) { return false; }
+
+        //The clock may be a buffer behind what's been submitted, like a device with a buffer queued
+        uint64_t submitted = getFramesSubmitted();
+        uint64_t ahead = submitted > _bufferFrames ? submitted - _bufferFrames : 0;
+        auto due = _start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(double(ahead) / _sampleRate));
+        std::this_thread::sleep_until(due);
+        return _isOpen;
+    }
+
+    size_t NullAudioDevice::submit(const float*, size_t frames) {
+        if (!_isOpen) { return 0; }
+        _framesSubmitted.fetch_add(frames, std::memory_order_relaxed);
+        return frames;
+    }
+
+    OfflineAudioDevice::OfflineAudioDevice(const Stream& stream, uint64_t frameLimit, AudioSampleType type, uint8_t depth) :
+        _stream(&stream), _frameLimit(frameLimit), _type(type), _depth(depth), _writer() {}
+
+    OfflineAudioDevice::~OfflineAudioDevice() {
+        close();
+    }
+
+    bool OfflineAudioDevice::open(uint32_t sampleRate, uint32_t bufferFrames) {
+        if (_isOpen || bufferFrames < 1) { return false; }
+        if (!_writer.open(*_stream, _type, _depth, CHANNELS, sampleRate)) {
+            JE_CORE_ERROR("[Audio Device] Error: Failed to open WAV output for offline rendering!");
+            return false;
+        }
+        begin(sampleRate, bufferFrames);
+        return true;
+    }
+
+    void OfflineAudioDevice::close() {
+        if (!_isOpen) { return; }
+        _writer.close();
+        _isOpen = false;
+    }
+
+    bool OfflineAudioDevice::waitForBuffer() {
+        return _isOpen && getFramesSubmitted() < _frameLimit;
+    }
+
+    size_t OfflineAudioDevice::submit(const float* samples, size_t frames) {
+        if (!_isOpen) { return 0; }
+
+        size_t count = size_t(std::min<uint64_t>(frames, _frameLimit - getFramesSubmitted()));
+        size_t written = _writer.writeFloat(samples, count);
+        _framesSubmitted.fetch_add(written, std::memory_order_relaxed);
+        if (written != count) {
+            JE_CORE_ERROR("[Audio Device] Error: Failed to write offline audio!");
+            close();
+        }
+        return written;
+    }
+
+#ifdef _WIN32
+    XAudio2Device::XAudio2Device() :
+        _xEngine(nullptr), _xMaster(nullptr), _xSource(nullptr), _callback(), _comInit(false), _buffers(), _nextBuffer(0) {}
+
+    XAudio2Device::~XAudio2Device() {
+        close();
+    }
+
+    bool XAudio2Device::open(uint32_t sampleRate, uint32_t bufferFrames) {
+        if (_isOpen || sampleRate < 1 || bufferFrames < 1) { return false; }
+
+        _comInit = SUCCEEDED(CoInitializeEx(NULL, COINIT_MULTITHREADED));
+        if (FAILED(XAudio2Create(&_xEngine, 0, XAUDIO2_DEFAULT_PROCESSOR)) || FAILED(_xEngine->CreateMasteringVoice(&_xMaster))) {
+            JE_CORE_ERROR("[Audio Device] Error: Failed to initialize XAudio2!");
+            close();
+            return false;
+        }
+
+        WAVEFORMATEX format{};
+        format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+        format.nChannels = CHANNELS;
+        format.nSamplesPerSec = sampleRate;
+        format.wBitsPerSample = 32;
+        format.nBlockAlign = CHANNELS * sizeof(float);
+        format.nAvgBytesPerSec = sampleRate * format.nBlockAlign;
+        format.cbSize = 0;
+
+        _callback.bufferEnd = CreateEvent(NULL, FALSE, FALSE, NULL);
+        if (!_callback.bufferEnd || FAILED(_xEngine->CreateSourceVoice(&_xSource, &format, 0, XAUDIO2_DEFAULT_FREQ_RATIO, &_callback))) {
+            JE_CORE_ERROR("[Audio Device] Error: Failed to create XAudio2 source voice!");
+            close();
+            return false;
+        }
+
+        _buffers.assign(size_t(BUFFER_COUNT) * bufferFrames * CHANNELS, 0.0f);
+        _nextBuffer = 0;
+        begin(sampleRate, bufferFrames);
+        _xSource->Start(0);
+        return true;
+    }
+
+    void XAudio2Device::close() {
+        if (_xSource) {
+            _xSource->Stop(0);
+            _xSource->DestroyVoice();
+            _xSource = nullptr;
+        }
+
+        if (_xMaster) {
+            _xMaster->DestroyVoice();
+            _xMaster = nullptr;
+        }
+
+        if (_xEngine) {
+            _xEngine->Release();
+            _xEngine = nullptr;
+        }
+
+        if (_callback.bufferEnd) {
+            CloseHandle(_callback.bufferEnd);
+            _callback.bufferEnd = nullptr;
+        }
+
+        if (_comInit) {
+            CoUninitialize();
+            _comInit = false;
+        }
+        _isOpen = false;
+    }
+
+    bool XAudio2Device::waitForBuffer() {
+        if (!_isOpen) { return false; }
+
+        XAUDIO2_VOICE_STATE state{};
+        _xSource->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+        if (state.BuffersQueued >= BUFFER_COUNT) {
+            //Times out so the mixer thread can still notice it's being stopped if the device stalls,
+            //'submit' takes nothing if the ring is still full and the mixer offers the same block again
+            WaitForSingleObject(_callback.bufferEnd, 100);
+        }
+        return _isOpen;
+    }
+
+    size_t XAudio2Device::submit(const float* samples, size_t frames) {
+        if (!_isOpen) { return 0; }
+
+        XAUDIO2_VOICE_STATE state{};
+        _xSource->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+        if (state.BuffersQueued >= BUFFER_COUNT) { return 0; }
+
+        frames = std::min<size_t>(frames, _bufferFrames);
+        float* buffer = _buffers.data() + size_t(_nextBuffer) * _bufferFrames * CHANNELS;
+        memcpy(buffer, samples, frames * CHANNELS * sizeof(float));
+
+        XAUDIO2_BUFFER xBuffer{};
+        xBuffer.AudioBytes = UINT32(frames * CHANNELS * sizeof(float));
+        xBuffer.pAudioData = reinterpret_cast<const BYTE*>(buffer);
+        if (FAILED(_xSource->SubmitSourceBuffer(&xBuffer))) {
+            JE_CORE_ERROR("[Audio Device] Error: Failed to submit audio buffer!");
+            close();
+            return 0;
+        }
+
+        _nextBuffer = (_nextBuffer + 1) % BUFFER_COUNT;
+        _framesSubmitted.fetch_add(frames, std::memory_order_relaxed);
+        return frames;
+    }
+#endif
+}
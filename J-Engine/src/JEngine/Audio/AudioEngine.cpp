@@ -1,248 +1,286 @@
 #include <JEngine/Audio/AudioEngine.h>
+#include <JEngine/Core/Log.h>
+#include <algorithm>
+#include <cstring>
 
 namespace JEngine {
 
-    AudioEngine::AudioEngine() : 
-        _format{}, _xEngine{ nullptr }, _xMaster{nullptr}{
-        auto ret = CoInitializeEx(NULL, COINITBASE_MULTITHREADED);
-        _format.cbSize = 0;
-        _format.nChannels = AUDIO_CHANNELS;
-        _format.nSamplesPerSec = AUDIO_SAMPLE_RATE;
-        _format.wFormatTag = AUDIO_FORMAT;
-        _format.wBitsPerSample = AUDIO_BIT_DEPTH;
-        _format.nAvgBytesPerSec = DWORD(AUDIO_BUFFER_SIZE);
-        _format.nBlockAlign = (AUDIO_CHANNELS * AUDIO_BIT_DEPTH) / 8;
-        
-        ret = XAudio2Create(&_xEngine);
-        _xEngine->CreateMasteringVoice(&_xMaster);
+    static_assert(MixVoice::MAX_LAYERS == AudioClip::MAX_AUDIO_LAYERS, "Mixer layer count doesn't match clips!");
+    static_assert(AudioEngine::MAX_VOICES < 0xFF, "Voice indices have to fit in a byte!");
 
-
-
-    }
-
-    AudioEngine::~AudioEngine() {
-        if (_xEngine) {
-            _xEngine->Release();
-            _xEngine = nullptr;
+    AudioEngine::AudioEngine() :
+        _device(nullptr), _thread(), _running(false), _stopRequested(false), _commands(), _mixer(AUDIO_SAMPLE_RATE) {
+        _idleVoices.reserve(MAX_VOICES);
+        _activeVoices.reserve(MAX_VOICES);
+        _mixing.reserve(MAX_VOICES);
+        for (int32_t i = MAX_VOICES - 1; i >= 0; i--) {
+            _idleVoices.push_back(uint8_t(i));
         }
-        CoUninitialize();
     }
 
-    void __stdcall AudioEngine::VoiceCallback::OnBufferStart(void* bufferContext) {
-        AudioEngine::Voice* voice = (AudioEngine::Voice*)bufferContext;
-        voice->mixAudioSource();
-    }
-
-    void __stdcall AudioEngine::VoiceCallback::OnBufferEnd(void* bufferContext) {
-        AudioEngine::Voice* voice = (AudioEngine::Voice*)bufferContext;
-
+    AudioEngine::~AudioEngine() {
+        stop();
     }
 
-    template<size_t size, AudioSampleType type>
-    static inline float getSampleF(const uint8_t* data) { return 0; }
+    bool AudioEngine::start(IAudioDevice& device, uint32_t bufferFrames) {
+        if (_thread.joinable()) {
+            JE_CORE_WARN("[Audio Engine] Warning: Audio engine is already running!");
+            return false;
+        }
 
-    template<>
-    inline float getSampleF<8, AudioSampleType::Signed>(const uint8_t* data) {
-        return Audio::sampleI8ToF_T(*reinterpret_cast<const int8_t*>(data));
-    }
+        if (!device.open(AUDIO_SAMPLE_RATE, bufferFrames)) {
+            JE_CORE_ERROR("[Audio Engine] Error: Failed to open audio device!");
+            return false;
+        }
 
-    template<>
-    inline float getSampleF<8, AudioSampleType::Unsigned>(const uint8_t* data) {
-        return Audio::sampleU8ToF_T(*data);
+        _device = &device;
+        _bus.assign(size_t(bufferFrames) * AUDIO_CHANNELS, 0.0f);
+        _stopRequested.store(false, std::memory_order_relaxed);
+        _running.store(true, std::memory_order_release);
+        _thread = std::thread(&AudioEngine::mixerLoop, this);
+        return true;
     }
 
-
-    template<>
-    inline float getSampleF<16, AudioSampleType::Signed>(const uint8_t* data) {
-        return Audio::sampleI16ToF_T(*reinterpret_cast<const int16_t*>(data));
+    void AudioEngine::stop() {
+        _stopRequested.store(true, std::memory_order_release);
+        join();
     }
 
-    template<>
-    inline float getSampleF<16, AudioSampleType::Unsigned>(const uint8_t* data) {
-        return Audio::sampleU16ToF_T(*reinterpret_cast<const uint16_t*>(data));
+    void AudioEngine::finish() {
+        join();
     }
 
-    template<>
-    inline float getSampleF<32, AudioSampleType::Signed>(const uint8_t* data) {
-        return Audio::fromSampleI32F(*reinterpret_cast<const int32_t*>(data));
-    }
+    void AudioEngine::join() {
+        if (_thread.joinable()) {
+            _thread.join();
+        }
 
-    template<>
-    inline float getSampleF<32, AudioSampleType::Unsigned>(const uint8_t* data) {
-        return Audio::fromSampleU32F(*reinterpret_cast<const uint32_t*>(data));
+        if (_device) {
+            _device->close();
+            _device = nullptr;
+        }
     }
 
-    typedef float (*GetAudioSample)(const uint8_t*);
+    bool AudioEngine::setupCommand(const IAudioSource& source, Command& command) {
+        auto clip = source._clip;
+        auto& clipData = clip->getAudioData();
+        uint8_t layers = uint8_t(clip->getLayerCount());
+        if (!AudioMixer::isSupported(clipData, layers)) {
+            JE_CORE_WARN("[Audio Engine] Warning: Audio bit depth '{0}' not supported!", int32_t(clipData.depth));
+            return false;
+        }
 
-    static void mixAudio(size_t* offsets, float* output, float* volumes, bool isMono, bool isLayered, uint8_t layers, const AudioData& audioData, GetAudioSample getSample) {     
-        size_t bps = (audioData.depth >> 3);
-        size_t bpsC = bps * audioData.channels;
+        float lVol = source._volume * Audio::getPanL(source._pan);
+        float rVol = source._volume * Audio::getPanR(source._pan);
 
-        if (isMono) {
-            if (isLayered) {
-                for (size_t i = 0, j = 0; i < audioData.sampleRate; i++) {
-                    for (size_t l = 0, lv = 0; l < layers; l++) {
-                        float sample = getSample(audioData.data + offsets[l]);
-                        output[j++] = volumes[lv++] * sample;
-                        output[j++] = volumes[lv++] * sample;
-                        offsets[l] += bpsC;
-                    }
-                }
-                return;
-            }
-            for (size_t i = 0, j = 0, k = offsets[0]; i < audioData.sampleRate; i++, k += bpsC) {
-                float sample = getSample(audioData.data + k);
-                output[j++] = volumes[0] * sample;
-                output[j++] = volumes[1] * sample;
+        if (clip->isLayered()) {
+            for (uint8_t i = 0; i < layers; i++) {
+                auto& layer = source._layers[i];
+                command.targets[i * 2 + 0] = lVol * Audio::getPanL(layer.pan) * layer.volume;
+                command.targets[i * 2 + 1] = rVol * Audio::getPanR(layer.pan) * layer.volume;
             }
-            return;
+        }
+        else {
+            command.targets[0] = lVol;
+            command.targets[1] = rVol;
         }
 
-        if (isLayered) {
-            for (size_t i = 0, j = 0; i < audioData.sampleRate; i++) {
-                for (size_t l = 0, lC = 0, lv = 0; l < layers; l++) {
-                    float sampleL = getSample(audioData.data + offsets[lC + 0]);
-                    float sampleR = getSample(audioData.data + offsets[lC + 1]);
+        //Sample rate conversion and pitch both happen in the mixer, positions are in clip frames
+        command.data = &clipData;
+        command.layers = clip->isLayered() ? layers : 1;
+        command.position = uint64_t(source._timeSamples);
+        command.pitch = source._pitch;
+        return true;
+    }
 
-                    output[j++] = volumes[lv++] * sampleL;
-                    output[j++] = volumes[lv++] * sampleR;
+    bool AudioEngine::send(const Command& command) {
+        if (_commands.push(command)) { return true; }
+        JE_CORE_WARN("[Audio Engine] Warning: Audio command queue is full, dropping command!");
+        return false;
+    }
 
-                    offsets[lC++] += bpsC;
-                    offsets[lC++] += bpsC;
-                }
-            }
-            return;
-        }
-        for (size_t i = 0, j = 0, k = offsets[0]; i < audioData.sampleRate; i++, k += bpsC) {
-            float sampleL = getSample(audioData.data + offsets[k + 0]);
-            float sampleR = getSample(audioData.data + offsets[k + 1]);
+    void AudioEngine::releaseVoice(size_t index) {
+        uint8_t voice = _activeVoices[index];
+        _activeVoices.erase(_activeVoices.begin() + index);
+        _idleVoices.push_back(voice);
 
-            output[j++] = volumes[0] * sampleL;
-            output[j++] = volumes[1] * sampleR;
-        }
+        VoiceSlot& slot = _slots[voice];
+        slot.source->_currentVoice = NO_VOICE;
+        slot.source->_asFlags.setBit(IAudioSource::AS_FLAG_IS_PLAYING, false);
+        slot.source = nullptr;
     }
 
-    void AudioEngine::Voice::mixAudioSource() {
-        if (!_aSource || !_aSource->_clip) { return; }
-        auto clip = _aSource->_clip;
-
-        if (clip->getSampleRate() > AUDIO_SAMPLE_RATE) {
-            JE_CORE_WARN("[Audio Engine] Warning: Audio sample rate must be less or equal to '{0}' but is '{1}'!", AUDIO_SAMPLE_RATE, clip->getSampleRate());
-            return;
+    bool AudioEngine::play(IAudioSource& source) {
+        if (!source._clip) {
+            JE_CORE_WARN("[Audio Engine] Warning: Cannot play an audio source without a clip!");
+            return false;
         }
 
-        float* samples = reinterpret_cast<float*>(_dBuffer);
-        memset(_dBuffer, 0, AUDIO_BUFFER_SIZE);
+        Command command{};
+        command.type = CommandType::Play;
+        if (!setupCommand(source, command)) { return false; }
 
-        uint8_t layers = clip->getLayerCount();
-        bool isLayered = clip->isLayered();
-        auto& clipData = clip->getAudioData();
+        //A source that's already playing restarts on the same voice
+        bool restart = isPlaying(source);
+        if (!restart && _idleVoices.empty()) {
+            JE_CORE_WARN("[Audio Engine] Warning: No free voices left!");
+            return false;
+        }
 
-        size_t bps = (clipData.depth >> 3);
-        size_t bpsC = bps * clipData.channels;
+        uint8_t voice = restart ? source._currentVoice : _idleVoices.back();
+        VoiceSlot& slot = _slots[voice];
+        command.voice = voice;
+        command.playId = slot.playId + 1;
+        if (!send(command)) { return false; }
+
+        slot.playId++;
+        if (!restart) {
+            _idleVoices.pop_back();
+            _activeVoices.push_back(voice);
+            slot.source = &source;
+            source._currentVoice = voice;
+        }
+        source._asFlags.setBit(IAudioSource::AS_FLAG_IS_PLAYING, true);
+        source._asFlags.setBit(SOURCE_CHANGED_FLAGS, false);
+        return true;
+    }
 
-        float lVol = _aSource->_volume * Audio::getPanL(_aSource->_pan);
-        float rVol = _aSource->_volume * Audio::getPanR(_aSource->_pan);
+    bool AudioEngine::stop(IAudioSource& source) {
+        if (!isPlaying(source)) { return false; }
 
-        size_t currentPos = _aSource->_timeSamples * bpsC;
+        Command command{};
+        command.type = CommandType::Stop;
+        command.voice = source._currentVoice;
+        if (!send(command)) { return false; }
 
-        size_t offsets[AudioClip::MAX_AUDIO_LAYERS * 2]{};
-        float volumes[AudioClip::MAX_AUDIO_LAYERS * 2] {};
+        //The mixer handles commands in order, so the voice can be handed out again right away
+        auto it = std::find(_activeVoices.begin(), _activeVoices.end(), source._currentVoice);
+        releaseVoice(size_t(it - _activeVoices.begin()));
+        return true;
+    }
 
-        GetAudioSample getSample{nullptr};
-        switch (clipData.depth) {
-            default:
-                JE_CORE_WARN("[Audio Engine] Warning: Audio bit depth '{0}' not supported!", int32_t(clipData.depth));
-                return;
-            case 8:
-                getSample = clipData.sampleType == AudioSampleType::Signed ? getSampleF<8, AudioSampleType::Signed> : getSampleF<8, AudioSampleType::Unsigned>;
-                break;  
-            case 16:
-                getSample = clipData.sampleType == AudioSampleType::Signed ? getSampleF<16, AudioSampleType::Signed> : getSampleF<16, AudioSampleType::Unsigned>;
-                break;
-            case 32:
-                getSample = clipData.sampleType == AudioSampleType::Signed ? getSampleF<32, AudioSampleType::Signed> : getSampleF<32, AudioSampleType::Unsigned>;
-                break;
-        }
+    bool AudioEngine::isPlaying(const IAudioSource& source) const {
+        return source._currentVoice < MAX_VOICES && _slots[source._currentVoice].source == &source;
+    }
 
-        if (clip->isMono()) {
-            for (size_t i = 0, j = 0; i < layers; i++ , j += bps) {
-                offsets[i] = j;
+    void AudioEngine::update() {
+        for (size_t i = _activeVoices.size(); i-- > 0;) {
+            uint8_t voice = _activeVoices[i];
+            VoiceSlot& slot = _slots[voice];
+            VoiceState& state = _states[voice];
+            IAudioSource& source = *slot.source;
+
+            if (state.ended.load(std::memory_order_acquire) == slot.playId) {
+                source._timeSamples = int64_t(state.position.load(std::memory_order_relaxed));
+                releaseVoice(i);
+                continue;
             }
-        }
-        else {
-            for (size_t i = 0, j = 0, k = 0; i < layers; i++) {
-                offsets[k++] = j;
-                j += bps;
-                offsets[k++] = j;
-                j += bps;
+
+            bool seek = source._asFlags.isBitSet(IAudioSource::AS_FLAG_CHANGED_TIME);
+            if (source._asFlags.isBitSet(SOURCE_CHANGED_FLAGS)) {
+                Command command{};
+                command.type = CommandType::Params;
+                command.voice = voice;
+                command.playId = slot.playId;
+                command.seek = seek;
+                if (setupCommand(source, command) && send(command)) {
+                    source._asFlags.setBit(SOURCE_CHANGED_FLAGS, false);
+                }
             }
-        }
 
-        if (isLayered) {
-            for (size_t i = 0, j = 0; i < layers; i++) {
-                auto& layer = _aSource->_layers[i];
-                volumes[j++] = lVol * Audio::getPanL(layer.pan) * layer.volume;
-                volumes[j++] = rVol * Audio::getPanR(layer.pan) * layer.volume;
+            //Until the mixer has picked up a play or seek the source keeps its own time
+            if (!seek && state.started.load(std::memory_order_acquire) == slot.playId) {
+                source._timeSamples = int64_t(state.position.load(std::memory_order_relaxed));
             }
         }
-        else {
-            volumes[0] = lVol;
-            volumes[1] = rVol;
-        }
-
-        mixAudio(offsets, samples, volumes, clip->isMono(), isLayered, layers, clipData, getSample);
-        _xBuffer.AudioBytes = clip->getSampleRate();
     }
 
-    bool AudioEngine::Voice::play(IAudioSource* aSource, VoiceBufferAllocator& allocator) {
-        _aSource = aSource;
-        _source->Stop(0);
-        _source->FlushSourceBuffers();
-        if (!_aSource || !_aSource->_clip) { 
-            return false;
-        }
-        _dBuffer = _dBuffer ? _dBuffer : allocator.allocate();
-        
-        if (!_dBuffer) {
-            JE_CORE_ERROR("[Audio Engine] Error: Failed to allocate/retrieve audio buffer!");
-            return false;
-        }
+    void AudioEngine::mixerLoop() {
+        const size_t frames = _device->getBufferFrames();
+        bool pending = false;
+        while (!_stopRequested.load(std::memory_order_acquire)) {
+            if (!_device->waitForBuffer()) { break; }
 
-        //_currentSample = _aSource->;
+            //A block the device had no room for is offered again instead of mixing past it
+            if (!pending) {
+                processCommands();
+                mixBuffer(frames);
+            }
 
-        mixAudioSource();
-        _xBuffer.pAudioData = _dBuffer->buffer;
-        _source->SetSourceSampleRate(_aSource->_clip->getSampleRate());
-        _source->SetFrequencyRatio(_aSource->_pitch);
-        _source->SubmitSourceBuffer(&_xBuffer);
-        _source->Start(0);
-        return true;
+            pending = _device->submit(_bus.data(), frames) < 1;
+            if (pending && !_device->isOpen()) {
+                JE_CORE_ERROR("[Audio Engine] Error: Audio device stopped taking audio!");
+                break;
+            }
+        }
+        _running.store(false, std::memory_order_release);
     }
 
-    bool AudioEngine::Voice::update() {
-        if (!_aSource) { return false; }
-
-        XAUDIO2_VOICE_STATE state{};
-        _source->GetState(&state, 0);
+    void AudioEngine::processCommands() {
+        Command command;
+        while (_commands.pop(command)) {
+            MixVoice& voice = _voices[command.voice];
+            VoiceState& state = _states[command.voice];
+            auto mixing = std::find(_mixing.begin(), _mixing.end(), command.voice);
+
+            switch (command.type) {
+                case CommandType::Play:
+                    voice.data = command.data;
+                    voice.layers = command.layers;
+                    voice.position = command.position;
+                    voice.fraction = 0;
+                    voice.pitch = command.pitch;
+                    memcpy(voice.targets, command.targets, sizeof(voice.targets));
+
+                    //A fresh clip starts at full volume, later changes ramp over a block
+                    voice.snapGains();
+
+                    _voiceIds[command.voice] = command.playId;
+                    state.position.store(command.position, std::memory_order_relaxed);
+                    state.started.store(command.playId, std::memory_order_release);
+                    if (mixing == _mixing.end()) {
+                        _mixing.push_back(command.voice);
+                    }
+                    break;
 
-        if (_aSource->_asFlags.isBitSet(IAudioSource::AS_FLAG_CHANGED_VOLUME)) {
-            mixAudioSource();
+                case CommandType::Stop:
+                    if (mixing != _mixing.end()) {
+                        _mixing.erase(mixing);
+                    }
+                    voice.data = nullptr;
+                    break;
+
+                case CommandType::Params:
+                    //Changes meant for an earlier play of the voice
+                    if (_voiceIds[command.voice] != command.playId || mixing == _mixing.end()) { break; }
+
+                    voice.pitch = command.pitch;
+                    memcpy(voice.targets, command.targets, sizeof(voice.targets));
+                    if (command.seek) {
+                        voice.position = command.position;
+                        voice.fraction = 0;
+                        state.position.store(command.position, std::memory_order_relaxed);
+                    }
+                    break;
+            }
         }
+    }
 
-        if (_aSource->_asFlags.isBitSet(IAudioSource::AS_FLAG_CHANGED_PITCH)) {
-            _source->SetFrequencyRatio(_aSource->_pitch);
-        }
+    void AudioEngine::mixBuffer(size_t frames) {
+        memset(_bus.data(), 0, frames * AUDIO_CHANNELS * sizeof(float));
 
-        if (_aSource->_asFlags.isBitSet(IAudioSource::AS_FLAG_CHANGED_TIME)) {
-            
-        }
-        else {
-            _aSource->_timeSamples = _currentSample + state.SamplesPlayed;
-        } 
+        for (size_t i = _mixing.size(); i-- > 0;) {
+            uint8_t index = _mixing[i];
+            MixVoice& voice = _voices[index];
+            VoiceState& state = _states[index];
 
-    
-        return true;
+            size_t mixed = _mixer.mix(voice, _bus.data(), frames);
+            state.position.store(voice.position, std::memory_order_relaxed);
+            if (mixed < frames) {
+                state.ended.store(_voiceIds[index], std::memory_order_release);
+                _mixing.erase(_mixing.begin() + i);
+                voice.data = nullptr;
+            }
+        }
     }
-
-}
\ No newline at end of file
+}
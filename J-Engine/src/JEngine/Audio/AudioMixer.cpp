@@ -0,0 +1,138 @@
+#include <JEngine/Audio/AudioMixer.h>
+#include <algorithm>
+
+namespace JEngine {
+
+    AudioMixer::AudioMixer(uint32_t sampleRate) :
+        _sampleRate(sampleRate), _resampler(), _samples(INPUT_FRAMES * MAX_CHANNELS), _layer(INPUT_FRAMES * 2), _resampled(BLOCK_FRAMES * 2) {}
+
+    bool AudioMixer::isSupported(const AudioData& data, uint8_t layers) {
+        if (!data.data || layers < 1 || data.channels < 1 || data.channels > MAX_CHANNELS || (data.channels % layers) != 0) { return false; }
+
+        uint8_t layerChannels = data.channels / layers;
+        if (layerChannels > 2) { return false; }
+
+        switch (data.sampleType) {
+            case AudioSampleType::Unsigned: return data.depth == 8;
+            case AudioSampleType::Signed:   return data.depth == 16 || data.depth == 24 || data.depth == 32;
+            case AudioSampleType::Float:    return data.depth == 32 || data.depth == 64;
+        }
+        return false;
+    }
+
+    size_t AudioMixer::mix(MixVoice& voice, float* output, size_t frames) {
+        if (!voice.data || !isSupported(*voice.data, voice.layers)) { return 0; }
+
+        uint64_t length = voice.data->sampleCount;
+        if (voice.position >= length) { return 0; }
+
+        uint64_t step = Resampler::getStep(voice.data->sampleRate, _sampleRate, voice.pitch);
+        if (step != Resampler::ONE || voice.fraction != 0) {
+            return mixResampled(voice, output, frames, step);
+        }
+
+        frames = size_t(std::min<uint64_t>(frames, length - voice.position));
+        for (size_t done = 0; done < frames;) {
+            size_t count = std::min(BLOCK_FRAMES, frames - done);
+            mixDirect(voice, output + done * 2, count);
+            voice.position += count;
+            done += count;
+        }
+        return frames;
+    }
+
+    bool AudioMixer::isAudible(const MixVoice& voice) {
+        //Nothing to convert if every layer is and stays silent
+        bool audible = false;
+        for (size_t i = 0; i < size_t(voice.layers) * 2; i++) {
+            audible |= voice.gains[i] != 0.0f || voice.targets[i] != 0.0f;
+        }
+        return audible;
+    }
+
+    void AudioMixer::mixDirect(MixVoice& voice, float* output, size_t frames) {
+        if (!isAudible(voice)) { return; }
+
+        const AudioData& data = *voice.data;
+        const size_t frameSize = data.channels * (data.depth >> 3);
+        Audio::samplesToFloat(data.data + voice.position * frameSize, data.sampleType, data.depth, _samples.data(), frames * data.channels);
+        mixLayers(voice, frames, 0, false, output, frames);
+    }
+
+    size_t AudioMixer::mixResampled(MixVoice& voice, float* output, size_t frames, uint64_t step) {
+        if (_resampler.getQuality() != voice.quality) {
+            _resampler.setQuality(voice.quality);
+        }
+        _resampler.setStep(step);
+        step = _resampler.getStep();
+
+        //The voice ends once its position passes the last frame
+        uint64_t position = (voice.position << Resampler::FRACTION_BITS) | voice.fraction;
+        uint64_t end = uint64_t(voice.data->sampleCount) << Resampler::FRACTION_BITS;
+        frames = size_t(std::min<uint64_t>(frames, (end - position + step - 1) / step));
+
+        //Shorter blocks for steps over 1 so the source frames they read still fit the scratch buffers
+        const size_t blockFrames = size_t(std::min<uint64_t>(BLOCK_FRAMES, (uint64_t(INPUT_FRAMES - Resampler::TAPS - 2) << Resampler::FRACTION_BITS) / step + 1));
+        const uint32_t lead = _resampler.getLead();
+
+        for (size_t done = 0; done < frames;) {
+            size_t count = std::min(blockFrames, frames - done);
+            if (isAudible(voice)) {
+                size_t inputFrames = _resampler.getInputFrames(position, count);
+                Resampler::loadFrames(*voice.data, int64_t(position >> Resampler::FRACTION_BITS) - lead, inputFrames, _samples.data());
+
+                //The loaded frames start 'lead' frames before the current one
+                uint64_t local = (position & (Resampler::ONE - 1)) + (uint64_t(lead) << Resampler::FRACTION_BITS);
+                mixLayers(voice, inputFrames, local, true, output + done * 2, count);
+            }
+            position += count * step;
+            done += count;
+        }
+
+        voice.position = position >> Resampler::FRACTION_BITS;
+        voice.fraction = uint32_t(position);
+        return frames;
+    }
+
+    void AudioMixer::mixLayers(MixVoice& voice, size_t inputFrames, uint64_t position, bool resample, float* output, size_t frames) {
+        const size_t channels = voice.data->channels;
+        const size_t layerChannels = channels / voice.layers;
+
+        const float invFrames = 1.0f / float(frames);
+        for (size_t l = 0; l < voice.layers; l++) {
+            float* gain = voice.gains + l * 2;
+            const float* target = voice.targets + l * 2;
+
+            if (gain[0] == 0.0f && gain[1] == 0.0f && target[0] == 0.0f && target[1] == 0.0f) { continue; }
+
+            const float* input = _samples.data();
+            if (voice.layers > 1) {
+                //Layers are interleaved with each other, so the layer is pulled out to keep the kernels contiguous
+                const float* source = _samples.data() + l * layerChannels;
+                float* layer = _layer.data();
+                for (size_t f = 0, j = 0; f < inputFrames; f++, source += channels) {
+                    for (size_t c = 0; c < layerChannels; c++) {
+                        layer[j++] = source[c];
+                    }
+                }
+                input = layer;
+            }
+
+            if (resample) {
+                _resampler.process(input, uint32_t(layerChannels), position, _resampled.data(), frames);
+                input = _resampled.data();
+            }
+
+            float stepL = (target[0] - gain[0]) * invFrames;
+            float stepR = (target[1] - gain[1]) * invFrames;
+            if (layerChannels == 1) {
+                Audio::mixMonoToStereo(input, output, frames, gain[0], gain[1], stepL, stepR);
+            }
+            else {
+                Audio::mixStereo(input, output, frames, gain[0], gain[1], stepL, stepR);
+            }
+            gain[0] = target[0];
+            gain[1] = target[1];
+        }
+    }
+}
@@ -0,0 +1,284 @@
+#include <JEngine/Audio/Resampler.h>
+#include <JEngine/Core/Log.h>
+#include <JEngine/Utility/SIMD.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace JEngine {
+    //Cutoff relative to the lower of the two Nyquist frequencies and the Kaiser window's beta
+    static constexpr double SINC_CUTOFF = 0.88;
+    static constexpr double SINC_BETA = 7.5;
+
+    //Downsampling tables are kept per 1/8th of a step, index 0 is the one for upsampling
+    static constexpr uint32_t TABLE_STEPS = 8;
+    static constexpr uint32_t TABLE_COUNT = (Resampler::MAX_STEP - 1) * TABLE_STEPS + 1;
+
+    static std::mutex s_tableMutex{};
+    static std::atomic<const float*> s_tables[TABLE_COUNT]{};
+    static std::unique_ptr<float[]> s_tableData[TABLE_COUNT]{};
+
+    static double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        double half = x * 0.5;
+        for (int32_t k = 1; k < 64 && term > sum * 1e-12; k++) {
+            term *= (half / k) * (half / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    static void buildTable(float* table, double cutoff) {
+        static constexpr double PI = 3.14159265358979323846;
+        const double center = Resampler::TAPS / 2 - 1;
+        const double radius = Resampler::TAPS / 2;
+        const double norm = 1.0 / besselI0(SINC_BETA);
+
+        //One more phase than needed so the last one can be blended with the next
+        for (uint32_t p = 0; p <= Resampler::PHASES; p++) {
+            float* row = table + p * Resampler::TAPS;
+            double sum = 0;
+            double coeffs[Resampler::TAPS]{};
+            for (uint32_t k = 0; k < Resampler::TAPS; k++) {
+                double d = double(k) - center - double(p) / Resampler::PHASES;
+                double t = d / radius;
+                double window = t * t < 1.0 ? besselI0(SINC_BETA * std::sqrt(1.0 - t * t)) * norm : 0.0;
+                double x = PI * cutoff * d;
+                double sinc = std::fabs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+                coeffs[k] = cutoff * sinc * window;
+                sum += coeffs[k];
+            }
+
+            //Every phase passes DC through unchanged
+            for (uint32_t k = 0; k < Resampler::TAPS; k++) {
+                row[k] = float(coeffs[k] / sum);
+            }
+        }
+    }
+
+    const float* Resampler::getTable(uint64_t step) {
+        uint32_t index = 0;
+        if (step > ONE) {
+            index = uint32_t((step * TABLE_STEPS + ONE - 1) >> FRACTION_BITS) - TABLE_STEPS;
+            index = std::min(index, TABLE_COUNT - 1);
+        }
+
+        const float* table = s_tables[index].load(std::memory_order_acquire);
+        if (table) { return table; }
+
+        std::lock_guard<std::mutex> lock(s_tableMutex);
+        table = s_tables[index].load(std::memory_order_relaxed);
+        if (!table) {
+            s_tableData[index].reset(new float[(PHASES + 1) * TAPS]);
+            buildTable(s_tableData[index].get(), SINC_CUTOFF * TABLE_STEPS / double(index + TABLE_STEPS));
+            table = s_tableData[index].get();
+            s_tables[index].store(table, std::memory_order_release);
+        }
+        return table;
+    }
+
+    Resampler::Resampler(ResampleQuality quality) : _quality(quality), _step(ONE), _table(nullptr) {
+        setStep(ONE);
+    }
+
+    void Resampler::setQuality(ResampleQuality quality) {
+        _quality = quality;
+        _table = nullptr;
+        setStep(_step);
+    }
+
+    void Resampler::setStep(uint64_t step) {
+        step = std::clamp<uint64_t>(step, 1, uint64_t(MAX_STEP) << FRACTION_BITS);
+        if (_table && step == _step) { return; }
+
+        _step = step;
+        _table = _quality == ResampleQuality::Sinc ? getTable(step) : nullptr;
+    }
+
+    uint64_t Resampler::getStep(double ratio) {
+        double step = std::round(ratio * double(ONE));
+        return uint64_t(std::clamp(step, 1.0, double(uint64_t(MAX_STEP) << FRACTION_BITS)));
+    }
+
+    template<uint32_t CHANNELS>
+    static void processLinear(const float* input, uint32_t channels, uint64_t position, uint64_t step, float* output, size_t frames) {
+        //A channel count of 0 means the count is only known at runtime
+        const uint32_t count = CHANNELS > 0 ? CHANNELS : channels;
+        for (size_t i = 0; i < frames; i++, position += step, output += count) {
+            const float* a = input + size_t(position >> Resampler::FRACTION_BITS) * count;
+            const float frac = float(uint32_t(position)) * (1.0f / 4294967296.0f);
+            for (uint32_t c = 0; c < count; c++) {
+                output[c] = a[c] + (a[c + count] - a[c]) * frac;
+            }
+        }
+    }
+
+    static constexpr uint32_t BLEND_BITS = Resampler::FRACTION_BITS - Resampler::PHASE_BITS;
+
+#ifdef JE_SIMD_SSE2
+    //Blends the two phases around 'position' into TAPS / 4 vectors and returns where the taps start in 'input'
+    static FORCE_INLINE const float* getSincTaps(const float* table, const float* input, uint32_t channels, uint64_t position, __m128* coeffs) {
+        static constexpr uint32_t TAPS = Resampler::TAPS;
+        const uint32_t frac = uint32_t(position);
+        const float* c0 = table + (frac >> BLEND_BITS) * TAPS;
+        const __m128 blend = _mm_set1_ps(float(frac & ((1U << BLEND_BITS) - 1)) * (1.0f / (1U << BLEND_BITS)));
+        for (uint32_t k = 0; k < TAPS / 4; k++) {
+            __m128 a = _mm_loadu_ps(c0 + k * 4);
+            __m128 b = _mm_loadu_ps(c0 + TAPS + k * 4);
+            coeffs[k] = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), blend));
+        }
+        return input + (size_t(position >> Resampler::FRACTION_BITS) - Resampler::getLead(ResampleQuality::Sinc)) * channels;
+    }
+#endif
+
+    static void processSinc(const float* table, const float* input, uint32_t channels, uint64_t position, uint64_t step, float* output, size_t frames) {
+        static constexpr uint32_t TAPS = Resampler::TAPS;
+        static constexpr uint32_t LEAD = Resampler::getLead(ResampleQuality::Sinc);
+
+        size_t i = 0;
+#ifdef JE_SIMD_SSE2
+        __m128 coeffs[TAPS / 4];
+        if (channels == 1) {
+            for (; i < frames; i++, position += step) {
+                const float* src = getSincTaps(table, input, 1, position, coeffs);
+                __m128 acc = _mm_setzero_ps();
+                for (uint32_t k = 0; k < TAPS / 4; k++) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(coeffs[k], _mm_loadu_ps(src + k * 4)));
+                }
+                acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+                acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+                _mm_store_ss(output + i, acc);
+            }
+            return;
+        }
+
+        if (channels == 2) {
+            //Interleaved stereo, every coefficient is used for an L/R pair
+            for (; i < frames; i++, position += step) {
+                const float* src = getSincTaps(table, input, 2, position, coeffs);
+                __m128 acc = _mm_setzero_ps();
+                for (uint32_t k = 0; k < TAPS / 4; k++) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpacklo_ps(coeffs[k], coeffs[k]), _mm_loadu_ps(src + k * 8 + 0)));
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_unpackhi_ps(coeffs[k], coeffs[k]), _mm_loadu_ps(src + k * 8 + 4)));
+                }
+                acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+                _mm_storel_pi(reinterpret_cast<__m64*>(output + i * 2), acc);
+            }
+            return;
+        }
+#endif
+        float taps[TAPS];
+        for (; i < frames; i++, position += step, output += channels) {
+            const uint32_t frac = uint32_t(position);
+            const float* c0 = table + (frac >> BLEND_BITS) * TAPS;
+            const float blend = float(frac & ((1U << BLEND_BITS) - 1)) * (1.0f / (1U << BLEND_BITS));
+            const float* src = input + (size_t(position >> Resampler::FRACTION_BITS) - LEAD) * channels;
+
+            for (uint32_t k = 0; k < TAPS; k++) {
+                taps[k] = c0[k] + (c0[k + TAPS] - c0[k]) * blend;
+            }
+
+            for (uint32_t c = 0; c < channels; c++) {
+                float acc = 0;
+                for (uint32_t k = 0; k < TAPS; k++) {
+                    acc += taps[k] * src[k * channels + c];
+                }
+                output[c] = acc;
+            }
+        }
+    }
+
+    void Resampler::process(const float* input, uint32_t channels, uint64_t position, float* output, size_t frames) const {
+        if (_quality == ResampleQuality::Sinc) {
+            processSinc(_table, input, channels, position, _step, output, frames);
+            return;
+        }
+
+        switch (channels) {
+            case 1:  processLinear<1>(input, channels, position, _step, output, frames); break;
+            case 2:  processLinear<2>(input, channels, position, _step, output, frames); break;
+            default: processLinear<0>(input, channels, position, _step, output, frames); break;
+        }
+    }
+
+    void Resampler::loadFrames(const AudioData& data, int64_t start, size_t frames, float* output) {
+        const size_t channels = data.channels;
+        const int64_t length = int64_t(data.sampleCount);
+        const int64_t end = start + int64_t(frames);
+
+        int64_t first = std::clamp<int64_t>(start, 0, length);
+        int64_t last = std::clamp<int64_t>(end, first, length);
+
+        size_t before = size_t(first - start);
+        size_t valid = size_t(last - first);
+        std::fill_n(output, before * channels, 0.0f);
+
+        const size_t frameSize = channels * (data.depth >> 3);
+        Audio::samplesToFloat(data.data + size_t(first) * frameSize, data.sampleType, data.depth, output + before * channels, valid * channels);
+        std::fill_n(output + (before + valid) * channels, (frames - before - valid) * channels, 0.0f);
+    }
+
+    bool Resampler::convert(const AudioData& input, AudioData& output, uint32_t sampleRate, ResampleQuality quality) {
+        static constexpr size_t BLOCK_FRAMES = 4096;
+
+        if (&input == &output || !input.data || input.format != AudioFormat::PCM || input.channels < 1 || input.sampleRate < 1 || sampleRate < 1) {
+            JE_CORE_ERROR("[Resampler] Error: Invalid audio data for sample rate conversion!");
+            return false;
+        }
+
+        //A count of 0 only checks the format
+        float probe = 0;
+        if (!Audio::samplesToFloat(input.data, input.sampleType, input.depth, &probe, 0)) {
+            JE_CORE_ERROR("[Resampler] Error: Unsupported sample format, '{0}' bits!", int32_t(input.depth));
+            return false;
+        }
+
+        if (double(input.sampleRate) / sampleRate > MAX_STEP) {
+            JE_CORE_ERROR("[Resampler] Error: Can't convert from '{0}' to '{1}', ratio is over '{2}'!", input.sampleRate, sampleRate, MAX_STEP);
+            return false;
+        }
+
+        Resampler resampler(quality);
+        resampler.setStep(getStep(input.sampleRate, sampleRate));
+        const uint64_t step = resampler.getStep();
+        const size_t channels = input.channels;
+        const size_t frames = getOutputFrames(input.sampleCount, step);
+
+        output.release();
+        output.clear(false);
+        output.format = AudioFormat::PCM;
+        output.sampleType = input.sampleType;
+        output.depth = input.depth;
+        output.channels = input.channels;
+        output.sampleRate = sampleRate;
+        output.blockAlign = uint16_t(channels * (input.depth >> 3));
+        output.sampleCount = frames;
+        if (!output.doAllocate()) {
+            JE_CORE_ERROR("[Resampler] Error: Failed to allocate '{0}' frames!", frames);
+            return false;
+        }
+
+        std::vector<float> source(resampler.getInputFrames(ONE - 1, BLOCK_FRAMES) * channels);
+        std::vector<float> target(BLOCK_FRAMES * channels);
+
+        const int64_t lead = int64_t(resampler.getLead());
+        uint64_t position = 0;
+        for (size_t done = 0; done < frames;) {
+            size_t count = std::min(BLOCK_FRAMES, frames - done);
+            size_t inFrames = resampler.getInputFrames(position, count);
+            loadFrames(input, int64_t(position >> FRACTION_BITS) - lead, inFrames, source.data());
+
+            //Positions are relative to the loaded block, which starts 'lead' frames before the first one
+            resampler.process(source.data(), uint32_t(channels), (position & (ONE - 1)) + (uint64_t(lead) << FRACTION_BITS), target.data(), count);
+            Audio::floatToSamples(target.data(), output.sampleType, output.depth, output.data + done * output.blockAlign, count * channels);
+
+            position += count * step;
+            done += count;
+        }
+        return true;
+    }
+}
@@ -1,9 +1,26 @@
 #include <JEngine/Core/AssetDB.h>
 #include <JEngine/Core.h>
+#include <JEngine/IO/FileStream.h>
 
 namespace JEngine {
+    static constexpr const char* SOURCE_PAK_NAMES[AssetDB::SRC_COUNT]{
+        "BuiltIn",
+        "Editor",
+        "Game",
+        "Runtime",
+        "Override",
+    };
 
-    AssetDB::AssetDB() : _allSources{} { }
+#ifdef JE_EDITOR
+    static constexpr const char* DEPENDENCY_FILE = "Dependencies.jdep";
+#endif
+
+    AssetDB::AssetDB() : _allSources{}, _loader(), _residency() {
+        _residency.setEvictCallback([this](AssetRef ref) {
+            IAsset* asset = findAsset(ref);
+            return asset && asset->unload();
+        });
+    }
 //
 //#ifdef JE_EDITOR
 //#else
@@ -21,6 +38,8 @@ namespace JEngine {
 //
 
     AssetDB::~AssetDB() {
+        //Workers may still be reading from the VFSs
+        _loader.stop();
         for (auto& vfs : _allSources) {
 
         }
@@ -119,18 +138,6 @@ namespace JEngine {
         return nullptr;
     }
 
-    IAsset* AssetDB::getAssetByUUID(AssetRef uuid, bool fromDB) {
-        if (!uuid.isValid()) { return nullptr; }
-
-        uint32_t source = uuid.getSource();
-        if (source >= SRC_COUNT) { return nullptr; }
-
-        uint32_t index = uuid.getUUID();
-        auto info = _allSources[source].assets.getAt(index);
-        if (!info) { return nullptr; }
-        return info->assetPtr;
-    }
-
     VFS* AssetDB::getVFS(uint8_t index) {
         return index >= SRC_COUNT ? nullptr : &_allSources[index].vfs;
     }
@@ -139,6 +146,79 @@ namespace JEngine {
         return index >= SRC_COUNT ? nullptr : &_allSources[index].vfs;
     }
 
+    uint32_t AssetDB::mountPak(uint8_t source, ConstSpan<char> path) {
+        if (source >= SRC_COUNT) { return UINT32_MAX; }
+        return _allSources[source].vfs.addPakFile(path);
+    }
+
+    bool AssetDB::readAsset(ConstSpan<char> path, uint8_t source, std::vector<uint8_t>& data) const {
+        const FileEntry* entry = findFromVFS(path, source);
+        return entry && _allSources[source].vfs.readEntry(entry->id, data);
+    }
+
+    uint64_t AssetDB::loadAsync(ConstSpan<char> path, uint8_t source, LoadType type, LoadPriority priority, AssetLoader::Callback callback) {
+        const FileEntry* entry = findFromVFS(path, source);
+        if (!entry || entry->isFolder()) {
+            JE_CORE_WARN("[AssetDB] Warning: Can't load '{0}', no such file in source '{1}'!", path, SOURCE_PAK_NAMES[source < SRC_COUNT ? source : 0]);
+            return AssetLoader::INVALID_ID;
+        }
+        return queueLoad(*entry, source, path, type, priority, std::move(callback));
+    }
+
+    uint64_t AssetDB::loadAsync(AssetRef ref, LoadType type, LoadPriority priority, AssetLoader::Callback callback) {
+        uint8_t source = ref.getSource();
+        const AssetInfo* info = ref.isValid() && source < SRC_COUNT ? _allSources[source].assets.getAt(uint32_t(ref.getUUID())) : nullptr;
+        if (!info || !info->assetPtr || !info->vfsEntry || info->vfsEntry->isFolder()) {
+            JE_CORE_WARN("[AssetDB] Warning: Can't load asset '{0:x}', it doesn't exist or has no file!", ref.uuid);
+            return AssetLoader::INVALID_ID;
+        }
+
+        const FileEntry& entry = *info->vfsEntry;
+        return queueLoad(entry, source, ConstSpan<char>(entry.name), type, priority, [this, ref, callback = std::move(callback)](LoadResult& result) {
+            if (callback) {
+                callback(result);
+            }
+
+            if (result.succeeded()) {
+                markLoaded(ref);
+            }
+        });
+    }
+
+    uint64_t AssetDB::queueLoad(const FileEntry& entry, uint8_t source, ConstSpan<char> path, LoadType type, LoadPriority priority, AssetLoader::Callback callback) {
+        if (!_loader.isRunning()) {
+            _loader.start();
+        }
+
+        //Pak entries know their size up front, loose files get reserved once they're read
+        const VFS* vfs = &_allSources[source].vfs;
+        size_t sizeHint = entry.dataInfo.size != EntryInfo::NPOS ? entry.dataInfo.size : 0;
+        FileID id = entry.id;
+        return _loader.load(path, [vfs, id](LoadSource& source) { return vfs->readEntry(id, source.bytes); }, sizeHint, type, priority, std::move(callback));
+    }
+
+    AssetRef AssetDB::addAsset(IAsset* asset, uint8_t source, FileEntry* entry) {
+        if (!asset || source >= SRC_COUNT) { return AssetRef(); }
+
+        AssetInfo* info{ nullptr };
+        uint32_t index = _allSources[source].assets.popNext(&info);
+        if (!info) {
+            JE_CORE_WARN("[AssetDB] Warning: Couldn't add asset, source '{0}' is full!", SOURCE_PAK_NAMES[source]);
+            return AssetRef();
+        }
+
+        *info = AssetInfo(asset, entry);
+        return AssetRef(false, 0, source, index);
+    }
+
+    bool AssetDB::unloadAsset(AssetRef ref) {
+        IAsset* asset = findAsset(ref);
+        if (!asset || !asset->unload()) { return false; }
+
+        markUnloaded(ref);
+        return true;
+    }
+
 #ifdef JE_EDITOR
 
     void AssetDB::initialize(const ConstSpan<char> roots[SRC_COUNT], const ConstSpan<char> dbRoots[SRC_COUNT]) {
@@ -167,13 +247,23 @@ namespace JEngine {
         size_t pakNameLen = sizeof(pathTGT) - startLen;
 
         int32_t count = 0;
-        FileStream stream{};
-        std::vector<uint32_t> assetsToWrite(512);
         for (uint32_t i = 0; i < AssetSourceType::SRC_COUNT; i++) {
-            if ((1 << i) & sources) {
-                assetsToWrite.clear();
-                auto& src = _allSources[i];
+            if (((1 << i) & sources) == 0 || i == SRC_RUNTIME) { continue; }
+
+            ConstSpan<char> root = _allSources[i].vfs.getRootPath();
+            if (root.length() < 1 || !IO::isDir(root)) {
+                JE_CORE_WARN("[AssetDB] Warning: Asset source '{0}' has no root directory, skipping!", SOURCE_PAK_NAMES[i]);
+                continue;
+            }
+
+            int32_t nameLen = snprintf(pakStart, pakNameLen, "%s%s", SOURCE_PAK_NAMES[i], AssetPacking::PakExtension);
+            if (nameLen < 1 || size_t(nameLen) >= pakNameLen) { continue; }
+
+            if (AssetPacking::packAssets(root, ConstSpan<char>(pathTGT, startLen + nameLen), AssetPacking::PAK_FLAG_COMPRESS | AssetPacking::PAK_FLAG_MULTITHREAD)) {
+                count++;
+                continue;
             }
+            JE_CORE_ERROR("[AssetDB] Error: Failed to pack asset source '{0}' to '{1}'!", SOURCE_PAK_NAMES[i], pathTGT);
         }
 
         if (count < 1) {
@@ -188,11 +278,72 @@ namespace JEngine {
         //}
     }
 
+    size_t AssetDB::reimportChanged(uint8_t source, const AssetDependencies::ImportFunc& import, uint32_t threads) {
+        if (source >= SRC_COUNT || source == SRC_RUNTIME) { return 0; }
+
+        auto& src = _allSources[source];
+        size_t imported = src.dependencies.reimport(import, threads);
+        if (imported > 0) {
+            src.saveDependencies();
+        }
+        return imported;
+    }
+
     void AssetDB::VFSSource::update() {
         static std::vector<DirectoryChange> changes{};
         if (dirMonitor.poll(changes)) {
+            //Only hashes are updated here, reimporting is left to 'reimportChanged'
+            ConstSpan<char> root = vfs.getRootPath();
+            for (const auto& change : changes) {
+                switch (change.type) {
+                    case DirectoryChange::TYPE_CREATE:
+                    case DirectoryChange::TYPE_MODIFIED:
+                        dependencies.updateContentHash(root, change.pathFrom);
+                        break;
+                    case DirectoryChange::TYPE_DELETE:
+                        dependencies.removeAsset(change.pathFrom);
+                        break;
+                    case DirectoryChange::TYPE_RENAME:
+                        dependencies.renameAsset(change.pathFrom, change.pathTo);
+                        break;
+                    default: break;
+                }
+            }
+        }
+    }
+
+    static std::string getDependencyPath(ConstSpan<char> dbRoot) {
+        std::string path(dbRoot.get(), dbRoot.length());
+        if (path.length() > 0 && path.back() != '/') {
+            path.push_back('/');
+        }
+        return path.append(DEPENDENCY_FILE);
+    }
+
+    bool AssetDB::VFSSource::loadDependencies() {
+        dependencies.clear();
+
+        ConstSpan<char> dbRoot = vfsDB.getRootPath();
+        if (dbRoot.length() < 1) { return false; }
+
+        std::string path = getDependencyPath(dbRoot);
+        if (!IO::exists(path)) { return false; }
+
+        FileStream stream(path.c_str(), "rb");
+        return stream.isOpen() && dependencies.load(stream);
+    }
 
+    bool AssetDB::VFSSource::saveDependencies() const {
+        ConstSpan<char> dbRoot = vfsDB.getRootPath();
+        if (dbRoot.length() < 1) { return false; }
+
+        std::string path = getDependencyPath(dbRoot);
+        FileStream stream(path.c_str(), "wb");
+        if (!stream.isOpen()) {
+            JE_CORE_ERROR("[AssetDB] Error: Couldn't save dependencies to '{0}'!", path);
+            return false;
         }
+        return dependencies.save(stream);
     }
 
     IAsset* AssetDB::getAssetByUUID(AssetRef uuid, bool fromDB) {
@@ -201,31 +352,65 @@ namespace JEngine {
         uint32_t source = uuid.getSource();
         if (source >= SRC_COUNT) { return nullptr; }
 
-        uint32_t index = uuid.getUUID();
+        uint32_t index = uint32_t(uuid.getUUID());
         auto info = (fromDB ? _allSources[source].assetsDB : _allSources[source].assets).getAt(index);
         if (!info) { return nullptr; }
+
+        if (!fromDB) {
+            _residency.touch(uuid);
+        }
         return info->assetPtr;
     }
 
 #else
-    void JEngine::AssetDB::initialize(const std::string_view roots[SRC_COUNT]) {
+    void AssetDB::initialize(const ConstSpan<char> roots[SRC_COUNT]) {
+        for (size_t i = 0; i < SRC_COUNT; i++) {
+            if (i == SRC_RUNTIME || roots[i].length() < 1) { continue; }
 
+            //Shipped builds point sources at paks, anything else is read loose from disk
+            if (IO::isFile(roots[i])) {
+                mountPak(uint8_t(i), roots[i]);
+                continue;
+            }
+            _allSources[i].setup(roots[i]);
+        }
     }
 
     IAsset* AssetDB::getAssetByUUID(AssetRef uuid) {
-        if (!uuid.isValid()) { return nullptr; }
+        IAsset* asset = findAsset(uuid);
+        if (asset) {
+            _residency.touch(uuid);
+        }
+        return asset;
+    }
 
-        uint32_t source = uuid.getSource();
+#endif
+
+    void AssetDB::markLoaded(AssetRef ref) {
+        IAsset* asset = findAsset(ref);
+        if (!asset) {
+            JE_CORE_WARN("[AssetDB] Warning: Can't mark asset '{0:x}' as loaded, it doesn't exist!", ref.uuid);
+            return;
+        }
+        _residency.setResident(ref, asset->getMemorySize());
+    }
+
+    void AssetDB::markUnloaded(AssetRef ref) {
+        _residency.setUnloaded(ref);
+    }
+
+    IAsset* AssetDB::findAsset(AssetRef ref) const {
+        if (!ref.isValid()) { return nullptr; }
+
+        uint32_t source = ref.getSource();
         if (source >= SRC_COUNT) { return nullptr; }
 
-        uint32_t index = uuid.getUUID();
+        uint32_t index = uint32_t(ref.getUUID());
         auto info = _allSources[source].assets.getAt(index);
         if (!info) { return nullptr; }
         return info->assetPtr;
     }
 
-#endif
-
     void AssetDB::VFSSource::unload(bool fully) {
 
     }
@@ -1,6 +1,7 @@
 #include <JEngine/IO/Audio.h>
 #include <JEngine/IO/FileStream.h>
 #include <JEngine/Core/Log.h>
+#include <algorithm>
 
 namespace JEngine {
 
@@ -11,80 +12,379 @@ namespace JEngine {
             char wave[4]{ 'W', 'A', 'V', 'E' };
         };
 
-        struct FormatChunk {
-            char fmt[4]{0};
+        struct ChunkHeader {
+            char id[4]{ 0 };
             uint32_t size{ 0 };
+        };
+
+        //WAVEFORMATEXTENSIBLE, plain PCM only has the fields up to 'bitsPerSample' and float adds 'extSize'
+        struct FormatChunk {
             uint16_t type{ 0 };
             uint16_t channels{ 0 };
             uint32_t sampleRate{ 0 };
             uint32_t byteRate{ 0 };
             uint16_t blockAlign{ 0 };
             uint16_t bitsPerSample{ 0 };
+            uint16_t extSize{ 0 };
+            uint16_t validBits{ 0 };
+            uint32_t channelMask{ 0 };
+            uint8_t subFormat[16]{ 0 };
         };
 
-        bool decode(const char* path, AudioData& audio) {
-            FileStream fs(path, "rb");
-            if (fs.isOpen()) {
-                return decode(fs, audio);
+        static constexpr uint32_t PCM_FORMAT_SIZE = 16;
+        static constexpr uint32_t FLOAT_FORMAT_SIZE = 18;
+        static constexpr uint32_t EXTENSIBLE_FORMAT_SIZE = 40;
+
+        //Extensible sub formats are the old format tag followed by this
+        static constexpr uint8_t SUB_FORMAT_GUID[14]{ 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71 };
+
+        static bool toSampleType(uint16_t type, uint16_t depth, AudioSampleType& sampleType) {
+            switch (type) {
+                case WAVE_FORMAT_PCM:
+                    if (depth == 8) {
+                        sampleType = AudioSampleType::Unsigned;
+                        return true;
+                    }
+                    sampleType = AudioSampleType::Signed;
+                    return depth == 16 || depth == 24 || depth == 32;
+                case WAVE_FORMAT_IEEE_FLOAT:
+                    sampleType = AudioSampleType::Float;
+                    return depth == 32 || depth == 64;
             }
-            JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to open file '{0}' for reading!", path);
             return false;
         }
 
-        bool decode(const Stream& stream, AudioData& audio) {
-            size_t pos = stream.tell();
+        static bool isSupported(AudioSampleType type, uint8_t depth) {
+            switch (type) {
+                case AudioSampleType::Unsigned: return depth == 8;
+                case AudioSampleType::Signed:   return depth == 16 || depth == 24 || depth == 32;
+                case AudioSampleType::Float:    return depth == 32 || depth == 64;
+            }
+            return false;
+        }
 
-            Header header{};
-            size_t read = stream.readValue(header, false);
+        WavReader::WavReader() : _stream(nullptr), _dataStart(0), _frameCount(0), _frame(0), _sampleRate(0), _blockAlign(0), _channels(0), _depth(0), _sampleType(), _scratch{} {}
+        WavReader::WavReader(const Stream& stream) : WavReader() {
+            open(stream);
+        }
+
+        bool WavReader::open(const Stream& stream) {
+            close();
+            if (!stream.canRead()) {
+                JE_ERROR("[Audio-IO] (WAV) Decode Error: Stream isn't readable!");
+                return false;
+            }
 
-            if (read < 1 || 
+            Header header{};
+            if (stream.read(&header, sizeof(Header), false) != sizeof(Header) ||
                 strncmp(header.riff, "RIFF", 4) != 0 ||
-                strncmp(header.wave, "WAVE", 4) != 0 ||
-                header.size <= 36) {
+                strncmp(header.wave, "WAVE", 4) != 0) {
                 JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, not a WAVE file!");
                 return false;
             }
-            FormatChunk fmtCh{};
-            stream.readValue(fmtCh, false);
 
-            if (strncmp(fmtCh.fmt, "fmt ", 4) != 0) {
-                JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, SubChunk 1 is not where it should be!");
+            //Chunks can come in any order and have anything between them, only 'fmt ' has to be before 'data'
+            FormatChunk fmt{};
+            bool hasFormat = false;
+            uint64_t dataSize = 0;
+            while (true) {
+                ChunkHeader chunk{};
+                if (stream.read(&chunk, sizeof(ChunkHeader), false) != sizeof(ChunkHeader)) {
+                    JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, no data chunk!");
+                    return false;
+                }
+
+                size_t chunkStart = stream.tell();
+                if (strncmp(chunk.id, "fmt ", 4) == 0) {
+                    size_t size = std::min<size_t>(chunk.size, sizeof(FormatChunk));
+                    if (size < PCM_FORMAT_SIZE || stream.read(&fmt, size, false) != size) {
+                        JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, format chunk is truncated!");
+                        return false;
+                    }
+
+                    if (fmt.type == WAVE_FORMAT_EXTENSIBLE) {
+                        if (size < EXTENSIBLE_FORMAT_SIZE || memcmp(fmt.subFormat + 2, SUB_FORMAT_GUID, sizeof(SUB_FORMAT_GUID)) != 0) {
+                            JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, unknown extensible sub format!");
+                            return false;
+                        }
+                        fmt.type = uint16_t(fmt.subFormat[0] | (fmt.subFormat[1] << 8));
+                    }
+                    hasFormat = true;
+                }
+                else if (strncmp(chunk.id, "data", 4) == 0) {
+                    if (!hasFormat) {
+                        JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, data chunk before the format chunk!");
+                        return false;
+                    }
+
+                    //Files that were never finalized have zero or maxed out sizes, the rest of the stream is used then
+                    size_t available = stream.size() > chunkStart ? stream.size() - chunkStart : 0;
+                    bool unfinished = chunk.size > available || (chunk.size == 0 && header.size == 0);
+                    dataSize = unfinished ? available : chunk.size;
+                    _dataStart = chunkStart;
+                    break;
+                }
+
+                //Chunks are padded to an even size
+                uint64_t next = uint64_t(chunkStart) + chunk.size + (chunk.size & 0x1);
+                if (next >= stream.size()) {
+                    JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, no data chunk!");
+                    return false;
+                }
+                stream.seek(int64_t(next), SEEK_SET);
+            }
+
+            AudioSampleType sampleType{};
+            if (!toSampleType(fmt.type, fmt.bitsPerSample, sampleType) ||
+                fmt.channels < 1 || fmt.channels > UINT8_MAX ||
+                fmt.blockAlign != fmt.channels * (fmt.bitsPerSample >> 3)) {
+                JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, unsupported format! (Type: {0}, Bits: {1}, Channels: {2})", fmt.type, fmt.bitsPerSample, fmt.channels);
                 return false;
             }
 
-            if (fmtCh.type != 1) {
-                JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, PCM is only supported but found type '{0}'!", fmtCh.type);
+            _stream = &stream;
+            _sampleType = sampleType;
+            _depth = uint8_t(fmt.bitsPerSample);
+            _channels = uint8_t(fmt.channels);
+            _sampleRate = fmt.sampleRate;
+            _blockAlign = fmt.blockAlign;
+            _frameCount = dataSize / fmt.blockAlign;
+            _frame = 0;
+            return true;
+        }
+
+        void WavReader::close() {
+            _stream = nullptr;
+            _dataStart = 0;
+            _frameCount = 0;
+            _frame = 0;
+            _sampleRate = 0;
+            _blockAlign = 0;
+            _channels = 0;
+            _depth = 0;
+        }
+
+        void WavReader::getFormat(AudioData& audio) const {
+            audio.format = AudioFormat::PCM;
+            audio.sampleType = _sampleType;
+            audio.depth = _depth;
+            audio.channels = _channels;
+            audio.sampleRate = _sampleRate;
+            audio.blockAlign = _blockAlign;
+            audio.sampleCount = size_t(_frameCount);
+        }
+
+        size_t WavReader::read(void* buffer, size_t frames) {
+            if (!_stream) { return 0; }
+
+            frames = size_t(std::min<uint64_t>(frames, _frameCount - _frame));
+            if (frames < 1) { return 0; }
+
+            size_t bytes = _stream->read(buffer, frames * _blockAlign, false);
+            size_t read = bytes / _blockAlign;
+            if (bytes != read * _blockAlign) {
+                //Truncated in the middle of a frame, keeps the stream on a frame boundary
+                _stream->seek(int64_t(_dataStart + (_frame + read) * _blockAlign), SEEK_SET);
+            }
+            _frame += read;
+            return read;
+        }
+
+        size_t WavReader::readFloat(float* buffer, size_t frames) {
+            if (!_stream) { return 0; }
+
+            //Already in the right format, no need to go through the scratch buffer
+            if (_sampleType == AudioSampleType::Float && _depth == 32) {
+                return read(buffer, frames);
+            }
+
+            _scratch.resize(BLOCK_FRAMES * _blockAlign);
+            size_t done = 0;
+            while (done < frames) {
+                size_t read = this->read(_scratch.data(), std::min(frames - done, BLOCK_FRAMES));
+                if (read < 1) { break; }
+
+                Audio::samplesToFloat(_scratch.data(), _sampleType, _depth, buffer + done * _channels, read * _channels);
+                done += read;
+            }
+            return done;
+        }
+
+        bool WavReader::seek(uint64_t frame) {
+            if (!_stream) { return false; }
+
+            _frame = std::min(frame, _frameCount);
+            size_t target = size_t(_dataStart + _frame * _blockAlign);
+            return _stream->seek(int64_t(target), SEEK_SET) == target;
+        }
+
+        WavWriter::WavWriter() : _stream(nullptr), _start(0), _dataStart(0), _frameCount(0), _blockAlign(0), _channels(0), _depth(0), _sampleType(), _scratch{} {}
+        WavWriter::~WavWriter() { close(); }
+
+        bool WavWriter::open(const Stream& stream, AudioSampleType type, uint8_t depth, uint8_t channels, uint32_t sampleRate) {
+            close();
+            if (!stream.canWrite()) {
+                JE_ERROR("[Audio-IO] (WAV) Encode Error: Stream isn't writable!");
                 return false;
             }
 
-            //We seek to the start of SubChunk 2, just in case there is data we don't need in SubChunk1
-            stream.seek(pos + fmtCh.size + 8 + sizeof(Header), SEEK_SET);
-            char temp[5]{ 0 };
-            stream.read(temp, 4, false);
+            if (!isSupported(type, depth) || channels < 1) {
+                JE_ERROR("[Audio-IO] (WAV) Encode Error: Unsupported format! (Bits: {0}, Channels: {1})", depth, channels);
+                return false;
+            }
 
-            if (strncmp(temp, "data", 4) != 0) {
-                JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to decode wav, SubChunk 2 is not where it should be!");
+            const bool isFloat = type == AudioSampleType::Float;
+            const bool extensible = channels > 2 || (!isFloat && depth > 16);
+
+            FormatChunk fmt{};
+            fmt.type = extensible ? WAVE_FORMAT_EXTENSIBLE : (isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+            fmt.channels = channels;
+            fmt.sampleRate = sampleRate;
+            fmt.blockAlign = uint16_t(channels * (depth >> 3));
+            fmt.byteRate = sampleRate * fmt.blockAlign;
+            fmt.bitsPerSample = depth;
+
+            uint32_t fmtSize = isFloat ? FLOAT_FORMAT_SIZE : PCM_FORMAT_SIZE;
+            if (extensible) {
+                uint16_t subType = isFloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+                fmtSize = EXTENSIBLE_FORMAT_SIZE;
+                fmt.extSize = EXTENSIBLE_FORMAT_SIZE - FLOAT_FORMAT_SIZE;
+                fmt.validBits = depth;
+                fmt.channelMask = channels < 32 ? (1U << channels) - 1 : 0;
+                fmt.subFormat[0] = uint8_t(subType);
+                fmt.subFormat[1] = uint8_t(subType >> 8);
+                memcpy(fmt.subFormat + 2, SUB_FORMAT_GUID, sizeof(SUB_FORMAT_GUID));
+            }
+
+            _start = stream.tell();
+
+            Header header{};
+            ChunkHeader fmtChunk{ { 'f', 'm', 't', ' ' }, fmtSize };
+            ChunkHeader dataChunk{ { 'd', 'a', 't', 'a' }, 0 };
+            if (stream.write(&header, sizeof(Header)) != sizeof(Header) ||
+                stream.write(&fmtChunk, sizeof(ChunkHeader)) != sizeof(ChunkHeader) ||
+                stream.write(&fmt, fmtSize) != fmtSize ||
+                stream.write(&dataChunk, sizeof(ChunkHeader)) != sizeof(ChunkHeader)) {
+                JE_ERROR("[Audio-IO] (WAV) Encode Error: Failed to write the header!");
                 return false;
             }
 
-            uint32_t size{ 0 };
-            stream.readValue(size, false);
+            _stream = &stream;
+            _dataStart = stream.tell();
+            _frameCount = 0;
+            _blockAlign = fmt.blockAlign;
+            _channels = channels;
+            _depth = depth;
+            _sampleType = type;
+            return true;
+        }
+
+        size_t WavWriter::write(const void* buffer, size_t frames) {
+            if (!_stream || frames < 1) { return 0; }
+
+            size_t written = _stream->write(buffer, frames * _blockAlign) / _blockAlign;
+            _frameCount += written;
+            return written;
+        }
+
+        size_t WavWriter::writeFloat(const float* buffer, size_t frames) {
+            if (!_stream) { return 0; }
+
+            if (_sampleType == AudioSampleType::Float && _depth == 32) {
+                return write(buffer, frames);
+            }
+
+            _scratch.resize(BLOCK_FRAMES * _blockAlign);
+            size_t done = 0;
+            while (done < frames) {
+                size_t count = std::min(frames - done, BLOCK_FRAMES);
+                Audio::floatToSamples(buffer + done * _channels, _sampleType, _depth, _scratch.data(), count * _channels);
+
+                size_t written = write(_scratch.data(), count);
+                done += written;
+                if (written < count) { break; }
+            }
+            return done;
+        }
+
+        bool WavWriter::close() {
+            if (!_stream) { return false; }
+
+            const Stream& stream = *_stream;
+            _stream = nullptr;
+
+            uint64_t dataSize = _frameCount * _blockAlign;
+            bool ret = (dataSize & 0x1) == 0 || stream.writeValue<uint8_t>(0) == 1;
+
+            //Sizes that don't fit are left maxed out, readers fall back to the stream size
+            size_t end = stream.tell();
+            uint32_t riffSize = uint32_t(std::min<uint64_t>(end - _start - 8, UINT32_MAX));
+            uint32_t dataSize32 = uint32_t(std::min<uint64_t>(dataSize, UINT32_MAX));
+
+            stream.seek(int64_t(_start + 4), SEEK_SET);
+            ret &= stream.writeValue(riffSize) == sizeof(uint32_t);
+            stream.seek(int64_t(_dataStart - 4), SEEK_SET);
+            ret &= stream.writeValue(dataSize32) == sizeof(uint32_t);
+            stream.seek(int64_t(end), SEEK_SET);
+
+            if (!ret) {
+                JE_ERROR("[Audio-IO] (WAV) Encode Error: Failed to finalize the file!");
+            }
+            return ret;
+        }
 
+        bool decode(const char* path, AudioData& audio) {
+            FileStream fs(path, "rb");
+            if (fs.isOpen()) {
+                return decode(fs, audio);
+            }
+            JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to open file '{0}' for reading!", path);
+            return false;
+        }
+
+        bool decode(const Stream& stream, AudioData& audio) {
+            WavReader reader{};
+            if (!reader.open(stream)) { return false; }
+
+            audio.release();
             audio.clear(false);
-            audio.format = AudioFormat::PCM;
-            audio.sampleRate = fmtCh.sampleRate;
-            audio.depth = fmtCh.bitsPerSample;
-            audio.channels = uint8_t(fmtCh.channels);
-            audio.blockAlign = fmtCh.blockAlign;
-            audio.sampleType = audio.depth == 8 ? AudioSampleType::Unsigned : AudioSampleType::Signed;
-            audio.sampleCount = fmtCh.byteRate < 1 ? 0 : (size / fmtCh.byteRate);
+            reader.getFormat(audio);
+
+            size_t size = audio.calculateSize();
+            if (size < 1) { return true; }
 
             if (!audio.doAllocate(size)) {
                 JE_ERROR("[Audio-IO] (WAV) Decode Error: Failed to allocate audio data buffer!");
                 return false;
             }
-            stream.read(audio.data, size, false);
+
+            if (reader.read(audio.data, audio.sampleCount) != audio.sampleCount) {
+                JE_ERROR("[Audio-IO] (WAV) Decode Error: Data chunk is truncated!");
+                return false;
+            }
+            return true;
+        }
+
+        bool encode(const char* path, const AudioData& audio) {
+            FileStream fs(path);
+            if (fs.open("wb")) {
+                return encode(fs, audio);
+            }
+            JE_ERROR("[Audio-IO] (WAV) Encode Error: Failed to open file '{0}' for writing!", path);
             return false;
         }
+
+        bool encode(const Stream& stream, const AudioData& audio) {
+            if (audio.format != AudioFormat::PCM || (audio.sampleCount > 0 && !audio.data)) {
+                JE_ERROR("[Audio-IO] (WAV) Encode Error: Only PCM audio data can be encoded!");
+                return false;
+            }
+
+            WavWriter writer{};
+            if (!writer.open(stream, audio.sampleType, audio.depth, audio.channels, audio.sampleRate)) { return false; }
+
+            bool ret = writer.write(audio.data, audio.sampleCount) == audio.sampleCount;
+            return writer.close() && ret;
+        }
     }
-}
\ No newline at end of file
+}
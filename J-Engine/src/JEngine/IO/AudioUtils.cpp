@@ -1,5 +1,7 @@
 #include <JEngine/IO/AudioUtils.h>
+#include <JEngine/Utility/SIMD.h>
 #include <algorithm>
+#include <cmath>
 
 namespace JEngine {
 
@@ -60,5 +62,227 @@ namespace JEngine {
 
             return TABLE[sample - INT16_MIN];
         }
+
+        static inline int32_t readI24(const uint8_t* data) {
+            return int32_t(uint32_t(data[0]) << 8 | uint32_t(data[1]) << 16 | uint32_t(data[2]) << 24) >> 8;
+        }
+
+        template<typename T>
+        static inline T clampSample(float value, float scale, float minValue, float maxValue) {
+            value *= scale;
+            value = value < minValue ? minValue : value;
+            value = value > maxValue ? maxValue : value;
+            return T(lrintf(value));
+        }
+
+        bool samplesToFloat(const void* samples, AudioSampleType type, uint8_t depth, float* output, size_t count) {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(samples);
+            size_t i = 0;
+            switch (type) {
+                case AudioSampleType::Unsigned:
+                    if (depth != 8) { return false; }
+#ifdef JE_SIMD_SSE2
+                    {
+                        const __m128i zero = _mm_setzero_si128();
+                        const __m128 bias = _mm_set1_ps(128.0f);
+                        const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+                        for (; i + 16 <= count; i += 16) {
+                            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                            __m128i lo = _mm_unpacklo_epi8(v, zero);
+                            __m128i hi = _mm_unpackhi_epi8(v, zero);
+                            _mm_storeu_ps(output + i + 0x0, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), bias), scale));
+                            _mm_storeu_ps(output + i + 0x4, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), bias), scale));
+                            _mm_storeu_ps(output + i + 0x8, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), bias), scale));
+                            _mm_storeu_ps(output + i + 0xC, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), bias), scale));
+                        }
+                    }
+#endif
+                    for (; i < count; i++) {
+                        output[i] = (float(data[i]) - 128.0f) * (1.0f / 128.0f);
+                    }
+                    return true;
+                case AudioSampleType::Signed:
+                    switch (depth) {
+                        case 16:
+#ifdef JE_SIMD_SSE2
+                            //Samples go to the top half of each lane and are shifted back down to sign extend them
+                            for (const __m128 scale = _mm_set1_ps(1.0f / 32768.0f); i + 8 <= count; i += 8) {
+                                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+                                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+                                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+                                _mm_storeu_ps(output + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                                _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+                            }
+#endif
+                            for (; i < count; i++) {
+                                int16_t value;
+                                memcpy(&value, data + i * 2, 2);
+                                output[i] = float(value) * (1.0f / 32768.0f);
+                            }
+                            return true;
+                        case 24:
+#ifdef JE_SIMD_SSSE3
+                            {
+                                const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+                                const __m128 scale = _mm_set1_ps(1.0f / 8388608.0f);
+                                //Loads 16 bytes for 4 samples, so stop early to stay inside the source
+                                for (; i + 6 <= count; i += 4) {
+                                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 3));
+                                    __m128i s = _mm_srai_epi32(_mm_shuffle_epi8(v, shuffle), 8);
+                                    _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+                                }
+                            }
+#endif
+                            for (; i < count; i++) {
+                                output[i] = float(readI24(data + i * 3)) * (1.0f / 8388608.0f);
+                            }
+                            return true;
+                        case 32:
+#ifdef JE_SIMD_SSE2
+                            for (const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f); i + 4 <= count; i += 4) {
+                                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 4));
+                                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(v), scale));
+                            }
+#endif
+                            for (; i < count; i++) {
+                                int32_t value;
+                                memcpy(&value, data + i * 4, 4);
+                                output[i] = float(value) * (1.0f / 2147483648.0f);
+                            }
+                            return true;
+                    }
+                    return false;
+                case AudioSampleType::Float:
+                    if (depth == 32) {
+                        memcpy(output, data, count * sizeof(float));
+                        return true;
+                    }
+
+                    if (depth == 64) {
+#ifdef JE_SIMD_SSE2
+                        for (; i + 4 <= count; i += 4) {
+                            __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(data + i * 8)));
+                            __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(reinterpret_cast<const double*>(data + i * 8 + 16)));
+                            _mm_storeu_ps(output + i, _mm_movelh_ps(lo, hi));
+                        }
+#endif
+                        for (; i < count; i++) {
+                            double value;
+                            memcpy(&value, data + i * 8, 8);
+                            output[i] = float(value);
+                        }
+                        return true;
+                    }
+                    return false;
+            }
+            return false;
+        }
+
+        bool floatToSamples(const float* input, AudioSampleType type, uint8_t depth, void* samples, size_t count) {
+            uint8_t* data = reinterpret_cast<uint8_t*>(samples);
+            switch (type) {
+                case AudioSampleType::Unsigned:
+                    if (depth != 8) { return false; }
+                    for (size_t i = 0; i < count; i++) {
+                        data[i] = uint8_t(clampSample<int32_t>(input[i], 128.0f, -128.0f, 127.0f) + 128);
+                    }
+                    return true;
+                case AudioSampleType::Signed:
+                    switch (depth) {
+                        case 16:
+                            for (size_t i = 0; i < count; i++) {
+                                int16_t value = clampSample<int16_t>(input[i], 32768.0f, -32768.0f, 32767.0f);
+                                memcpy(data + i * 2, &value, 2);
+                            }
+                            return true;
+                        case 24:
+                            for (size_t i = 0; i < count; i++) {
+                                int32_t value = clampSample<int32_t>(input[i], 8388608.0f, -8388608.0f, 8388607.0f);
+                                data[i * 3 + 0] = uint8_t(value);
+                                data[i * 3 + 1] = uint8_t(value >> 8);
+                                data[i * 3 + 2] = uint8_t(value >> 16);
+                            }
+                            return true;
+                        case 32:
+                            for (size_t i = 0; i < count; i++) {
+                                //The largest float below 2^31, 2147483647 itself isn't representable
+                                int32_t value = clampSample<int32_t>(input[i], 2147483648.0f, -2147483648.0f, 2147483520.0f);
+                                memcpy(data + i * 4, &value, 4);
+                            }
+                            return true;
+                    }
+                    return false;
+                case AudioSampleType::Float:
+                    if (depth == 32) {
+                        memcpy(data, input, count * sizeof(float));
+                        return true;
+                    }
+
+                    if (depth == 64) {
+                        for (size_t i = 0; i < count; i++) {
+                            double value = input[i];
+                            memcpy(data + i * 8, &value, 8);
+                        }
+                        return true;
+                    }
+                    return false;
+            }
+            return false;
+        }
+
+        void mixMonoToStereo(const float* input, float* output, size_t frames, float gainL, float gainR, float stepL, float stepR) {
+            size_t i = 0;
+#ifdef JE_SIMD_SSE2
+            {
+                //Gains are worked out from the frame index rather than summed up so the ramp lands exactly where the scalar tail expects
+                const __m128 base = _mm_setr_ps(gainL, gainR, gainL, gainR);
+                const __m128 step = _mm_setr_ps(stepL, stepR, stepL, stepR);
+                const __m128 four = _mm_set1_ps(4.0f);
+                __m128 frameLo = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+                __m128 frameHi = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+                for (; i + 4 <= frames; i += 4, input += 4, output += 8) {
+                    __m128 v = _mm_loadu_ps(input);
+                    __m128 lo = _mm_unpacklo_ps(v, v);
+                    __m128 hi = _mm_unpackhi_ps(v, v);
+                    __m128 gLo = _mm_add_ps(base, _mm_mul_ps(frameLo, step));
+                    __m128 gHi = _mm_add_ps(base, _mm_mul_ps(frameHi, step));
+                    _mm_storeu_ps(output + 0, _mm_add_ps(_mm_loadu_ps(output + 0), _mm_mul_ps(lo, gLo)));
+                    _mm_storeu_ps(output + 4, _mm_add_ps(_mm_loadu_ps(output + 4), _mm_mul_ps(hi, gHi)));
+                    frameLo = _mm_add_ps(frameLo, four);
+                    frameHi = _mm_add_ps(frameHi, four);
+                }
+            }
+#endif
+            for (; i < frames; i++, output += 2) {
+                float sample = *input++;
+                output[0] += sample * (gainL + stepL * float(i));
+                output[1] += sample * (gainR + stepR * float(i));
+            }
+        }
+
+        void mixStereo(const float* input, float* output, size_t frames, float gainL, float gainR, float stepL, float stepR) {
+            size_t i = 0;
+#ifdef JE_SIMD_SSE2
+            {
+                const __m128 base = _mm_setr_ps(gainL, gainR, gainL, gainR);
+                const __m128 step = _mm_setr_ps(stepL, stepR, stepL, stepR);
+                const __m128 four = _mm_set1_ps(4.0f);
+                __m128 frameLo = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+                __m128 frameHi = _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f);
+                for (; i + 4 <= frames; i += 4, input += 8, output += 8) {
+                    __m128 gLo = _mm_add_ps(base, _mm_mul_ps(frameLo, step));
+                    __m128 gHi = _mm_add_ps(base, _mm_mul_ps(frameHi, step));
+                    _mm_storeu_ps(output + 0, _mm_add_ps(_mm_loadu_ps(output + 0), _mm_mul_ps(_mm_loadu_ps(input + 0), gLo)));
+                    _mm_storeu_ps(output + 4, _mm_add_ps(_mm_loadu_ps(output + 4), _mm_mul_ps(_mm_loadu_ps(input + 4), gHi)));
+                    frameLo = _mm_add_ps(frameLo, four);
+                    frameHi = _mm_add_ps(frameHi, four);
+                }
+            }
+#endif
+            for (; i < frames; i++, input += 2, output += 2) {
+                output[0] += input[0] * (gainL + stepL * float(i));
+                output[1] += input[1] * (gainR + stepR * float(i));
+            }
+        }
     }
 }
\ No newline at end of file
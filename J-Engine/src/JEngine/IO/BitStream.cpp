@@ -1,74 +1,359 @@
 #include <JEngine/IO/BitStream.h>
-#include <JEngine/Math/Math.h>
+#include <algorithm>
 
+BitStream::BitStream() : Stream(), _stream(nullptr), _bitPos(0), _acc(0), _accBits(0), _bufferPos(0), _bufferLen(0), _mode(MODE_NONE), _overrun(false) {}
+BitStream::BitStream(const Stream& stream) : BitStream() {
+    setStream(&stream);
+}
+
+BitStream::~BitStream() { close(); }
+
+bool BitStream::setStream(const Stream* stream) const {
+    close();
+    if (!stream) { return false; }
+
+    _stream = stream;
+    _flags = (stream->canRead() ? READ_FLAG : 0) | (stream->canWrite() ? WRITE_FLAG : 0);
+    _bitPos = uint64_t(stream->tell()) << 3;
+    _position = stream->tell();
+    _length = stream->size();
+    _capacity = stream->capacity();
+    _overrun = false;
+    return true;
+}
+
+size_t BitStream::size() const {
+    if (!_stream) { return 0; }
+    return std::max(_stream->size(), size_t((_bitPos + 7) >> 3));
+}
+
+bool BitStream::fill() const {
+    //Keeps the unread tail, words are loaded from wherever the cursor happens to be
+    size_t left = _bufferLen - _bufferPos;
+    if (left > 0 && _bufferPos > 0) {
+        memmove(_buffer, _buffer + _bufferPos, left);
+    }
+
+    _bufferPos = 0;
+    _bufferLen = left + _stream->read(_buffer + left, 1, BUFFER_SIZE - left, false);
+    return _bufferLen > left;
+}
+
+void BitStream::flushBytes() const {
+    while (_accBits >= 8 && _bufferLen < BUFFER_SIZE) {
+        _buffer[_bufferLen++] = uint8_t(_acc);
+        _acc >>= 8;
+        _accBits -= 8;
+    }
+}
+
+bool BitStream::flushWrites() const {
+    if (_mode != MODE_WRITE) { return true; }
+
+    bool ret = true;
+    do {
+        flushBytes();
+
+        size_t pending = _bufferLen;
+        _bufferLen = 0;
+        if (pending > 0 && _stream->write(_buffer, 1, pending, false) != pending) {
+            ret = false;
+        }
+    } while (_accBits >= 8);
+    return ret;
+}
+
+void BitStream::dropReadAhead() const {
+    if (_mode != MODE_READ) { return; }
+
+    //The wrapped stream is ahead by whatever wasn't consumed yet, a partially read byte is rewound to its start
+    if (_accBits > 0 || _bufferPos < _bufferLen) {
+        _stream->seek(int64_t(tell()), SEEK_SET);
+    }
+    _bitPos &= ~uint64_t(0x7);
+    _acc = 0;
+    _accBits = 0;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+}
 
-//TODO: Finish writing this bitstream class.
+bool BitStream::beginRead() const {
+    if (_mode == MODE_READ) { return true; }
+    if (!canRead()) { return false; }
 
-//bool BitStream::isOpen() const
-//{
-//    return false;
-//}
+    if (_mode == MODE_WRITE) {
+        byteAlign();
+        flushWrites();
+    }
+
+    _acc = 0;
+    _accBits = 0;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_READ;
+    return true;
+}
+
+bool BitStream::beginWrite() const {
+    if (_mode == MODE_WRITE) { return true; }
+    if (!canWrite()) { return false; }
+
+    dropReadAhead();
+    _acc = 0;
+    _accBits = 0;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_WRITE;
+    return true;
+}
 
 void BitStream::byteAlign() const {
-    if (_stream && (_bitPos & 0x7) != 0) {
-        uint64_t next = JEngine::Math::nextDivByPowOf2<uint64_t, 8>(_bitPos);
-        //_bitPos = 
+    uint32_t pad = uint32_t(8 - (_bitPos & 0x7)) & 0x7;
+    if (pad < 1) { return; }
+
+    if (_mode == MODE_READ) {
+        //Words are whole bytes, so the rest of the current byte is always in the accumulator
+        readBits(pad);
+    }
+    else if (_mode == MODE_WRITE) {
+        writeBits(0, pad);
     }
 }
 
-size_t BitStream::read(void* buffer, size_t elementSize, size_t count, const bool bigEndian) const {
-    if (!_stream || !_stream->canRead()) { return 0; }
+uint64_t BitStream::readBitsSlow(uint32_t bits) const {
+    if (!beginRead()) {
+        _overrun = true;
+        return 0;
+    }
+
+    if (bits <= _accBits) { return readBits(bits); }
+    if (_bufferLen - _bufferPos < 8) {
+        fill();
+    }
+
+    size_t available = std::min<size_t>(_bufferLen - _bufferPos, 8);
+    uint64_t word = 0;
+    memcpy(&word, _buffer + _bufferPos, available);
+    _bufferPos += available;
 
+    uint32_t wordBits = uint32_t(available << 3);
+    if (_accBits + wordBits < bits) {
+        //Out of data, whatever was left is returned with zeros after it
+        uint64_t value = _acc | (word << _accBits);
+        _bitPos += _accBits + wordBits;
+        _acc = 0;
+        _accBits = 0;
+        _overrun = true;
+        return value;
+    }
+    return takeBits(word, wordBits, bits);
+}
+
+bool BitStream::writeBitsSlow(uint64_t value, uint32_t bits) const {
+    if (!beginWrite()) { return false; }
+    if (BUFFER_SIZE - _bufferLen < 8 && !flushWrites()) { return false; }
+    return writeBits(value, bits);
+}
+
+size_t BitStream::read(void* buffer, size_t elementSize, size_t count, const bool bigEndian) const {
+    if (!beginRead()) { return 0; }
     byteAlign();
-    size_t len = _stream->read(buffer, elementSize, count);
-    _position = _stream->tell();
-    return len;
+
+    uint8_t* target = reinterpret_cast<uint8_t*>(buffer);
+    const size_t size = elementSize * count;
+    size_t done = 0;
+
+    //Bytes already loaded into the accumulator come first
+    while (_accBits >= 8 && done < size) {
+        target[done++] = uint8_t(_acc);
+        _acc >>= 8;
+        _accBits -= 8;
+    }
+
+    while (done < size) {
+        size_t available = _bufferLen - _bufferPos;
+        if (available < 1) {
+            //Reads at least as big as the buffer skip it
+            size_t remaining = size - done;
+            if (remaining >= BUFFER_SIZE) {
+                _bufferPos = 0;
+                _bufferLen = 0;
+                done += _stream->read(target + done, 1, remaining, false);
+                break;
+            }
+
+            if (!fill()) { break; }
+            continue;
+        }
+
+        size_t toCopy = std::min(available, size - done);
+        memcpy(target + done, _buffer + _bufferPos, toCopy);
+        _bufferPos += toCopy;
+        done += toCopy;
+    }
+
+    _bitPos += uint64_t(done) << 3;
+    if (bigEndian && elementSize > 1) {
+        JEngine::Data::reverseEndianess(target, elementSize, done / elementSize);
+    }
+    return done;
 }
 
 size_t BitStream::write(const void* buffer, const size_t elementSize, const size_t count, const bool bigEndian) const {
-    if (!_stream || !_stream->canWrite()) { return 0; }
-    size_t ret = _stream->write(buffer, elementSize, count);
-    _position = _stream->tell();
-    return ret; 
+    if (!beginWrite()) { return 0; }
+    byteAlign();
+
+    const size_t size = elementSize * count;
+    if (size < 1) { return 0; }
+
+    //Pending bytes have to go out before the data
+    if (size >= BUFFER_SIZE || BUFFER_SIZE - _bufferLen < size + 8) {
+        if (!flushWrites()) { return 0; }
+    }
+    else {
+        flushBytes();
+    }
+
+    size_t written = size;
+    if (size >= BUFFER_SIZE) {
+        written = _stream->write(buffer, elementSize, count, bigEndian);
+    }
+    else {
+        uint8_t* target = _buffer + _bufferLen;
+        memcpy(target, buffer, size);
+        if (bigEndian) {
+            JEngine::Data::reverseEndianess(target, elementSize, count);
+        }
+        _bufferLen += size;
+    }
+
+    _bitPos += uint64_t(written) << 3;
+    return written;
 }
 
-bool BitStream::flush() const {
-    return false;
+size_t BitStream::readBits(void* buffer, size_t bits) const {
+    uint8_t* target = reinterpret_cast<uint8_t*>(buffer);
+    size_t done = 0;
+    if (isByteAligned() && bits >= 64) {
+        size_t bytes = bits >> 3;
+        done = read(target, 1, bytes, false) << 3;
+        if (done < (bytes << 3)) {
+            _overrun = true;
+            return done;
+        }
+    }
+
+    for (; bits - done >= 64; done += 64) {
+        uint64_t value = readBits(64);
+        memcpy(target + (done >> 3), &value, 8);
+    }
+
+    //The unused high bits of the last byte are cleared
+    uint32_t tail = uint32_t(bits - done);
+    if (tail > 0) {
+        uint64_t value = readBits(tail);
+        memcpy(target + (done >> 3), &value, (tail + 7) >> 3);
+    }
+    return _overrun ? done : bits;
 }
 
-bool BitStream::close() const {
-    return false;
+size_t BitStream::writeBits(const void* buffer, const size_t bits) const {
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(buffer);
+    size_t done = 0;
+    if (isByteAligned() && bits >= 64) {
+        size_t bytes = bits >> 3;
+        done = write(source, 1, bytes, false) << 3;
+        if (done < (bytes << 3)) { return done; }
+    }
+
+    for (; bits - done >= 64; done += 64) {
+        uint64_t value;
+        memcpy(&value, source + (done >> 3), 8);
+        if (!writeBits(value, 64)) { return done; }
+    }
+
+    uint32_t tail = uint32_t(bits - done);
+    if (tail > 0) {
+        uint64_t value = 0;
+        memcpy(&value, source + (done >> 3), (tail + 7) >> 3);
+        if (!writeBits(value, tail)) { return done; }
+    }
+    return bits;
 }
 
-size_t BitStream::seek(int64_t offset, int origin) const {
-    switch (origin) {
-        case SEEK_CUR:
-            _bitPos += offset;
+uint64_t BitStream::readVarUInt() const {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        uint64_t group = readBits(8);
+        value |= (group & 0x7F) << shift;
+        if ((group & 0x80) == 0 || _overrun) { return value; }
+    }
 
-            size_t bufferPos = tell();
-            if (bufferPos < _position || bufferPos > _position + BIT_BUFFER_SIZE) {
-                _flags |= FLAG_NEED_READ;
-            }
+    //More groups than a 64-bit value can have
+    _overrun = true;
+    return value;
+}
 
-            break;
+bool BitStream::writeVarUInt(uint64_t value) const {
+    while (value >= 0x80) {
+        if (!writeBits((value & 0x7F) | 0x80, 8)) { return false; }
+        value >>= 7;
     }
+    return writeBits(value, 8);
+}
 
-    return _bitPos;
+bool BitStream::flush() const {
+    if (!isOpen()) { return false; }
+    bool ret = flushWrites();
+    return _stream->flush() && ret;
 }
 
-void BitStream::checkBitBuffer() const {
-    size_t curPos = (_bitPos >> 3);
-    if (curPos < _position || curPos > _position + BIT_BUFFER_SIZE) {
-        _position = curPos;
-        _flags |= FLAG_NEED_READ;
+bool BitStream::close() const {
+    if (!_stream) { return false; }
+
+    if (_mode == MODE_WRITE) {
+        byteAlign();
+        flushWrites();
     }
+    dropReadAhead();
 
-    if (_stream) {
-        if (_flags & FLAG_NEED_READ) {
-            _stream->seek(_position, SEEK_SET);
-            _stream->read(_bitBuffer, BIT_BUFFER_SIZE, false);
+    _stream = nullptr;
+    _bitPos = 0;
+    _acc = 0;
+    _accBits = 0;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+    _flags = 0;
+    _position = 0;
+    _length = 0;
+    _capacity = 0;
+    return true;
+}
 
-            _flags &= ~BIT_BUFFER_SIZE;
-        }
+size_t BitStream::seek(int64_t offset, int origin) const {
+    if (!isOpen()) { return tell(); }
+
+    //A partially written byte is padded out first, SEEK_CUR counts from after it
+    if (_mode == MODE_WRITE) {
+        byteAlign();
+        flushWrites();
     }
+
+    int64_t target = int64_t(tell());
+    switch (origin) {
+        case SEEK_CUR: target += offset; break;
+        case SEEK_SET: target = offset; break;
+        case SEEK_END: target = int64_t(size()) - offset; break;
+    }
+    target = std::clamp<int64_t>(target, 0, int64_t(size()));
+
+    _acc = 0;
+    _accBits = 0;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+    _bitPos = uint64_t(_stream->seek(target, SEEK_SET)) << 3;
+    return tell();
 }
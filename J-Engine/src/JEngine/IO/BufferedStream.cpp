@@ -0,0 +1,228 @@
+#include <JEngine/IO/BufferedStream.h>
+#include <algorithm>
+
+BufferedStream::BufferedStream() : Stream(), _stream(nullptr), _buffer(nullptr), _bufferSize(0), _bufferPos(0), _bufferLen(0), _mode(MODE_NONE) {}
+BufferedStream::BufferedStream(const Stream& stream, size_t bufferSize) : BufferedStream() {
+    setStream(&stream, bufferSize);
+}
+
+BufferedStream::~BufferedStream() { close(); }
+
+bool BufferedStream::setStream(const Stream* stream, size_t bufferSize) const {
+    close();
+    if (!stream) { return false; }
+
+    bufferSize = std::max<size_t>(bufferSize, 16);
+    _buffer = reinterpret_cast<uint8_t*>(malloc(bufferSize));
+    if (!_buffer) { return false; }
+
+    _stream = stream;
+    _bufferSize = bufferSize;
+    _flags = (stream->canRead() ? READ_FLAG : 0) | (stream->canWrite() ? WRITE_FLAG : 0);
+    _position = stream->tell();
+    _length = stream->size();
+    _capacity = stream->capacity();
+    return true;
+}
+
+bool BufferedStream::fill() const {
+    _bufferPos = 0;
+    _bufferLen = _stream->read(_buffer, 1, _bufferSize, false);
+    _mode = _bufferLen > 0 ? MODE_READ : MODE_NONE;
+    return _bufferLen > 0;
+}
+
+bool BufferedStream::flushWrites() const {
+    if (_mode != MODE_WRITE) { return true; }
+
+    size_t pending = _bufferLen;
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+    return pending < 1 || _stream->write(_buffer, 1, pending, false) == pending;
+}
+
+void BufferedStream::dropReadAhead() const {
+    if (_mode != MODE_READ) { return; }
+
+    //The wrapped stream is ahead by whatever wasn't consumed yet
+    if (_bufferPos < _bufferLen) {
+        _stream->seek(int64_t(_position), SEEK_SET);
+    }
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+}
+
+size_t BufferedStream::read(void* buffer, size_t elementSize, size_t count, const bool bigEndian) const {
+    if (!canRead()) { return 0; }
+    flushWrites();
+
+    uint8_t* target = reinterpret_cast<uint8_t*>(buffer);
+    const size_t size = elementSize * count;
+    size_t done = 0;
+    while (done < size) {
+        size_t available = _mode == MODE_READ ? _bufferLen - _bufferPos : 0;
+        if (available < 1) {
+            //Reads at least as big as the buffer skip it
+            size_t remaining = size - done;
+            if (remaining >= _bufferSize) {
+                _bufferPos = 0;
+                _bufferLen = 0;
+                _mode = MODE_NONE;
+                size_t bRead = _stream->read(target + done, 1, remaining, false);
+                done += bRead;
+                _position += bRead;
+                break;
+            }
+
+            if (!fill()) { break; }
+            continue;
+        }
+
+        size_t toCopy = std::min(available, size - done);
+        memcpy(target + done, _buffer + _bufferPos, toCopy);
+        _bufferPos += toCopy;
+        _position += toCopy;
+        done += toCopy;
+    }
+
+    if (bigEndian && elementSize > 1) {
+        JEngine::Data::reverseEndianess(target, elementSize, done / elementSize);
+    }
+    return done;
+}
+
+size_t BufferedStream::write(const void* buffer, const size_t elementSize, const size_t count, const bool bigEndian) const {
+    if (!canWrite()) { return 0; }
+    dropReadAhead();
+
+    const size_t size = elementSize * count;
+    if (size < 1) { return 0; }
+
+    if (_mode == MODE_WRITE && _bufferSize - _bufferLen < size) {
+        flushWrites();
+    }
+
+    size_t written = size;
+    if (size >= _bufferSize) {
+        written = _stream->write(buffer, elementSize, count, bigEndian);
+    }
+    else {
+        uint8_t* target = _buffer + _bufferLen;
+        memcpy(target, buffer, size);
+        if (bigEndian) {
+            JEngine::Data::reverseEndianess(target, elementSize, count);
+        }
+        _bufferLen += size;
+        _mode = MODE_WRITE;
+    }
+
+    _position += written;
+    _length = _position > _length ? _position : _length;
+    return written;
+}
+
+size_t BufferedStream::writeZero(const size_t count) const {
+    if (!canWrite()) { return 0; }
+    dropReadAhead();
+
+    size_t written = 0;
+    while (written < count) {
+        if (_mode != MODE_WRITE || _bufferLen >= _bufferSize) {
+            if (!flushWrites()) { break; }
+            _mode = MODE_WRITE;
+        }
+
+        size_t toZero = std::min(count - written, _bufferSize - _bufferLen);
+        memset(_buffer + _bufferLen, 0, toZero);
+        _bufferLen += toZero;
+        written += toZero;
+    }
+
+    _position += written;
+    _length = _position > _length ? _position : _length;
+    return written;
+}
+
+bool BufferedStream::flush() const {
+    if (!isOpen()) { return false; }
+    bool ret = flushWrites();
+    return _stream->flush() && ret;
+}
+
+bool BufferedStream::close() const {
+    if (!_stream) { return false; }
+
+    flushWrites();
+    dropReadAhead();
+    free(_buffer);
+
+    _stream = nullptr;
+    _buffer = nullptr;
+    _bufferSize = 0;
+    _flags = 0;
+    _position = 0;
+    _length = 0;
+    _capacity = 0;
+    return true;
+}
+
+size_t BufferedStream::seek(int64_t offset, int origin) const {
+    if (!isOpen()) { return _position; }
+
+    int64_t target = int64_t(_position);
+    switch (origin) {
+        case SEEK_CUR: target += offset; break;
+        case SEEK_SET: target = offset; break;
+        case SEEK_END: target = int64_t(_length) - offset; break;
+    }
+    target = std::clamp<int64_t>(target, 0, int64_t(_length));
+
+    //Seeks that land inside the read-ahead just move the cursor
+    if (_mode == MODE_READ) {
+        int64_t bufStart = int64_t(_position - _bufferPos);
+        if (target >= bufStart && target <= bufStart + int64_t(_bufferLen)) {
+            _bufferPos = size_t(target - bufStart);
+            _position = size_t(target);
+            return _position;
+        }
+    }
+
+    flushWrites();
+    _bufferPos = 0;
+    _bufferLen = 0;
+    _mode = MODE_NONE;
+    _position = _stream->seek(target, SEEK_SET);
+    return _position;
+}
+
+size_t BufferedStream::readCString(char* str, size_t maxLen) const {
+    if (!canRead() || maxLen < 1) { return 0; }
+    flushWrites();
+
+    maxLen--;
+    size_t pos = _position;
+    size_t len = 0;
+    while (len < maxLen) {
+        if (_mode != MODE_READ || _bufferPos >= _bufferLen) {
+            if (!fill()) { break; }
+        }
+
+        const uint8_t* start = _buffer + _bufferPos;
+        size_t available = std::min(_bufferLen - _bufferPos, maxLen - len);
+        const uint8_t* end = reinterpret_cast<const uint8_t*>(memchr(start, 0, available));
+        size_t count = end ? size_t(end - start) : available;
+
+        memcpy(str + len, start, count);
+        len += count;
+        _bufferPos += count;
+        _position += count;
+        if (end) { break; }
+    }
+
+    //Same as Stream::readCString, the terminator (or the character after a truncated string) is skipped
+    seek(int64_t(pos + len + 1), SEEK_SET);
+    str[len] = 0;
+    return len;
+}
@@ -0,0 +1,500 @@
+#include <JEngine/IO/Compression/LZ4.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace JEngine::LZ4 {
+    static constexpr uint32_t FRAME_SIG = 0x345A4C4AU;
+
+    //Blocks that don't shrink are stored as is, flagged in the top bit of the block size
+    static constexpr uint32_t STORED_BLOCK = 0x80000000U;
+
+    //Format limits, the last match has to start 12 bytes before the end and the last 5 bytes are always literals
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t LAST_LITERALS = 5;
+    static constexpr size_t MF_LIMIT = 12;
+    static constexpr size_t MAX_DISTANCE = 65535;
+    static constexpr size_t WINDOW_SIZE = 65536;
+
+    static constexpr uint32_t MIN_HASH_LOG = 10;
+    static constexpr uint32_t MAX_HASH_LOG = 16;
+
+    static inline uint32_t read32(const uint8_t* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline uint64_t read64(const uint8_t* data) {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline uint32_t readLE32(const uint8_t* data) {
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+    }
+
+    static inline void writeLE32(uint8_t* data, uint32_t value) {
+        data[0] = uint8_t(value);
+        data[1] = uint8_t(value >> 8);
+        data[2] = uint8_t(value >> 16);
+        data[3] = uint8_t(value >> 24);
+    }
+
+    static inline uint32_t countTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return uint32_t(index);
+#else
+        return uint32_t(__builtin_ctzll(value));
+#endif
+    }
+
+    static inline uint32_t hashSequence(uint32_t sequence, uint32_t hashLog) {
+        return (sequence * 2654435761U) >> (32 - hashLog);
+    }
+
+    //Compares 8 bytes at a time, the first differing byte is found from the lowest set bit (little endian)
+    static inline size_t countMatch(const uint8_t* current, const uint8_t* match, const uint8_t* limit) {
+        const uint8_t* start = current;
+        while (current + 8 <= limit) {
+            uint64_t diff = read64(current) ^ read64(match);
+            if (diff) {
+                return size_t(current - start) + (countTrailingZeros(diff) >> 3);
+            }
+            current += 8;
+            match += 8;
+        }
+
+        while (current < limit && *current == *match) {
+            current++;
+            match++;
+        }
+        return size_t(current - start);
+    }
+
+    static inline void writeLength(uint8_t*& op, size_t length) {
+        while (length >= 255) {
+            *op++ = 255;
+            length -= 255;
+        }
+        *op++ = uint8_t(length);
+    }
+
+    static inline bool readLength(const uint8_t*& ip, const uint8_t* iend, size_t& length) {
+        uint8_t value;
+        do {
+            if (ip >= iend) { return false; }
+            value = *ip++;
+            length += value;
+        } while (value == 255);
+        return true;
+    }
+
+    static bool writeSequence(uint8_t*& op, const uint8_t* oend, const uint8_t* literals, size_t litLen, size_t offset, size_t matchLen) {
+        size_t matchCode = matchLen - MIN_MATCH;
+        size_t need = 1 + litLen + litLen / 255 + 1 + (offset > 0 ? 2 + matchCode / 255 + 1 : 0);
+        if (size_t(oend - op) < need) { return false; }
+
+        uint8_t* token = op++;
+        if (litLen >= 15) {
+            *token = 15 << 4;
+            writeLength(op, litLen - 15);
+        }
+        else {
+            *token = uint8_t(litLen << 4);
+        }
+
+        if (litLen > 0) {
+            memcpy(op, literals, litLen);
+            op += litLen;
+        }
+
+        //The last sequence is literals only
+        if (offset < 1) { return true; }
+
+        op[0] = uint8_t(offset);
+        op[1] = uint8_t(offset >> 8);
+        op += 2;
+
+        if (matchCode >= 15) {
+            *token |= 15;
+            writeLength(op, matchCode - 15);
+        }
+        else {
+            *token |= uint8_t(matchCode);
+        }
+        return true;
+    }
+
+    int32_t compressData(const void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level) {
+        if (lenIn > size_t(INT32_MAX) || (lenIn > 0 && !dataIn) || !dataOut) { return -1; }
+
+        const uint8_t* in = reinterpret_cast<const uint8_t*>(dataIn);
+        uint8_t* op = reinterpret_cast<uint8_t*>(dataOut);
+        const uint8_t* oend = op + lenOut;
+
+        size_t anchor = 0;
+        if (lenIn > MF_LIMIT) {
+            uint32_t hashLog = MIN_HASH_LOG;
+            while (hashLog < MAX_HASH_LOG && (size_t(1) << hashLog) < lenIn) {
+                hashLog++;
+            }
+
+            //Level 1 only looks at the newest position of a hash, higher levels follow a chain through the whole window
+            int32_t clamped = std::min(std::max(level, MIN_LEVEL), MAX_LEVEL);
+            uint32_t depth = 1U << (clamped - 1);
+            bool useChain = depth > 1;
+
+            static thread_local std::vector<int32_t> head{};
+            static thread_local std::vector<int32_t> chain{};
+            head.assign(size_t(1) << hashLog, -1);
+            if (useChain) {
+                chain.assign(std::min(lenIn, WINDOW_SIZE), -1);
+            }
+
+            auto insert = [&](size_t pos) {
+                uint32_t hash = hashSequence(read32(in + pos), hashLog);
+                if (useChain) {
+                    chain[pos & (WINDOW_SIZE - 1)] = head[hash];
+                }
+                head[hash] = int32_t(pos);
+            };
+
+            const size_t mfLimit = lenIn - MF_LIMIT;
+            const uint8_t* matchLimit = in + lenIn - LAST_LITERALS;
+            size_t ip = 0;
+            while (ip <= mfLimit) {
+                uint32_t sequence = read32(in + ip);
+                uint32_t hash = hashSequence(sequence, hashLog);
+
+                size_t bestLen = 0;
+                size_t bestPos = 0;
+                int32_t candidate = head[hash];
+                for (uint32_t tries = depth; candidate >= 0 && ip - size_t(candidate) <= MAX_DISTANCE && tries > 0; tries--) {
+                    if (read32(in + candidate) == sequence) {
+                        size_t length = MIN_MATCH + countMatch(in + ip + MIN_MATCH, in + candidate + MIN_MATCH, matchLimit);
+                        if (length > bestLen) {
+                            bestLen = length;
+                            bestPos = size_t(candidate);
+                            if (in + ip + length >= matchLimit) { break; }
+                        }
+                    }
+
+                    if (!useChain) { break; }
+                    candidate = chain[size_t(candidate) & (WINDOW_SIZE - 1)];
+                }
+
+                if (useChain) {
+                    chain[ip & (WINDOW_SIZE - 1)] = head[hash];
+                }
+                head[hash] = int32_t(ip);
+
+                if (bestLen < MIN_MATCH) {
+                    //The greedy parser skips ahead faster the longer it goes without a match
+                    ip += useChain ? 1 : 1 + ((ip - anchor) >> 6);
+                    continue;
+                }
+
+                while (ip > anchor && bestPos > 0 && in[ip - 1] == in[bestPos - 1]) {
+                    ip--;
+                    bestPos--;
+                    bestLen++;
+                }
+
+                if (!writeSequence(op, oend, in + anchor, ip - anchor, ip - bestPos, bestLen)) { return -1; }
+
+                size_t end = ip + bestLen;
+                if (useChain) {
+                    for (size_t pos = ip + 1; pos < end && pos <= mfLimit; pos++) {
+                        insert(pos);
+                    }
+                }
+                else if (end - 2 <= mfLimit) {
+                    insert(end - 2);
+                }
+                ip = end;
+                anchor = ip;
+            }
+        }
+
+        if (!writeSequence(op, oend, in + anchor, lenIn - anchor, 0, MIN_MATCH)) { return -1; }
+        return int32_t(op - reinterpret_cast<uint8_t*>(dataOut));
+    }
+
+    int32_t decompressData(const void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut) {
+        if (lenIn < 1 || lenOut > size_t(INT32_MAX) || !dataIn || (lenOut > 0 && !dataOut)) { return -1; }
+
+        const uint8_t* ip = reinterpret_cast<const uint8_t*>(dataIn);
+        const uint8_t* iend = ip + lenIn;
+        uint8_t* out = reinterpret_cast<uint8_t*>(dataOut);
+        uint8_t* op = out;
+        uint8_t* oend = out + lenOut;
+
+        while (true) {
+            if (ip >= iend) { return -1; }
+            uint32_t token = *ip++;
+
+            size_t litLen = token >> 4;
+            if (litLen == 15 && !readLength(ip, iend, litLen)) { return -1; }
+            if (size_t(iend - ip) < litLen || size_t(oend - op) < litLen) { return -1; }
+
+            //Short literal runs are copied as one fixed size block when there's room for it
+            if (litLen <= 16 && iend - ip >= 16 && oend - op >= 16) {
+                memcpy(op, ip, 16);
+            }
+            else {
+                memcpy(op, ip, litLen);
+            }
+            op += litLen;
+            ip += litLen;
+
+            //Only the last sequence has no match
+            if (ip == iend) { break; }
+            if (iend - ip < 2) { return -1; }
+
+            size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+            ip += 2;
+            if (offset < 1 || offset > size_t(op - out)) { return -1; }
+
+            size_t matchLen = token & 0xF;
+            if (matchLen == 15 && !readLength(ip, iend, matchLen)) { return -1; }
+            matchLen += MIN_MATCH;
+            if (size_t(oend - op) < matchLen) { return -1; }
+
+            const uint8_t* match = op - offset;
+            uint8_t* end = op + matchLen;
+            if (offset >= 8 && size_t(oend - end) >= 8) {
+                //May copy up to 7 bytes past the end of the match, they get overwritten by what follows
+                do {
+                    memcpy(op, match, 8);
+                    op += 8;
+                    match += 8;
+                } while (op < end);
+            }
+            else if (offset >= matchLen) {
+                memcpy(op, match, matchLen);
+            }
+            else {
+                //Overlapping match repeats the last 'offset' bytes
+                for (size_t i = 0; i < matchLen; i++) {
+                    op[i] = match[i];
+                }
+            }
+            op = end;
+        }
+        return int32_t(op - out);
+    }
+
+    static int32_t writeBlock(LZ4Context& context, const uint8_t* data, size_t length) {
+        if (length < 1) { return LZ4_OK; }
+
+        int32_t size = compressData(data, length, context.output.data(), context.output.size(), context.level);
+        uint32_t header = uint32_t(length) | STORED_BLOCK;
+        const uint8_t* payload = data;
+        if (size >= 0 && size_t(size) < length) {
+            header = uint32_t(size);
+            payload = context.output.data();
+        }
+
+        uint8_t headerBytes[4];
+        writeLE32(headerBytes, header);
+
+        size_t payloadSize = header & ~STORED_BLOCK;
+        if (context.stream->write(headerBytes, sizeof(headerBytes)) != sizeof(headerBytes) ||
+            context.stream->write(payload, payloadSize) != payloadSize) {
+            return LZ4_STREAM_ERROR;
+        }
+        return LZ4_OK;
+    }
+
+    //Validates a block header and decodes the block into 'context.output', returns the decoded size or an error
+    static int32_t readBlock(LZ4Context& context, uint32_t header, const uint8_t* payload) {
+        size_t size = header & ~STORED_BLOCK;
+        if ((header & STORED_BLOCK) != 0) {
+            if (size > BLOCK_SIZE) { return LZ4_DATA_ERROR; }
+            memcpy(context.output.data(), payload, size);
+            return int32_t(size);
+        }
+
+        int32_t ret = decompressData(payload, size, context.output.data(), BLOCK_SIZE);
+        return ret < 0 ? LZ4_DATA_ERROR : ret;
+    }
+
+    static bool isValidBlockSize(uint32_t header) {
+        size_t size = header & ~STORED_BLOCK;
+        return (header & STORED_BLOCK) != 0 ? size <= BLOCK_SIZE : size <= compressBound(BLOCK_SIZE);
+    }
+
+    int32_t compressBegin(LZ4Context& context, const Stream& target, const int32_t level) {
+        if (!target.canWrite()) { return LZ4_STREAM_ERROR; }
+
+        context.stream = &target;
+        context.level = level;
+        context.input.clear();
+        context.input.reserve(BLOCK_SIZE);
+        context.output.resize(compressBound(BLOCK_SIZE));
+        context.finished = false;
+
+        uint8_t sig[4];
+        writeLE32(sig, FRAME_SIG);
+        if (target.write(sig, sizeof(sig)) != sizeof(sig)) { return LZ4_STREAM_ERROR; }
+
+        context.initialized = true;
+        return LZ4_OK;
+    }
+
+    int32_t compressSegment(LZ4Context& context, const void* dataIn, const size_t lenIn) {
+        if (!context.initialized) { return LZ4_STREAM_ERROR; }
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(dataIn);
+        size_t left = lenIn;
+        while (left > 0) {
+            //Whole blocks skip the staging buffer
+            if (context.input.size() < 1 && left >= BLOCK_SIZE) {
+                int32_t ret = writeBlock(context, data, BLOCK_SIZE);
+                if (ret != LZ4_OK) { return ret; }
+                data += BLOCK_SIZE;
+                left -= BLOCK_SIZE;
+                continue;
+            }
+
+            size_t count = std::min(BLOCK_SIZE - context.input.size(), left);
+            context.input.insert(context.input.end(), data, data + count);
+            data += count;
+            left -= count;
+
+            if (context.input.size() >= BLOCK_SIZE) {
+                int32_t ret = writeBlock(context, context.input.data(), context.input.size());
+                context.input.clear();
+                if (ret != LZ4_OK) { return ret; }
+            }
+        }
+        return LZ4_OK;
+    }
+
+    int32_t compressEnd(LZ4Context& context) {
+        if (!context.initialized) { return LZ4_OK; }
+        context.initialized = false;
+
+        int32_t ret = writeBlock(context, context.input.data(), context.input.size());
+        context.input.clear();
+        if (ret != LZ4_OK) { return ret; }
+
+        uint8_t end[4]{ 0 };
+        return context.stream->write(end, sizeof(end)) == sizeof(end) ? LZ4_OK : LZ4_STREAM_ERROR;
+    }
+
+    int32_t decompressBegin(LZ4Context& context, const Stream& target) {
+        if (!target.canWrite()) { return LZ4_STREAM_ERROR; }
+
+        context.stream = &target;
+        context.input.clear();
+        context.output.resize(BLOCK_SIZE);
+        context.hasSignature = false;
+        context.finished = false;
+        context.initialized = true;
+        return LZ4_OK;
+    }
+
+    int32_t decompressSegment(LZ4Context& context, const void* dataIn, const size_t lenIn) {
+        if (!context.initialized) { return LZ4_STREAM_ERROR; }
+        if (context.finished) { return LZ4_STREAM_END; }
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(dataIn);
+        context.input.insert(context.input.end(), data, data + lenIn);
+
+        const uint8_t* start = context.input.data();
+        size_t avail = context.input.size();
+        size_t pos = 0;
+        int32_t ret = LZ4_OK;
+
+        if (!context.hasSignature && avail >= 4) {
+            if (readLE32(start) != FRAME_SIG) { return LZ4_DATA_ERROR; }
+            context.hasSignature = true;
+            pos = 4;
+        }
+
+        while (context.hasSignature && avail - pos >= 4) {
+            uint32_t header = readLE32(start + pos);
+            if (header == 0) {
+                context.finished = true;
+                ret = LZ4_STREAM_END;
+                pos += 4;
+                break;
+            }
+
+            if (!isValidBlockSize(header)) { return LZ4_DATA_ERROR; }
+
+            size_t size = header & ~STORED_BLOCK;
+            if (avail - pos - 4 < size) { break; }
+
+            int32_t decoded = readBlock(context, header, start + pos + 4);
+            if (decoded < 0) { return decoded; }
+            if (context.stream->write(context.output.data(), size_t(decoded)) != size_t(decoded)) { return LZ4_STREAM_ERROR; }
+            pos += 4 + size;
+        }
+
+        context.input.erase(context.input.begin(), context.input.begin() + pos);
+        return ret;
+    }
+
+    int32_t decompressEnd(LZ4Context& context) {
+        if (!context.initialized) { return LZ4_OK; }
+        context.initialized = false;
+        context.input.clear();
+        return context.finished ? LZ4_OK : LZ4_DATA_ERROR;
+    }
+
+    int32_t compressData(const Stream& streamIn, const Stream& target, const int32_t level) {
+        LZ4Context context{};
+        int32_t ret = compressBegin(context, target, level);
+        if (ret != LZ4_OK) { return ret; }
+
+        std::vector<uint8_t> buffer(BLOCK_SIZE);
+        while (true) {
+            size_t length = streamIn.read(buffer.data(), buffer.size(), false);
+            if (length < 1) { break; }
+
+            ret = writeBlock(context, buffer.data(), length);
+            if (ret != LZ4_OK) { return ret; }
+            if (length < buffer.size()) { break; }
+        }
+        return compressEnd(context);
+    }
+
+    int32_t decompressData(const Stream& streamIn, const Stream& target) {
+        LZ4Context context{};
+        int32_t ret = decompressBegin(context, target);
+        if (ret != LZ4_OK) { return ret; }
+
+        //Blocks are read straight from the stream, sizes are known from their headers
+        uint8_t header[4];
+        if (streamIn.read(header, sizeof(header), false) != sizeof(header) || readLE32(header) != FRAME_SIG) { return LZ4_DATA_ERROR; }
+
+        std::vector<uint8_t> block(compressBound(BLOCK_SIZE));
+        while (true) {
+            if (streamIn.read(header, sizeof(header), false) != sizeof(header)) { return LZ4_DATA_ERROR; }
+
+            uint32_t value = readLE32(header);
+            if (value == 0) { break; }
+            if (!isValidBlockSize(value)) { return LZ4_DATA_ERROR; }
+
+            size_t size = value & ~STORED_BLOCK;
+            if (streamIn.read(block.data(), size, false) != size) { return LZ4_DATA_ERROR; }
+
+            int32_t decoded = readBlock(context, value, block.data());
+            if (decoded < 0) { return decoded; }
+            if (target.write(context.output.data(), size_t(decoded)) != size_t(decoded)) { return LZ4_STREAM_ERROR; }
+        }
+
+        context.initialized = false;
+        return LZ4_OK;
+    }
+}
@@ -1,9 +1,40 @@
 #include <JEngine/IO/Compression/ZLib.h>
+#include <JEngine/Utility/Parallel.h>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace JEngine::ZLib {
-    int32_t deflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level) {
-        return 0;
+    static void writeAdler(std::vector<uint8_t>& dataOut, uint32_t adler) {
+        for (int32_t i = 24; i >= 0; i -= 8) {
+            dataOut.push_back(uint8_t(adler >> i));
+        }
+    }
+
+    int32_t deflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut, const int32_t level, const uint32_t threads) {
+        if (Parallel::getWorkerCount(threads) > 1 && lenIn > PARALLEL_BLOCK_SIZE) {
+            std::vector<uint8_t> packed{};
+            if (deflateParallel(dataIn, lenIn, packed, level, threads) != Z_OK || packed.size() > lenOut) { return -1; }
+            memcpy(dataOut, packed.data(), packed.size());
+            return int32_t(packed.size());
+        }
+
+        z_stream zInfo{};
+        zInfo.total_in = zInfo.avail_in = uInt(lenIn);
+        zInfo.total_out = zInfo.avail_out = uInt(lenOut);
+        zInfo.next_in = reinterpret_cast<uint8_t*>(dataIn);
+        zInfo.next_out = reinterpret_cast<uint8_t*>(dataOut);
+
+        int32_t nErr, nRet = -1;
+        nErr = deflateInit(&zInfo, level);
+        if (nErr == Z_OK) {
+            nErr = deflate(&zInfo, Z_FINISH);
+            if (nErr == Z_STREAM_END) {
+                nRet = zInfo.total_out;
+            }
+        }
+        deflateEnd(&zInfo);
+        return(nRet);
     }
 
     int32_t inflateData(void* dataIn, const size_t lenIn, void* dataOut, const size_t lenOut) {
@@ -39,8 +70,7 @@ namespace JEngine::ZLib {
     }
 
     int32_t deflateSegment(ZLibContext& context, void* dataIn, const size_t lenIn, const Stream& streamIn, void* buffer, const size_t bufferSize) {
-        static 
-        int32_t nErr = Z_OK, nRet = -1;
+        int32_t nErr = Z_OK;
 
         context.refreshNext(dataIn, lenIn);
         while (context.stream.avail_in != 0) {
@@ -112,43 +142,156 @@ namespace JEngine::ZLib {
         return ret;
     }
 
-    int32_t deflateData(const Stream& streamIn, Stream& target, const int32_t level) {
-        int ret, flush{};
-        unsigned have;
-        z_stream strm{};
-        uint8_t in[CHUNK]{};
-        uint8_t out[CHUNK]{};
+    uint16_t getHeader(const int32_t level) {
+        static constexpr uint16_t CMF = 0x78;
 
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
+        uint16_t fLevel = 2;
+        if (level >= 0) {
+            fLevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+        }
 
-        ret = deflateInit(&strm, level);
+        uint16_t header = (CMF << 8) | (fLevel << 6);
+        return header + (31 - (header % 31)) % 31;
+    }
+
+    int32_t deflateBlock(const void* dataIn, const size_t lenIn, const void* dictionary, const size_t dictLen, const bool isLast, const int32_t level, std::vector<uint8_t>& dataOut) {
+        z_stream strm{};
+        int32_t ret = deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
         if (ret != Z_OK) { return ret; }
 
-        do {
-            strm.avail_in = uInt(streamIn.read(in, CHUNK, false));
-            /*if (streamIn.bad()) {
+        if (dictionary && dictLen > 0) {
+            ret = deflateSetDictionary(&strm, reinterpret_cast<const Bytef*>(dictionary), uInt(dictLen));
+            if (ret != Z_OK) {
                 (void)deflateEnd(&strm);
-                return Z_ERRNO;
-            }*/
-            flush = streamIn.isEOF() ? Z_FINISH : Z_NO_FLUSH;
-            strm.next_in = in;
+                return ret;
+            }
+        }
 
-            do {
-                strm.avail_out = CHUNK;
-                strm.next_out = out;
-                ret = deflate(&strm, flush);
-                assert(ret != Z_STREAM_ERROR);
-                have = CHUNK - strm.avail_out;
-                target.write(reinterpret_cast<char*>(out), have);
+        //A sync flush adds an empty stored block on top of the bound
+        size_t start = dataOut.size();
+        dataOut.resize(start + deflateBound(&strm, uLong(lenIn)) + 16);
 
-            } while (strm.avail_out == 0);
-            assert(strm.avail_in == 0);
-        } while (flush != Z_FINISH);
+        strm.next_in = reinterpret_cast<Bytef*>(const_cast<void*>(dataIn));
+        strm.avail_in = uInt(lenIn);
+        strm.next_out = dataOut.data() + start;
+        strm.avail_out = uInt(dataOut.size() - start);
 
-        assert(ret == Z_STREAM_END);
+        ret = deflate(&strm, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+        dataOut.resize(dataOut.size() - strm.avail_out);
+
+        bool done = strm.avail_in == 0 && (isLast ? ret == Z_STREAM_END : ret == Z_OK);
         (void)deflateEnd(&strm);
+        return done ? Z_OK : (ret < 0 ? ret : Z_BUF_ERROR);
+    }
+
+    int32_t deflateParallel(const void* dataIn, const size_t lenIn, std::vector<uint8_t>& dataOut, const int32_t level, const uint32_t threads, const size_t blockSize) {
+        const uint8_t* input = reinterpret_cast<const uint8_t*>(dataIn);
+        size_t start = dataOut.size();
+
+        uint16_t header = getHeader(level);
+        dataOut.push_back(uint8_t(header >> 8));
+        dataOut.push_back(uint8_t(header));
+
+        size_t block = std::max<size_t>(blockSize, 1);
+        size_t count = (lenIn + block - 1) / block;
+        uint32_t workers = Parallel::getWorkerCount(threads);
+
+        //Splitting only pays off when the blocks actually run side by side
+        if (count <= 1 || workers <= 1) {
+            int32_t ret = deflateBlock(input, lenIn, nullptr, 0, true, level, dataOut);
+            if (ret != Z_OK) {
+                dataOut.resize(start);
+                return ret;
+            }
+            writeAdler(dataOut, uint32_t(adler32(adler32(0, Z_NULL, 0), input, uInt(lenIn))));
+            return Z_OK;
+        }
+
+        std::vector<std::vector<uint8_t>> blocks(count);
+        std::vector<uint32_t> adlers(count);
+        std::vector<int32_t> results(count);
+        Parallel::forEach(count, workers, [&](size_t i) {
+            size_t offset = i * block;
+            size_t length = std::min(block, lenIn - offset);
+            size_t dictLen = std::min(offset, DICTIONARY_SIZE);
+
+            adlers[i] = uint32_t(adler32(adler32(0, Z_NULL, 0), input + offset, uInt(length)));
+            results[i] = deflateBlock(input + offset, length, input + offset - dictLen, dictLen, i == count - 1, level, blocks[i]);
+        });
+
+        size_t total = 0;
+        uint32_t adler = adlers[0];
+        for (size_t i = 0; i < count; i++) {
+            if (results[i] != Z_OK) {
+                dataOut.resize(start);
+                return results[i];
+            }
+
+            if (i > 0) {
+                adler = uint32_t(adler32_combine(adler, adlers[i], z_off_t(std::min(block, lenIn - i * block))));
+            }
+            total += blocks[i].size();
+        }
+
+        dataOut.reserve(dataOut.size() + total + 4);
+        for (const auto& data : blocks) {
+            dataOut.insert(dataOut.end(), data.begin(), data.end());
+        }
+        writeAdler(dataOut, adler);
+        return Z_OK;
+    }
+
+    int32_t deflateData(const Stream& streamIn, Stream& target, const int32_t level, const uint32_t threads) {
+        uint32_t workers = Parallel::getWorkerCount(threads);
+        size_t batch = PARALLEL_BLOCK_SIZE * workers;
+
+        //The tail of the previous batch stays in front of the next one as its dictionary
+        std::vector<uint8_t> input(DICTIONARY_SIZE + batch);
+        std::vector<std::vector<uint8_t>> blocks(workers);
+        std::vector<int32_t> results(workers);
+        std::vector<uint32_t> adlers(workers);
+
+        uint16_t zHeader = getHeader(level);
+        uint8_t header[2]{ uint8_t(zHeader >> 8), uint8_t(zHeader) };
+        target.write(header, sizeof(header));
+
+        uint32_t adler = uint32_t(adler32(0, Z_NULL, 0));
+        size_t dictLen = 0;
+        while (true) {
+            uint8_t* batchData = input.data() + DICTIONARY_SIZE;
+            size_t length = streamIn.read(batchData, batch, false);
+            if (length < 1) { break; }
+
+            //Every block is sync flushed, the stream is closed by an empty final block once the input runs out
+            size_t count = (length + PARALLEL_BLOCK_SIZE - 1) / PARALLEL_BLOCK_SIZE;
+            Parallel::forEach(count, workers, [&](size_t i) {
+                size_t offset = i * PARALLEL_BLOCK_SIZE;
+                size_t blockLen = std::min(PARALLEL_BLOCK_SIZE, length - offset);
+                size_t blockDict = i > 0 ? DICTIONARY_SIZE : dictLen;
+
+                blocks[i].clear();
+                adlers[i] = uint32_t(adler32(adler32(0, Z_NULL, 0), batchData + offset, uInt(blockLen)));
+                results[i] = deflateBlock(batchData + offset, blockLen, batchData + offset - blockDict, blockDict, false, level, blocks[i]);
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                if (results[i] != Z_OK) { return results[i]; }
+                adler = uint32_t(adler32_combine(adler, adlers[i], z_off_t(std::min(PARALLEL_BLOCK_SIZE, length - i * PARALLEL_BLOCK_SIZE))));
+                target.write(blocks[i].data(), blocks[i].size());
+            }
+
+            dictLen = std::min(DICTIONARY_SIZE, dictLen + length);
+            memmove(input.data() + DICTIONARY_SIZE - dictLen, batchData + length - dictLen, dictLen);
+            if (length < batch) { break; }
+        }
+
+        auto& tail = blocks[0];
+        tail.clear();
+        int32_t ret = deflateBlock(nullptr, 0, nullptr, 0, true, level, tail);
+        if (ret != Z_OK) { return ret; }
+
+        writeAdler(tail, adler);
+        target.write(tail.data(), tail.size());
         return Z_OK;
     }
 
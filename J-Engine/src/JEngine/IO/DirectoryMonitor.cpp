@@ -1,30 +1,475 @@
-#include <Editor/IO/DirectoryMonitor.h>
+#include <JEngine/IO/DirectoryMonitor.h>
 #include <JEngine/Core/Log.h>
 #include <JEngine/Utility/StringHelpers.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+#endif
 
 namespace JEngine {
-    struct TempAction {
-        DWORD action{};
-        std::string path{};
-    };
+    static uint64_t getTimeMs() {
+        return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static std::string joinPath(const std::string& dir, const char* name, size_t length) {
+        std::string path = dir;
+        if (path.length() > 0) {
+            path.push_back('/');
+        }
+        return path.append(name, length);
+    }
+
+    //Renames are handed out first so a path that gets reused after its file moved away is created after the move
+    static uint8_t getFlushPhase(DirectoryChange::ChangeType type) {
+        switch (type) {
+            case DirectoryChange::TYPE_DELETE: return 0;
+            case DirectoryChange::TYPE_RENAME: return 1;
+            case DirectoryChange::TYPE_CREATE: return 2;
+            default: return 3;
+        }
+    }
+
+    void DirectoryChangeCoalescer::removeOrigin(const std::string& origin, uint64_t timeMs) {
+        auto find = _pending.find(origin);
+        if (find == _pending.end()) {
+            _pending[origin] = { DirectoryChange::TYPE_DELETE, {}, false, timeMs };
+            return;
+        }
+
+        //Something else took the original's place, to the listener that's the original changing
+        Pending& pend = find->second;
+        switch (pend.type) {
+            case DirectoryChange::TYPE_CREATE:
+                pend.type = DirectoryChange::TYPE_MODIFIED;
+                pend.modified = true;
+                pend.time = timeMs;
+                break;
+            case DirectoryChange::TYPE_RENAME: {
+                std::string other = std::move(pend.origin);
+                pend = { DirectoryChange::TYPE_MODIFIED, {}, true, timeMs };
+                removeOrigin(other, timeMs);
+                break;
+            }
+            default: break;
+        }
+    }
+
+    void DirectoryChangeCoalescer::push(const DirectoryChange& change, uint64_t timeMs) {
+        switch (change.type) {
+            case DirectoryChange::TYPE_CREATE: {
+                auto find = _pending.find(change.pathFrom);
+                if (find == _pending.end()) {
+                    _pending[change.pathFrom] = { DirectoryChange::TYPE_CREATE, {}, false, timeMs };
+                    break;
+                }
+
+                //Deleted and created again (atomic saves) is just a modification
+                Pending& pend = find->second;
+                if (pend.type == DirectoryChange::TYPE_DELETE) {
+                    pend.type = DirectoryChange::TYPE_MODIFIED;
+                }
+                pend.modified = true;
+                pend.time = timeMs;
+                break;
+            }
+
+            case DirectoryChange::TYPE_MODIFIED: {
+                auto find = _pending.find(change.pathFrom);
+                if (find == _pending.end()) {
+                    _pending[change.pathFrom] = { DirectoryChange::TYPE_MODIFIED, {}, true, timeMs };
+                    break;
+                }
+
+                Pending& pend = find->second;
+                if (pend.type == DirectoryChange::TYPE_DELETE) {
+                    pend.type = DirectoryChange::TYPE_MODIFIED;
+                }
+                pend.modified = true;
+                pend.time = timeMs;
+                break;
+            }
+
+            case DirectoryChange::TYPE_DELETE: {
+                auto find = _pending.find(change.pathFrom);
+                if (find == _pending.end()) {
+                    _pending[change.pathFrom] = { DirectoryChange::TYPE_DELETE, {}, false, timeMs };
+                    break;
+                }
+
+                Pending& pend = find->second;
+                switch (pend.type) {
+                    //Never existed as far as the listener knows
+                    case DirectoryChange::TYPE_CREATE:
+                        _pending.erase(find);
+                        break;
+
+                    //What got deleted is the file at the original path
+                    case DirectoryChange::TYPE_RENAME: {
+                        std::string origin = std::move(pend.origin);
+                        _pending.erase(find);
+                        removeOrigin(origin, timeMs);
+                        break;
+                    }
+
+                    default:
+                        pend.type = DirectoryChange::TYPE_DELETE;
+                        pend.modified = false;
+                        pend.time = timeMs;
+                        break;
+                }
+                break;
+            }
+
+            case DirectoryChange::TYPE_RENAME: {
+                if (change.pathFrom == change.pathTo) { break; }
+
+                //Pending changes inside a renamed folder follow it, deletions stay where the listener last saw the file
+                std::vector<std::pair<std::string, Pending>> moved{};
+                std::string prefix = change.pathFrom + '/';
+                for (auto it = _pending.lower_bound(prefix); it != _pending.end() && it->first.compare(0, prefix.length(), prefix) == 0;) {
+                    if (it->second.type != DirectoryChange::TYPE_DELETE) {
+                        moved.emplace_back(change.pathTo + it->first.substr(change.pathFrom.length()), std::move(it->second));
+                        it = _pending.erase(it);
+                        continue;
+                    }
+                    ++it;
+                }
+
+                for (auto& item : moved) {
+                    _pending[item.first] = std::move(item.second);
+                }
+
+                Pending result{ DirectoryChange::TYPE_RENAME, change.pathFrom, false, timeMs };
+                auto find = _pending.find(change.pathFrom);
+                if (find != _pending.end()) {
+                    Pending& pend = find->second;
+                    switch (pend.type) {
+                        case DirectoryChange::TYPE_CREATE:
+                            result.type = DirectoryChange::TYPE_CREATE;
+                            result.origin.clear();
+                            break;
+                        case DirectoryChange::TYPE_RENAME:
+                            result.origin = std::move(pend.origin);
+                            result.modified = pend.modified;
+                            break;
+                        case DirectoryChange::TYPE_MODIFIED:
+                            result.modified = true;
+                            break;
+                        default: break;
+                    }
+                    _pending.erase(find);
+                }
+
+                //Whatever was at the target before gets replaced
+                bool existed = false;
+                find = _pending.find(change.pathTo);
+                if (find != _pending.end()) {
+                    Pending& pend = find->second;
+                    existed = pend.type == DirectoryChange::TYPE_DELETE || pend.type == DirectoryChange::TYPE_MODIFIED;
+
+                    if (pend.type == DirectoryChange::TYPE_RENAME) {
+                        std::string origin = std::move(pend.origin);
+                        _pending.erase(find);
+                        removeOrigin(origin, timeMs);
+                    }
+                    else {
+                        _pending.erase(find);
+                    }
+                }
+
+                if (result.type == DirectoryChange::TYPE_RENAME) {
+                    //Moved back to where it started
+                    if (result.origin == change.pathTo) {
+                        if (result.modified) {
+                            _pending[change.pathTo] = { DirectoryChange::TYPE_MODIFIED, {}, true, timeMs };
+                        }
+                        break;
+                    }
+
+                    if (existed) {
+                        std::string origin = std::move(result.origin);
+                        _pending[change.pathTo] = { DirectoryChange::TYPE_MODIFIED, {}, true, timeMs };
+                        removeOrigin(origin, timeMs);
+                        break;
+                    }
+                }
+                else if (existed) {
+                    result.type = DirectoryChange::TYPE_MODIFIED;
+                    result.modified = true;
+                }
+                _pending[change.pathTo] = std::move(result);
+                break;
+            }
+            default: break;
+        }
+    }
+
+    size_t DirectoryChangeCoalescer::flush(std::vector<DirectoryChange>& changes, uint64_t nowMs, bool force) {
+        std::vector<std::pair<std::string, Pending>> settled{};
+        for (auto it = _pending.begin(); it != _pending.end();) {
+            if (force || nowMs >= it->second.time + _debounce) {
+                settled.emplace_back(it->first, std::move(it->second));
+                it = _pending.erase(it);
+                continue;
+            }
+            ++it;
+        }
+
+        std::sort(settled.begin(), settled.end(), [](const std::pair<std::string, Pending>& lhs, const std::pair<std::string, Pending>& rhs) {
+            uint8_t phaseL = getFlushPhase(lhs.second.type);
+            uint8_t phaseR = getFlushPhase(rhs.second.type);
+            return phaseL != phaseR ? phaseL < phaseR : lhs.first < rhs.first;
+        });
+
+        size_t start = changes.size();
+        for (auto& item : settled) {
+            if (item.second.type == DirectoryChange::TYPE_RENAME) {
+                changes.emplace_back(item.second.origin, item.first);
+                continue;
+            }
+            changes.emplace_back(item.second.type, item.first);
+        }
+
+        //Contents of renamed files come after every rename
+        for (auto& item : settled) {
+            if (item.second.type == DirectoryChange::TYPE_RENAME && item.second.modified) {
+                changes.emplace_back(DirectoryChange::TYPE_MODIFIED, item.first);
+            }
+        }
+        return changes.size() - start;
+    }
+
+    bool DirectoryMonitor::poll(std::vector<DirectoryChange>& changes) {
+        changes.clear();
+        if (!isOpen()) { return false; }
+
+        _raw.clear();
+        bool intact = readEvents();
+
+        uint64_t now = getTimeMs();
+        for (const auto& change : _raw) {
+            applyKnown(change);
+            _coalescer.push(change, now);
+        }
+        _raw.clear();
+
+        //Nothing is left at the root path to watch or rescan, whatever the listener still knows of is gone
+        if (_flags & FLAG_ROOT_LOST) {
+            for (const auto& known : _known) {
+                _coalescer.push(DirectoryChange(DirectoryChange::TYPE_DELETE, known.first), now);
+            }
+            _coalescer.flush(changes, now, true);
+
+            JE_CORE_WARN("[DirectoryMonitor] Warning: Monitored directory '{0}' was deleted or moved, closing the monitor!", _root);
+            close();
+            return changes.size() > 0;
+        }
+
+        //Events read before the overflow are already known, the rescan only adds what got lost
+        if (!intact) {
+            rescan();
+            for (const auto& change : _raw) {
+                _coalescer.push(change, now);
+            }
+            _raw.clear();
+        }
+
+        _coalescer.flush(changes, now);
+        return changes.size() > 0;
+    }
+
+    bool DirectoryMonitor::flush(std::vector<DirectoryChange>& changes) {
+        changes.clear();
+        if (!isOpen()) { return false; }
+
+        _coalescer.flush(changes, getTimeMs(), true);
+        return changes.size() > 0;
+    }
+
+    void DirectoryMonitor::rescan() {
+#ifndef _WIN32
+        //Directories created while events were lost aren't watched yet
+        addWatches("", false);
+#endif
+        DirectoryScan current{};
+        if (!current.scan(_root)) { return; }
+        _overflows++;
+
+        std::unordered_set<std::string> matched{};
+        matched.reserve(_known.size());
+
+        //Without the lost events renames can't be told apart from a delete and a create
+        for (const auto& dir : current.getDirectories()) {
+            for (const auto& item : dir.items) {
+                std::string path = joinPath(dir.path, item.name.c_str(), item.name.length());
+                auto find = _known.find(path);
+                if (find == _known.end()) {
+                    _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
+                    continue;
+                }
+
+                const ScanItem& prev = find->second;
+                matched.insert(path);
+                if (prev.type != item.type) {
+                    _raw.emplace_back(DirectoryChange::TYPE_DELETE, path);
+                    _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
+                }
+                else if (!item.isFolder() && (prev.size != item.size || prev.modTime != item.modTime)) {
+                    _raw.emplace_back(DirectoryChange::TYPE_MODIFIED, path);
+                }
+            }
+        }
+
+        for (const auto& prev : _known) {
+            if (matched.find(prev.first) == matched.end()) {
+                _raw.emplace_back(DirectoryChange::TYPE_DELETE, prev.first);
+            }
+        }
+
+        setKnown(current);
+        JE_CORE_WARN("[DirectoryMonitor] Warning: Change buffer of '{0}' overflowed, rescanned the directory ({1} changes)!", _root, _raw.size());
+    }
+
+    void DirectoryMonitor::setKnown(const DirectoryScan& scan) {
+        _known.clear();
+        for (const auto& dir : scan.getDirectories()) {
+            for (const auto& item : dir.items) {
+                _known[joinPath(dir.path, item.name.c_str(), item.name.length())] = item;
+            }
+        }
+    }
+
+    static void eraseWithin(std::unordered_map<std::string, ScanItem>& known, const std::string& dir) {
+        std::string prefix = dir + '/';
+        for (auto it = known.begin(); it != known.end();) {
+            if (it->first.compare(0, prefix.length(), prefix) == 0) {
+                it = known.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    void DirectoryMonitor::applyKnown(const DirectoryChange& change) {
+        switch (change.type) {
+            case DirectoryChange::TYPE_CREATE:
+            case DirectoryChange::TYPE_MODIFIED: {
+                //The listener was told the path exists, if it's already gone again a later event or rescan reports that
+                ScanItem& item = _known[change.pathFrom];
+                std::error_code ec{};
+                fs::directory_entry entry(fs::path(_root) / change.pathFrom, ec);
+                if (entry.is_regular_file(ec)) {
+                    item.type = IO::F_TYPE_FILE;
+                    item.size = uint64_t(entry.file_size(ec));
+                }
+                else if (entry.is_directory(ec)) {
+                    item.type = IO::F_TYPE_FOLDER;
+                    item.size = 0;
+                }
+                item.modTime = uint64_t(entry.last_write_time(ec).time_since_epoch().count());
+                break;
+            }
+
+            case DirectoryChange::TYPE_DELETE: {
+                auto find = _known.find(change.pathFrom);
+                if (find == _known.end()) { break; }
+
+                bool isFolder = find->second.isFolder();
+                _known.erase(find);
+                if (isFolder) {
+                    eraseWithin(_known, change.pathFrom);
+                }
+                break;
+            }
+
+            case DirectoryChange::TYPE_RENAME: {
+                if (change.pathFrom == change.pathTo) { break; }
+
+                //Moved out of a path the listener never heard of, to it that's just a new path
+                auto find = _known.find(change.pathFrom);
+                if (find == _known.end()) {
+                    applyKnown(DirectoryChange(DirectoryChange::TYPE_CREATE, change.pathTo));
+                    break;
+                }
+
+                ScanItem item = std::move(find->second);
+                _known.erase(find);
+
+                auto target = _known.find(change.pathTo);
+                if (target != _known.end() && target->second.isFolder()) {
+                    eraseWithin(_known, change.pathTo);
+                }
+
+                if (item.isFolder()) {
+                    std::string prefix = change.pathFrom + '/';
+                    std::vector<std::pair<std::string, ScanItem>> moved{};
+                    for (auto it = _known.begin(); it != _known.end();) {
+                        if (it->first.compare(0, prefix.length(), prefix) == 0) {
+                            moved.emplace_back(change.pathTo + it->first.substr(change.pathFrom.length()), std::move(it->second));
+                            it = _known.erase(it);
+                            continue;
+                        }
+                        ++it;
+                    }
+
+                    for (auto& child : moved) {
+                        _known[child.first] = std::move(child.second);
+                    }
+                }
+                _known[change.pathTo] = std::move(item);
+                break;
+            }
+            default: break;
+        }
+    }
+
+#ifdef _WIN32
+    static constexpr DWORD CHANGE_FILTER =
+        FILE_NOTIFY_CHANGE_FILE_NAME |
+        FILE_NOTIFY_CHANGE_DIR_NAME |
+        FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+    DirectoryMonitor::DirectoryMonitor() :
+        _flags{}, _root{}, _coalescer{}, _raw{}, _known{}, _overflows{ 0 },
+        _handle{ INVALID_HANDLE_VALUE }, _overlapped{}, _changeBuffer{ nullptr } {
+        _coalescer.setDebounce(DEFAULT_DEBOUNCE_MS);
+    }
 
-    DirectoryMonitor::DirectoryMonitor() : _handle{}, _overlapped{}, _flags{}, _changeBuffer{0} { }
     DirectoryMonitor::~DirectoryMonitor() {
         close();
     }
 
     void DirectoryMonitor::close() {
         if (_handle != INVALID_HANDLE_VALUE) {
+            //The pending read has to finish before its buffer can go
+            CancelIo(_handle);
+            if (_overlapped.hEvent) {
+                DWORD bytes{};
+                GetOverlappedResult(_handle, &_overlapped, &bytes, TRUE);
+            }
             CloseHandle(_handle);
             _handle = INVALID_HANDLE_VALUE;
         }
 
-        if (_overlapped.hEvent != INVALID_HANDLE_VALUE) {
+        if (_overlapped.hEvent) {
             CloseHandle(_overlapped.hEvent);
-            _overlapped.hEvent = INVALID_HANDLE_VALUE;
         }
+        _overlapped = {};
+
+        delete[] _changeBuffer;
+        _changeBuffer = nullptr;
 
-        _flags &= ~FLAG_OPEN;
+        _coalescer.clear();
+        _known.clear();
+        _flags &= ~(FLAG_OPEN | FLAG_ROOT_LOST);
     }
 
     bool DirectoryMonitor::tryOpen(const std::string& path) {
@@ -42,79 +487,292 @@ namespace JEngine {
             JE_CORE_ERROR("[DirectoryMonitor] Error: Failed to create handle to directory {0}!", path);
             return false;
         }
-        memset(_changeBuffer, 0, CHANGE_BUFFER_SIZE);
+
+        _root = path;
+        IO::fixPath(_root);
+
+        DirectoryScan scan{};
+        scan.scan(_root);
+        setKnown(scan);
+
+        //DWORD aligned as required by ReadDirectoryChangesW
+        _changeBuffer = new DWORD[CHANGE_BUFFER_SIZE / sizeof(DWORD)]{};
         _overlapped.hEvent = CreateEvent(NULL, FALSE, 0, NULL);
 
         _flags |= FLAG_OPEN;
-        BOOL success = ReadDirectoryChangesW(
-            _handle, _changeBuffer, CHANGE_BUFFER_SIZE, TRUE,
-            FILE_NOTIFY_CHANGE_FILE_NAME |
-            FILE_NOTIFY_CHANGE_DIR_NAME |
-            FILE_NOTIFY_CHANGE_LAST_WRITE,
+        ReadDirectoryChangesW(
+            _handle, _changeBuffer, DWORD(CHANGE_BUFFER_SIZE), TRUE, CHANGE_FILTER,
             NULL, &_overlapped, NULL);
-
         return true;
     }
 
-    bool DirectoryMonitor::poll(std::vector<DirectoryChange>& changes) {
-        if (!isOpen()) { return false; }
-
-        changes.clear();
-        static std::vector<TempAction> actions{};
-        wchar_t nameBuf[MAX_PATH]{0};
-
+    bool DirectoryMonitor::readEvents() {
         DWORD result = WaitForSingleObject(_overlapped.hEvent, 0);
-        if (result == WAIT_OBJECT_0) {
-            DWORD bytesTransferred{};
-            GetOverlappedResult(_handle, &_overlapped, &bytesTransferred, FALSE);
+        if (result != WAIT_OBJECT_0) { return true; }
+
+        DWORD bytesTransferred{};
+        BOOL ok = GetOverlappedResult(_handle, &_overlapped, &bytesTransferred, FALSE);
 
-            FILE_NOTIFY_INFORMATION* evnt = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(_changeBuffer);
-            actions.clear();
+        //Zero bytes means the buffer overflowed and the changes were dropped
+        bool intact = ok && bytesTransferred > 0;
+        if (intact) {
+            wchar_t nameBuf[MAX_PATH]{ 0 };
+            std::string renamedFrom{};
+            const uint8_t* ptr = reinterpret_cast<const uint8_t*>(_changeBuffer);
             while (true) {
+                const FILE_NOTIFY_INFORMATION* evnt = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(ptr);
                 DWORD nameLen = evnt->FileNameLength / sizeof(wchar_t);
-                memcpy(nameBuf, evnt->FileName, evnt->FileNameLength);
+                if (nameLen >= MAX_PATH) { nameLen = MAX_PATH - 1; }
+                memcpy(nameBuf, evnt->FileName, nameLen * sizeof(wchar_t));
                 nameBuf[nameLen] = 0;
 
-                auto& act = actions.emplace_back();
-                act.action = evnt->Action;
-                Helpers::wideToUTF8(nameBuf, nameLen, act.path);
-
-                if (evnt->NextEntryOffset == 0) {
-                    break;
-                }
-                *((uint8_t**)&evnt) += evnt->NextEntryOffset;
-            }
+                std::string path{};
+                Helpers::wideToUTF8(nameBuf, nameLen, path);
+                IO::fixPath(path);
 
-            BOOL success = ReadDirectoryChangesW(
-                _handle, _changeBuffer, CHANGE_BUFFER_SIZE, TRUE,
-                FILE_NOTIFY_CHANGE_FILE_NAME |
-                FILE_NOTIFY_CHANGE_DIR_NAME |
-                FILE_NOTIFY_CHANGE_LAST_WRITE,
-                NULL, &_overlapped, NULL);
-
-            for (size_t i = 0; i < actions.size(); i++) {
-                auto& act = actions[i];
-                switch (act.action)
-                {
+                switch (evnt->Action) {
                     case FILE_ACTION_ADDED:
-                        changes.emplace_back(DirectoryChange::TYPE_CREATE, act.path);
+                        _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
                         break;
                     case FILE_ACTION_REMOVED:
-                        changes.emplace_back(DirectoryChange::TYPE_DELETE, act.path);
+                        _raw.emplace_back(DirectoryChange::TYPE_DELETE, path);
                         break;
                     case FILE_ACTION_MODIFIED:
-                        changes.emplace_back(DirectoryChange::TYPE_MODIFIED, act.path);
+                        _raw.emplace_back(DirectoryChange::TYPE_MODIFIED, path);
                         break;
                     case FILE_ACTION_RENAMED_OLD_NAME:
-                        i++;
-                        if (i < actions.size()) {
-                            changes.emplace_back(act.path, actions[i].path);
-                        }
+                        renamedFrom = std::move(path);
+                        break;
+                    case FILE_ACTION_RENAMED_NEW_NAME:
+                        _raw.emplace_back(renamedFrom, path);
+                        renamedFrom.clear();
                         break;
                 }
+
+                if (evnt->NextEntryOffset == 0) {
+                    break;
+                }
+                ptr += evnt->NextEntryOffset;
             }
         }
 
-        return changes.size() > 0;
+        ReadDirectoryChangesW(
+            _handle, _changeBuffer, DWORD(CHANGE_BUFFER_SIZE), TRUE, CHANGE_FILTER,
+            NULL, &_overlapped, NULL);
+        return intact;
+    }
+#else
+    static constexpr uint32_t WATCH_MASK =
+        IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE |
+        IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_DONT_FOLLOW | IN_ONLYDIR;
+
+    DirectoryMonitor::DirectoryMonitor() :
+        _flags{}, _root{}, _coalescer{}, _raw{}, _known{}, _overflows{ 0 },
+        _fd{ -1 }, _watches{}, _changeBuffer{ nullptr } {
+        _coalescer.setDebounce(DEFAULT_DEBOUNCE_MS);
+    }
+
+    DirectoryMonitor::~DirectoryMonitor() {
+        close();
+    }
+
+    void DirectoryMonitor::close() {
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+
+        _watches.clear();
+        free(_changeBuffer);
+        _changeBuffer = nullptr;
+
+        _coalescer.clear();
+        _known.clear();
+        _flags &= ~(FLAG_OPEN | FLAG_ROOT_LOST);
+    }
+
+    bool DirectoryMonitor::tryOpen(const std::string& path) {
+        close();
+
+        _root = path;
+        IO::fixPath(_root);
+        while (_root.length() > 1 && _root.back() == '/') {
+            _root.pop_back();
+        }
+
+        _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (_fd < 0) {
+            JE_CORE_ERROR("[DirectoryMonitor] Error: Failed to create inotify instance for directory {0}! ({1})", path, errno);
+            return false;
+        }
+
+        //Watches go in before the snapshot so nothing between the two is missed
+        if (!addWatches("", false)) {
+            JE_CORE_ERROR("[DirectoryMonitor] Error: Failed to watch directory {0}! ({1})", path, errno);
+            close();
+            return false;
+        }
+        _changeBuffer = reinterpret_cast<uint8_t*>(malloc(CHANGE_BUFFER_SIZE));
+
+        DirectoryScan scan{};
+        scan.scan(_root);
+        setKnown(scan);
+
+        _flags |= FLAG_OPEN;
+        return true;
+    }
+
+    bool DirectoryMonitor::addWatches(const std::string& dir, bool reportContents) {
+        //Watching a directory again gives back its existing descriptor, only the path is updated
+        std::string full = dir.length() > 0 ? _root + '/' + dir : _root;
+        int wd = inotify_add_watch(_fd, full.c_str(), WATCH_MASK);
+        if (wd < 0) {
+            //Usually gone again already, its deletion is reported by the parent
+            if (errno != ENOENT && errno != ENOTDIR) {
+                JE_CORE_WARN("[DirectoryMonitor] Warning: Failed to watch '{0}'! ({1})", full, errno);
+            }
+            return false;
+        }
+        _watches[wd] = dir;
+
+        //Anything created before the watch existed is only found by listing the directory
+        std::error_code ec{};
+        for (fs::directory_iterator it(full, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            std::string path = joinPath(dir, name.c_str(), name.length());
+
+            std::error_code entEc{};
+            bool isDir = it->is_directory(entEc) && !it->is_symlink(entEc);
+            if (reportContents) {
+                _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
+            }
+
+            if (isDir) {
+                addWatches(path, reportContents);
+            }
+        }
+        return true;
+    }
+
+    static bool isWithin(const std::string& path, const std::string& dir) {
+        return path.length() >= dir.length() && path.compare(0, dir.length(), dir) == 0 &&
+            (path.length() == dir.length() || path[dir.length()] == '/');
+    }
+
+    void DirectoryMonitor::removeWatches(const std::string& dir) {
+        for (auto it = _watches.begin(); it != _watches.end();) {
+            if (isWithin(it->second, dir)) {
+                inotify_rm_watch(_fd, it->first);
+                it = _watches.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    bool DirectoryMonitor::moveWatches(const std::string& from, const std::string& to) {
+        bool watched = false;
+        for (auto& watch : _watches) {
+            if (isWithin(watch.second, from)) {
+                watched |= watch.second.length() == from.length();
+                watch.second = to + watch.second.substr(from.length());
+            }
+        }
+        return watched;
+    }
+
+    bool DirectoryMonitor::readEvents() {
+        struct MovedFrom {
+            uint32_t cookie;
+            std::string path;
+            bool isDir;
+        };
+
+        std::vector<MovedFrom> moves{};
+        bool overflowed = false;
+        while (true) {
+            ssize_t length = read(_fd, _changeBuffer, CHANGE_BUFFER_SIZE);
+            if (length <= 0) {
+                if (length < 0 && errno == EINTR) { continue; }
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* evnt = reinterpret_cast<const inotify_event*>(_changeBuffer + offset);
+                offset += sizeof(inotify_event) + evnt->len;
+
+                if (evnt->mask & IN_Q_OVERFLOW) {
+                    overflowed = true;
+                    continue;
+                }
+
+                if (evnt->mask & IN_IGNORED) {
+                    _watches.erase(evnt->wd);
+                    continue;
+                }
+
+                //Subdirectories going away are reported by their parent, only the root matters here
+                if (evnt->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                    auto self = _watches.find(evnt->wd);
+                    if (self != _watches.end() && self->second.length() < 1) {
+                        _flags |= FLAG_ROOT_LOST;
+                    }
+                    continue;
+                }
+
+                auto dir = _watches.find(evnt->wd);
+                if (dir == _watches.end() || evnt->len < 1) { continue; }
+
+                std::string path = joinPath(dir->second, evnt->name, strlen(evnt->name));
+                bool isDir = (evnt->mask & IN_ISDIR) != 0;
+
+                if (evnt->mask & IN_CREATE) {
+                    _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
+                    if (isDir) {
+                        addWatches(path, true);
+                    }
+                }
+                else if (evnt->mask & IN_DELETE) {
+                    _raw.emplace_back(DirectoryChange::TYPE_DELETE, path);
+                }
+                else if (evnt->mask & (IN_MODIFY | IN_CLOSE_WRITE)) {
+                    if (!isDir) {
+                        _raw.emplace_back(DirectoryChange::TYPE_MODIFIED, path);
+                    }
+                }
+                else if (evnt->mask & IN_MOVED_FROM) {
+                    moves.push_back({ evnt->cookie, std::move(path), isDir });
+                }
+                else if (evnt->mask & IN_MOVED_TO) {
+                    auto from = std::find_if(moves.begin(), moves.end(), [cookie = evnt->cookie](const MovedFrom& move) { return move.cookie == cookie; });
+                    if (from != moves.end()) {
+                        _raw.emplace_back(from->path, path);
+
+                        //Created and moved before it could be watched, nothing inside it has been seen yet
+                        if (isDir && !moveWatches(from->path, path)) {
+                            addWatches(path, true);
+                        }
+                        moves.erase(from);
+                    }
+                    else {
+                        //Moved in from outside the tree
+                        _raw.emplace_back(DirectoryChange::TYPE_CREATE, path);
+                        if (isDir) {
+                            addWatches(path, true);
+                        }
+                    }
+                }
+            }
+        }
+
+        //Both halves of a move are queued at once, a lone half means it left the tree
+        for (auto& move : moves) {
+            if (move.isDir) {
+                removeWatches(move.path);
+            }
+            _raw.emplace_back(DirectoryChange::TYPE_DELETE, move.path);
+        }
+        return !overflowed;
     }
-}
\ No newline at end of file
+#endif
+}
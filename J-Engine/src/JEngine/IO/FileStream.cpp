@@ -137,7 +137,8 @@ bool FileStream::open(const char* mode, const int shared, bool keepPosition) con
     _capacity = 0;
     size_t oldPos = _position;
 
-    if (access(_filepath.c_str(), F_OK) == 0) {
+    //Writing is allowed to create the file, reading requires it to exist
+    if ((_flags & WRITE_FLAG) || access(_filepath.c_str(), F_OK) == 0) {
         if (shared) {
             _file = _fsopen(_filepath.c_str(), mode, shared);
         }
@@ -206,16 +207,41 @@ size_t FileStream::write(const void* buffer, size_t elementSize, const size_t co
     _length = _position > _length ? _position : _length;
     _capacity = _length;
 
-    if (bigEndian) {
-        uint8_t* tempBuf = reinterpret_cast<uint8_t*>(_malloca(size));
-
-        if (tempBuf) {
-            memcpy(tempBuf, buffer, size);
-            JEngine::Data::reverseEndianess(tempBuf, elementSize, count);
-            size_t ret = _fwrite_nolock(tempBuf, elementSize, count, _file);
-            _freea(tempBuf);
-            return ret * elementSize;
+    if (bigEndian && elementSize > 1) {
+        //Swaps through a fixed stack chunk, elements never straddle two chunks
+        //unless they're wider than the chunk, those get written back to front piece by piece
+        static constexpr size_t SWAP_CHUNK = 1024;
+        uint8_t chunk[SWAP_CHUNK];
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(buffer);
+
+        const size_t perChunk = SWAP_CHUNK / elementSize;
+        size_t written = 0;
+        while (written < count) {
+            if (perChunk < 1) {
+                size_t left = elementSize;
+                while (left > 0) {
+                    const size_t piece = left > SWAP_CHUNK ? SWAP_CHUNK : left;
+                    left -= piece;
+                    for (size_t i = 0; i < piece; i++) {
+                        chunk[i] = src[left + piece - 1 - i];
+                    }
+                    if (_fwrite_nolock(chunk, 1, piece, _file) < piece) { return written * elementSize; }
+                }
+                src += elementSize;
+                written++;
+                continue;
+            }
+
+            const size_t batch = count - written > perChunk ? perChunk : count - written;
+            memcpy(chunk, src, batch * elementSize);
+            JEngine::Data::reverseEndianess(chunk, elementSize, batch);
+
+            const size_t ret = _fwrite_nolock(chunk, elementSize, batch, _file);
+            written += ret;
+            src += batch * elementSize;
+            if (ret < batch) { break; }
         }
+        return written * elementSize;
     }
     return _fwrite_nolock(buffer, elementSize, count, _file) * elementSize;
 }
@@ -334,14 +334,16 @@ namespace JEngine::IO {
         }
     }
 
-    bool pathsAreEqual(ConstSpan<char> lhs, ConstSpan<char> rhs) {
+    bool pathsAreEqual(ConstSpan<char> lhs, ConstSpan<char> rhs, bool ignoreCase) {
         if (lhs.length() == rhs.length()) {
             for (size_t i = 0; i < lhs.length(); i++) {
                 char a = lhs[i];
                 char b = rhs[i];
 
-                a = char(std::tolower(a));
-                b = char(std::tolower(b));
+                if (ignoreCase) {
+                    a = char(std::tolower(uint8_t(a)));
+                    b = char(std::tolower(uint8_t(b)));
+                }
 
                 a = a == '\\' ? '/' : a;
                 b = b == '\\' ? '/' : b;
@@ -352,4 +354,23 @@ namespace JEngine::IO {
         }
         return false;
     }
+
+    uint64_t hashPath(ConstSpan<char> path, bool ignoreCase) {
+        return appendPathHash(PATH_HASH_SEED, path, ignoreCase);
+    }
+
+    uint64_t appendPathHash(uint64_t hash, ConstSpan<char> part, bool ignoreCase) {
+        static constexpr uint64_t FNV_PRIME = 0x00000100000001B3ULL;
+
+        for (size_t i = 0; i < part.length(); i++) {
+            char c = part[i];
+            c = c == '\\' ? '/' : c;
+            if (ignoreCase) {
+                c = char(std::tolower(uint8_t(c)));
+            }
+            hash ^= uint8_t(c);
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
 }
\ No newline at end of file
@@ -5,31 +5,22 @@
 #include <JEngine/Math/Math.h>
 #include <JEngine/Utility/DataUtilities.h>
 #include <JEngine/Utility/Span.h>
+#include <JEngine/Utility/SIMD.h>
+#include <JEngine/Utility/Parallel.h>
 #include <JEngine/IO/FileStream.h>
 #include <JEngine/IO/Compression/ZLib.h>
+#include <JEngine/IO/Compression/LZ4.h>
 #include <JEngine/IO/MemoryStream.h>
 #include <JEngine/Math/Graphics/JColor4444.h>
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
 
 namespace JEngine {
     int32_t calcualtePadding(const int32_t width, const int32_t bpp) {
         const int32_t rem = (width * bpp) & 0x3;
         return rem ? 4 - rem : 0;
     }
-    void flipRB(uint8_t* data, const int32_t width, const int32_t bpp) {
-        switch (bpp)
-        {
-            default: return;
-            case 3:
-            case 4:
-                for (size_t i = 0, j = 0, k = 2; i < width; i++, j += bpp, k += bpp) {
-                    uint8_t temp = data[j];
-                    data[j] = data[k];
-                    data[k] = temp;
-                }
-                break;
-        }
-    }
-
     namespace Bmp {
 JE_BEG_PACK
         struct BmpHeader {
@@ -472,6 +463,9 @@ JE_END_PACK
             return true;
         }
 
+        //Rows are filtered and deflated in bands of roughly this size, IDAT chunks are split at the same size.
+        static constexpr size_t BAND_SIZE = 256 * 1024;
+
         static int32_t paethPredictor(int32_t a, int32_t b, int32_t c) {
             int32_t p = a + b - c;
             int32_t pA = std::abs(p - a);
@@ -482,12 +476,15 @@ JE_END_PACK
             return pB <= pC ? b : c;
         }
 
-        static void applyFilter(Span<uint8_t>& current, Span<uint8_t>& prior, Span<uint8_t>& target, int32_t width, int32_t bpp, uint8_t filter) {
+        static void applyFilter(const uint8_t* current, const uint8_t* prior, uint8_t* target, int32_t width, int32_t bpp, uint8_t filter) {
             width *= bpp;
             switch (filter)
             {
+                default: //None
+                    memcpy(target, current, width);
+                    break;
                 case 1: //Sub
-                    memcpy(target.get(), current.get(), bpp);
+                    memcpy(target, current, bpp);
                     for (int32_t x = bpp, xS = 0; x < width; x++, xS++) {
                         target[x] = uint8_t(int32_t(current[x]) - current[xS]);
                     }
@@ -513,33 +510,207 @@ JE_END_PACK
             }
         }
 
-        static void reverseFilter(Span<uint8_t>& current, Span<uint8_t>& prior, int32_t width, int32_t bpp, uint8_t filter) {
-            width *= bpp;
+        static uint8_t pickFilterBest(const uint8_t* current, const uint8_t* prior, uint8_t* candidates, int32_t width, int32_t bpp) {
+            uint64_t score = UINT64_MAX;
+            uint8_t filter = 0;
+            calculateDiff(current, width, bpp, score);
+
+            const size_t scanSR = size_t(width) * bpp;
+            for (uint8_t i = 0; i < 4; i++) {
+                uint8_t* target = candidates + i * scanSR;
+                applyFilter(current, prior, target, width, bpp, i + 1);
+                if (calculateDiff(target, width, bpp, score)) {
+                    filter = uint8_t(i + 1);
+                }
+            }
+            return filter;
+        }
+
+        // Cheap estimate, sums the absolute residuals of every filter over a 
+        // sparse sample of the row and only runs the winning filter afterwards.
+        static uint8_t pickFilterFast(const uint8_t* current, const uint8_t* prior, int32_t width, int32_t bpp) {
+            static constexpr int32_t SAMPLE_STEP = 4;
+            uint64_t costs[5]{ 0 };
+            for (int32_t x = 1; x < width; x += SAMPLE_STEP) {
+                const uint8_t* cur = current + x * bpp;
+                const uint8_t* up = prior + x * bpp;
+                for (int32_t i = 0; i < bpp; i++) {
+                    int32_t v = cur[i];
+                    int32_t a = cur[i - bpp];
+                    int32_t b = up[i];
+                    int32_t c = up[i - bpp];
+                    costs[0] += std::abs(int8_t(v));
+                    costs[1] += std::abs(int8_t(v - a));
+                    costs[2] += std::abs(int8_t(v - b));
+                    costs[3] += std::abs(int8_t(v - ((a + b) >> 1)));
+                    costs[4] += std::abs(int8_t(v - paethPredictor(a, b, c)));
+                }
+            }
+
+            uint8_t filter = 0;
+            for (uint8_t i = 1; i < 5; i++) {
+                if (costs[i] < costs[filter]) { filter = i; }
+            }
+            return filter;
+        }
+
+        static void expandIndexed16(const uint8_t* indices, const uint8_t* palette, uint8_t* target, int32_t width, int32_t bpp) {
+            const uint16_t* idx = reinterpret_cast<const uint16_t*>(indices);
+            for (int32_t i = 0, j = 0; i < width; i++, j += bpp) {
+                memcpy(target + j, palette + (size_t(idx[i]) << 2), bpp);
+            }
+        }
+
+        static void unfilterSub(uint8_t* current, size_t length, int32_t bpp) {
+            for (size_t x = bpp, xS = 0; x < length; x++, xS++) {
+                current[x] = uint8_t(current[x] + current[xS]);
+            }
+        }
+
+        static void unfilterUp(uint8_t* current, const uint8_t* prior, size_t length) {
+            size_t x = 0;
+#ifdef JE_SIMD_SSE2
+            for (; x + 16 <= length; x += 16) {
+                __m128i cur = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + x));
+                __m128i pri = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(current + x), _mm_add_epi8(cur, pri));
+            }
+#endif
+            for (; x < length; x++) {
+                current[x] = uint8_t(current[x] + prior[x]);
+            }
+        }
+
+        static void unfilterAverage(uint8_t* current, const uint8_t* prior, size_t length, int32_t bpp) {
+            for (size_t x = 0; x < size_t(bpp); x++) {
+                current[x] = uint8_t(current[x] + (prior[x] >> 1));
+            }
+
+            for (size_t x = bpp, xS = 0; x < length; x++, xS++) {
+                current[x] = uint8_t(current[x] + ((prior[x] + current[xS]) >> 1));
+            }
+        }
+
+        static void unfilterPaeth(uint8_t* current, const uint8_t* prior, size_t length, int32_t bpp) {
+            for (size_t x = 0; x < size_t(bpp); x++) {
+                current[x] = uint8_t(current[x] + prior[x]);
+            }
+
+            for (size_t x = bpp, xS = 0; x < length; x++, xS++) {
+                current[x] = uint8_t(current[x] + paethPredictor(current[xS], prior[x], prior[xS]));
+            }
+        }
+
+#ifdef JE_SIMD_SSE2
+        // The SIMD kernels work on one pixel at a time, since every pixel
+        // depends on the one to its left. Loads and stores go through memcpy 
+        // so that 3 and 6 byte pixels never touch memory past the scanline.
+        template<int32_t BPP>
+        static FORCE_INLINE __m128i loadPixel(const uint8_t* data) {
+            uint64_t temp = 0;
+            memcpy(&temp, data, BPP);
+            return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&temp));
+        }
+
+        template<int32_t BPP>
+        static FORCE_INLINE void storePixel(uint8_t* data, const __m128i& value) {
+            uint64_t temp = 0;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&temp), value);
+            memcpy(data, &temp, BPP);
+        }
+
+        static FORCE_INLINE __m128i abs16(const __m128i& value) {
+#ifdef JE_SIMD_SSSE3
+            return _mm_abs_epi16(value);
+#else
+            return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+#endif
+        }
+
+        static FORCE_INLINE __m128i select128(const __m128i& mask, const __m128i& a, const __m128i& b) {
+            return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+        }
+
+        template<int32_t BPP>
+        static void unfilterSubSIMD(uint8_t* current, size_t length) {
+            __m128i a = _mm_setzero_si128();
+            for (size_t x = 0; x < length; x += BPP) {
+                a = _mm_add_epi8(loadPixel<BPP>(current + x), a);
+                storePixel<BPP>(current + x, a);
+            }
+        }
+
+        template<int32_t BPP>
+        static void unfilterAverageSIMD(uint8_t* current, const uint8_t* prior, size_t length) {
+            const __m128i ones = _mm_set1_epi8(1);
+            __m128i a = _mm_setzero_si128();
+            for (size_t x = 0; x < length; x += BPP) {
+                __m128i b = loadPixel<BPP>(prior + x);
+
+                //_mm_avg_epu8 rounds up, PNG rounds down
+                __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+                a = _mm_add_epi8(loadPixel<BPP>(current + x), avg);
+                storePixel<BPP>(current + x, a);
+            }
+        }
+
+        template<int32_t BPP>
+        static void unfilterPaethSIMD(uint8_t* current, const uint8_t* prior, size_t length) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i lowMask = _mm_set1_epi16(0xFF);
+
+            __m128i a = zero;
+            __m128i c = zero;
+            for (size_t x = 0; x < length; x += BPP) {
+                __m128i b = _mm_unpacklo_epi8(loadPixel<BPP>(prior + x), zero);
+                __m128i d = _mm_unpacklo_epi8(loadPixel<BPP>(current + x), zero);
+
+                // p = a + b - c, so |p - a| = |b - c|, |p - b| = |a - c| and |p - c| = |(b - c) + (a - c)|
+                __m128i pa = _mm_sub_epi16(b, c);
+                __m128i pb = _mm_sub_epi16(a, c);
+                __m128i pc = abs16(_mm_add_epi16(pa, pb));
+                pa = abs16(pa);
+                pb = abs16(pb);
+
+                __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                __m128i pred = select128(_mm_cmpeq_epi16(smallest, pa), a, select128(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+                a = _mm_and_si128(_mm_add_epi16(d, pred), lowMask);
+                c = b;
+                storePixel<BPP>(current + x, _mm_packus_epi16(a, a));
+            }
+        }
+
+        template<int32_t BPP>
+        static void reverseFilterSIMD(uint8_t* current, const uint8_t* prior, size_t length, uint8_t filter) {
             switch (filter)
             {
-                case 1: //Sub
-                    for (int32_t x = bpp, xS = 0; x < width; x++, xS++) {
-                        current[x] = uint8_t(current[x] + current[xS]);
-                    }
-                    break;
-                case 2: //Up
-                    for (int32_t x = 0; x < width; x++) {
-                        current[x] = uint8_t(current[x] + prior[x]);
-                    }
-                    break;
-                case 3: //Average
-                    for (int32_t x = 0, xS = -bpp; x < width; x++, xS++) {
-                        current[x] = uint8_t(current[x] + ((prior[x] + (xS < 0 ? 0 : current[xS])) >> 1));
-                    }
-                    break;
-                case 4: //Paeth
-                    for (int32_t x = 0, xS = -bpp; x < width; x++, xS++) {
-                        int32_t a = (xS < 0 ? 0 : current[xS]);
-                        int32_t b = prior[x];
-                        int32_t c = (xS < 0 ? 0 : prior[xS]);
-                        current[x] = uint8_t(current[x] + paethPredictor(a, b, c));
-                    }
-                    break;
+                case 1: unfilterSubSIMD<BPP>(current, length);            break;
+                case 2: unfilterUp(current, prior, length);               break;
+                case 3: unfilterAverageSIMD<BPP>(current, prior, length); break;
+                case 4: unfilterPaethSIMD<BPP>(current, prior, length);   break;
+            }
+        }
+#endif
+
+        static void reverseFilter(uint8_t* current, const uint8_t* prior, int32_t width, int32_t bpp, uint8_t filter) {
+            const size_t length = size_t(width) * bpp;
+#ifdef JE_SIMD_SSE2
+            switch (bpp)
+            {
+                case 3: reverseFilterSIMD<3>(current, prior, length, filter); return;
+                case 4: reverseFilterSIMD<4>(current, prior, length, filter); return;
+                case 6: reverseFilterSIMD<6>(current, prior, length, filter); return;
+                case 8: reverseFilterSIMD<8>(current, prior, length, filter); return;
+            }
+#endif
+
+            switch (filter)
+            {
+                case 1: unfilterSub(current, length, bpp);              break;
+                case 2: unfilterUp(current, prior, length);             break;
+                case 3: unfilterAverage(current, prior, length, bpp);   break;
+                case 4: unfilterPaeth(current, prior, length, bpp);     break;
             }
         }
 
@@ -567,6 +738,10 @@ JE_END_PACK
             return encode(path.c_str(), imgData, compression);
         }
 
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encode(path.c_str(), imgData, params);
+        }
+
         bool decode(const char* path, ImageData& imgData, const ImageDecodeParams params) {
             FileStream stream(path, "rb");
             if (stream.isOpen()) {
@@ -591,8 +766,6 @@ JE_END_PACK
             PngChunk paletteChnk{};
             PngChunk alphaChnk{};
 
-            size_t totalIdat = 0;
-
             IHDRChunk ihdr{};
             PngChunk chunk{};
             while (!stream.isEOF()) {
@@ -660,7 +833,6 @@ JE_END_PACK
                         break;
 
                     case CH_IDAT:
-                        totalIdat += chunk.length;
                         idats.emplace_back(chunk);
                         stream.seek(chunk.length + 4, SEEK_CUR);
                         break;
@@ -676,60 +848,27 @@ JE_END_PACK
             uint32_t scanSR = imgData.width * bpp;
             uint32_t scanSP = scanSR + 1;
 
-            uint32_t paletteSize = imgData.format == TextureFormat::Indexed8 ? 256 * 4 : (params.flags & F_IMG_BUILD_PALETTE) ? 256 * 256 * 4 : 0;
+            uint32_t paletteSize = imgData.format == TextureFormat::Indexed8 ? 256 * 4 : 0;
             uint32_t totalSize = scanSR * imgData.height + paletteSize;
-            uint32_t rawSize = scanSP * imgData.height;
+            imgData.paletteSize = paletteSize >> 2;
 
             if (!imgData.doAllocate(totalSize)) {
                 JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to allocate pixel buffer! ({0} bytes)", totalSize);
                 return false;
             }
 
-            uint8_t* rawBuffer = reinterpret_cast<uint8_t*>(_malloca(rawSize));
-            if (!rawBuffer) {
-                free(imgData.data);
-                imgData.data = nullptr;
-                JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to allocate decompress buffer! ({0} bytes)", rawSize);
-                return false;
-            }
-
-            uint8_t* compBuffer = reinterpret_cast<uint8_t*>(_malloca(totalIdat));
-            if (!compBuffer) {
-                _freea(rawBuffer);
-                free(imgData.data);
-                imgData.data = nullptr;
-                JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to allocate IDAT buffer! ({0} bytes)", totalIdat);
-                return false;
-            }
-
-            size_t pos = 0;
-            for (const auto& ch : idats) {
-                stream.seek(ch.position, SEEK_SET);
-                stream.read(compBuffer + pos, ch.length, false);
-                pos += ch.length;
-            }
-            int32_t ret = ZLib::inflateData(compBuffer, totalIdat, rawBuffer, rawSize);
-            _freea(compBuffer);
-
-            if (ret == -1) {
-                JE_ERROR("[Image-IO] (PNG) Decode Error: ZLib Inflate failed!");
-                _freea(rawBuffer);
-
-                free(imgData.data);
-                imgData.data = nullptr;
-                return false;
-            }
-
-            uint8_t* scanBuffer = reinterpret_cast<uint8_t*>(_malloca(scanSP * 2));
+            //Only two scanlines and a small IDAT window are kept around, 
+            //rows are unfiltered as soon as ZLib has produced them.
+            static constexpr size_t IDAT_BUFFER_SIZE = 8192 << 2;
+            uint8_t* scanBuffer = reinterpret_cast<uint8_t*>(_malloca(scanSP * 2 + IDAT_BUFFER_SIZE));
             if (!scanBuffer) {
                 JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to allocate scan buffer!");
-                _freea(rawBuffer);
-
                 free(imgData.data);
                 imgData.data = nullptr;
                 return false;
             }
             memset(scanBuffer, 0, scanSP * 2);
+            uint8_t* idatBuffer = scanBuffer + scanSP * 2;
 
             if (imgData.format == TextureFormat::Indexed8) {
                 if (paletteChnk.type == CH_PLTE) {
@@ -757,55 +896,85 @@ JE_END_PACK
                 }
             }
 
-            Span<uint8_t> prior(scanBuffer, scanSP);
-            Span<uint8_t> current(scanBuffer + scanSP, scanSP);
+            uint8_t* prior = scanBuffer;
+            uint8_t* current = scanBuffer + scanSP;
+
+            ZLib::ZLibContext context{};
+            int32_t ret = ZLib::inflateBegin(context, current, scanSP);
+            int32_t inflated = 0;
 
-            Span<uint8_t> priorPix = prior.slice(1);
-            Span<uint8_t> currentPix = current.slice(1);
+            size_t idatIndex = 0;
+            size_t idatPos = 0;
+            size_t idatLeft = 0;
 
-            TextureFormat fmt = TextureFormat::Indexed8;
             size_t posR = paletteSize;
-            int32_t colorCount = 0;
-            bool canBuild = bpp > 1;
             size_t bytesPC = ihdr.bitDepth >> 3;
             size_t channelsW = (bpp / bytesPC) * imgData.width;
-            for (size_t y = 0, xP = 0, xPS = 0; y < imgData.height; y++, xP += scanSP) {
-                memcpy(current.get(), rawBuffer + xP, scanSP);
-                Data::reverseEndianess(currentPix.get(), bytesPC, channelsW);
+            for (int32_t y = 0; y < imgData.height && ret == Z_OK; y++) {
+                context.stream.next_out = current;
+                context.stream.avail_out = scanSP;
 
-                reverseFilter(currentPix, priorPix, imgData.width, bpp, current[0]);
+                while (context.stream.avail_out > 0) {
+                    if (!context.initialized) {
+                        ret = Z_DATA_ERROR;
+                        break;
+                    }
 
-                auto pixTgt = imgData.data + posR;
-                currentPix.copyTo(pixTgt);
-                posR += scanSR;
+                    if (context.stream.avail_in == 0) {
+                        while (idatLeft == 0 && idatIndex < idats.size()) {
+                            idatPos = idats[idatIndex].position;
+                            idatLeft = idats[idatIndex].length;
+                            idatIndex++;
+                        }
+
+                        if (idatLeft == 0) {
+                            ret = Z_BUF_ERROR;
+                            break;
+                        }
 
-                if (canBuild && imgData.format != TextureFormat::Indexed8 && (params.flags & F_IMG_BUILD_PALETTE)) {
-                    if (!tryBuildPalette(pixTgt, 0, scanSR, colorCount, fmt, bpp, imgData.data, -1)) {
-                        canBuild = false;
+                        size_t toRead = std::min(idatLeft, IDAT_BUFFER_SIZE);
+                        stream.seek(idatPos, SEEK_SET);
+                        stream.read(idatBuffer, toRead, false);
+                        idatPos += toRead;
+                        idatLeft -= toRead;
+                        context.refreshNext(idatBuffer, toRead);
                     }
-                }
-                current.copyTo(prior);
-            }
 
-            if (colorCount > 0 && canBuild) {
-                colorCount = fmt == TextureFormat::Indexed8 ? 256 : Math::alignToPalette(colorCount);
+                    ret = ZLib::inflateSegment(context, context.stream.next_in, context.stream.avail_in, inflated, false);
+                    if (ret != Z_OK) { break; }
+                }
+                if (ret != Z_OK) { break; }
 
-                JE_TRACE("[Image-IO] (PNG) Decode: Building palette with {0} colors!", colorCount);
-                totalSize = colorCount * 4 + (imgData.width * imgData.height * 2);
-                uint8_t* temp = reinterpret_cast<uint8_t*>(malloc(totalSize));
+                reverseFilter(current + 1, prior + 1, imgData.width, bpp, current[0]);
 
-                if (!temp) {
-                    JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to allocate Indexed pixel buffer! ({0} bytes)", totalSize);
-                    return false;
-                }
-                applyPalette(imgData.data, imgData.width, imgData.height, colorCount, imgData.format, temp, fmt, -1);
+                auto pixTgt = imgData.data + posR;
+                memcpy(pixTgt, current + 1, scanSR);
+                Data::reverseEndianess(pixTgt, bytesPC, channelsW);
+                posR += scanSR;
+                std::swap(prior, current);
+            }
+            ZLib::inflateEnd(context, inflated);
+            _freea(scanBuffer);
 
+            if (ret != Z_OK) {
+                JE_ERROR("[Image-IO] (PNG) Decode Error: ZLib Inflate failed! ({0})", ZLib::zerr(ret));
                 free(imgData.data);
-                imgData.data = temp;
+                imgData.data = nullptr;
+                return false;
             }
 
-            _freea(scanBuffer);
-            _freea(rawBuffer);
+            //Images with too many colors get quantized, so this always ends up indexed
+            if (imgData.format != TextureFormat::Indexed8 && (params.flags & F_IMG_BUILD_PALETTE)) {
+                JE_TRACE("[Image-IO] (PNG) Decode: Building palette!");
+                QuantizeParams quantParams{};
+                quantParams.maxColors = 256 * 256;
+                if (!quantize(imgData, imgData, quantParams)) {
+                    JE_ERROR("[Image-IO] (PNG) Decode Error: Failed to build palette!");
+                    free(imgData.data);
+                    imgData.data = nullptr;
+                    return false;
+                }
+            }
             return true;
         }
 
@@ -894,15 +1063,27 @@ JE_END_PACK
         }
 
         bool encode(const char* path, const ImageData& imgData, const uint32_t compression) {
+            ImageEncodeParams params{};
+            params.compression = int32_t(compression);
+            return encode(path, imgData, params);
+        }
+
+        bool encode(const Stream& stream, const ImageData& imgData, const uint32_t compression) {
+            ImageEncodeParams params{};
+            params.compression = int32_t(compression);
+            return encode(stream, imgData, params);
+        }
+
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params) {
             FileStream fs(path);
             if (fs.open("wb")) {
-                return encode(fs, imgData, compression);
+                return encode(fs, imgData, params);
             }
             JE_ERROR("[Image-IO] (PNG) Encode Error: Failed to open file '{0}' for writing!", path);
             return false;
         }
 
-        bool encode(const Stream& stream, const ImageData& imgData, const uint32_t compression) {
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params) {
             if (!stream.isOpen()) {
                 JE_ERROR("[Image-IO] (PNG) Encode Error: Stream isn't open!");
                 return false;
@@ -1003,350 +1184,840 @@ JE_END_PACK
             int32_t bpp = getBitsPerPixel(fmt) >> 3;
             uint32_t scanSR = imgData.width * bpp;
             uint32_t scanSP = scanSR + 1;
-            uint8_t* scanBuffer = reinterpret_cast<uint8_t*>(malloc(scanSP * 6));
-            if (!scanBuffer) {
-                JE_ERROR("[Image-IO] (PNG) Encode Error: Couldn't allocate scan/filter buffer! ({0} bytes)", scanSP * 6);
-                return false;
-            }
-
-            size_t cmpBufSize = scanSP * (imgData.height + 2) + 4;
-            uint8_t* compressBuf = reinterpret_cast<uint8_t*>(malloc(cmpBufSize));
-            Span<uint8_t> compBuf(compressBuf, cmpBufSize);
-            if (!compressBuf) {
-                free(scanBuffer);
-                JE_ERROR("[Image-IO] (PNG) Encode Error: Couldn't allocate compression buffer! ({0} bytes)", cmpBufSize);
-                return false;
-            }
 
             bool indexed = imgData.format == TextureFormat::Indexed8 || imgData.format == TextureFormat::Indexed16;
-            MemoryStream compStrm(compressBuf, 0, cmpBufSize);
-            uint8_t* pixData = imgData.data + (indexed ? imgData.paletteSize * 4 : 0);
+            const uint8_t* pixData = imgData.data + (indexed ? imgData.paletteSize * 4 : 0);
+            auto getRow = [&](size_t y, uint8_t* temp) -> const uint8_t* {
+                if (imgData.format != TextureFormat::Indexed16) {
+                    return pixData + y * scanSR;
+                }
+                expandIndexed16(pixData + y * imgData.width * 2, imgData.data, temp, imgData.width, bpp);
+                return temp;
+            };
 
-            memset(scanBuffer, 0, scanSP * 6);
-            Span<uint8_t> prior(scanBuffer, scanSP);
-            Span<uint8_t> current(scanBuffer + scanSP, scanSP);
+            //Rows are filtered and deflated in bands, one window of bands per worker at a time,
+            //so only a window of filtered rows and its deflated output are ever held in memory.
+            uint32_t threads = (params.flags & F_IMG_ENC_MULTITHREAD) ? Parallel::getWorkerCount(params.threads) : 1;
+            size_t rowsPerBand = std::max<size_t>(BAND_SIZE / scanSP, 1);
+            size_t bandCount = (imgData.height + rowsPerBand - 1) / rowsPerBand;
+            size_t windowBands = std::min<size_t>(threads, bandCount);
+            size_t bandSize = rowsPerBand * scanSP;
+
+            //The tail of the previous window stays in front of the current one as the dictionary of its first band
+            const size_t dictSize = ZLib::DICTIONARY_SIZE;
+            size_t windowSize = dictSize + windowBands * bandSize;
+            uint8_t* window = reinterpret_cast<uint8_t*>(malloc(windowSize));
+            if (!window) {
+                JE_ERROR("[Image-IO] (PNG) Encode Error: Couldn't allocate filter buffer! ({0} bytes)", windowSize);
+                return false;
+            }
+            uint8_t* filtered = window + dictSize;
+
+            std::vector<std::vector<uint8_t>> blocks(windowBands);
+            std::vector<uint32_t> adlers(windowBands);
+            std::vector<int32_t> results(windowBands);
+
+            uint16_t zHeader = ZLib::getHeader(params.compression);
+            blocks[0].push_back(uint8_t(zHeader >> 8));
+            blocks[0].push_back(uint8_t(zHeader));
+
+            uint32_t adler = uint32_t(adler32(0, Z_NULL, 0));
+            size_t dictLen = 0;
+            std::atomic<bool> filterFailed{ false };
+            for (size_t first = 0; first < bandCount; first += windowBands) {
+                size_t count = std::min(windowBands, bandCount - first);
+                Parallel::forEach(count, threads, [&](size_t i) {
+                    size_t band = first + i;
+                    size_t yStart = band * rowsPerBand;
+                    size_t yEnd = std::min<size_t>(yStart + rowsPerBand, imgData.height);
+                    uint8_t* bandData = filtered + i * bandSize;
+                    size_t bandLen = (yEnd - yStart) * scanSP;
+
+                    //Zero row, two expanded Indexed16 rows and the four filter candidates
+                    uint8_t* scratch = reinterpret_cast<uint8_t*>(malloc(scanSR * 7));
+                    if (!scratch) {
+                        filterFailed.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                    memset(scratch, 0, scanSR * 7);
 
-            Span<uint8_t> priorPix = prior.slice(1);
-            Span<uint8_t> currentPix = current.slice(1);
+                    uint8_t* expanded[2]{ scratch + scanSR, scratch + scanSR * 2 };
+                    uint8_t* candidates = scratch + scanSR * 3;
 
-            Span<uint8_t> filters[4]
-            {
-                Span<uint8_t>(scanBuffer + scanSP * 2 , scanSR),
-                Span<uint8_t>(scanBuffer + scanSP * 2 + scanSR, scanSR),
-                Span<uint8_t>(scanBuffer + scanSP * 2 + scanSR * 2, scanSR),
-                Span<uint8_t>(scanBuffer + scanSP * 2 + scanSR * 3, scanSR),
-            };
+                    const uint8_t* prior = yStart > 0 ? getRow(yStart - 1, expanded[0]) : scratch;
+                    for (size_t y = yStart, j = 1; y < yEnd; y++, j++) {
+                        const uint8_t* current = getRow(y, expanded[j & 1]);
+                        uint8_t* target = bandData + (y - yStart) * scanSP;
 
-            static constexpr size_t ZLIB_BUFFER_SIZE = 8192 << 3;
-            static uint8_t BUFFER[ZLIB_BUFFER_SIZE]{};
-            ZLib::ZLibContext context{};
-            ZLib::deflateBegin(context, compression, BUFFER, ZLIB_BUFFER_SIZE);
+                        uint8_t filter = 0;
+                        if (imgData.format != TextureFormat::Indexed8) {
+                            filter = (params.flags & F_IMG_ENC_FAST_FILTER) ?
+                                pickFilterFast(current, prior, imgData.width, bpp) :
+                                pickFilterBest(current, prior, candidates, imgData.width, bpp);
+                        }
 
-            uint64_t score = 0;
-            uint8_t filter = 0;
-            int32_t dataOut = 0;
-            current[0] = 0;
+                        target[0] = filter;
+                        if (filter > 0 && !(params.flags & F_IMG_ENC_FAST_FILTER)) {
+                            memcpy(target + 1, candidates + (filter - 1) * scanSR, scanSR);
+                        }
+                        else {
+                            applyFilter(current, prior, target + 1, imgData.width, bpp, filter);
+                        }
+                        prior = current;
+                    }
+                    free(scratch);
 
-            uint32_t compBufPos = 0;
+                    //Bands of a window are contiguous, so everything before a band is its dictionary
+                    size_t blockDict = i > 0 ? dictSize : dictLen;
+                    adlers[i] = uint32_t(adler32(adler32(0, Z_NULL, 0), bandData, uInt(bandLen)));
+                    results[i] = ZLib::deflateBlock(bandData, bandLen, bandData - blockDict, blockDict, band == bandCount - 1, params.compression, blocks[i]);
+                });
 
-            int32_t bppR = getBitsPerPixel(imgData.format) >> 3;
-            for (int32_t y = 0, yP = 0, yPP = 0; y < imgData.height; y++, yP += scanSR, yPP += bppR) {
-                if (imgData.format == TextureFormat::Indexed16) {
-                    currentPix.write<uint8_t>(pixData + yPP, scanSR);
-                }
-                else {
-                    currentPix.write<uint8_t>(pixData + yP, scanSR);
+                if (filterFailed.load(std::memory_order_relaxed)) {
+                    free(window);
+                    JE_ERROR("[Image-IO] (PNG) Encode Error: Couldn't allocate filter scratch buffer! ({0} bytes)", scanSR * 7);
+                    return false;
                 }
 
-                if (imgData.format != TextureFormat::Indexed8) {
-                    score = UINT64_MAX;
-                    filter = 0;
-                    calculateDiff(currentPix.get(), imgData.width, bpp, score);
+                size_t windowLen = 0;
+                for (size_t i = 0; i < count; i++) {
+                    if (results[i] != Z_OK) {
+                        free(window);
+                        JE_ERROR("[Image-IO] (PNG) Encode Error: ZLib Deflate failed! ({0})", ZLib::zerr(results[i]));
+                        return false;
+                    }
+
+                    size_t bandLen = (std::min<size_t>((first + i + 1) * rowsPerBand, imgData.height) - (first + i) * rowsPerBand) * scanSP;
+                    adler = uint32_t(adler32_combine(adler, adlers[i], z_off_t(bandLen)));
+                    windowLen += bandLen;
 
-                    Span<uint8_t> pixScan(pixData + yP, scanSR);
-                    for (uint8_t i = 0; i < 4; i++) {
-                        applyFilter(pixScan, priorPix, filters[i], imgData.width, bpp, i + 1);
-                        if (calculateDiff(filters[i].get(), imgData.width, bpp, score)) {
-                            filter = uint8_t(i + 1);
+                    auto& data = blocks[i];
+                    if (first + i == bandCount - 1) {
+                        for (int32_t shift = 24; shift >= 0; shift -= 8) {
+                            data.push_back(uint8_t(adler >> shift));
                         }
                     }
 
-                    if (filter > 0) {
-                        filters[filter - 1].copyTo(currentPix.get());
+                    for (size_t pos = 0; pos < data.size(); pos += BAND_SIZE) {
+                        chunk.type = CH_IDAT;
+                        chunk.length = uint32_t(std::min(BAND_SIZE, data.size() - pos));
+                        writeChunk(stream, chunk, data.data() + pos);
                     }
-
-                    current[0] = filter;
-                    priorPix.write<uint8_t>(pixData + yP, scanSR);
+                    data.clear();
                 }
 
-                ZLib::deflateSegment(context, current.get(), current.length(), compStrm, BUFFER, ZLIB_BUFFER_SIZE);
+                dictLen = std::min(dictSize, dictLen + windowLen);
+                memmove(filtered - dictLen, filtered + windowLen - dictLen, dictLen);
             }
-            ZLib::deflateEnd(context, dataOut, compStrm, BUFFER, ZLIB_BUFFER_SIZE);
-
-            chunk.type = CH_IDAT;
-            chunk.length = uint32_t(compStrm.tell());
-            writeChunk(stream, chunk, compressBuf);
+            free(window);
 
             chunk.type = CH_IEND;
             chunk.length = 0;
             writeChunk(stream, chunk, nullptr);
-
-            free(scanBuffer);
-            free(compressBuf);
             return true;
         }
     }
 
     namespace DXT {
-        uint32_t packRGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-            return ((r << 0) | (g << 8) | (b << 16) | (a << 24));
+        // Multiply-shift form of the old '(t / 32 + t) / 32' widening, 
+        // gives identical results for every 5 and 6 bit value.
+        static FORCE_INLINE uint32_t unpack565(uint16_t color) {
+            uint32_t r = (((color >> 11) & 0x1F) * 526 + 32) >> 6;
+            uint32_t g = (((color >> 5) & 0x3F) * 259 + 32) >> 6;
+            uint32_t b = ((color & 0x1F) * 526 + 32) >> 6;
+            return r | (g << 8) | (b << 16) | 0xFF000000U;
         }
 
-        void decompressDXT1Block(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* blockStorage, JColor24* image) {
-            uint16_t color0 = *reinterpret_cast<const uint16_t*>(blockStorage);
-            uint16_t color1 = *reinterpret_cast<const uint16_t*>(blockStorage + 2);
+        static FORCE_INLINE uint32_t readUI32(const uint8_t* data) {
+            return uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16) | (uint32_t(data[3]) << 24);
+        }
 
-            uint32_t temp{};
+        // Scalar versions of the palette builders, these match the SIMD ones bit for bit.
+        static void buildColorPalette(uint16_t c0, uint16_t c1, bool allowAlpha, uint8_t palette[16]) {
+            uint32_t ends[2]{ unpack565(c0), unpack565(c1) };
+            memcpy(palette, ends, 8);
+
+            const uint8_t* p0 = palette;
+            const uint8_t* p1 = palette + 4;
+            uint8_t* p2 = palette + 8;
+            uint8_t* p3 = palette + 12;
+            bool fourColor = c0 > c1 || !allowAlpha;
+            for (int32_t c = 0; c < 4; c++) {
+                if (fourColor) {
+                    p2[c] = uint8_t((2 * p0[c] + p1[c]) / 3);
+                    p3[c] = uint8_t((p0[c] + 2 * p1[c]) / 3);
+                }
+                else {
+                    p2[c] = uint8_t((p0[c] + p1[c]) >> 1);
+                    p3[c] = 0;
+                }
+            }
+        }
 
-            temp = (color0 >> 11) * 255 + 16;
-            uint16_t r0 = uint16_t((temp / 32 + temp) / 32);
-            temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
-            uint16_t g0 = uint16_t((temp / 64 + temp) / 64);
-            temp = (color0 & 0x001F) * 255 + 16;
-            uint16_t b0 = uint16_t((temp / 32 + temp) / 32);
+        static void buildAlphaPalette(uint8_t a0, uint8_t a1, uint8_t palette[8]) {
+            palette[0] = a0;
+            palette[1] = a1;
+            if (a0 > a1) {
+                for (int32_t i = 2; i < 8; i++) {
+                    palette[i] = uint8_t(((8 - i) * a0 + (i - 1) * a1) / 7);
+                }
+                return;
+            }
 
-            temp = (color1 >> 11) * 255 + 16;
-            uint16_t r1 = uint16_t((temp / 32 + temp) / 32);
-            temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
-            uint16_t g1 = uint16_t((temp / 64 + temp) / 64);
-            temp = (color1 & 0x001F) * 255 + 16;
-            uint16_t b1 = uint16_t((temp / 32 + temp) / 32);
+            for (int32_t i = 2; i < 6; i++) {
+                palette[i] = uint8_t(((6 - i) * a0 + (i - 1) * a1) / 5);
+            }
+            palette[6] = 0x00;
+            palette[7] = 0xFF;
+        }
 
-            uint32_t code = *reinterpret_cast<const uint32_t*>(blockStorage + 4);
+#ifdef JE_SIMD_SSE2
+        // Returns the 4 RGBA colors of a color block packed into one register. 
+        // 'allowAlpha' enables the 3 color + transparent black mode of BC1.
+        static FORCE_INLINE __m128i buildColorPalette(const uint8_t* block, bool allowAlpha) {
+            uint16_t c0 = uint16_t(block[0] | (block[1] << 8));
+            uint16_t c1 = uint16_t(block[2] | (block[3] << 8));
 
-            for (int32_t j = 0; j < 4; j++)
-            {
-                for (int32_t i = 0; i < 4; i++)
-                {
-                    JColor24 finalColor{};
-                    uint8_t positionCode = (code >> 2 * (4 * j + i)) & 0x03;
+            __m128i ends = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, int32_t(unpack565(c1)), int32_t(unpack565(c0))), _mm_setzero_si128());
+            __m128i swapped = _mm_shuffle_epi32(ends, _MM_SHUFFLE(1, 0, 3, 2));
 
-                    if (color0 > color1)
-                    {
-                        switch (positionCode)
-                        {
-                            case 0:
-                                finalColor = JColor24(uint8_t(r0), uint8_t(g0), uint8_t(b0));
-                                break;
-                            case 1:
-                                finalColor = JColor24(uint8_t(r1), uint8_t(g1), uint8_t(b1));
-                                break;
-                            case 2:
-                                finalColor = JColor24(uint8_t((2 * r0 + r1) / 3), uint8_t((2 * g0 + g1) / 3), uint8_t((2 * b0 + b1) / 3));
-                                break;
-                            case 3:
-                                finalColor = JColor24(uint8_t((r0 + 2 * r1) / 3), uint8_t((g0 + 2 * g1) / 3), uint8_t((b0 + 2 * b1) / 3));
-                                break;
-                        }
-                    }
-                    else
-                    {
-                        switch (positionCode)
-                        {
-                            case 0:
-                                finalColor = JColor24(uint8_t(r0), uint8_t(g0), uint8_t(b0));
-                                break;
-                            case 1:
-                                finalColor = JColor24(uint8_t(r1), uint8_t(g1), uint8_t(b1));
-                                break;
-                            case 2:
-                                finalColor = JColor24(uint8_t((r0 + r1) / 2), uint8_t((g0 + g1) / 2), uint8_t((b0 + b1) / 2));
-                                break;
-                            case 3:
-                                finalColor = JColor24(0, 0, 0);
-                                break;
-                        }
-                    }
+            __m128i mid;
+            if (c0 > c1 || !allowAlpha) {
+                //(2 * c0 + c1) / 3 and (c0 + 2 * c1) / 3, x * 0x5556 >> 16 is exact for x / 3 in this range
+                mid = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(ends, ends), swapped), _mm_set1_epi16(0x5556));
+            }
+            else {
+                //(c0 + c1) / 2 and transparent black
+                mid = _mm_and_si128(_mm_srli_epi16(_mm_add_epi16(ends, swapped), 1), _mm_set_epi32(0, 0, -1, -1));
+            }
+            return _mm_packus_epi16(ends, mid);
+        }
+
+        // Returns the 8 alpha values of a BC3 alpha block in the low 8 bytes.
+        static FORCE_INLINE __m128i buildAlphaPalette(uint8_t a0, uint8_t a1) {
+            __m128i w0, w1, div;
+            __m128i extra = _mm_setzero_si128();
+            if (a0 > a1) {
+                w0 = _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1);
+                w1 = _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6);
+                div = _mm_set1_epi16(9363);  // x / 7
+            }
+            else {
+                w0 = _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0);
+                w1 = _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0);
+                div = _mm_set1_epi16(13108); // x / 5
+                extra = _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 0xFF);
+            }
 
-                    if (x + i < width) {
-                        image[(y + j) * width + (x + i)] = finalColor;
+            __m128i sum = _mm_add_epi16(_mm_mullo_epi16(w0, _mm_set1_epi16(a0)), _mm_mullo_epi16(w1, _mm_set1_epi16(a1)));
+            __m128i pal = _mm_or_si128(_mm_mulhi_epu16(sum, div), extra);
+            return _mm_packus_epi16(pal, pal);
+        }
+#endif
+
+#ifdef JE_SIMD_SSSE3
+        // pshufb masks that turn 4 2-bit color indices into 4 RGBA pixels picked from the palette register.
+        struct ColorShuffleTable {
+            __m128i masks[256];
+
+            ColorShuffleTable() : masks{} {
+                for (int32_t i = 0; i < 256; i++) {
+                    SIMD_ALIGN uint8_t mask[16]{};
+                    for (int32_t p = 0; p < 4; p++) {
+                        int32_t idx = (i >> (p << 1)) & 0x3;
+                        for (int32_t c = 0; c < 4; c++) {
+                            mask[(p << 2) + c] = uint8_t((idx << 2) + c);
+                        }
                     }
+                    masks[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
                 }
             }
+        };
+
+        static const ColorShuffleTable& getColorShuffles() {
+            static const ColorShuffleTable TABLE{};
+            return TABLE;
+        }
+#endif
+
+        // Decodes the color half of a block into 16 RGBA pixels (64 bytes, row major).
+        static FORCE_INLINE void decodeColorBlock(const uint8_t* block, uint8_t* pixels, bool allowAlpha) {
+            uint32_t code = readUI32(block + 4);
+#if defined(JE_SIMD_SSSE3)
+            __m128i palette = buildColorPalette(block, allowAlpha);
+            const ColorShuffleTable& table = getColorShuffles();
+            for (int32_t row = 0; row < 4; row++, code >>= 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + (row << 4)), _mm_shuffle_epi8(palette, table.masks[code & 0xFF]));
+            }
+#else
+            SIMD_ALIGN uint32_t palette[4]{};
+#if defined(JE_SIMD_SSE2)
+            _mm_store_si128(reinterpret_cast<__m128i*>(palette), buildColorPalette(block, allowAlpha));
+#else
+            buildColorPalette(uint16_t(block[0] | (block[1] << 8)), uint16_t(block[2] | (block[3] << 8)), allowAlpha, reinterpret_cast<uint8_t*>(palette));
+#endif
+            for (int32_t i = 0; i < 16; i++, code >>= 2) {
+                memcpy(pixels + (i << 2), palette + (code & 0x3), 4);
+            }
+#endif
         }
 
+        // Fills in the alpha channel of 16 RGBA pixels from a BC3 alpha block.
+        // The 3-bit indices are looked up from the palette directly, a pshufb 
+        // lookup didn't pay off once the indices had to be unpacked first.
+        static FORCE_INLINE void decodeAlphaBlock(const uint8_t* block, uint8_t* pixels) {
+            uint64_t bits = 0;
+            for (int32_t i = 0; i < 6; i++) {
+                bits |= uint64_t(block[2 + i]) << (i << 3);
+            }
 
-        bool decodeDxt1(const char* path, ImageData& imgData, const ImageDecodeParams params) {
-            FileStream fs(path);
-            if (fs.open("rb")) {
-                return decodeDxt1(fs, imgData);
+            uint8_t palette[8]{};
+#if defined(JE_SIMD_SSE2)
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(palette), buildAlphaPalette(block[0], block[1]));
+#else
+            buildAlphaPalette(block[0], block[1], palette);
+#endif
+            for (int32_t i = 0, j = 3; i < 16; i++, j += 4, bits >>= 3) {
+                pixels[j] = palette[bits & 0x7];
             }
-            JE_ERROR("[Image-IO] (DXT1) Decode Error: Failed to open file '{0}' for reading!", path);
-            return false;
         }
 
-        bool decodeDxt1(const Stream& stream, ImageData& img, const ImageDecodeParams params) {
-            uint32_t blockCountX = (img.width + 3) >> 2;
-            uint32_t blockCountY = (img.height + 3) >> 2;
-            uint32_t blockWidth = (img.width < 4) ? img.width : 4;
-            uint32_t blockHeight = (img.height < 4) ? img.height : 4;
-
-            size_t bufSize = blockCountX * 8;
-            uint8_t* blockStorage = reinterpret_cast<uint8_t*>(_malloca(bufSize));
-            JColor24* pixels = reinterpret_cast<JColor24*>(img.data);
+        // Copies a decoded 4x4 RGBA block into the image, clipped to its bounds.
+        static FORCE_INLINE void writeBlock(const uint8_t* pixels, ImageData& img, int32_t x, int32_t y) {
+            const int32_t bpp = img.format == TextureFormat::RGBA32 ? 4 : 3;
+            const int32_t w = std::min(4, img.width - x);
+            const int32_t h = std::min(4, img.height - y);
+            const size_t stride = size_t(img.width) * bpp;
+
+            uint8_t* target = img.getData() + size_t(y) * stride + size_t(x) * bpp;
+            for (int32_t row = 0; row < h; row++, target += stride, pixels += 16) {
+                if (bpp == 4) {
+                    memcpy(target, pixels, size_t(w) << 2);
+                    continue;
+                }
 
-            if (blockStorage) {
-                for (uint32_t j = 0; j < blockCountY; j++)
-                {
-                    stream.read(blockStorage, 1, bufSize, false);
-                    for (uint32_t i = 0, k = 0; i < blockCountX; i++, k += 8) {
-                        decompressDXT1Block(i * 4, j * 4, img.width, img.height, blockStorage + k, pixels);
-                    }
+#ifdef JE_SIMD_SSSE3
+                SIMD_ALIGN uint8_t rgb[16];
+                __m128i packed = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)),
+                    _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+                _mm_store_si128(reinterpret_cast<__m128i*>(rgb), packed);
+                memcpy(target, rgb, size_t(w) * 3);
+#else
+                for (int32_t i = 0, j = 0, k = 0; i < w; i++, j += 3, k += 4) {
+                    memcpy(target + j, pixels + k, 3);
                 }
-                _freea(blockStorage);
-                return true;
+#endif
             }
-            return false;
         }
 
+        void decodeDxt1Row(const uint8_t* blocks, ImageData& img, int32_t blockY) {
+            SIMD_ALIGN uint8_t pixels[64];
+            const int32_t blockCountX = (img.width + 3) >> 2;
+            const int32_t y = blockY << 2;
+            for (int32_t i = 0, x = 0; i < blockCountX; i++, x += 4, blocks += 8) {
+                decodeColorBlock(blocks, pixels, true);
+                writeBlock(pixels, img, x, y);
+            }
+        }
 
-        void decompressDXT5Block(int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t* blockStorage, JColor32* image) {
-            uint8_t alpha0 = *reinterpret_cast<const uint8_t*>(blockStorage);
-            uint8_t alpha1 = *reinterpret_cast<const uint8_t*>(blockStorage + 1);
+        void decodeDxt5Row(const uint8_t* blocks, ImageData& img, int32_t blockY) {
+            SIMD_ALIGN uint8_t pixels[64];
+            const int32_t blockCountX = (img.width + 3) >> 2;
+            const int32_t y = blockY << 2;
+            for (int32_t i = 0, x = 0; i < blockCountX; i++, x += 4, blocks += 16) {
+                decodeColorBlock(blocks + 8, pixels, false);
+                decodeAlphaBlock(blocks, pixels);
+                writeBlock(pixels, img, x, y);
+            }
+        }
 
-            const uint8_t* bits = blockStorage + 2;
-            uint32_t alphaCode1 = bits[2] | (bits[3] << 8) | (bits[4] << 16) | (bits[5] << 24);
-            uint16_t alphaCode2 = bits[0] | (bits[1] << 8);
+        static bool decodeBlocks(const Stream& stream, ImageData& img, size_t blockSize, TextureFormat defaultFormat, void(*decodeRow)(const uint8_t*, ImageData&, int32_t)) {
+            if (img.format != TextureFormat::RGB24 && img.format != TextureFormat::RGBA32) {
+                img.format = defaultFormat;
+            }
 
-            uint16_t color0 = *reinterpret_cast<const uint16_t*>(blockStorage + 8);
-            uint16_t color1 = *reinterpret_cast<const uint16_t*>(blockStorage + 10);
+            if (!img.doAllocate()) {
+                return false;
+            }
 
-            uint32_t temp;
+            uint32_t blockCountX = (img.width + 3) >> 2;
+            uint32_t blockCountY = (img.height + 3) >> 2;
+            size_t bufSize = blockCountX * blockSize;
+            uint8_t* blockStorage = reinterpret_cast<uint8_t*>(_malloca(bufSize));
+            if (!blockStorage) { return false; }
 
-            temp = (color0 >> 11) * 255 + 16;
-            uint8_t r0 = (uint8_t)((temp / 32 + temp) / 32);
-            temp = ((color0 & 0x07E0) >> 5) * 255 + 32;
-            uint8_t g0 = (uint8_t)((temp / 64 + temp) / 64);
-            temp = (color0 & 0x001F) * 255 + 16;
-            uint8_t b0 = (uint8_t)((temp / 32 + temp) / 32);
+            for (uint32_t j = 0; j < blockCountY; j++) {
+                if (stream.read(blockStorage, 1, bufSize, false) < bufSize) {
+                    _freea(blockStorage);
+                    return false;
+                }
+                decodeRow(blockStorage, img, int32_t(j));
+            }
+            _freea(blockStorage);
+            return true;
+        }
 
-            temp = (color1 >> 11) * 255 + 16;
-            uint8_t r1 = (uint8_t)((temp / 32 + temp) / 32);
-            temp = ((color1 & 0x07E0) >> 5) * 255 + 32;
-            uint8_t g1 = (uint8_t)((temp / 64 + temp) / 64);
-            temp = (color1 & 0x001F) * 255 + 16;
-            uint8_t b1 = (uint8_t)((temp / 32 + temp) / 32);
+        bool decodeDxt1(const std::string& path, ImageData& imgData, const ImageDecodeParams params) {
+            return decodeDxt1(path.c_str(), imgData, params);
+        }
 
-            uint32_t code = *reinterpret_cast<const uint32_t*>(blockStorage + 12);
+        bool decodeDxt1(const char* path, ImageData& imgData, const ImageDecodeParams params) {
+            FileStream fs(path);
+            if (fs.open("rb")) {
+                return decodeDxt1(fs, imgData, params);
+            }
+            JE_ERROR("[Image-IO] (DXT1) Decode Error: Failed to open file '{0}' for reading!", path);
+            return false;
+        }
 
-            for (int j = 0; j < 4; j++)
-            {
-                for (int i = 0; i < 4; i++)
-                {
-                    int alphaCodeIndex = 3 * (4 * j + i);
-                    int alphaCode;
+        bool decodeDxt1(const Stream& stream, ImageData& img, const ImageDecodeParams) {
+            return decodeBlocks(stream, img, 8, TextureFormat::RGB24, decodeDxt1Row);
+        }
 
-                    if (alphaCodeIndex <= 12)
-                    {
-                        alphaCode = (alphaCode2 >> alphaCodeIndex) & 0x07;
-                    }
-                    else if (alphaCodeIndex == 15)
-                    {
-                        alphaCode = (alphaCode2 >> 15) | ((alphaCode1 << 1) & 0x06);
-                    }
-                    else // alphaCodeIndex >= 18 && alphaCodeIndex <= 45
-                    {
-                        alphaCode = (alphaCode1 >> (alphaCodeIndex - 16)) & 0x07;
-                    }
+        bool decodeDxt5(const std::string& path, ImageData& imgData, const ImageDecodeParams params) {
+            return decodeDxt5(path.c_str(), imgData, params);
+        }
 
-                    uint8_t finalAlpha;
-                    if (alphaCode == 0)
-                    {
-                        finalAlpha = alpha0;
-                    }
-                    else if (alphaCode == 1)
-                    {
-                        finalAlpha = alpha1;
+        bool decodeDxt5(const char* path, ImageData& imgData, const ImageDecodeParams params) {
+            FileStream fs(path);
+            if (fs.open("rb")) {
+                return decodeDxt5(fs, imgData, params);
+            }
+            JE_ERROR("[Image-IO] (DXT5) Decode Error: Failed to open file '{0}' for reading!", path);
+            return false;
+        }
+
+        bool decodeDxt5(const Stream& stream, ImageData& img, const ImageDecodeParams) {
+            return decodeBlocks(stream, img, 16, TextureFormat::RGBA32, decodeDxt5Row);
+        }
+
+        static FORCE_INLINE uint16_t pack565(const float* rgb) {
+            int32_t r = int32_t(Math::clamp(rgb[0], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+            int32_t g = int32_t(Math::clamp(rgb[1], 0.0f, 255.0f) * (63.0f / 255.0f) + 0.5f);
+            int32_t b = int32_t(Math::clamp(rgb[2], 0.0f, 255.0f) * (31.0f / 255.0f) + 0.5f);
+            return uint16_t((r << 11) | (g << 5) | b);
+        }
+
+        static FORCE_INLINE float snap565(float value, float steps) {
+            return std::floor(Math::clamp(value, 0.0f, 255.0f) * (steps / 255.0f) + 0.5f) * (255.0f / steps);
+        }
+
+        static FORCE_INLINE float distanceSqr(const uint8_t* a, const uint8_t* b) {
+            float r = float(a[0]) - b[0];
+            float g = float(a[1]) - b[1];
+            float bl = float(a[2]) - b[2];
+            return r * r + g * g + bl * bl;
+        }
+
+        // Reads a 4x4 block as RGBA, pixels outside of the image repeat the edge.
+        static void fetchBlock(const ImageData& img, int32_t x, int32_t y, uint8_t* pixels) {
+            const int32_t bpp = getBitsPerPixel(img.format) >> 3;
+            const int32_t count = std::min(4, img.width - x);
+            const uint8_t* src = img.getData();
+            for (int32_t row = 0; row < 4; row++, pixels += 16) {
+                const int32_t sY = std::min(y + row, img.height - 1);
+                convertPixels(img.format, TextureFormat::RGBA32, src + (size_t(sY) * img.width + x) * bpp, pixels, count, img.data);
+                for (int32_t col = count; col < 4; col++) {
+                    memcpy(pixels + col * 4, pixels + (count - 1) * 4, 4);
+                }
+            }
+        }
+
+        // Picks the closest palette entry for every pixel, returns the total squared error.
+        // With 'transparent' pixels with alpha below 128 map to the transparent index 3.
+        static float assignColorIndices(const uint8_t* pixels, uint16_t c0, uint16_t c1, bool allowAlpha, bool transparent, uint32_t& indices) {
+            uint8_t palette[16]{};
+            buildColorPalette(c0, c1, allowAlpha, palette);
+            const int32_t count = (c0 > c1 || !allowAlpha) ? 4 : 3;
+
+            float error = 0;
+            indices = 0;
+            for (int32_t i = 0; i < 16; i++, pixels += 4) {
+                if (transparent && pixels[3] < 128) {
+                    indices |= 0x3U << (i << 1);
+                    continue;
+                }
+
+                uint32_t best = 0;
+                float bestDist = distanceSqr(pixels, palette);
+                for (int32_t j = 1; j < count; j++) {
+                    float dist = distanceSqr(pixels, palette + (j << 2));
+                    if (dist < bestDist) {
+                        bestDist = dist;
+                        best = j;
                     }
-                    else
-                    {
-                        if (alpha0 > alpha1)
-                        {
-                            finalAlpha = ((8 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 7;
+                }
+                indices |= best << (i << 1);
+                error += bestDist;
+            }
+            return error;
+        }
+
+        static void computePrincipalAxis(const float points[16][3], int32_t count, float mean[3], float axis[3]) {
+            mean[0] = mean[1] = mean[2] = 0;
+            for (int32_t i = 0; i < count; i++) {
+                mean[0] += points[i][0];
+                mean[1] += points[i][1];
+                mean[2] += points[i][2];
+            }
+
+            const float inv = count > 0 ? 1.0f / count : 0.0f;
+            mean[0] *= inv;
+            mean[1] *= inv;
+            mean[2] *= inv;
+
+            float cov[6]{ 0 };
+            for (int32_t i = 0; i < count; i++) {
+                float r = points[i][0] - mean[0];
+                float g = points[i][1] - mean[1];
+                float b = points[i][2] - mean[2];
+                cov[0] += r * r;
+                cov[1] += r * g;
+                cov[2] += r * b;
+                cov[3] += g * g;
+                cov[4] += g * b;
+                cov[5] += b * b;
+            }
+
+            //Power iteration, converges quickly enough for a 3x3 matrix
+            float v[3]{ 1.0f, 1.0f, 1.0f };
+            for (int32_t iter = 0; iter < 8; iter++) {
+                float x = v[0] * cov[0] + v[1] * cov[1] + v[2] * cov[2];
+                float y = v[0] * cov[1] + v[1] * cov[3] + v[2] * cov[4];
+                float z = v[0] * cov[2] + v[1] * cov[4] + v[2] * cov[5];
+                float m = std::max(std::abs(x), std::max(std::abs(y), std::abs(z)));
+                if (m <= 0.0f) { break; }
+                v[0] = x / m;
+                v[1] = y / m;
+                v[2] = z / m;
+            }
+            axis[0] = v[0];
+            axis[1] = v[1];
+            axis[2] = v[2];
+        }
+
+        // Least squares endpoints for every ordered split of the points into the 
+        // 4 palette clusters, only used for blocks in 4 color mode.
+        static bool clusterFit(const float points[16][3], const float axis[3], float start[3], float end[3]) {
+            int32_t order[16]{};
+            float dots[16]{};
+            for (int32_t i = 0; i < 16; i++) {
+                order[i] = i;
+                dots[i] = points[i][0] * axis[0] + points[i][1] * axis[1] + points[i][2] * axis[2];
+            }
+            std::sort(order, order + 16, [&dots](int32_t a, int32_t b) { return dots[a] < dots[b]; });
+
+            float prefix[17][3]{};
+            for (int32_t i = 0; i < 16; i++) {
+                for (int32_t c = 0; c < 3; c++) {
+                    prefix[i + 1][c] = prefix[i][c] + points[order[i]][c];
+                }
+            }
+
+            float bestError = FLT_MAX;
+            bool found = false;
+            for (int32_t i = 0; i <= 16; i++) {
+                for (int32_t j = i; j <= 16; j++) {
+                    for (int32_t k = j; k <= 16; k++) {
+                        //Clusters along the axis: [0, i) -> end, [i, j) -> 1/3, [j, k) -> 2/3, [k, 16) -> start
+                        const float n0 = float(i), n1 = float(j - i), n2 = float(k - j), n3 = float(16 - k);
+                        const float alpha2 = n3 + n2 * (4.0f / 9.0f) + n1 * (1.0f / 9.0f);
+                        const float beta2 = n0 + n1 * (4.0f / 9.0f) + n2 * (1.0f / 9.0f);
+                        const float alphaBeta = (n1 + n2) * (2.0f / 9.0f);
+                        const float denom = alpha2 * beta2 - alphaBeta * alphaBeta;
+                        if (std::abs(denom) < 1e-6f) { continue; }
+                        const float factor = 1.0f / denom;
+
+                        float a[3]{}, b[3]{};
+                        float error = 0;
+                        for (int32_t c = 0; c < 3; c++) {
+                            const float x0 = prefix[i][c];
+                            const float x1 = prefix[j][c] - prefix[i][c];
+                            const float x2 = prefix[k][c] - prefix[j][c];
+                            const float x3 = prefix[16][c] - prefix[k][c];
+                            const float alphaX = x3 + x2 * (2.0f / 3.0f) + x1 * (1.0f / 3.0f);
+                            const float betaX = x0 + x1 * (2.0f / 3.0f) + x2 * (1.0f / 3.0f);
+
+                            const float steps = c == 1 ? 63.0f : 31.0f;
+                            a[c] = snap565((alphaX * beta2 - betaX * alphaBeta) * factor, steps);
+                            b[c] = snap565((betaX * alpha2 - alphaX * alphaBeta) * factor, steps);
+                            error += a[c] * a[c] * alpha2 + b[c] * b[c] * beta2 + 2.0f * (a[c] * b[c] * alphaBeta - a[c] * alphaX - b[c] * betaX);
                         }
-                        else
-                        {
-                            if (alphaCode == 6)
-                                finalAlpha = 0;
-                            else if (alphaCode == 7)
-                                finalAlpha = 255;
-                            else
-                                finalAlpha = ((6 - alphaCode) * alpha0 + (alphaCode - 1) * alpha1) / 5;
+
+                        if (error < bestError) {
+                            bestError = error;
+                            memcpy(start, a, sizeof(a));
+                            memcpy(end, b, sizeof(b));
+                            found = true;
                         }
                     }
+                }
+            }
+            return found;
+        }
 
-                    uint8_t colorCode = (code >> 2 * (4 * j + i)) & 0x03;
+        static void encodeColorBlock(const uint8_t* pixels, uint8_t* block, bool allowAlpha, bool highQuality) {
+            float points[16][3]{};
+            int32_t count = 0;
+            bool transparent = false;
+            for (int32_t i = 0; i < 16; i++) {
+                const uint8_t* pix = pixels + (i << 2);
+                if (allowAlpha && pix[3] < 128) {
+                    transparent = true;
+                    continue;
+                }
+                points[count][0] = pix[0];
+                points[count][1] = pix[1];
+                points[count][2] = pix[2];
+                count++;
+            }
+
+            uint16_t c0 = 0, c1 = 0;
+            uint32_t indices = 0;
+            if (count > 0) {
+                //Range fit, endpoints are the pixels furthest apart along the principal axis
+                float mean[3]{}, axis[3]{};
+                computePrincipalAxis(points, count, mean, axis);
+
+                int32_t minI = 0, maxI = 0;
+                float minD = FLT_MAX, maxD = -FLT_MAX;
+                for (int32_t i = 0; i < count; i++) {
+                    float d = points[i][0] * axis[0] + points[i][1] * axis[1] + points[i][2] * axis[2];
+                    if (d < minD) { minD = d; minI = i; }
+                    if (d > maxD) { maxD = d; maxI = i; }
+                }
+                c0 = pack565(points[maxI]);
+                c1 = pack565(points[minI]);
 
-                    JColor32 finalColor;
-                    switch (colorCode)
-                    {
-                        case 0:
-                            finalColor = JColor32(r0, g0, b0, finalAlpha);
-                            break;
-                        case 1:
-                            finalColor = JColor32(r1, g1, b1, finalAlpha);
-                            break;
-                        case 2:
-                            finalColor = JColor32((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, finalAlpha);
-                            break;
-                        case 3:
-                            finalColor = JColor32((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, finalAlpha);
-                            break;
+                //3 color mode needs c0 <= c1, 4 color mode c0 > c1
+                if ((transparent && c0 > c1) || (!transparent && c0 < c1)) {
+                    std::swap(c0, c1);
+                }
+                float error = assignColorIndices(pixels, c0, c1, allowAlpha, transparent, indices);
+
+                if (highQuality && !transparent && error > 0) {
+                    float start[3]{}, end[3]{};
+                    if (clusterFit(points, axis, start, end)) {
+                        uint16_t cc0 = pack565(start);
+                        uint16_t cc1 = pack565(end);
+                        if (cc0 < cc1) { std::swap(cc0, cc1); }
+
+                        uint32_t clusterIndices = 0;
+                        float clusterError = assignColorIndices(pixels, cc0, cc1, allowAlpha, false, clusterIndices);
+                        if (clusterError < error) {
+                            c0 = cc0;
+                            c1 = cc1;
+                            indices = clusterIndices;
+                        }
                     }
+                }
+            }
+            else {
+                indices = 0xFFFFFFFFU;
+            }
 
-                    if (x + i < width) {
-                        image[(y + j) * width + (x + i)] = finalColor;
+            block[0] = uint8_t(c0);
+            block[1] = uint8_t(c0 >> 8);
+            block[2] = uint8_t(c1);
+            block[3] = uint8_t(c1 >> 8);
+            for (int32_t i = 0; i < 4; i++) {
+                block[4 + i] = uint8_t(indices >> (i << 3));
+            }
+        }
+
+        static uint32_t assignAlphaIndices(const uint8_t* pixels, uint8_t a0, uint8_t a1, uint64_t& indices) {
+            uint8_t palette[8]{};
+            buildAlphaPalette(a0, a1, palette);
+
+            uint32_t error = 0;
+            indices = 0;
+            for (int32_t i = 0, j = 3; i < 16; i++, j += 4) {
+                uint32_t best = 0;
+                int32_t bestDist = 256;
+                for (int32_t k = 0; k < 8; k++) {
+                    int32_t dist = std::abs(int32_t(pixels[j]) - palette[k]);
+                    if (dist < bestDist) {
+                        bestDist = dist;
+                        best = k;
                     }
                 }
+                indices |= uint64_t(best) << (i * 3);
+                error += uint32_t(bestDist * bestDist);
             }
+            return error;
         }
 
+        static void encodeAlphaBlock(const uint8_t* pixels, uint8_t* block) {
+            uint8_t minA = 0xFF, maxA = 0x00;
+            uint8_t minInner = 0xFF, maxInner = 0x00;
+            for (int32_t i = 3; i < 64; i += 4) {
+                uint8_t a = pixels[i];
+                minA = std::min(minA, a);
+                maxA = std::max(maxA, a);
+                if (a > 0x00 && a < 0xFF) {
+                    minInner = std::min(minInner, a);
+                    maxInner = std::max(maxInner, a);
+                }
+            }
+
+            //8 value mode over the full range
+            uint8_t a0 = maxA, a1 = minA;
+            uint64_t indices = 0;
+            uint32_t error = assignAlphaIndices(pixels, a0, a1, indices);
 
-        bool decodeDxt5(const char* path, ImageData& imgData, const ImageDecodeParams params) {
-            FileStream fs(path);
-            if (fs.open("rb")) {
-                return decodeDxt5(fs, imgData);
+            //6 value mode with explicit 0 and 255, better when those are present
+            if (error > 0 && (minA == 0x00 || maxA == 0xFF)) {
+                if (minInner > maxInner) { minInner = maxInner = minA; }
+
+                uint64_t innerIndices = 0;
+                uint32_t innerError = assignAlphaIndices(pixels, minInner, maxInner, innerIndices);
+                if (innerError < error) {
+                    a0 = minInner;
+                    a1 = maxInner;
+                    indices = innerIndices;
+                }
+            }
+
+            block[0] = a0;
+            block[1] = a1;
+            for (int32_t i = 0; i < 6; i++) {
+                block[2 + i] = uint8_t(indices >> (i << 3));
             }
-            JE_ERROR("[Image-IO] (DXT5) Decode Error: Failed to open file '{0}' for reading!", path);
-            return false;
         }
 
-        bool decodeDxt5(const Stream& stream, ImageData& img, const ImageDecodeParams params) {
+        bool compress(const ImageData& source, ImageData& target, TextureFormat format, const ImageEncodeParams& params) {
+            if (!isBlockCompressed(format)) {
+                JE_ERROR("[Image-IO] (DXT) Encode Error: '{0}' isn't a block compressed format!", getTextureFormatName(format));
+                return false;
+            }
 
-            uint32_t blockCountX = (img.width + 3) / 4;
-            uint32_t blockCountY = (img.height + 3) / 4;
-            uint32_t blockWidth = (img.width < 4) ? img.width : 4;
-            uint32_t blockHeight = (img.height < 4) ? img.height : 4;
-            size_t bufSize = blockCountX * 16;
-            uint8_t* blockStorage = reinterpret_cast<uint8_t*>(_malloca(bufSize));
-            JColor32* pixels = reinterpret_cast<JColor32*>(img.data);
+            if (!source.data || source.width < 1 || source.height < 1) {
+                JE_ERROR("[Image-IO] (DXT) Encode Error: Source image is empty!");
+                return false;
+            }
 
-            if (blockStorage) {
-                for (uint32_t j = 0; j < blockCountY; j++)
-                {
-                    stream.read(blockStorage, 1, bufSize, false);
-                    for (uint32_t i = 0, k = 0; i < blockCountX; i++, k += 16) {
-                        decompressDXT5Block(i * 4, j * 4, img.width, img.height, blockStorage + k, pixels);
+            if (source.format >= TextureFormat::__Count || source.format == TextureFormat::Unknown) {
+                JE_ERROR("[Image-IO] (DXT) Encode Error: Can't compress from format '{0}'!", getTextureFormatName(source.format));
+                return false;
+            }
+
+            //Block data has no per-pixel layout to fetch from, so it's decoded to RGBA first and compressed from that
+            if (isBlockCompressed(source.format)) {
+                ImageData decoded{};
+                if (!decoded.doAllocate(source.width, source.height, TextureFormat::RGBA32)) {
+                    JE_ERROR("[Image-IO] (DXT) Encode Error: Failed to allocate decode buffer!");
+                    return false;
+                }
+                decoded.filter[0] = source.filter[0];
+                decoded.filter[1] = source.filter[1];
+                decoded.wrap[0] = source.wrap[0];
+                decoded.wrap[1] = source.wrap[1];
+
+                const int32_t sourceBlocksX = (source.width + 3) >> 2;
+                const size_t sourceBlockSize = source.format == TextureFormat::DXT5 ? 16 : 8;
+                for (int32_t j = 0, rows = (source.height + 3) >> 2; j < rows; j++) {
+                    const uint8_t* row = source.data + size_t(j) * sourceBlocksX * sourceBlockSize;
+                    if (source.format == TextureFormat::DXT5) {
+                        decodeDxt5Row(row, decoded, j);
+                    }
+                    else {
+                        decodeDxt1Row(row, decoded, j);
+                    }
+                }
+
+                bool result = compress(decoded, target, format, params);
+                decoded.clear(true);
+                return result;
+            }
+
+            if (!target.doAllocate(source.width, source.height, format)) {
+                JE_ERROR("[Image-IO] (DXT) Encode Error: Failed to allocate block buffer!");
+                return false;
+            }
+            target.filter[0] = source.filter[0];
+            target.filter[1] = source.filter[1];
+            target.wrap[0] = source.wrap[0];
+            target.wrap[1] = source.wrap[1];
+
+            const bool dxt5 = format == TextureFormat::DXT5;
+            const bool highQuality = (params.flags & F_IMG_ENC_DXT_CLUSTER_FIT) != 0;
+            const size_t blockSize = dxt5 ? 16 : 8;
+            const int32_t blockCountX = (source.width + 3) >> 2;
+            const int32_t blockCountY = (source.height + 3) >> 2;
+            const uint32_t threads = (params.flags & F_IMG_ENC_MULTITHREAD) ? Parallel::getWorkerCount(params.threads) : 1;
+
+            uint8_t* blocks = target.data;
+            Parallel::forEach(size_t(blockCountY), threads, [&](size_t blockY) {
+                SIMD_ALIGN uint8_t pixels[64];
+                uint8_t* block = blocks + blockY * blockCountX * blockSize;
+                for (int32_t i = 0; i < blockCountX; i++, block += blockSize) {
+                    fetchBlock(source, i << 2, int32_t(blockY) << 2, pixels);
+                    if (dxt5) {
+                        encodeAlphaBlock(pixels, block);
+                        encodeColorBlock(pixels, block + 8, false, highQuality);
+                    }
+                    else {
+                        encodeColorBlock(pixels, block, true, highQuality);
                     }
                 }
+            });
+            return true;
+        }
 
-                _freea(blockStorage);
+        static bool encodeBlocks(const Stream& stream, const ImageData& imgData, TextureFormat format, const ImageEncodeParams& params) {
+            if (!stream.isOpen()) {
+                JE_ERROR("[Image-IO] (DXT) Encode Error: Stream isn't open!");
+                return false;
+            }
+
+            if (imgData.format == format) {
+                stream.write(imgData.data, imgData.getSize(), false);
                 return true;
             }
 
+            ImageData blocks{};
+            if (!compress(imgData, blocks, format, params)) {
+                blocks.clear(true);
+                return false;
+            }
+            stream.write(blocks.data, blocks.getSize(), false);
+            blocks.clear(true);
+            return true;
+        }
+
+        bool encodeDxt1(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encodeDxt1(path.c_str(), imgData, params);
+        }
+
+        bool encodeDxt1(const char* path, const ImageData& imgData, const ImageEncodeParams& params) {
+            FileStream fs(path);
+            if (fs.open("wb")) {
+                return encodeDxt1(fs, imgData, params);
+            }
+            JE_ERROR("[Image-IO] (DXT1) Encode Error: Failed to open file '{0}' for writing!", path);
+            return false;
+        }
+
+        bool encodeDxt1(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encodeBlocks(stream, imgData, TextureFormat::DXT1, params);
+        }
+
+        bool encodeDxt5(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encodeDxt5(path.c_str(), imgData, params);
+        }
+
+        bool encodeDxt5(const char* path, const ImageData& imgData, const ImageEncodeParams& params) {
+            FileStream fs(path);
+            if (fs.open("wb")) {
+                return encodeDxt5(fs, imgData, params);
+            }
+            JE_ERROR("[Image-IO] (DXT5) Encode Error: Failed to open file '{0}' for writing!", path);
             return false;
         }
 
+        bool encodeDxt5(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encodeBlocks(stream, imgData, TextureFormat::DXT5, params);
+        }
     }
 
     namespace DDS {
@@ -1382,6 +2053,10 @@ JE_END_PACK
             return encode(path.c_str(), imgData);
         }
 
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encode(path.c_str(), imgData, params);
+        }
+
         bool getInfo(const char* path, ImageData& imgData) {
             FileStream stream(path, "rb");
 
@@ -1429,6 +2104,11 @@ JE_END_PACK
                 default:
                     JE_ERROR("[Image-IO] (DDS) Error: Unsupported compression format!");
                     return false;
+                case DDS_DXT1:
+                case DDS_DXT5:
+                    //Block compressed data is decoded to RGBA32
+                    imgData.format = TextureFormat::RGBA32;
+                    return true;
                 case DDS_None:
                     break;
             }
@@ -1499,7 +2179,16 @@ JE_END_PACK
                 default:
                     JE_ERROR("[Image-IO] (DDS) Error: Unsupported compression format!");
                     return false;
-                case 0:
+                case DDS_DXT1:
+                case DDS_DXT5:
+                    imgData.format = TextureFormat::RGBA32;
+                    stream.seek(dataStart, SEEK_SET);
+                    if (!(fmt.compression == DDS_DXT1 ? DXT::decodeDxt1(stream, imgData, params) : DXT::decodeDxt5(stream, imgData, params))) {
+                        JE_ERROR("[Image-IO] (DDS) Error: Failed to decode block compressed data!");
+                        return false;
+                    }
+                    return true;
+                case DDS_None:
                     break;
             }
 
@@ -1603,20 +2292,70 @@ JE_END_PACK
         }
 
         bool encode(const char* path, const ImageData& imgData) {
+            return encode(path, imgData, ImageEncodeParams{});
+        }
+
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params) {
             FileStream fs(path);
             if (fs.open("wb")) {
-                return encode(fs, imgData);
+                return encode(fs, imgData, params);
             }
             JE_ERROR("[Image-IO] (DDS) Encode Error: Failed to open file '{0}' for writing!", path);
             return false;
         }
 
+        static bool encodeCompressed(const Stream& stream, const ImageData& imgData, TextureFormat format, const ImageEncodeParams& params) {
+            ImageData blocks{};
+            const ImageData* source = &imgData;
+            if (imgData.format != format) {
+                if (!DXT::compress(imgData, blocks, format, params)) {
+                    blocks.clear(true);
+                    return false;
+                }
+                source = &blocks;
+            }
+
+            DDSFormat fmt{};
+            fmt.flags = 0x4;
+            fmt.compression = format == TextureFormat::DXT1 ? DDS_DXT1 : DDS_DXT5;
+
+            const uint32_t linearSize = uint32_t(source->getSize());
+            static constexpr uint32_t SIGNATURE = 0x20534444;
+            static constexpr uint32_t FLAGS = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000;
+            stream.writeValue(SIGNATURE);
+            stream.writeValue(124U);
+            stream.writeValue(FLAGS);
+            stream.writeValue(imgData.height);
+            stream.writeValue(imgData.width);
+            stream.writeValue(linearSize);
+            stream.writeValue<uint8_t>(0, 52);
+
+            stream.writeValue(32);
+            stream.writeValue(fmt);
+
+            stream.writeValue(0x1000U);
+            stream.writeValue(0x0000U, 4);
+
+            stream.write(source->data, linearSize, false);
+            blocks.clear(true);
+            return true;
+        }
+
         bool encode(const Stream& stream, const ImageData& imgData) {
+            return encode(stream, imgData, ImageEncodeParams{});
+        }
+
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params) {
             if (!stream.isOpen()) {
                 JE_ERROR("[Image-IO] (DDS) Encode Error: Stream isn't open!");
                 return false;
             }
 
+            TextureFormat blockFormat = isBlockCompressed(imgData.format) ? imgData.format : params.targetFormat;
+            if (isBlockCompressed(blockFormat)) {
+                return encodeCompressed(stream, imgData, blockFormat, params);
+            }
+
             switch (imgData.format) {
                 default:
                     JE_ERROR("[Image-IO] (DDS) Encode Error: Format '{0}' isn't supported!", getTextureFormatName(imgData.format));
@@ -1738,56 +2477,210 @@ JE_END_PACK
 
     namespace JTEX {
         static constexpr uint32_t JTEX_SIG = 0x5845544AU;
+        static constexpr uint32_t JTEX_ALIGNMENT = 4096;
         enum JTEXFlags : uint32_t {
             JTEX_None,
             JTEX_Compressed = 0x1,
+            //Set along with 'JTEX_Compressed' when the levels are LZ4 instead of zlib
+            JTEX_LZ4 = 0x2,
+            JTEX_V2 = 0x100,
         };
 
-        bool getInfo(const char* path, ImageData& imgData) {
-            FileStream stream(path, "rb");
+JE_BEG_PACK
+        struct Header {
+            uint32_t sig;
+            JTEXFlags flags;
+            int32_t width;
+            int32_t height;
+            TextureFormat format;
+            int32_t paletteSize;
+            uint8_t imgFlags;
+        };
 
-            if (stream.isOpen()) {
-                return getInfo(stream, imgData);
-            }
+        //Follows the base header when 'JTEX_V2' is set
+        struct HeaderV2 {
+            uint16_t levels;
+            uint16_t reserved;
+            uint32_t alignment;
+        };
 
-            JE_ERROR("[Image-IO] (JTEX) Error: Failed to open '{0}'!", path);
-            return false;
-        }
+        //Offsets are relative to the start of the JTEX header
+        struct LevelEntry {
+            uint64_t offset;
+            uint64_t size;
+            uint64_t rawSize;
+            int32_t width;
+            int32_t height;
+        };
+JE_END_PACK
 
-        bool getInfo(const Stream& stream, ImageData& imgData) {
+        static bool readLayout(const Stream& stream, Header& hdr, std::vector<LevelEntry>& levels) {
             if (!stream.isOpen()) {
                 JE_ERROR("[Image-IO] (JTEX) Decode Error: Stream isn't open!");
                 return false;
             }
 
-JE_BEG_PACK
-            struct Header {
-                uint32_t sig;
-                JTEXFlags flags;
-                int32_t width;
-                int32_t height;
-                TextureFormat format;
-                int32_t paletteSize;
-                uint8_t imgFlags;
-            };
-JE_END_PACK
-
-            Header hdr{};
             stream.readValue(hdr, false);
-
             if (hdr.sig != JTEX_SIG) {
                 JE_ERROR("[Image-IO] (JTEX) Decode Error: Signature isn't valid!");
                 return false;
             }
 
-            imgData.width = hdr.width;
-            imgData.height = hdr.height;
+            bool aligned = (hdr.imgFlags & IMG_FLAG_ALIGNED) != 0;
+            levels.clear();
+            if ((hdr.flags & JTEX_V2) == 0) {
+                size_t size = ImageData::calculateSize(hdr.width, hdr.height, hdr.format, hdr.paletteSize, aligned);
+                levels.push_back({ sizeof(Header), size, size, hdr.width, hdr.height });
+                return true;
+            }
+
+            HeaderV2 hdrV2{};
+            stream.readValue(hdrV2, false);
+            if (hdrV2.levels < 1) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: File has no mip levels!");
+                return false;
+            }
+
+            levels.resize(hdrV2.levels);
+            if (stream.read(levels.data(), sizeof(LevelEntry), levels.size(), false) != levels.size() * sizeof(LevelEntry)) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Mip table is truncated!");
+                return false;
+            }
+
+            for (const auto& entry : levels) {
+                if (entry.width < 1 || entry.height < 1 ||
+                    entry.rawSize != ImageData::calculateSize(entry.width, entry.height, hdr.format, hdr.paletteSize, aligned)) {
+                    JE_ERROR("[Image-IO] (JTEX) Decode Error: Mip level {0}x{1} doesn't match its size!", entry.width, entry.height);
+                    return false;
+                }
+
+                //Uncompressed levels are read and mapped straight from the file, so 'size' is what gets bounds checked
+                if ((hdr.flags & JTEX_Compressed) == 0 && entry.size != entry.rawSize) {
+                    JE_ERROR("[Image-IO] (JTEX) Decode Error: Uncompressed mip level {0}x{1} has a payload of {2} bytes, expected {3}!", entry.width, entry.height, entry.size, entry.rawSize);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static void setupLevel(const Header& hdr, const LevelEntry& entry, ImageData& imgData) {
+            imgData.width = entry.width;
+            imgData.height = entry.height;
             imgData.format = hdr.format;
             imgData.paletteSize = hdr.paletteSize;
-            imgData.flags = hdr.imgFlags;
+            imgData.flags = (hdr.imgFlags & ~IMG_FLAG_VIEW) | (imgData.flags & IMG_FLAG_VIEW);
+        }
+
+        static bool inflateLevel(const Header& hdr, const uint8_t* payload, const LevelEntry& entry, ImageData& imgData) {
+            if (!imgData.doAllocate()) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Failed to allocate pixel buffer!");
+                return false;
+            }
+
+            int32_t ret = (hdr.flags & JTEX_LZ4) ?
+                LZ4::decompressData(payload, size_t(entry.size), imgData.data, size_t(entry.rawSize)) :
+                ZLib::inflateData(const_cast<uint8_t*>(payload), size_t(entry.size), imgData.data, size_t(entry.rawSize));
+            if (ret < 0 || uint64_t(ret) != entry.rawSize) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Failed to decompress {0}x{1} mip level!", entry.width, entry.height);
+                return false;
+            }
+            return true;
+        }
+
+        static bool readLevel(const Stream& stream, size_t start, const Header& hdr, const LevelEntry& entry, ImageData& imgData) {
+            setupLevel(hdr, entry, imgData);
+            stream.seek(int64_t(start + entry.offset), SEEK_SET);
+
+            if ((hdr.flags & JTEX_Compressed) == 0) {
+                if (!imgData.doAllocate()) {
+                    JE_ERROR("[Image-IO] (JTEX) Decode Error: Failed to allocate pixel buffer!");
+                    return false;
+                }
+                return stream.read(imgData.data, size_t(entry.rawSize), false) == entry.rawSize;
+            }
+
+            uint8_t* payload = reinterpret_cast<uint8_t*>(malloc(size_t(entry.size)));
+            if (!payload) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Failed to allocate compressed buffer! ({0} bytes)", entry.size);
+                return false;
+            }
+
+            bool ret = stream.read(payload, size_t(entry.size), false) == entry.size && inflateLevel(hdr, payload, entry, imgData);
+            free(payload);
+            return ret;
+        }
+
+        static bool mapLevel(const MappedFile& file, const Header& hdr, const LevelEntry& entry, ImageData& imgData) {
+            if (entry.offset > file.size() || entry.size > file.size() - entry.offset) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Mip level {0}x{1} is out of bounds!", entry.width, entry.height);
+                return false;
+            }
+
+            const uint8_t* payload = file.data() + entry.offset;
+            if ((hdr.flags & JTEX_Compressed) == 0) {
+                imgData.clear(true);
+                setupLevel(hdr, entry, imgData);
+                imgData.setView(const_cast<uint8_t*>(payload), size_t(entry.rawSize));
+                return true;
+            }
+
+            setupLevel(hdr, entry, imgData);
+            return inflateLevel(hdr, payload, entry, imgData);
+        }
+
+        static bool deflateLevel(const ImageData& imgData, bool lz4, int32_t compression, uint32_t threads, std::vector<uint8_t>& payload) {
+            if (lz4) {
+                payload.resize(LZ4::compressBound(imgData.getSize()));
+                int32_t ret = LZ4::compressData(imgData.data, imgData.getSize(), payload.data(), payload.size(), compression);
+                if (ret < 0) {
+                    JE_ERROR("[Image-IO] (JTEX) Encode Error: LZ4 compression failed!");
+                    return false;
+                }
+                payload.resize(size_t(ret));
+                return true;
+            }
+
+            int32_t ret = ZLib::deflateParallel(imgData.data, imgData.getSize(), payload, compression, threads);
+            if (ret != Z_OK) {
+                JE_ERROR("[Image-IO] (JTEX) Encode Error: ZLib Deflate failed! ({0})", ZLib::zerr(ret));
+                return false;
+            }
+            return true;
+        }
+
+        static size_t alignOffset(size_t offset) {
+            return (offset + JTEX_ALIGNMENT - 1) & ~size_t(JTEX_ALIGNMENT - 1);
+        }
+
+        bool getInfo(const std::string& path, ImageData& imgData) {
+            return getInfo(path.c_str(), imgData);
+        }
+
+        bool getInfo(const char* path, ImageData& imgData) {
+            FileStream stream(path, "rb");
+
+            if (stream.isOpen()) {
+                return getInfo(stream, imgData);
+            }
+
+            JE_ERROR("[Image-IO] (JTEX) Error: Failed to open '{0}'!", path);
+            return false;
+        }
+
+        bool getInfo(const Stream& stream, ImageData& imgData) {
+            Header hdr{};
+            std::vector<LevelEntry> levels{};
+            if (!readLayout(stream, hdr, levels)) {
+                return false;
+            }
+            setupLevel(hdr, levels[0], imgData);
             return true;
         }
 
+        bool decode(const std::string& path, ImageData& imgData, const ImageDecodeParams params) {
+            return decode(path.c_str(), imgData, params);
+        }
+
         bool decode(const char* path, ImageData& imgData, const ImageDecodeParams params) {
             FileStream stream(path, "rb");
 
@@ -1800,41 +2693,208 @@ JE_END_PACK
         }
 
         bool decode(const Stream& stream, ImageData& imgData, const ImageDecodeParams params) {
-            if (!getInfo(stream, imgData)) {
+            size_t start = stream.tell();
+            Header hdr{};
+            std::vector<LevelEntry> levels{};
+            if (!readLayout(stream, hdr, levels)) {
                 return false;
             }
+            return readLevel(stream, start, hdr, levels[0], imgData);
+        }
 
-            if (!imgData.doAllocate()) {
-                JE_ERROR("[Image-IO] (JTEX) Decode Error: Failed to allocate pixel buffer!");
+        bool decodeLevels(const Stream& stream, std::vector<ImageData>& levels) {
+            size_t start = stream.tell();
+            Header hdr{};
+            std::vector<LevelEntry> entries{};
+            if (!readLayout(stream, hdr, entries)) {
+                return false;
+            }
+
+            levels.resize(entries.size());
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (!readLevel(stream, start, hdr, entries[i], levels[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool decode(const MappedFile& file, ImageData& imgData, uint32_t level) {
+            if (!file.isOpen()) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: File isn't mapped!");
+                return false;
+            }
+
+            MemoryStream stream(file.data(), file.size(), file.size());
+            Header hdr{};
+            std::vector<LevelEntry> levels{};
+            if (!readLayout(stream, hdr, levels)) {
+                return false;
+            }
+
+            if (level >= levels.size()) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: Mip level {0} doesn't exist! ({1} levels)", level, levels.size());
                 return false;
             }
-            stream.read(imgData.data, imgData.getSize(), false);
+            return mapLevel(file, hdr, levels[level], imgData);
+        }
+
+        bool decodeLevels(const MappedFile& file, std::vector<ImageData>& levels) {
+            if (!file.isOpen()) {
+                JE_ERROR("[Image-IO] (JTEX) Decode Error: File isn't mapped!");
+                return false;
+            }
+
+            MemoryStream stream(file.data(), file.size(), file.size());
+            Header hdr{};
+            std::vector<LevelEntry> entries{};
+            if (!readLayout(stream, hdr, entries)) {
+                return false;
+            }
+
+            levels.resize(entries.size());
+            for (size_t i = 0; i < entries.size(); i++) {
+                if (!mapLevel(file, hdr, entries[i], levels[i])) {
+                    return false;
+                }
+            }
             return true;
         }
 
+        bool encode(const std::string& path, const ImageData& imgData) {
+            return encode(path.c_str(), imgData, ImageEncodeParams{});
+        }
+
+        bool encode(const std::string& path, const ImageData& imgData, const ImageEncodeParams& params) {
+            return encode(path.c_str(), imgData, params);
+        }
+
         bool encode(const char* path, const ImageData& imgData) {
+            return encode(path, imgData, ImageEncodeParams{});
+        }
+
+        bool encode(const char* path, const ImageData& imgData, const ImageEncodeParams& params) {
             FileStream fs(path);
             if (fs.open("wb")) {
-                return encode(fs, imgData);
+                return encode(fs, imgData, params);
             }
             JE_ERROR("[Image-IO] (JTEX) Encode Error: Failed to open file '{0}' for writing!", path);
             return false;
         }
 
         bool encode(const Stream& stream, const ImageData& imgData) {
+            return encode(stream, imgData, ImageEncodeParams{});
+        }
+
+        bool encode(const Stream& stream, const ImageData& imgData, const ImageEncodeParams& params) {
             if (!stream.isOpen()) {
                 JE_ERROR("[Image-IO] (JTEX) Encode Error: Stream isn't open!");
                 return false;
             }
 
-            stream.writeValue(JTEX_SIG);
-            stream.writeValue(0U);
-            stream.writeValue(imgData.width);
-            stream.writeValue(imgData.height);
-            stream.writeValue(imgData.format);
-            stream.writeValue(imgData.paletteSize);
-            stream.writeValue(imgData.flags);
-            stream.write(imgData.data, imgData.getSize(), false);
+            //Level 0 is the source itself unless it has to be block compressed, owned levels get freed at the end
+            std::vector<ImageData> levels{};
+            std::vector<bool> owned{};
+            auto release = [&]() {
+                for (size_t i = 0; i < levels.size(); i++) {
+                    levels[i].clear(owned[i]);
+                }
+            };
+
+            levels.push_back(imgData);
+            owned.push_back(false);
+            if ((params.flags & F_IMG_ENC_MIPMAPS) != 0) {
+                std::vector<ImageData> mips{};
+                if (!generateMipChain(imgData, mips, params.mipFilter, params.threads)) {
+                    for (auto& mip : mips) {
+                        mip.clear(true);
+                    }
+                    JE_ERROR("[Image-IO] (JTEX) Encode Error: Failed to generate mip chain!");
+                    return false;
+                }
+
+                for (auto& mip : mips) {
+                    levels.push_back(mip);
+                    owned.push_back(true);
+                }
+            }
+
+            if (levels.size() > 0xFFFF) {
+                release();
+                JE_ERROR("[Image-IO] (JTEX) Encode Error: Too many mip levels! ({0})", levels.size());
+                return false;
+            }
+
+            if (isBlockCompressed(params.targetFormat) && imgData.format != params.targetFormat) {
+                for (size_t i = 0; i < levels.size(); i++) {
+                    ImageData blocks{};
+                    if (!DXT::compress(levels[i], blocks, params.targetFormat, params)) {
+                        blocks.clear(true);
+                        release();
+                        return false;
+                    }
+                    levels[i].clear(owned[i]);
+                    levels[i] = blocks;
+                    owned[i] = true;
+                }
+            }
+
+            const bool lz4 = (params.flags & F_IMG_ENC_LZ4) != 0;
+            const bool compressed = lz4 || (params.flags & F_IMG_ENC_ZLIB) != 0;
+            std::vector<std::vector<uint8_t>> payloads(compressed ? levels.size() : 0);
+            if (compressed) {
+                //The first level is most of the data, so the blocks of each level are spread over the threads instead of the levels
+                uint32_t threads = (params.flags & F_IMG_ENC_MULTITHREAD) != 0 ? params.threads : 1;
+                for (size_t i = 0; i < levels.size(); i++) {
+                    if (!deflateLevel(levels[i], lz4, params.compression, threads, payloads[i])) {
+                        release();
+                        return false;
+                    }
+                }
+            }
+
+            const ImageData& first = levels[0];
+            std::vector<LevelEntry> entries(levels.size());
+            size_t offset = sizeof(Header) + sizeof(HeaderV2) + entries.size() * sizeof(LevelEntry);
+            for (size_t i = 0; i < levels.size(); i++) {
+                auto& entry = entries[i];
+                offset = alignOffset(offset);
+                entry.offset = offset;
+                entry.rawSize = levels[i].getSize();
+                entry.size = compressed ? payloads[i].size() : entry.rawSize;
+                entry.width = levels[i].width;
+                entry.height = levels[i].height;
+                offset += size_t(entry.size);
+            }
+
+            Header hdr{};
+            hdr.sig = JTEX_SIG;
+            hdr.flags = JTEXFlags(JTEX_V2 | (compressed ? JTEX_Compressed : JTEX_None) | (lz4 ? JTEX_LZ4 : JTEX_None));
+            hdr.width = first.width;
+            hdr.height = first.height;
+            hdr.format = first.format;
+            hdr.paletteSize = first.paletteSize;
+            hdr.imgFlags = first.flags & ~IMG_FLAG_VIEW;
+
+            HeaderV2 hdrV2{};
+            hdrV2.levels = uint16_t(levels.size());
+            hdrV2.alignment = JTEX_ALIGNMENT;
+
+            stream.writeValue(hdr);
+            stream.writeValue(hdrV2);
+            stream.write(entries.data(), sizeof(LevelEntry), entries.size());
+
+            size_t written = sizeof(Header) + sizeof(HeaderV2) + entries.size() * sizeof(LevelEntry);
+            for (size_t i = 0; i < levels.size(); i++) {
+                if (entries[i].offset > written) {
+                    stream.writeZero(size_t(entries[i].offset - written));
+                }
+
+                const uint8_t* payload = compressed ? payloads[i].data() : levels[i].data;
+                stream.write(payload, size_t(entries[i].size), false);
+                written = size_t(entries[i].offset + entries[i].size);
+            }
+            release();
             return true;
         }
     }
@@ -1921,13 +2981,13 @@ JE_END_PACK
                     return false;
 
                 case JEngine::FMT_PNG:
-                    return Png::encode(stream, imgData, encodeParams.compression);
+                    return Png::encode(stream, imgData, encodeParams);
                 case JEngine::FMT_BMP:
                     return Bmp::encode(stream, imgData, encodeParams.dpi);
                 case JEngine::FMT_DDS:
-                    return DDS::encode(stream, imgData);
+                    return DDS::encode(stream, imgData, encodeParams);
                 case JEngine::FMT_JTEX:
-                    return JTEX::encode(stream, imgData);
+                    return JTEX::encode(stream, imgData, encodeParams);
             }
         }
     }
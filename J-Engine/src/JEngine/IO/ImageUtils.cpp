@@ -1,6 +1,11 @@
 #include <JEngine/IO/ImageUtils.h>
+#include <JEngine/IO/Image.h>
 #include <JEngine/Core/Assert.h>
 #include <JEngine/Math/Math.h>
+#include <JEngine/Utility/SIMD.h>
+#include <JEngine/Utility/Parallel.h>
+#include <algorithm>
+#include <cmath>
 
 namespace JEngine {
 
@@ -54,232 +59,1222 @@ namespace JEngine {
         return false;
     }
 
-    int32_t findInPalette(const JColor32 color, const JColor32* palette, uint32_t size) {
-        for (size_t i = 0; i < size; i++) {
-            if (color == palette[i]) { return int32_t(i); }
+    void applyPalette(const uint8_t* pixelData, int32_t width, int32_t height, int32_t colors, TextureFormat format, uint8_t* targetPixels, TextureFormat paletteFmt, int32_t alphaClip) {
+        if (paletteFmt != TextureFormat::Indexed8 && paletteFmt != TextureFormat::Indexed16) {
+            JE_CORE_WARN("Couldn't apply palette, invalid texture format! ({0})", getTextureFormatName(paletteFmt));
+            return;
+        }
+
+        const size_t reso = size_t(width) * height;
+        const size_t bpp = getBitsPerPixel(format) >> 3;
+        const bool wide = paletteFmt == TextureFormat::Indexed16;
+        PaletteLookup lookup(reinterpret_cast<const JColor32*>(targetPixels), colors);
+
+        uint8_t* pixData8 = targetPixels + (wide ? colors * 4 : 256 * 4);
+        uint16_t* pixData16 = reinterpret_cast<uint16_t*>(pixData8);
+
+        JColor32 buffer[256];
+        for (size_t i = 0; i < reso; i += 256, pixelData += 256 * bpp) {
+            const size_t count = std::min<size_t>(reso - i, 256);
+            convertPixels(format, TextureFormat::RGBA32, pixelData, reinterpret_cast<uint8_t*>(buffer), count);
+
+            for (size_t j = 0; j < count; j++) {
+                if (buffer[j].a <= alphaClip) {
+                    buffer[j] = Colors32::Clear;
+                }
+
+                const int32_t index = lookup.find(buffer[j]);
+                if (wide) {
+                    pixData16[i + j] = uint16_t(index);
+                }
+                else {
+                    pixData8[i + j] = uint8_t(index);
+                }
+            }
         }
-        return -1;
     }
 
-    bool tryBuildPalette8(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, JColor32 buffer[32], uint32_t& bufSize, int32_t alphaClip) {
-        int32_t target = format == TextureFormat::Indexed16 ? 256 * 256 : 256;
-        if (pixel.a <= alphaClip) {
-            *reinterpret_cast<uint32_t*>(&pixel) = 0;
+    void ColorHash::clear() {
+        std::fill(_values.begin(), _values.end(), -1);
+        _count = 0;
+    }
+
+    void ColorHash::reserve(uint32_t count) {
+        uint32_t capacity = 16;
+        while (capacity < count + (count >> 1)) {
+            capacity <<= 1;
+        }
+        if (capacity > _keys.size()) {
+            grow(capacity);
         }
+    }
 
-        uint32_t bSize = bufSize > 8 ? 8 : bufSize;
-        for (size_t i = 0; i < bSize; i++) {
-            if (buffer[i] == pixel) { return true; }
+    int32_t ColorHash::find(uint32_t color) const {
+        if (_count < 1) { return -1; }
+        for (uint32_t i = hash(color) & _mask;; i = (i + 1) & _mask) {
+            if (_values[i] < 0) { return -1; }
+            if (_keys[i] == color) { return _values[i]; }
         }
+    }
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newPalette);
-        int32_t ind = findInPalette(pixel, palette, colors);
-        if (ind < 0) {
-            palette[colors++] = pixel;
-            if (colors > target) {
-                if (colors > 256 * 256) {
-                    JE_CORE_WARN("Couldn't build palette, too many colors!");
-                    return false;
-                }
-                target = 256 * 256;
-                format = TextureFormat::Indexed16;
+    int32_t ColorHash::insert(uint32_t color, int32_t value) {
+        //Kept at most 2/3 full so probe chains stay short
+        if ((_count + 1) * 3 > _keys.size() * 2) {
+            grow(_keys.size() < 16 ? 16 : uint32_t(_keys.size() << 1));
+        }
+
+        for (uint32_t i = hash(color) & _mask;; i = (i + 1) & _mask) {
+            if (_values[i] < 0) {
+                _keys[i] = color;
+                _values[i] = value;
+                _count++;
+                return value;
             }
+            if (_keys[i] == color) { return _values[i]; }
         }
-        buffer[bufSize & 31] = pixel;
-        bufSize++;
-        return true;
     }
-    bool tryBuildPalette16(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, JColor32 buffer[256], uint32_t& bufSize, int32_t alphaClip, int32_t maxSize) {
-        int32_t target = 256 * 256;
-        if (pixel.a <= alphaClip) {
-            *reinterpret_cast<uint32_t*>(&pixel) = 0;
+
+    void ColorHash::grow(uint32_t capacity) {
+        std::vector<uint32_t> keys(capacity, 0);
+        std::vector<int32_t> values(capacity, -1);
+        std::swap(keys, _keys);
+        std::swap(values, _values);
+        _mask = capacity - 1;
+        _count = 0;
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (values[i] >= 0) {
+                insert(keys[i], values[i]);
+            }
         }
-        maxSize = maxSize < 0 || maxSize > 256 * 256 ? 256 * 256 : maxSize;
+    }
 
-        uint32_t bSize = bufSize > 8 ? 8 : bufSize;
-        for (size_t i = 0; i < bSize; i++) {
-            if (buffer[i] == pixel) { return true; }
+    static inline uint32_t colorDistance(JColor32 a, JColor32 b) {
+        const int32_t r = int32_t(a.r) - b.r;
+        const int32_t g = int32_t(a.g) - b.g;
+        const int32_t bl = int32_t(a.b) - b.b;
+        const int32_t al = int32_t(a.a) - b.a;
+        return uint32_t(r * r + g * g + bl * bl + al * al);
+    }
+
+    PaletteLookup::PaletteLookup(const JColor32* palette, int32_t colors) : _cache(colors > 0 ? colors : 0) {
+        _sorted.reserve(colors > 0 ? colors : 0);
+        for (int32_t i = 0; i < colors; i++) {
+            _sorted.push_back({ palette[i], i });
         }
+        std::sort(_sorted.begin(), _sorted.end(), [](const Entry& a, const Entry& b) { return a.color.g < b.color.g; });
+    }
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newPalette);
-        int32_t ind = findInPalette(pixel, palette, colors);
-        if (ind < 0) {
-            palette[colors++] = pixel;
-            if (colors > target) {
-                if (colors > maxSize) {
-                    JE_CORE_WARN("Couldn't build palette, too many colors!");
-                    return false;
-                }
+    int32_t PaletteLookup::find(JColor32 color) {
+        if (_sorted.size() < 1) { return 0; }
+
+        const uint32_t key = reinterpret_cast<const uint32_t&>(color);
+        int32_t index = _cache.find(key);
+        if (index >= 0) { return index; }
+
+        //Entries are sorted by green, so the search walks outwards from the closest
+        //green value and stops once green alone is further off than the best match.
+        const size_t start = std::lower_bound(_sorted.begin(), _sorted.end(), color.g,
+            [](const Entry& a, uint8_t g) { return a.color.g < g; }) - _sorted.begin();
+
+        uint32_t best = UINT32_MAX;
+        for (size_t i = start; i < _sorted.size(); i++) {
+            const int32_t dG = int32_t(_sorted[i].color.g) - color.g;
+            if (uint32_t(dG * dG) >= best) { break; }
+            const uint32_t dist = colorDistance(color, _sorted[i].color);
+            if (dist < best) {
+                best = dist;
+                index = _sorted[i].index;
             }
         }
-        buffer[bufSize & 0xFF] = pixel;
-        bufSize++;
-        return true;
+
+        for (size_t i = start; i > 0; i--) {
+            const int32_t dG = int32_t(color.g) - _sorted[i - 1].color.g;
+            if (uint32_t(dG * dG) >= best) { break; }
+            const uint32_t dist = colorDistance(color, _sorted[i - 1].color);
+            if (dist < best) {
+                best = dist;
+                index = _sorted[i - 1].index;
+            }
+        }
+
+        //Dithering can produce a lot of one off colors, don't let the cache grow forever
+        if (_cache.size() >= 1 << 20) {
+            _cache.clear();
+        }
+        _cache.insert(key, index);
+        return index;
     }
 
-    bool tryBuildPalette(JColor32 pixel, int32_t& colors, TextureFormat& format, uint8_t* newPalette, std::unordered_map<uint32_t, int32_t>& paletteLut, int32_t alphaClip, int32_t absoluteMax) {
-        absoluteMax = absoluteMax <= 0 ? 256 * 256 : absoluteMax;
+    struct QuantColor {
+        JColor32 color;
+        uint32_t count;
+    };
+
+    struct QuantBox {
+        size_t begin;
+        size_t end;
+        uint64_t score;
+        uint8_t channel;
+    };
+
+    static void updateBox(const QuantColor* colors, QuantBox& box) {
+        uint8_t minC[4]{ 0xFF, 0xFF, 0xFF, 0xFF };
+        uint8_t maxC[4]{ 0, 0, 0, 0 };
+        uint64_t total = 0;
+        for (size_t i = box.begin; i < box.end; i++) {
+            const uint8_t* ch = reinterpret_cast<const uint8_t*>(&colors[i].color);
+            for (size_t c = 0; c < 4; c++) {
+                minC[c] = std::min(minC[c], ch[c]);
+                maxC[c] = std::max(maxC[c], ch[c]);
+            }
+            total += colors[i].count;
+        }
 
-        uint32_t& colorInt = reinterpret_cast<uint32_t&>(pixel);
-        if (pixel.a <= alphaClip) {
-            colorInt = 0;
+        uint32_t range = 0;
+        box.channel = 0;
+        for (uint8_t c = 0; c < 4; c++) {
+            if (uint32_t(maxC[c] - minC[c]) > range) {
+                range = maxC[c] - minC[c];
+                box.channel = c;
+            }
         }
+        box.score = range * total;
+    }
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newPalette);
-        auto find = paletteLut.find(colorInt);
+    static JColor32 averageBox(const QuantColor* colors, const QuantBox& box) {
+        uint64_t sum[4]{ 0 };
+        uint64_t total = 0;
+        for (size_t i = box.begin; i < box.end; i++) {
+            const uint8_t* ch = reinterpret_cast<const uint8_t*>(&colors[i].color);
+            for (size_t c = 0; c < 4; c++) {
+                sum[c] += uint64_t(ch[c]) * colors[i].count;
+            }
+            total += colors[i].count;
+        }
 
-        if (find == paletteLut.end()) {
-            paletteLut[colorInt] = colors;
-            palette[colors++] = pixel;
+        JColor32 color{};
+        uint8_t* out = reinterpret_cast<uint8_t*>(&color);
+        for (size_t c = 0; c < 4; c++) {
+            out[c] = uint8_t((sum[c] + (total >> 1)) / total);
+        }
+        return color;
+    }
 
-            if (colors > absoluteMax) {
-                JE_CORE_WARN("Couldn't build palette, too many colors!");
-                return false;
+    //Median cut, keeps splitting the box with the widest channel range (weighted by
+    //pixel count) at the weighted median until there are 'maxColors' boxes.
+    static void medianCut(std::vector<QuantColor>& colors, int32_t maxColors, std::vector<JColor32>& palette) {
+        auto compare = [](const QuantBox& a, const QuantBox& b) { return a.score < b.score; };
+        std::vector<QuantBox> boxes{};
+        boxes.reserve(maxColors);
+        boxes.push_back({ 0, colors.size(), 0, 0 });
+        updateBox(colors.data(), boxes[0]);
+
+        std::vector<QuantBox> done{};
+        while (boxes.size() > 0 && int32_t(boxes.size() + done.size()) < maxColors) {
+            std::pop_heap(boxes.begin(), boxes.end(), compare);
+            QuantBox box = boxes.back();
+            boxes.pop_back();
+
+            if (box.score == 0) {
+                done.push_back(box);
+                continue;
+            }
+
+            const uint8_t ch = box.channel;
+            std::sort(colors.begin() + box.begin, colors.begin() + box.end, [ch](const QuantColor& a, const QuantColor& b) {
+                return reinterpret_cast<const uint8_t*>(&a.color)[ch] < reinterpret_cast<const uint8_t*>(&b.color)[ch];
+            });
+
+            uint64_t total = 0;
+            for (size_t i = box.begin; i < box.end; i++) {
+                total += colors[i].count;
             }
 
-            if (format == TextureFormat::Indexed8 && colors > 256) {
-                format = TextureFormat::Indexed16;
+            size_t split = box.begin + 1;
+            for (uint64_t sum = colors[box.begin].count; split < box.end - 1 && sum * 2 < total; split++) {
+                sum += colors[split].count;
             }
+
+            QuantBox low{ box.begin, split, 0, 0 };
+            QuantBox high{ split, box.end, 0, 0 };
+            updateBox(colors.data(), low);
+            updateBox(colors.data(), high);
+
+            boxes.push_back(low);
+            std::push_heap(boxes.begin(), boxes.end(), compare);
+            boxes.push_back(high);
+            std::push_heap(boxes.begin(), boxes.end(), compare);
         }
-        return true;
+
+        palette.clear();
+        palette.reserve(boxes.size() + done.size());
+        for (const auto& box : boxes) {
+            palette.push_back(averageBox(colors.data(), box));
+        }
+        for (const auto& box : done) {
+            palette.push_back(averageBox(colors.data(), box));
+        }
+    }
+
+    static inline uint8_t clampUI8(int32_t value) {
+        return uint8_t(value < 0 ? 0 : value > 255 ? 255 : value);
     }
-    bool tryBuildPalette(const uint8_t* pixelData, int32_t start, int32_t length, int32_t& colors, TextureFormat& format, int32_t bpp, uint8_t* newPalette, int32_t alphaClip) {
-        if (bpp < 2) {
-            format = TextureFormat::Unknown;
-            JE_CORE_WARN("[JEngine - ImageUtils] Warning: Couldn't build palette, bpp is too small {0}!", bpp);
+
+    bool quantize(const ImageData& source, ImageData& target, const QuantizeParams& params) {
+        if (isBlockCompressed(source.format) || source.format == TextureFormat::Unknown || !source.data) {
+            JE_CORE_WARN("Couldn't quantize image, unsupported texture format! ({0})", getTextureFormatName(source.format));
             return false;
         }
 
-        JColor32 buffer{ 0,0,0,0xFF };
-        int32_t target = format == TextureFormat::Indexed16 ? 256 * 256 : 256;
+        const int32_t width = source.width;
+        const int32_t height = source.height;
+        const size_t reso = size_t(width) * height;
+        const int32_t maxColors = Math::clamp(params.maxColors, 1, 256 * 256);
+
+        std::vector<JColor32> pixels(reso);
+        convertPixels(source.format, TextureFormat::RGBA32, source.getData(), reinterpret_cast<uint8_t*>(pixels.data()), reso, source.data);
+
+        ColorHash hash{};
+        std::vector<QuantColor> colors{};
+        for (auto& pixel : pixels) {
+            if (pixel.a <= params.alphaClip) {
+                pixel = Colors32::Clear;
+            }
+            const uint32_t key = reinterpret_cast<const uint32_t&>(pixel);
+            const int32_t index = hash.insert(key, int32_t(colors.size()));
+            if (size_t(index) == colors.size()) {
+                colors.push_back({ pixel, 0 });
+            }
+            colors[index].count++;
+        }
+
+        std::vector<JColor32> palette{};
+        const bool exact = int32_t(colors.size()) <= maxColors;
+        if (exact) {
+            palette.reserve(colors.size());
+            for (const auto& color : colors) {
+                palette.push_back(color.color);
+            }
+        }
+        else {
+            JE_CORE_TRACE("Quantizing {0} colors down to {1}", colors.size(), maxColors);
+            medianCut(colors, maxColors, palette);
+        }
+
+        const int32_t colorCount = int32_t(palette.size());
+        const TextureFormat format = colorCount <= 256 ? TextureFormat::Indexed8 : TextureFormat::Indexed16;
+        const int32_t paletteSize = format == TextureFormat::Indexed8 ? 256 : Math::alignToPalette(colorCount);
+        if (!target.doAllocate(width, height, format, paletteSize)) {
+            JE_CORE_ERROR("Couldn't quantize image, failed to allocate pixel buffer!");
+            return false;
+        }
+
+        memset(target.data, 0, target.getPaletteOffset());
+        memcpy(target.data, palette.data(), palette.size() * sizeof(JColor32));
+
+        uint8_t* indices8 = target.getData();
+        uint16_t* indices16 = reinterpret_cast<uint16_t*>(indices8);
+        auto setIndex = [&](size_t i, int32_t index) {
+            if (format == TextureFormat::Indexed8) {
+                indices8[i] = uint8_t(index);
+            }
+            else {
+                indices16[i] = uint16_t(index);
+            }
+        };
+
+        if (exact) {
+            for (size_t i = 0; i < reso; i++) {
+                setIndex(i, hash.find(reinterpret_cast<const uint32_t&>(pixels[i])));
+            }
+            return true;
+        }
+
+        PaletteLookup lookup(palette.data(), colorCount);
+        if (!params.dither) {
+            for (size_t i = 0; i < reso; i++) {
+                setIndex(i, lookup.find(pixels[i]));
+            }
+            return true;
+        }
+
+        //Floyd-Steinberg, error rows are padded by a pixel on both sides
+        std::vector<int32_t> errors(size_t(width + 2) * 8, 0);
+        int32_t* errCur = errors.data() + 4;
+        int32_t* errNext = errors.data() + (width + 2) * 4 + 4;
+        for (int32_t y = 0, i = 0; y < height; y++) {
+            for (int32_t x = 0; x < width; x++, i++) {
+                const uint8_t* ch = reinterpret_cast<const uint8_t*>(&pixels[i]);
+                int32_t* err = errCur + x * 4;
+
+                JColor32 wanted{};
+                uint8_t* want = reinterpret_cast<uint8_t*>(&wanted);
+                for (size_t c = 0; c < 4; c++) {
+                    want[c] = clampUI8(ch[c] + (err[c] >> 4));
+                }
+
+                const int32_t index = lookup.find(wanted);
+                setIndex(i, index);
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newPalette);
-        for (size_t i = 0, j = 0, k = start; i < length; i++, j += bpp, k++) {
-            memcpy(&buffer, pixelData + j, bpp);
-            if (buffer.a <= alphaClip) {
-                *reinterpret_cast<uint32_t*>(&buffer) = 0;
+                const uint8_t* got = reinterpret_cast<const uint8_t*>(&palette[index]);
+                for (size_t c = 0; c < 4; c++) {
+                    const int32_t diff = int32_t(want[c]) - got[c];
+                    err[c + 4] += diff * 7;
+                    errNext[x * 4 + c - 4] += diff * 3;
+                    errNext[x * 4 + c] += diff * 5;
+                    errNext[x * 4 + c + 4] += diff;
+                }
             }
+            std::swap(errCur, errNext);
+            memset(errNext - 4, 0, size_t(width + 2) * 4 * sizeof(int32_t));
+        }
+        return true;
+    }
+
+    // Bulk pixel conversion, every format is either converted straight to the target
+    // or goes through a small RGBA32 (or RGBAF for the 16-bit/float formats) staging buffer.
+    static constexpr size_t CONVERT_CHUNK = 256;
+
+    static inline uint8_t floatToUI8(float value) {
+        return uint8_t(Math::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    static inline uint16_t floatToUI16(float value) {
+        return uint16_t(Math::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
 
-            int32_t ind = findInPalette(buffer, palette, colors);
-            if (ind < 0) {
-                if (colors >= target) {
-                    if (colors >= 256 * 256) {
-                        JE_CORE_WARN("[JEngine - ImageUtils] Warning: Couldn't build palette, too many colors!");
-                        return false;
+    static inline uint8_t to4Bit(uint8_t value) {
+        return uint8_t((uint32_t(value) * 15 + 128) / 255);
+    }
+
+    static void gatherPalette(const uint8_t* src, uint8_t* dst, size_t count, const uint8_t* palette, bool wide) {
+        const uint32_t* pal = reinterpret_cast<const uint32_t*>(palette);
+        uint32_t* out = reinterpret_cast<uint32_t*>(dst);
+        if (!pal) {
+            memset(dst, 0, count * 4);
+            return;
+        }
+
+        if (wide) {
+            for (size_t i = 0, j = 0; i < count; i++, j += 2) {
+                out[i] = pal[size_t(src[j]) | (size_t(src[j + 1]) << 8)];
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            out[i] = pal[src[i]];
+        }
+    }
+
+    static void expandRGB24(const uint8_t* src, uint8_t* dst, size_t count) {
+        size_t i = 0;
+#ifdef JE_SIMD_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i alpha = _mm_set1_epi32(int32_t(0xFF000000));
+        //Loads 16 bytes for 4 pixels, so stop a pixel early to stay inside the source
+        for (; i + 6 <= count; i += 4, src += 12, dst += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+        }
+#endif
+        for (; i < count; i++, src += 3, dst += 4) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = 0xFF;
+        }
+    }
+
+    static void packRGB24(const uint8_t* src, uint8_t* dst, size_t count) {
+        size_t i = 0;
+#ifdef JE_SIMD_SSSE3
+        const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        //Stores 16 bytes for 4 pixels, so stop a pixel early to stay inside the target
+        for (; i + 6 <= count; i += 4, src += 16, dst += 12) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(v, shuffle));
+        }
+#endif
+        for (; i < count; i++, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+
+    static void toRGBA32(TextureFormat format, const uint8_t* src, uint8_t* dst, size_t count, const uint8_t* palette) {
+        size_t i = 0;
+        switch (format) {
+            default:
+                memset(dst, 0, count * 4);
+                break;
+            case TextureFormat::R8:
+#ifdef JE_SIMD_SSE2
+                for (const __m128i alpha = _mm_set1_epi8(-1); i + 16 <= count; i += 16, src += 16, dst += 64) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i rrLo = _mm_unpacklo_epi8(v, v);
+                    __m128i rrHi = _mm_unpackhi_epi8(v, v);
+                    __m128i raLo = _mm_unpacklo_epi8(v, alpha);
+                    __m128i raHi = _mm_unpackhi_epi8(v, alpha);
+                    __m128i* out = reinterpret_cast<__m128i*>(dst);
+                    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(rrLo, raLo));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rrLo, raLo));
+                    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rrHi, raHi));
+                    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rrHi, raHi));
+                }
+#endif
+                for (; i < count; i++, dst += 4) {
+                    dst[0] = dst[1] = dst[2] = *src++;
+                    dst[3] = 0xFF;
+                }
+                break;
+            case TextureFormat::RG8:
+#ifdef JE_SIMD_SSE2
+                for (const __m128i alpha = _mm_set1_epi16(int16_t(0xFF00)); i + 8 <= count; i += 8, src += 16, dst += 32) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i* out = reinterpret_cast<__m128i*>(dst);
+                    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(v, alpha));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(v, alpha));
+                }
+#endif
+                for (; i < count; i++, src += 2, dst += 4) {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                    dst[2] = 0x00;
+                    dst[3] = 0xFF;
+                }
+                break;
+            case TextureFormat::RGB24:
+                expandRGB24(src, dst, count);
+                break;
+            case TextureFormat::RGBA32:
+                memcpy(dst, src, count * 4);
+                break;
+            case TextureFormat::RGBA4444:
+#ifdef JE_SIMD_SSE2
+                for (const __m128i mask = _mm_set1_epi16(0x0F0F); i + 8 <= count; i += 8, src += 16, dst += 32) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i rb = _mm_and_si128(v, mask);
+                    __m128i ga = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+                    __m128i lo = _mm_unpacklo_epi8(rb, ga);
+                    __m128i hi = _mm_unpackhi_epi8(rb, ga);
+
+                    //Nibbles never carry into the next byte so n * 17 is just n | (n << 4)
+                    __m128i* out = reinterpret_cast<__m128i*>(dst);
+                    _mm_storeu_si128(out + 0, _mm_or_si128(lo, _mm_slli_epi16(lo, 4)));
+                    _mm_storeu_si128(out + 1, _mm_or_si128(hi, _mm_slli_epi16(hi, 4)));
+                }
+#endif
+                for (; i < count; i++, src += 2, dst += 4) {
+                    const uint16_t v = uint16_t(src[0] | (src[1] << 8));
+                    dst[0] = uint8_t((v & 0xF) * 17);
+                    dst[1] = uint8_t(((v >> 4) & 0xF) * 17);
+                    dst[2] = uint8_t(((v >> 8) & 0xF) * 17);
+                    dst[3] = uint8_t(((v >> 12) & 0xF) * 17);
+                }
+                break;
+            case TextureFormat::RGB48: {
+                const uint16_t* srcUI = reinterpret_cast<const uint16_t*>(src);
+                for (; i < count; i++, srcUI += 3, dst += 4) {
+                    dst[0] = remapUI16ToUI8(srcUI[0]);
+                    dst[1] = remapUI16ToUI8(srcUI[1]);
+                    dst[2] = remapUI16ToUI8(srcUI[2]);
+                    dst[3] = 0xFF;
+                }
+                break;
+            }
+            case TextureFormat::RGBA64: {
+#ifdef JE_SIMD_SSE2
+                for (; i + 4 <= count; i += 4, src += 32, dst += 16) {
+                    const __m128i* in = reinterpret_cast<const __m128i*>(src);
+                    __m128i a = _mm_srli_epi16(_mm_loadu_si128(in + 0), 8);
+                    __m128i b = _mm_srli_epi16(_mm_loadu_si128(in + 1), 8);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(a, b));
+                }
+#endif
+                const uint16_t* srcUI = reinterpret_cast<const uint16_t*>(src);
+                for (; i < count; i++, srcUI += 4, dst += 4) {
+                    dst[0] = remapUI16ToUI8(srcUI[0]);
+                    dst[1] = remapUI16ToUI8(srcUI[1]);
+                    dst[2] = remapUI16ToUI8(srcUI[2]);
+                    dst[3] = remapUI16ToUI8(srcUI[3]);
+                }
+                break;
+            }
+            case TextureFormat::Indexed8:
+            case TextureFormat::Indexed16:
+                gatherPalette(src, dst, count, palette, format == TextureFormat::Indexed16);
+                break;
+            case TextureFormat::RGBAF: {
+                const float* srcF = reinterpret_cast<const float*>(src);
+#ifdef JE_SIMD_SSE2
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 one = _mm_set1_ps(1.0f);
+                const __m128 scale = _mm_set1_ps(255.0f);
+                const __m128 half = _mm_set1_ps(0.5f);
+                for (; i + 4 <= count; i += 4, srcF += 16, dst += 16) {
+                    __m128i px[4];
+                    for (size_t j = 0; j < 4; j++) {
+                        __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcF + j * 4), zero), one);
+                        px[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
                     }
-                    target = 256 * 256;
-                    format = TextureFormat::Indexed16;
+                    __m128i lo = _mm_packs_epi32(px[0], px[1]);
+                    __m128i hi = _mm_packs_epi32(px[2], px[3]);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+                }
+#endif
+                for (; i < count; i++, srcF += 4, dst += 4) {
+                    dst[0] = floatToUI8(srcF[0]);
+                    dst[1] = floatToUI8(srcF[1]);
+                    dst[2] = floatToUI8(srcF[2]);
+                    dst[3] = floatToUI8(srcF[3]);
+                }
+                break;
+            }
+        }
+    }
+
+    static bool fromRGBA32(TextureFormat format, const uint8_t* src, uint8_t* dst, size_t count) {
+        size_t i = 0;
+        switch (format) {
+            default: return false;
+            case TextureFormat::R8:
+#ifdef JE_SIMD_SSE2
+                for (const __m128i mask = _mm_set1_epi32(0xFF); i + 16 <= count; i += 16, src += 64, dst += 16) {
+                    const __m128i* in = reinterpret_cast<const __m128i*>(src);
+                    __m128i a = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(in + 0), mask), _mm_and_si128(_mm_loadu_si128(in + 1), mask));
+                    __m128i b = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(in + 2), mask), _mm_and_si128(_mm_loadu_si128(in + 3), mask));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(a, b));
+                }
+#endif
+                for (; i < count; i++, src += 4) {
+                    *dst++ = src[0];
+                }
+                break;
+            case TextureFormat::RG8:
+#ifdef JE_SIMD_SSE2
+                for (; i + 8 <= count; i += 8, src += 32, dst += 16) {
+                    const __m128i* in = reinterpret_cast<const __m128i*>(src);
+                    //Keeps the low 16 bits (RG) of every pixel, shifting the high halves down first
+                    __m128i a = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(in + 0), 16), 16);
+                    __m128i b = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(in + 1), 16), 16);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packs_epi32(a, b));
+                }
+#endif
+                for (; i < count; i++, src += 4, dst += 2) {
+                    dst[0] = src[0];
+                    dst[1] = src[1];
+                }
+                break;
+            case TextureFormat::RGB24:
+                packRGB24(src, dst, count);
+                break;
+            case TextureFormat::RGBA32:
+                memcpy(dst, src, count * 4);
+                break;
+            case TextureFormat::RGBA4444:
+                for (; i < count; i++, src += 4, dst += 2) {
+                    const uint16_t v =
+                        uint16_t(to4Bit(src[0])) |
+                        uint16_t(to4Bit(src[1]) << 4) |
+                        uint16_t(to4Bit(src[2]) << 8) |
+                        uint16_t(to4Bit(src[3]) << 12);
+                    dst[0] = uint8_t(v);
+                    dst[1] = uint8_t(v >> 8);
+                }
+                break;
+            case TextureFormat::RGB48: {
+                uint16_t* dstUI = reinterpret_cast<uint16_t*>(dst);
+                for (; i < count; i++, src += 4, dstUI += 3) {
+                    dstUI[0] = uint16_t(src[0] * 257);
+                    dstUI[1] = uint16_t(src[1] * 257);
+                    dstUI[2] = uint16_t(src[2] * 257);
+                }
+                break;
+            }
+            case TextureFormat::RGBA64: {
+#ifdef JE_SIMD_SSE2
+                for (; i + 4 <= count; i += 4, src += 16, dst += 32) {
+                    //Interleaving a byte with itself is the same as multiplying it by 257
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i* out = reinterpret_cast<__m128i*>(dst);
+                    _mm_storeu_si128(out + 0, _mm_unpacklo_epi8(v, v));
+                    _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(v, v));
+                }
+#endif
+                uint16_t* dstUI = reinterpret_cast<uint16_t*>(dst);
+                for (; i < count; i++, src += 4, dstUI += 4) {
+                    dstUI[0] = uint16_t(src[0] * 257);
+                    dstUI[1] = uint16_t(src[1] * 257);
+                    dstUI[2] = uint16_t(src[2] * 257);
+                    dstUI[3] = uint16_t(src[3] * 257);
+                }
+                break;
+            }
+            case TextureFormat::RGBAF: {
+                float* dstF = reinterpret_cast<float*>(dst);
+#ifdef JE_SIMD_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+                for (; i + 4 <= count; i += 4, src += 16, dstF += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                    __m128i lo = _mm_unpacklo_epi8(v, zero);
+                    __m128i hi = _mm_unpackhi_epi8(v, zero);
+                    _mm_storeu_ps(dstF + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(dstF + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+                    _mm_storeu_ps(dstF + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+                    _mm_storeu_ps(dstF + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+                }
+#endif
+                for (; i < count; i++, src += 4, dstF += 4) {
+                    dstF[0] = src[0] * (1.0f / 255.0f);
+                    dstF[1] = src[1] * (1.0f / 255.0f);
+                    dstF[2] = src[2] * (1.0f / 255.0f);
+                    dstF[3] = src[3] * (1.0f / 255.0f);
                 }
-                palette[colors++] = buffer;
+                break;
             }
         }
         return true;
     }
 
-    void applyPalette(const uint8_t* pixelData, int32_t width, int32_t height, int32_t colors, TextureFormat format, uint8_t* targetPixels, TextureFormat paletteFmt, int32_t alphaClip) {
+    static constexpr bool isWideFormat(TextureFormat format) {
+        return format == TextureFormat::RGB48 || format == TextureFormat::RGBA64 || format == TextureFormat::RGBAF;
+    }
 
-        int32_t reso = width * height;
-        JColor32* palette = reinterpret_cast<JColor32*>(targetPixels);
-        JColor32 colorBuf{ 0,0,0,0xFF };
-        int32_t bpp = getBitsPerPixel(format) >> 3;
-        switch (paletteFmt)
-        {
-        case JEngine::TextureFormat::Indexed8: {
-            uint8_t* pixData = targetPixels + 256 * 4;
-            for (size_t i = 0, j = 0; i < reso; i++, j = 0) {
-                memcpy(&colorBuf, pixelData + j, bpp);
-                if (colorBuf.a <= alphaClip) {
-                    *reinterpret_cast<uint32_t*>(&colorBuf) = 0;
+    static void toRGBAF(TextureFormat format, const uint8_t* src, float* dst, size_t count) {
+        switch (format) {
+            case TextureFormat::RGB48: {
+                const uint16_t* srcUI = reinterpret_cast<const uint16_t*>(src);
+                for (size_t i = 0; i < count; i++, srcUI += 3, dst += 4) {
+                    dst[0] = srcUI[0] * (1.0f / 65535.0f);
+                    dst[1] = srcUI[1] * (1.0f / 65535.0f);
+                    dst[2] = srcUI[2] * (1.0f / 65535.0f);
+                    dst[3] = 1.0f;
                 }
-                int32_t index = findInPalette(colorBuf, palette, colors);
-                pixData[i] = uint8_t(index < 0 ? 0 : index);
+                break;
             }
-            break;
+            case TextureFormat::RGBA64: {
+                const uint16_t* srcUI = reinterpret_cast<const uint16_t*>(src);
+                for (size_t i = 0; i < count * 4; i++) {
+                    dst[i] = srcUI[i] * (1.0f / 65535.0f);
+                }
+                break;
+            }
+            default:
+                memcpy(dst, src, count * 16);
+                break;
         }
-        case JEngine::TextureFormat::Indexed16: {
-            uint16_t* pixData = reinterpret_cast<uint16_t*>(targetPixels + colors * 4);
-            for (size_t i = 0, j = 0; i < reso; i++, j = 0) {
-                memcpy(&colorBuf, pixelData + j, bpp);
-                if (colorBuf.a <= alphaClip) {
-                    *reinterpret_cast<uint32_t*>(&colorBuf) = 0;
+    }
+
+    static void fromRGBAF(TextureFormat format, const float* src, uint8_t* dst, size_t count) {
+        switch (format) {
+            case TextureFormat::RGB48: {
+                uint16_t* dstUI = reinterpret_cast<uint16_t*>(dst);
+                for (size_t i = 0; i < count; i++, src += 4, dstUI += 3) {
+                    dstUI[0] = floatToUI16(src[0]);
+                    dstUI[1] = floatToUI16(src[1]);
+                    dstUI[2] = floatToUI16(src[2]);
                 }
-                int32_t index = findInPalette(colorBuf, palette, colors);
-                pixData[i] = uint16_t(index < 0 ? 0 : index);
+                break;
             }
-            break;
+            case TextureFormat::RGBA64: {
+                uint16_t* dstUI = reinterpret_cast<uint16_t*>(dst);
+                for (size_t i = 0; i < count * 4; i++) {
+                    dstUI[i] = floatToUI16(src[i]);
+                }
+                break;
+            }
+            default:
+                memcpy(dst, src, count * 16);
+                break;
         }
-        default:
-            JE_CORE_WARN("Couldn't apply palette, invalid texture format! ({0})", getTextureFormatName(format));
-            break;
+    }
+
+    bool convertPixels(TextureFormat srcFmt, TextureFormat dstFmt, const uint8_t* src, uint8_t* dst, size_t count, const uint8_t* palette) {
+        if (srcFmt == TextureFormat::Unknown || srcFmt >= TextureFormat::__Count ||
+            dstFmt == TextureFormat::Unknown || dstFmt >= TextureFormat::__Count) {
+            return false;
         }
+
+        if (srcFmt == dstFmt) {
+            if (src != dst) {
+                memmove(dst, src, count * (getBitsPerPixel(srcFmt) >> 3));
+            }
+            return true;
+        }
+
+        //Indexed targets need a palette to be built, see quantize/applyPalette
+        if (ImageData::isIndexed(dstFmt)) { return false; }
+
+        if (srcFmt == TextureFormat::RGBA32) { return fromRGBA32(dstFmt, src, dst, count); }
+        if (dstFmt == TextureFormat::RGBA32) {
+            toRGBA32(srcFmt, src, dst, count, palette);
+            return true;
+        }
+
+        const size_t srcBpp = getBitsPerPixel(srcFmt) >> 3;
+        const size_t dstBpp = getBitsPerPixel(dstFmt) >> 3;
+
+        //16-bit and float formats convert between each other without going through 8 bits
+        if (isWideFormat(srcFmt) && isWideFormat(dstFmt)) {
+            if (srcFmt == TextureFormat::RGBAF) {
+                fromRGBAF(dstFmt, reinterpret_cast<const float*>(src), dst, count);
+                return true;
+            }
+            if (dstFmt == TextureFormat::RGBAF) {
+                toRGBAF(srcFmt, src, reinterpret_cast<float*>(dst), count);
+                return true;
+            }
+
+            const uint16_t* srcUI = reinterpret_cast<const uint16_t*>(src);
+            uint16_t* dstUI = reinterpret_cast<uint16_t*>(dst);
+            const bool expand = dstFmt == TextureFormat::RGBA64;
+            for (size_t i = 0; i < count; i++, srcUI += srcBpp >> 1, dstUI += dstBpp >> 1) {
+                dstUI[0] = srcUI[0];
+                dstUI[1] = srcUI[1];
+                dstUI[2] = srcUI[2];
+                if (expand) { dstUI[3] = 0xFFFF; }
+            }
+            return true;
+        }
+
+        uint8_t buffer[CONVERT_CHUNK * 4];
+        while (count > 0) {
+            const size_t chunk = count > CONVERT_CHUNK ? CONVERT_CHUNK : count;
+            toRGBA32(srcFmt, src, buffer, chunk, palette);
+            fromRGBA32(dstFmt, buffer, dst, chunk);
+
+            src += chunk * srcBpp;
+            dst += chunk * dstBpp;
+            count -= chunk;
+        }
+        return true;
     }
 
-    int32_t tryBuildPalette(const uint8_t* pixelData, uint32_t width, uint32_t height, TextureFormat format, uint8_t* newTexture, int32_t alphaClip) {
-        switch (format)
-        {
-        case JEngine::TextureFormat::Unknown:
-            JE_CORE_WARN("Couldn't build palette, texture format unknown!");
-            return 0;
-        case JEngine::TextureFormat::Indexed8:
-        case JEngine::TextureFormat::Indexed16:
-            JE_CORE_WARN("Didn't build palette, texture is already indexed!");
-            return 0;
+    void flipRB(uint8_t* data, size_t count, int32_t bpp) {
+        size_t i = 0;
+        switch (bpp) {
+            default: return;
+            case 3:
+#ifdef JE_SIMD_SSSE3
+                for (const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15); i + 6 <= count; i += 5, data += 15) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_shuffle_epi8(v, shuffle));
+                }
+#endif
+                for (; i < count; i++, data += 3) {
+                    std::swap(data[0], data[2]);
+                }
+                break;
+            case 4:
+#ifdef JE_SIMD_SSE2
+                for (const __m128i ga = _mm_set1_epi32(int32_t(0xFF00FF00)), rb = _mm_set1_epi32(0xFF); i + 4 <= count; i += 4, data += 16) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+                    __m128i r = _mm_slli_epi32(_mm_and_si128(v, rb), 16);
+                    __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), rb);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), _mm_or_si128(_mm_and_si128(v, ga), _mm_or_si128(r, b)));
+                }
+#endif
+                for (; i < count; i++, data += 4) {
+                    std::swap(data[0], data[2]);
+                }
+                break;
+            case 6:
+            case 8: {
+                uint16_t* dataUI = reinterpret_cast<uint16_t*>(data);
+                for (const size_t stride = size_t(bpp) >> 1; i < count; i++, dataUI += stride) {
+                    std::swap(dataUI[0], dataUI[2]);
+                }
+                break;
+            }
+            case 16: {
+                float* dataF = reinterpret_cast<float*>(data);
+                for (; i < count; i++, dataF += 4) {
+                    std::swap(dataF[0], dataF[2]);
+                }
+                break;
+            }
+        }
+    }
+
+    // Resampling, images are converted to premultiplied RGBAF once and filtered
+    // separably with precomputed weight tables, one pixel per SSE register.
+    static constexpr int32_t RESAMPLE_BAND = 32;
+
+    struct ResampleWeights {
+        std::vector<int32_t> start{};
+        std::vector<int32_t> count{};
+        std::vector<float> weights{};
+        int32_t taps{ 0 };
+    };
+
+    static float getFilterSupport(ResampleFilter filter) {
+        switch (filter) {
+            default:                         return 0.5f;
+            case ResampleFilter::Triangle:   return 1.0f;
+            case ResampleFilter::Lanczos3:   return 3.0f;
+        }
+    }
+
+    static float evaluateFilter(ResampleFilter filter, float x) {
+        x = std::abs(x);
+        switch (filter) {
+            default:
+                return x < 0.5f ? 1.0f : 0.0f;
+            case ResampleFilter::Triangle:
+                return x < 1.0f ? 1.0f - x : 0.0f;
+            case ResampleFilter::Lanczos3: {
+                if (x < 1e-5f) { return 1.0f; }
+                if (x >= 3.0f) { return 0.0f; }
+                static constexpr float PI = 3.14159265358979f;
+                const float px = PI * x;
+                return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+            }
         }
+    }
+
+    static void buildWeights(int32_t srcSize, int32_t dstSize, ResampleFilter filter, ResampleWeights& table) {
+        const float scale = float(dstSize) / float(srcSize);
+        const float filterScale = scale < 1.0f ? 1.0f / scale : 1.0f;
+        const float support = filter == ResampleFilter::Nearest ? 0.0f : getFilterSupport(filter) * filterScale;
+
+        table.taps = int32_t(std::ceil(support * 2.0f)) + 2;
+        table.start.resize(dstSize);
+        table.count.resize(dstSize);
+        table.weights.assign(size_t(dstSize) * table.taps, 0.0f);
+
+        for (int32_t i = 0; i < dstSize; i++) {
+            const float center = (i + 0.5f) / scale;
+            float* weights = table.weights.data() + size_t(i) * table.taps;
+
+            if (filter == ResampleFilter::Nearest) {
+                table.start[i] = std::min(int32_t(center), srcSize - 1);
+                table.count[i] = 1;
+                weights[0] = 1.0f;
+                continue;
+            }
+
+            const int32_t left = std::max(int32_t(std::floor(center - support)), 0);
+            const int32_t right = std::min(int32_t(std::ceil(center + support)), srcSize);
+
+            float sum = 0;
+            for (int32_t j = left; j < right; j++) {
+                const float w = evaluateFilter(filter, (j + 0.5f - center) / filterScale);
+                weights[j - left] = w;
+                sum += w;
+            }
 
-        int32_t colCount = 0;
-        JColor32 buffer{};
+            //Filter missed every sample, fall back to the closest one
+            if (std::abs(sum) < 1e-6f) {
+                std::fill(weights, weights + table.taps, 0.0f);
+                table.start[i] = std::min(int32_t(center), srcSize - 1);
+                table.count[i] = 1;
+                weights[0] = 1.0f;
+                continue;
+            }
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newTexture);
-        for (size_t i = 0; i < 256; i++) {
-            palette[i].a = 0xFF;
+            for (int32_t j = left; j < right; j++) {
+                weights[j - left] /= sum;
+            }
+            table.start[i] = left;
+            table.count[i] = right - left;
         }
+    }
+
+    //Multiplies RGB by alpha in place
+    static inline void premultiplyPixel(float* px) {
+#ifdef JE_SIMD_SSE2
+        const __m128 v = _mm_loadu_ps(px);
+        const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 alpha = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_ps(px, _mm_mul_ps(v, _mm_or_ps(_mm_and_ps(rgbMask, alpha), _mm_andnot_ps(rgbMask, _mm_set1_ps(1.0f)))));
+#else
+        px[0] *= px[3];
+        px[1] *= px[3];
+        px[2] *= px[3];
+#endif
+    }
 
-        uint32_t bpp = getBitsPerPixel(format);
-        uint32_t reso = width * height;
-        uint8_t* newPixData = newTexture + 1024;
-        for (size_t i = 0, j = 0; i < reso; i++, j += bpp) {
-            memcpy(&buffer, pixelData + j, bpp);
-            if (buffer.a <= alphaClip) {
-                *reinterpret_cast<uint32_t*>(&buffer) = 0;
+    //Divides RGB by alpha, RGB of fully transparent pixels becomes 0
+    static inline void unpremultiplyPixel(const float* src, float* dst) {
+        const float inv = src[3] > 0.0f ? 1.0f / src[3] : 0.0f;
+#ifdef JE_SIMD_SSE2
+        const __m128 rgbMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+        const __m128 scale = _mm_or_ps(_mm_and_ps(rgbMask, _mm_set1_ps(inv)), _mm_andnot_ps(rgbMask, _mm_set1_ps(1.0f)));
+        _mm_storeu_ps(dst, _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src), scale), _mm_setzero_ps()));
+#else
+        dst[0] = std::max(0.0f, src[0] * inv);
+        dst[1] = std::max(0.0f, src[1] * inv);
+        dst[2] = std::max(0.0f, src[2] * inv);
+        dst[3] = std::max(0.0f, src[3]);
+#endif
+    }
+
+    //Writes the weighted sum of 'count' RGBAF pixels that are 'stride' floats apart
+    static inline void filterPixel(const float* pix, size_t stride, const float* weights, int32_t count, float* out) {
+#ifdef JE_SIMD_SSE2
+        __m128 acc = _mm_setzero_ps();
+        for (int32_t k = 0; k < count; k++, pix += stride) {
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(pix), _mm_set1_ps(weights[k])));
+        }
+        _mm_storeu_ps(out, acc);
+#else
+        float acc[4]{};
+        for (int32_t k = 0; k < count; k++, pix += stride) {
+            for (size_t c = 0; c < 4; c++) {
+                acc[c] += pix[c] * weights[k];
             }
+        }
+        memcpy(out, acc, sizeof(acc));
+#endif
+    }
 
-            int32_t ind = findInPalette(buffer, palette, colCount);
-            if (ind < 0) {
-                if (colCount >= 256) {
-                    JE_CORE_WARN("Couldn't build palette, too many colors!");
-                    return false;
+    //Converts 'source' to premultiplied RGBAF, block compressed images are decoded to RGBA32 first.
+    static bool imageToFloat(const ImageData& source, std::vector<float>& pixels, uint32_t threads) {
+        ImageData decoded{};
+        const ImageData* input = &source;
+        if (isBlockCompressed(source.format)) {
+            if (!decoded.doAllocate(source.width, source.height, TextureFormat::RGBA32)) { return false; }
+
+            const bool dxt5 = source.format == TextureFormat::DXT5;
+            const size_t rowSize = size_t((source.width + 3) >> 2) * (dxt5 ? 16 : 8);
+            for (int32_t y = 0; y < ((source.height + 3) >> 2); y++) {
+                if (dxt5) {
+                    DXT::decodeDxt5Row(source.data + y * rowSize, decoded, y);
+                }
+                else {
+                    DXT::decodeDxt1Row(source.data + y * rowSize, decoded, y);
                 }
+            }
+            input = &decoded;
+        }
+
+        const size_t width = size_t(input->width);
+        const size_t bpp = getBitsPerPixel(input->format) >> 3;
+        pixels.resize(width * input->height * 4);
 
-                ind = colCount;
-                palette[colCount++] = buffer;
+        const size_t bands = (size_t(input->height) + RESAMPLE_BAND - 1) / RESAMPLE_BAND;
+        Parallel::forEach(bands, threads, [&](size_t band) {
+            const size_t y0 = band * RESAMPLE_BAND;
+            const size_t y1 = std::min<size_t>(y0 + RESAMPLE_BAND, input->height);
+            float* out = pixels.data() + y0 * width * 4;
+            convertPixels(input->format, TextureFormat::RGBAF, input->getData() + y0 * width * bpp, reinterpret_cast<uint8_t*>(out), (y1 - y0) * width, input->data);
+
+            for (size_t i = 0; i < (y1 - y0) * width; i++, out += 4) {
+                premultiplyPixel(out);
             }
-            newPixData[i] = ind;
+        });
+
+        decoded.clear(true);
+        return true;
+    }
+
+    //Writes premultiplied RGBAF pixels into 'target', which is allocated in 'format'.
+    //Indexed targets reuse the palette of 'paletteSource', 'target' can't be the same image.
+    static bool floatToImage(const float* pixels, int32_t width, int32_t height, TextureFormat format, const ImageData& paletteSource, ImageData& target, uint32_t threads) {
+        const bool blocks = isBlockCompressed(format);
+        const bool indexed = ImageData::isIndexed(format);
+        ImageData staging{};
+        ImageData& output = blocks ? staging : target;
+
+        const TextureFormat outFormat = blocks ? TextureFormat::RGBA32 : format;
+        if (indexed) {
+            if (!output.doAllocate(width, height, outFormat, paletteSource.paletteSize, paletteSource.isAligned())) { return false; }
+            memcpy(output.data, paletteSource.data, paletteSource.getPaletteOffset());
+        }
+        else if (!output.doAllocate(width, height, outFormat)) {
+            return false;
+        }
+
+        const size_t bpp = getBitsPerPixel(outFormat) >> 3;
+        const size_t bands = (size_t(height) + RESAMPLE_BAND - 1) / RESAMPLE_BAND;
+        const JColor32* palette = reinterpret_cast<const JColor32*>(output.data);
+        const int32_t colors = indexed ? int32_t(output.getPaletteOffset() / sizeof(JColor32)) : 0;
+
+        Parallel::forEach(bands, threads, [&](size_t band) {
+            const size_t y0 = band * RESAMPLE_BAND;
+            const size_t y1 = std::min<size_t>(y0 + RESAMPLE_BAND, size_t(height));
+            const size_t count = (y1 - y0) * width;
+
+            std::vector<float> row(count * 4);
+            const float* src = pixels + y0 * width * 4;
+            for (size_t i = 0; i < count; i++) {
+                unpremultiplyPixel(src + i * 4, row.data() + i * 4);
+            }
+
+            uint8_t* dst = output.getData() + y0 * width * bpp;
+            if (!indexed) {
+                convertPixels(TextureFormat::RGBAF, outFormat, reinterpret_cast<const uint8_t*>(row.data()), dst, count);
+                return;
+            }
+
+            std::vector<JColor32> colorRow(count);
+            convertPixels(TextureFormat::RGBAF, TextureFormat::RGBA32, reinterpret_cast<const uint8_t*>(row.data()), reinterpret_cast<uint8_t*>(colorRow.data()), count);
+
+            PaletteLookup lookup(palette, colors);
+            for (size_t i = 0; i < count; i++) {
+                const int32_t index = lookup.find(colorRow[i]);
+                if (outFormat == TextureFormat::Indexed16) {
+                    reinterpret_cast<uint16_t*>(dst)[i] = uint16_t(index);
+                }
+                else {
+                    dst[i] = uint8_t(index);
+                }
+            }
+        });
+
+        if (blocks) {
+            ImageEncodeParams params{};
+            params.flags = F_IMG_ENC_MULTITHREAD;
+            params.threads = threads;
+            const bool ok = DXT::compress(staging, target, format, params);
+            staging.clear(true);
+            return ok;
         }
-        return colCount;
+        return true;
     }
 
+    static void resampleFloat(const float* src, int32_t srcW, int32_t srcH, float* dst, int32_t dstW, int32_t dstH, ResampleFilter filter, uint32_t threads) {
+        ResampleWeights horizontal{};
+        ResampleWeights vertical{};
+        buildWeights(srcW, dstW, filter, horizontal);
+        buildWeights(srcH, dstH, filter, vertical);
+
+        //Every band filters the source rows it needs horizontally, then runs the vertical pass on those
+        const size_t bands = (size_t(dstH) + RESAMPLE_BAND - 1) / RESAMPLE_BAND;
+        Parallel::forEach(bands, threads, [&](size_t band) {
+            const int32_t y0 = int32_t(band * RESAMPLE_BAND);
+            const int32_t y1 = std::min(y0 + RESAMPLE_BAND, dstH);
+
+            int32_t rowBegin = srcH;
+            int32_t rowEnd = 0;
+            for (int32_t y = y0; y < y1; y++) {
+                rowBegin = std::min(rowBegin, vertical.start[y]);
+                rowEnd = std::max(rowEnd, vertical.start[y] + vertical.count[y]);
+            }
 
-    bool tryBuildPalette(const uint8_t* pixelData, int32_t start, int32_t length, int32_t& colors, int32_t bpp, uint8_t* newTexture, int32_t alphaClip) {
-        JColor32 buffer{ 0,0,0,0xFF };
+            std::vector<float> rows(size_t(rowEnd - rowBegin) * dstW * 4);
+            for (int32_t sy = rowBegin; sy < rowEnd; sy++) {
+                const float* srcRow = src + size_t(sy) * srcW * 4;
+                float* out = rows.data() + size_t(sy - rowBegin) * dstW * 4;
+                for (int32_t x = 0; x < dstW; x++, out += 4) {
+                    const float* weights = horizontal.weights.data() + size_t(x) * horizontal.taps;
+                    filterPixel(srcRow + size_t(horizontal.start[x]) * 4, 4, weights, horizontal.count[x], out);
+                }
+            }
 
-        JColor32* palette = reinterpret_cast<JColor32*>(newTexture);
-        uint8_t* newPix = (newTexture + 1024);
-        for (size_t i = 0, j = 0, k = start; i < length; i++, j += bpp, k++) {
-            memcpy(&buffer, pixelData + j, bpp);
-            if (buffer.a <= alphaClip) {
-                *reinterpret_cast<uint32_t*>(&buffer) = 0;
+            for (int32_t y = y0; y < y1; y++) {
+                const float* weights = vertical.weights.data() + size_t(y) * vertical.taps;
+                const float* base = rows.data() + size_t(vertical.start[y] - rowBegin) * dstW * 4;
+                float* out = dst + size_t(y) * dstW * 4;
+                for (int32_t x = 0; x < dstW; x++) {
+                    filterPixel(base + size_t(x) * 4, size_t(dstW) * 4, weights, vertical.count[y], out + size_t(x) * 4);
+                }
             }
-            int32_t ind = findInPalette(buffer, palette, colors);
-            if (ind < 0) {
-                if (colors >= 256) {
-                    JE_CORE_WARN("Couldn't build palette, too many colors!");
-                    return false;
+        });
+    }
+
+    bool resample(const ImageData& source, ImageData& target, int32_t newWidth, int32_t newHeight, ResampleFilter filter, uint32_t threads) {
+        if (!source.data || source.width < 1 || source.height < 1 || newWidth < 1 || newHeight < 1 ||
+            source.format == TextureFormat::Unknown) {
+            return false;
+        }
+
+        threads = Parallel::getWorkerCount(threads);
+
+        //Nearest doesn't need to blend anything, so per pixel formats just copy pixels over
+        if (filter == ResampleFilter::Nearest && !isBlockCompressed(source.format)) {
+            ImageData result{};
+            if (!result.doAllocate(newWidth, newHeight, source.format, source.paletteSize, source.isAligned())) { return false; }
+            memcpy(result.data, source.data, source.getPaletteOffset());
+
+            ResampleWeights horizontal{};
+            ResampleWeights vertical{};
+            buildWeights(source.width, newWidth, filter, horizontal);
+            buildWeights(source.height, newHeight, filter, vertical);
+
+            const size_t bpp = getBitsPerPixel(source.format) >> 3;
+            const uint8_t* src = source.getData();
+            uint8_t* dst = result.getData();
+            Parallel::forEach(size_t(newHeight), threads, [&](size_t y) {
+                const uint8_t* srcRow = src + size_t(vertical.start[y]) * source.width * bpp;
+                uint8_t* dstRow = dst + y * newWidth * bpp;
+                for (int32_t x = 0; x < newWidth; x++, dstRow += bpp) {
+                    memcpy(dstRow, srcRow + size_t(horizontal.start[x]) * bpp, bpp);
                 }
+            });
+
+            result.filter[0] = source.filter[0];
+            result.filter[1] = source.filter[1];
+            result.wrap[0] = source.wrap[0];
+            result.wrap[1] = source.wrap[1];
+            target.clear(true);
+            target = result;
+            return true;
+        }
+
+        std::vector<float> srcPixels{};
+        if (!imageToFloat(source, srcPixels, threads)) { return false; }
+
+        std::vector<float> dstPixels(size_t(newWidth) * newHeight * 4);
+        resampleFloat(srcPixels.data(), source.width, source.height, dstPixels.data(), newWidth, newHeight, filter, threads);
+        srcPixels = {};
+
+        ImageData result{};
+        if (!floatToImage(dstPixels.data(), newWidth, newHeight, source.format, source, result, threads)) {
+            result.clear(true);
+            return false;
+        }
+
+        result.filter[0] = source.filter[0];
+        result.filter[1] = source.filter[1];
+        result.wrap[0] = source.wrap[0];
+        result.wrap[1] = source.wrap[1];
+        target.clear(true);
+        target = result;
+        return true;
+    }
+
+    bool generateMipChain(const ImageData& source, std::vector<ImageData>& mips, ResampleFilter filter, uint32_t threads) {
+        mips.clear();
+        if (!source.data || source.width < 1 || source.height < 1 || source.format == TextureFormat::Unknown) {
+            return false;
+        }
+
+        threads = Parallel::getWorkerCount(threads);
+
+        std::vector<float> current{};
+        if (!imageToFloat(source, current, threads)) { return false; }
+
+        std::vector<float> next{};
+        int32_t width = source.width;
+        int32_t height = source.height;
+        while (width > 1 || height > 1) {
+            const int32_t mipW = std::max(width >> 1, 1);
+            const int32_t mipH = std::max(height >> 1, 1);
 
-                palette[colors] = buffer;
-                ind = colors++;
+            next.resize(size_t(mipW) * mipH * 4);
+            resampleFloat(current.data(), width, height, next.data(), mipW, mipH, filter, threads);
+
+            ImageData& mip = mips.emplace_back();
+            if (!floatToImage(next.data(), mipW, mipH, source.format, source, mip, threads)) {
+                for (auto& level : mips) {
+                    level.clear(true);
+                }
+                mips.clear();
+                return false;
             }
-            newPix[k] = uint8_t(ind);
+            mip.filter[0] = source.filter[0];
+            mip.filter[1] = source.filter[1];
+            mip.wrap[0] = source.wrap[0];
+            mip.wrap[1] = source.wrap[1];
+
+            std::swap(current, next);
+            width = mipW;
+            height = mipH;
         }
         return true;
     }
@@ -332,168 +1327,36 @@ namespace JEngine {
     }
 
     void ImageData::resize(int32_t newWidth, int32_t newHeight, bool linear, ImageData* tempBuffer) {
-        if ((newWidth == width && newHeight == height) || ((newHeight & newWidth) & 0x7FFFFFFF) == 0 || !data) { return; }
+        resize(newWidth, newHeight, linear ? ResampleFilter::Triangle : ResampleFilter::Nearest, tempBuffer);
+    }
+
+    void ImageData::resize(int32_t newWidth, int32_t newHeight, ResampleFilter filter, ImageData* tempBuffer) {
+        if ((newWidth == width && newHeight == height) || newWidth < 1 || newHeight < 1 || !data) { return; }
 
         ImageData tmpIM{};
         ImageData& tmp = tempBuffer ? *tempBuffer : tmpIM;
-
-        int32_t oldW = width;
-        int32_t oldH = height;
-
-        int32_t bpp = (getBitsPerPixel(format) >> 3);
-        int32_t resoNew = newWidth * newHeight;
-        int32_t resoOld = width * height;
-
-        if (!tmp.doAllocate(width, height, format, paletteSize, flags)) {
-            return;
-        }
-        memcpy(tmp.data, data, getSize());
-
-        if (!doAllocate(newWidth, newHeight, format)) {
-            width = oldW;
-            height = oldH;
-
-            if (!tempBuffer) {
-                tmp.clear(true);
-            }
+        if (!resample(*this, tmp, newWidth, newHeight, filter)) {
+            JE_CORE_WARN("Couldn't resize image to {0}x{1}!", newWidth, newHeight);
             return;
         }
-        switch (format)
-        {
-        default:
-            linear = false;
-            break;
-        case TextureFormat::RGB24:
-        case TextureFormat::RGBA32:
-            break;
-        }
-
-
-        int32_t scan = newWidth * bpp;
-        int32_t scanOld = oldW * bpp;
-        if (linear) {
-            const uint8_t* bufferIn = tmp.getData();
-            uint8_t* bufferOut = this->getData();
-            JColor32 clr32[4]{
-                {0x00, 0x00, 0x00, 0x00},
-                {0x00, 0x00, 0x00, 0x00},
-                {0x00, 0x00, 0x00, 0x00},
-                {0x00, 0x00, 0x00, 0x00},
-            };
-
-            float xs = (float)oldW / width;
-            float ys = (float)oldH / height;
-
-            float fracx{ 0 }, fracy{ 0 }, ifracx{ 0 }, ifracy{ 0 }, sx{ 0 }, sy{ 0 }, l0{ 0 }, l1{ 0 }, rf{ 0 }, gf{ 0 }, bf{ 0 };
-            int32_t  x0{ 0 }, x1{ 0 }, y0{ 0 }, y1{ 0 };
-
-            JColor32 out{ 0x00, 0x00, 0x00, 0xFF };
-
-            int32_t srcIdx = 0;
-
-            for (int32_t y = 0, yP = 0; y < newHeight; y++, yP += scan) {
-                for (int32_t x = 0, xP = yP; x < newWidth; x++, xP += bpp) {
-                    sx = x * xs;
-                    sy = y * ys;
-                    x0 = (int)sx;
-                    y0 = (int)sy;
-
-                    // Calculate coordinates of the 4 interpolation points
-                    fracx = sx - x0;
-                    fracy = sy - y0;
-                    ifracx = 1.0f - fracx;
-                    ifracy = 1.0f - fracy;
-                    x1 = x0 + 1;
-                    if (x1 >= oldW)
-                    {
-                        x1 = x0;
-                    }
-                    y1 = y0 + 1;
-                    if (y1 >= oldH)
-                    {
-                        y1 = y0;
-                    }
-
-                    // Read source color
-                    const uint8_t* c = (bufferIn + (y0 * scanOld) + x0 * bpp);
-                    memcpy(clr32 + 0, c, bpp);
-
-                    c = bufferIn + (y0 * scanOld + x1 * bpp);
-                    memcpy(clr32 + 1, c, bpp);
-
-                    c = bufferIn + (y1 * scanOld + x0 * bpp);
-                    memcpy(clr32 + 2, c, bpp);
-
-                    c = bufferIn + (y1 * scanOld + x1 * bpp);
-                    memcpy(clr32 + 3, c, bpp);
-
-                    // Calculate colors
-                    // Alpha
-                    l0 = ifracx * clr32[0].a + fracx * clr32[1].a;
-                    l1 = ifracx * clr32[2].a + fracx * clr32[3].a;
-                    out.a = uint8_t(ifracy * l0 + fracy * l1);
-
-                    // Write destination
-                    if (out.a > 0)
-                    {
-                        // Red
-                        l0 = ifracx * clr32[0].r + fracx * clr32[1].r;
-                        l1 = ifracx * clr32[2].r + fracx * clr32[3].r;
-                        rf = ifracy * l0 + fracy * l1;
-
-                        // Green
-                        l0 = ifracx * clr32[0].g + fracx * clr32[1].g;
-                        l1 = ifracx * clr32[2].g + fracx * clr32[3].g;
-                        gf = ifracy * l0 + fracy * l1;
-
-                        // Blue
-                        l0 = ifracx * clr32[0].b + fracx * clr32[1].b;
-                        l1 = ifracx * clr32[2].b + fracx * clr32[3].b;
-                        bf = ifracy * l0 + fracy * l1;
-
-                        // Cast to byte
-                        out.r = uint8_t(Math::clamp(rf, 0.0f, 255.0f));
-                        out.g = uint8_t(Math::clamp(gf, 0.0f, 255.0f));
-                        out.b = uint8_t(Math::clamp(bf, 0.0f, 255.0f));
-                    }
-                    else
-                    {
-                        out.r = 0x00;
-                        out.g = 0x00;
-                        out.b = 0x00;
-                        out.a = 0x00;
-                    }
-                    memcpy(bufferOut + xP, &out, bpp);
-                }
-            }
-        }
-        else {
-            const uint8_t* bufferIn = tmp.getData();
-            uint8_t* bufferOut = this->getData();
-            for (size_t y = 0, yP = 0; y < newHeight; y++, yP += scan) {
-                int32_t srY = int32_t((oldH - 1) * (y / float(newHeight - 1.0f))) * scanOld;
-                for (int32_t x = 0, xP = yP; x < newWidth; x++, xP += bpp) {
-                    int32_t srX = ((oldW - 1) * x / float(newWidth - 1.0f)) * bpp;
-                    memcpy(bufferOut + xP, bufferIn + srY + srX, bpp);
-                }
-            }
-        }
-
 
+        //The old pixels end up in 'tmp', which gets freed unless the caller gave it
+        std::swap(*this, tmp);
         if (!tempBuffer) {
             tmp.clear(true);
         }
     }
 
     void ImageData::replaceData(uint8_t* newData, bool destroy) {
-        if (destroy && data) {
+        if (destroy && data && !isView()) {
             free(data);
         }
         data = newData;
+        flags &= ~IMG_FLAG_VIEW;
     }
 
     void ImageData::clear(bool destroy) {
-        if (destroy && data) {
+        if (destroy && data && !isView()) {
             free(data);
         }
         data = nullptr;
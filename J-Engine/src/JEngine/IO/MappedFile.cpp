@@ -0,0 +1,115 @@
+#include <JEngine/IO/MappedFile.h>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : _file(INVALID_HANDLE_VALUE), _mapping(nullptr), _data(nullptr), _size(0) {}
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    _file(std::exchange(other._file, INVALID_HANDLE_VALUE)),
+    _mapping(std::exchange(other._mapping, nullptr)),
+    _data(std::exchange(other._data, nullptr)),
+    _size(std::exchange(other._size, 0)) {}
+#else
+MappedFile::MappedFile() : _file(-1), _data(nullptr), _size(0) {}
+MappedFile::MappedFile(MappedFile&& other) noexcept :
+    _file(std::exchange(other._file, -1)),
+    _data(std::exchange(other._data, nullptr)),
+    _size(std::exchange(other._size, 0)) {}
+#endif
+
+MappedFile::MappedFile(const char* filepath) : MappedFile() {
+    open(filepath);
+}
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(_file, other._file);
+#ifdef _WIN32
+        std::swap(_mapping, other._mapping);
+#endif
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const char* filepath) {
+    close();
+    if (!filepath) { return false; }
+
+#ifdef _WIN32
+    _file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(_file, &size) || size.QuadPart < 1) {
+        close();
+        return false;
+    }
+
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!_mapping) {
+        close();
+        return false;
+    }
+
+    _data = reinterpret_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+    _size = size_t(size.QuadPart);
+#else
+    _file = ::open(filepath, O_RDONLY);
+    if (_file < 0) { return false; }
+
+    struct stat info {};
+    if (fstat(_file, &info) != 0 || info.st_size < 1) {
+        close();
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    _data = mapped == MAP_FAILED ? nullptr : reinterpret_cast<const uint8_t*>(mapped);
+    _size = size_t(info.st_size);
+#endif
+
+    if (!_data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (_data) {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+        CloseHandle(_mapping);
+    }
+    if (_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(_file);
+    }
+    _file = INVALID_HANDLE_VALUE;
+    _mapping = nullptr;
+#else
+    if (_data) {
+        munmap(const_cast<uint8_t*>(_data), _size);
+    }
+    if (_file >= 0) {
+        ::close(_file);
+    }
+    _file = -1;
+#endif
+    _data = nullptr;
+    _size = 0;
+}
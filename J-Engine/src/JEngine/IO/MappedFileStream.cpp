@@ -0,0 +1,85 @@
+#include <JEngine/IO/MappedFileStream.h>
+#include <algorithm>
+#include <utility>
+
+MappedFileStream::MappedFileStream() : Stream(), _file() {}
+MappedFileStream::MappedFileStream(const char* filepath) : Stream(), _file() {
+    open(filepath);
+}
+
+MappedFileStream::MappedFileStream(MappedFileStream&& other) noexcept :
+    Stream(std::exchange(other._flags, 0), std::exchange(other._length, 0), std::exchange(other._capacity, 0)),
+    _file(std::move(other._file))
+{
+    _position = std::exchange(other._position, 0);
+}
+
+MappedFileStream::~MappedFileStream() { close(); }
+
+MappedFileStream& MappedFileStream::operator=(MappedFileStream&& other) noexcept {
+    if (this != &other) {
+        _flags = std::exchange(other._flags, 0);
+        _position = std::exchange(other._position, 0);
+        _length = std::exchange(other._length, 0);
+        _capacity = std::exchange(other._capacity, 0);
+        _file = std::move(other._file);
+    }
+    return *this;
+}
+
+bool MappedFileStream::open(const char* filepath) const {
+    close();
+    if (!_file.open(filepath)) { return false; }
+
+    _flags = READ_FLAG;
+    _length = _file.size();
+    _capacity = _length;
+    return true;
+}
+
+bool MappedFileStream::close() const {
+    if (isOpen()) {
+        _file.close();
+        _flags = 0;
+        _position = 0;
+        _length = 0;
+        _capacity = 0;
+        return true;
+    }
+    return false;
+}
+
+size_t MappedFileStream::read(void* buffer, size_t elementSize, size_t count, const bool bigEndian) const {
+    if (!canRead() || elementSize < 1) { return 0; }
+
+    count = std::min(count, (_length - _position) / elementSize);
+    size_t size = elementSize * count;
+    memcpy(buffer, _file.data() + _position, size);
+    if (bigEndian) {
+        JEngine::Data::reverseEndianess(reinterpret_cast<uint8_t*>(buffer), elementSize, count);
+    }
+    _position += size;
+    return size;
+}
+
+size_t MappedFileStream::seek(int64_t offset, int origin) const {
+    if (isOpen()) {
+        switch (origin) {
+            case SEEK_CUR:
+                _position = offset < 0 && size_t(-offset) > _position ? 0 : std::min<size_t>(_position + offset, _length);
+                break;
+            case SEEK_SET:
+                _position = offset < 0 ? 0 : std::min<size_t>(size_t(offset), _length);
+                break;
+            case SEEK_END:
+                _position = offset < 0 || size_t(offset) > _length ? 0 : _length - size_t(offset);
+                break;
+        }
+    }
+    return _position;
+}
+
+JEngine::Span<const uint8_t> MappedFileStream::view(size_t offset, size_t size) const {
+    if (!isOpen() || offset >= _length) { return JEngine::Span<const uint8_t>(); }
+    return JEngine::Span<const uint8_t>(_file.data() + offset, std::min(size, _length - offset));
+}
@@ -39,6 +39,7 @@ size_t MemoryStream::write(const void* buffer, const size_t elementSize, const s
         JEngine::Data::reverseEndianess(_buffer + _position, elementSize, count);
     }
     _position += size;
+    _length = _position > _length ? _position : _length;
     return size;
 }
 
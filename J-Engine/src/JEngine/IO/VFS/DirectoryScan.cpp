@@ -0,0 +1,196 @@
+#include <JEngine/IO/VFS/DirectoryScan.h>
+#include <JEngine/Core/Log.h>
+#include <JEngine/Utility/Parallel.h>
+#include <algorithm>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
+
+namespace JEngine {
+    static constexpr uint32_t SCAN_SIG = 0x4353564AU;
+    static constexpr uint32_t SCAN_VERSION = 1;
+
+    //Sanity limits for loading, a corrupted count shouldn't turn into a huge allocation
+    static constexpr uint32_t SCAN_MAX_ITEMS = 1U << 24;
+    static constexpr uint32_t SCAN_MAX_NAME = 4096;
+
+    static uint64_t toModTime(const fs::file_time_type& time) {
+        return uint64_t(time.time_since_epoch().count());
+    }
+
+    static void listDirectory(const fs::path& path, ScanDir& dir) {
+        std::error_code ec{};
+        for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+            const auto& entry = *it;
+            std::error_code entEc{};
+
+            ScanItem item{};
+            if (entry.is_regular_file(entEc)) {
+                item.type = IO::F_TYPE_FILE;
+                item.size = uint64_t(entry.file_size(entEc));
+            }
+            else if (entry.is_directory(entEc)) {
+                item.type = IO::F_TYPE_FOLDER;
+            }
+            else {
+                continue;
+            }
+
+            item.modTime = toModTime(entry.last_write_time(entEc));
+            item.name = entry.path().filename().string();
+            dir.items.emplace_back(std::move(item));
+        }
+
+        std::sort(dir.items.begin(), dir.items.end(), [](const ScanItem& lhs, const ScanItem& rhs) { return lhs.name < rhs.name; });
+    }
+
+    bool DirectoryScan::scan(ConstSpan<char> root, const DirectoryScan* previous, uint32_t threads) {
+        clear();
+        _root = std::string(root.get(), root.length());
+        IO::fixPath(_root);
+        while (_root.length() > 1 && _root.back() == '/') {
+            _root.pop_back();
+        }
+
+        if (_root.length() < 1 || !IO::exists(_root)) {
+            JE_CORE_ERROR("[DirectoryScan] Error: Can't scan '{0}', the directory doesn't exist!", _root);
+            return false;
+        }
+
+        //A listing from another root can't be reused
+        std::unordered_map<std::string_view, size_t> prevDirs{};
+        if (previous && IO::pathsAreEqual(previous->_root, _root)) {
+            prevDirs.reserve(previous->_dirs.size());
+            for (size_t i = 0; i < previous->_dirs.size(); i++) {
+                prevDirs.emplace(previous->_dirs[i].path, i);
+            }
+        }
+
+        std::atomic<size_t> rescanned{ 0 };
+        std::vector<size_t> level{};
+        std::vector<size_t> nextLevel{};
+
+        _dirs.emplace_back();
+        level.push_back(0);
+        while (level.size() > 0) {
+            Parallel::forEach(level.size(), threads, [&](size_t i) {
+                ScanDir& dir = _dirs[level[i]];
+                fs::path path = dir.path.length() > 0 ? fs::path(_root + '/' + dir.path) : fs::path(_root);
+
+                std::error_code ec{};
+                dir.modTime = toModTime(fs::last_write_time(path, ec));
+
+                auto prev = prevDirs.find(dir.path);
+                if (!ec && prev != prevDirs.end() && previous->_dirs[prev->second].modTime == dir.modTime) {
+                    dir.items = previous->_dirs[prev->second].items;
+                    return;
+                }
+                listDirectory(path, dir);
+                rescanned++;
+            });
+
+            //Sub directories are appended in the same order every run, the parallel part above never touches '_dirs' itself
+            nextLevel.clear();
+            for (size_t dirI : level) {
+                for (size_t i = 0; i < _dirs[dirI].items.size(); i++) {
+                    if (!_dirs[dirI].items[i].isFolder()) { continue; }
+
+                    uint32_t index = uint32_t(_dirs.size());
+                    _dirs[dirI].items[i].dir = index;
+                    nextLevel.push_back(index);
+
+                    ScanDir& sub = _dirs.emplace_back();
+                    const ScanDir& parent = _dirs[dirI];
+                    sub.path = parent.path.length() > 0 ? parent.path + '/' + parent.items[i].name : parent.items[i].name;
+                }
+            }
+            std::swap(level, nextLevel);
+        }
+        _rescanned = rescanned;
+        return true;
+    }
+
+    bool DirectoryScan::save(const Stream& stream) const {
+        if (!stream.canWrite()) {
+            JE_CORE_ERROR("[DirectoryScan] Error: Can't save a scan, given stream isn't writable!");
+            return false;
+        }
+
+        stream.writeValue(SCAN_SIG);
+        stream.writeValue(SCAN_VERSION);
+        stream.writeString(_root);
+        stream.writeValue(uint32_t(_dirs.size()));
+        for (const auto& dir : _dirs) {
+            stream.writeString(dir.path);
+            stream.writeValue(dir.modTime);
+            stream.writeValue(uint32_t(dir.items.size()));
+            for (const auto& item : dir.items) {
+                stream.writeString(item.name);
+                stream.writeValue(item.type);
+                stream.writeValue(item.size);
+                stream.writeValue(item.modTime);
+            }
+        }
+        return stream.flush();
+    }
+
+    bool DirectoryScan::load(const Stream& stream) {
+        clear();
+
+        uint32_t sig = 0;
+        uint32_t version = 0;
+        if (!stream.canRead() || stream.readValue(sig, false) != sizeof(sig) || sig != SCAN_SIG) {
+            JE_CORE_ERROR("[DirectoryScan] Error: Given stream isn't a directory scan!");
+            return false;
+        }
+
+        stream.readValue(version, false);
+        if (version != SCAN_VERSION) {
+            JE_CORE_WARN("[DirectoryScan] Warning: Scan version {0} isn't supported, it will be rebuilt!", version);
+            return false;
+        }
+
+        auto readName = [&stream](std::string& str) {
+            uint32_t len = 0;
+            if (stream.readValue(len, false) != sizeof(len) || len > SCAN_MAX_NAME || stream.isEOF(len)) { return false; }
+            str = stream.readString(len);
+            return true;
+        };
+
+        uint32_t dirCount = 0;
+        if (!readName(_root) || stream.readValue(dirCount, false) != sizeof(dirCount) || dirCount > SCAN_MAX_ITEMS) {
+            goto invalid;
+        }
+
+        _dirs.resize(dirCount);
+        for (auto& dir : _dirs) {
+            uint32_t itemCount = 0;
+            if (!readName(dir.path) || stream.readValue(dir.modTime, false) != sizeof(dir.modTime) ||
+                stream.readValue(itemCount, false) != sizeof(itemCount) || itemCount > SCAN_MAX_ITEMS) {
+                goto invalid;
+            }
+
+            dir.items.resize(itemCount);
+            for (auto& item : dir.items) {
+                if (!readName(item.name) ||
+                    stream.readValue(item.type, false) != sizeof(item.type) ||
+                    stream.readValue(item.size, false) != sizeof(item.size) ||
+                    stream.readValue(item.modTime, false) != sizeof(item.modTime)) {
+                    goto invalid;
+                }
+            }
+        }
+        return true;
+
+    invalid:
+        JE_CORE_ERROR("[DirectoryScan] Error: Directory scan is truncated or corrupted!");
+        clear();
+        return false;
+    }
+
+    void DirectoryScan::clear() {
+        _root.clear();
+        _dirs.clear();
+        _rescanned = 0;
+    }
+}
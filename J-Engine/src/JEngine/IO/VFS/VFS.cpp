@@ -2,12 +2,17 @@
 #include <JEngine/Utility/StringHelpers.h>
 
 namespace JEngine {
-    VFS::VFS() : _rootPath(), _root(), _entries{}, _sources{}  {}
+    VFS::VFS() : _flags(VFS_FLAG_NONE), _rootPath(), _root(), _entries{}, _sources{}, _paks{}, _pathIndex{}, _pathCollisions(0), _sourceIndex{} {
+        FileEntry* rootEnt{ nullptr };
+
+        _root = FileID(uint32_t(_entries.getNext(&rootEnt)), true);
+        rootEnt->setup(_root, FileID(), ConstSpan<char>(), FileEntry::NULL_SOURCE, FOLDER_EINF);
+    }
 
-    VFS::VFS(ConstSpan<char> root, uint32_t flags) : _flags(flags), _rootPath(root.get(), root.get() + root.length()), _root(), _entries{}, _sources{} {
+    VFS::VFS(ConstSpan<char> root, uint32_t flags) : _flags(flags), _rootPath(root.get(), root.get() + root.length()), _root(), _entries{}, _sources{}, _paks{}, _pathIndex{}, _pathCollisions(0), _sourceIndex{} {
         FileEntry* rootEnt{ nullptr };
         
-        _root = FileID(_entries.getNext(&rootEnt));
+        _root = FileID(uint32_t(_entries.getNext(&rootEnt)), true);
 
         IO::fixPath(_rootPath);
         ConstSpan<char> temp(_rootPath.c_str(), _rootPath.length());
@@ -15,16 +20,25 @@ namespace JEngine {
         rootEnt->setup(_root, FileID(), _rootSpan.slice(_rootSpan.indexOfLast('/') + 1), SIZE_MAX, FOLDER_EINF);
     }
 
-    VFS::~VFS() { }
+    VFS::~VFS() {
+        _entries.clear(true);
+        _sources.clear(true);
+    }
 
     void VFS::changeRoot(ConstSpan<char> root, uint32_t flags) {
+        bool caseChanged = ((_flags ^ flags) & VFS_FLAG_CASE_SENSITIVE) != 0;
+        _flags = flags;
+
+        //Index keys are relative to the root so only a change in case sensitivity requires rehashing
+        if (caseChanged) {
+            rebuildIndex();
+        }
+
         if(Helpers::strIEquals(root, _rootPath)) {
             JE_CORE_WARN("[VFS] Warning: Given root path is already setup! Nothing changed.");
             return;
         }
 
-        _flags = flags;
-
         char* tempBuf = reinterpret_cast<char*>(_malloca(root.length() + 1));
         if (!tempBuf) { return; }
         tempBuf[root.length()] = 0;
@@ -63,6 +77,8 @@ namespace JEngine {
             }
         }
 
+        rebuildSourceIndex();
+
         FileEntry* rootE = getEntryByRef(_root);
 
         int32_t lastSlash = newRoot.indexOfLast('/');
@@ -75,26 +91,52 @@ namespace JEngine {
         _freea(tempBuf);
     }
 
-    bool VFS::buildFromRoot() {
-        if (_rootSpan.length() < 1 || !IO::exists(_rootSpan)) {
+    bool VFS::buildFromRoot(const char* snapshotPath, uint32_t threads) {
+        if (_rootSpan.length() < 1 || !IO::exists(_rootPath)) {
             JE_CORE_ERROR("[VFS] Error: Failed to build VFS from root path '{0}' (Either the given directory doesn't exist or path string is empty)", _rootPath.c_str());
             return false; 
         }
 
-        fs::path rootP(_rootSpan.get(), _rootSpan.get() + _rootSpan.length());
-        std::vector<IO::FilePath> paths{};
-        std::string temp{};
-        temp.reserve(260);
-        if (IO::getAll(rootP, IO::F_TYPE_ALL, paths, true)) {
-            for (auto& pth : paths) {
-                bool isFile = pth.type == IO::F_TYPE_FILE;
-                temp = pth.path.string();
-                addEntry(-1, temp, isFile ? FILE_EINF : FOLDER_EINF);
+        DirectoryScan previous{};
+        bool hasPrevious = false;
+        if (snapshotPath) {
+            FileStream stream(snapshotPath, "rb");
+            hasPrevious = stream.isOpen() && previous.load(stream);
+        }
+
+        DirectoryScan scan{};
+        if (!scan.scan(_rootPath, hasPrevious ? &previous : nullptr, threads)) { return false; }
+
+        std::string path = scan.getRoot();
+        mergeScan(scan, 0, _root, IO::PATH_HASH_SEED, path);
+
+        if (snapshotPath) {
+            FileStream stream(snapshotPath, "wb");
+            if (!stream.isOpen() || !scan.save(stream)) {
+                JE_CORE_WARN("[VFS] Warning: Failed to write VFS snapshot '{0}'!", snapshotPath);
             }
         }
+        JE_CORE_TRACE("[VFS] Built '{0}', listed {1}/{2} directories", _rootPath, scan.getRescannedCount(), scan.getDirectories().size());
         return true;
     }
 
+    void VFS::mergeScan(const DirectoryScan& scan, size_t dirIndex, FileID parent, uint64_t hash, std::string& path) {
+        size_t baseLen = path.length();
+        for (const auto& item : scan.getDirectories()[dirIndex].items) {
+            path.append(1, '/').append(item.name);
+
+            ConstSpan<char> name(item.name.c_str(), item.name.length());
+            uint32_t source = item.isFolder() ? FileEntry::NULL_SOURCE : addSourceFile(ConstSpan<char>(path.c_str(), path.length()));
+            uint64_t itemHash = hashChild(hash, name);
+            FileID id = addChild(parent, itemHash, name, source, item.isFolder() ? FOLDER_EINF : FILE_EINF);
+
+            if (id.isFolder() && item.dir != ScanItem::NO_DIR) {
+                mergeScan(scan, item.dir, id, itemHash, path);
+            }
+            path.resize(baseLen);
+        }
+    }
+
     FileID VFS::addEntry(uint32_t source, ConstSpan<char> path, EntryInfo dataInfo, bool* addedNew) {
         if (addedNew) {
             *addedNew = false;
@@ -102,95 +144,54 @@ namespace JEngine {
         
         size_t len = path.length();
         char* tempBuf = reinterpret_cast<char*>(_malloca(len + 1));
-        if (!tempBuf) { return false; }
+        if (!tempBuf) { return FileID(); }
         tempBuf[len] = 0;
         memcpy(tempBuf, path.get(), len);
-        Span<char> pathSpn(tempBuf, len);
-        IO::fixPath(pathSpn);
-
-        if (source < 0 && dataInfo == FILE_EINF) {
-            source = indexOfSourceFile(pathSpn);
-            if (source < 0) {
-                FileStream* strm{ nullptr };
-                source = _sources.getNext(&strm);
-                if (strm) {
-                    strm->setFilepath(pathSpn.get(), pathSpn.length());
-                }
-            }
-        }
+        IO::fixPath(Span<char>(tempBuf, len));
+        ConstSpan<char> pathSpn(tempBuf, len);
 
-        if (source < 0 && dataInfo == FILE_EINF) {
-            JE_CORE_WARN("[VFS] Warning: Given path '{0}' couldn't be added! (File source is invalid, if part of a JPAK add the file beforehand)", tempBuf);
-            goto failure;
+        if (source == FileEntry::NULL_SOURCE && dataInfo == FILE_EINF) {
+            source = addSourceFile(pathSpn);
         }
 
-        size_t rootP = Helpers::indexOf(pathSpn, _rootSpan);
-        if (rootP != SIZE_MAX) {
-            pathSpn = pathSpn.slice(rootP + _rootSpan.length());
+        if (source == FileEntry::NULL_SOURCE && dataInfo == FILE_EINF) {
+            JE_CORE_WARN("[VFS] Warning: Given path '{0}' couldn't be added! (File source is invalid, if part of a JPAK add the file beforehand)", tempBuf);
+            _freea(tempBuf);
+            return FileID();
         }
 
-        FileEntry* root = getRoot();
+        pathSpn = toRelative(pathSpn);
 
-        FileEntry* current = root;
+        FileEntry* current = getRoot();
         size_t slashCount = pathSpn.getOccurenceCount('/') + 1;
         size_t partCount = 0;
-        Span<char>* pathParts = reinterpret_cast<Span<char>*>(_malloca(slashCount * sizeof(Span<char>)));
+        ConstSpan<char>* pathParts = reinterpret_cast<ConstSpan<char>*>(_malloca(slashCount * sizeof(ConstSpan<char>)));
 
-        FileID lastInd{};
         if (pathParts && (partCount = pathSpn.split(pathParts, slashCount, '/')) && current) {
-            if (!current->isSame(pathParts[0])) {
-                current = getEntryByRef(current->findInChild(*this, pathParts[0]));
-            }
-            bool isLast = partCount == 1;
+            size_t start = current->isSame(pathParts[0], ignoresCase()) ? 1 : 0;
 
-            if (current == nullptr) {
-                lastInd = _entries.getNext(&current);
-                root->children.emplace_back(lastInd);
-                current->setup(lastInd, _root, pathParts[0], source, isLast ? dataInfo : FOLDER_EINF);
+            //'getNext' can grow the LUT so entries are tracked by ID instead of pointer
+            FileID currentID = current->id;
+            uint64_t hash = IO::PATH_HASH_SEED;
+            for (size_t i = start; i < partCount; i++) {
+                auto& part = pathParts[i];
+                bool isLast = i >= partCount - 1;
 
-                if (isLast && addedNew) {
-                    *addedNew = true;
-                }
-            }
-
-            if (current) {
-                for (size_t i = 1; i < partCount; i++) {
-                    auto& part = pathParts[i];
-                    isLast = i >= partCount - 1;
-
-                    auto find = current->findInChild(*this, part);
-                    if (find.isValid()) {
-                        FileEntry* findPtr{ nullptr };
-                        lastInd = _entries.getNext(&findPtr);
-       
-                        current->children.emplace_back(lastInd);
-                        findPtr->setup(lastInd, current->id, part, source, isLast ? dataInfo : FOLDER_EINF);
-
-                        if (isLast && addedNew) {
-                            *addedNew = true;
-                        }
-                    }
-                    else if (isLast) {
-                        lastInd = find;
-                    }
-                    current = getEntryByRef(find);
-                }
-            }
-            else {
-                JE_CORE_WARN("[VFS] Warning: Given path '{0}' isn't a valid path!", tempBuf);
-                goto failure;
+                hash = hashChild(hash, part);
+                currentID = addChild(currentID, hash, part, source, isLast ? dataInfo : FOLDER_EINF, isLast ? addedNew : nullptr);
+                if (!currentID.isValid()) { break; }
             }
             _freea(pathParts);
             _freea(tempBuf);
-            return lastInd;
+            return currentID;
         }
+        JE_CORE_WARN("[VFS] Warning: Given path '{0}' isn't a valid path!", tempBuf);
 
-    failure:
         if (pathParts) {
             _freea(pathParts);
         }
         _freea(tempBuf);
-        return -1;
+        return FileID();
     }
 
     void VFS::openSourceFile(uint32_t index, const char* mode) {
@@ -205,52 +206,145 @@ namespace JEngine {
     }
 
     bool VFS::removeSourceFile(uint32_t index) {
+        const FileStream* strm = _sources.getAt(index);
+        if (!strm) { return false; }
+
+        auto range = _sourceIndex.equal_range(IO::hashPath(strm->getFilePath()));
+        for (auto it = range.first; it != range.second; it++) {
+            if (it->second == index) {
+                _sourceIndex.erase(it);
+                break;
+            }
+        }
+
+        for (auto it = _paks.begin(); it != _paks.end(); it++) {
+            if (it->source == index) {
+                removePakEntries(index);
+                _paks.erase(it);
+                break;
+            }
+        }
         return _sources.markFree(index);
     }
 
+    uint32_t VFS::addPakFile(ConstSpan<char> path) {
+        uint32_t source = addSourceFile(path);
+        if (source == UINT32_MAX || getPakFile(source)) { return source; }
+
+        std::string pathStr(path.get(), path.length());
+        AssetPacking::PakFile pak{};
+        if (!pak.open(pathStr.c_str())) {
+            JE_CORE_WARN("[VFS] Warning: Failed to mount pak '{0}'!", pathStr);
+            removeSourceFile(source);
+            return UINT32_MAX;
+        }
+
+        for (size_t i = 0; i < pak.getEntryCount(); i++) {
+            const AssetPacking::PakEntry* entry = pak.getEntry(i);
+            addEntry(source, pak.getName(*entry), EntryInfo(i, size_t(entry->rawSize)));
+        }
+
+        auto& mounted = _paks.emplace_back();
+        mounted.source = source;
+        mounted.pak = std::move(pak);
+        return source;
+    }
+
+    const AssetPacking::PakFile* VFS::getPakFile(uint32_t source) const {
+        for (const auto& mounted : _paks) {
+            if (mounted.source == source) { return &mounted.pak; }
+        }
+        return nullptr;
+    }
+
+    bool VFS::readEntry(FileID entry, std::vector<uint8_t>& data) const {
+        const FileEntry* ePtr = getEntryByRef(entry);
+        if (!ePtr || ePtr->isFolder()) { return false; }
+
+        //Packed entries are a single copy/inflate out of the mapping
+        if (auto pak = getPakFile(ePtr->source)) {
+            auto pakEntry = pak->getEntry(ePtr->dataInfo.position);
+            return pakEntry && pak->read(*pakEntry, data);
+        }
+
+        const FileStream* src = getSourceFile(ePtr->source);
+        if (!src) { return false; }
+
+        FileStream stream(src->getFilePath().c_str(), "rb");
+        if (!stream.isOpen()) { return false; }
+        data.resize(stream.size());
+        return stream.read(data.data(), 1, data.size(), false) == data.size();
+    }
+
     bool VFS::removeSourceFile(ConstSpan<char> path) {
         return removeSourceFile(indexOfSourceFile(path));
     }
 
     FileID VFS::indexOfFileEntry(ConstSpan<char> path) const {
-        char* temp = reinterpret_cast<char*>(_malloca(path.length()));
-        if (!temp) { return FileID(); }
-
-        memcpy(temp, path.get(), path.length());
-        IO::fixPath({ temp, path.length() });
-        path = ConstSpan<char>(temp, path.length());
+        const FileEntry* current = getEntryByRef(_root);
+        if (!current) { return FileID(); }
 
-        size_t slashCount = path.getOccurenceCount('/') + 1;
+        path = toRelative(path);
+        size_t slashCount = path.getOccurenceCount('/') + path.getOccurenceCount('\\') + 1;
         size_t partCount = 0;
         ConstSpan<char>* pathParts = reinterpret_cast<ConstSpan<char>*>(_malloca(slashCount * sizeof(ConstSpan<char>)));
-        const FileEntry* current = getEntryByRef(_root);
+        if (!pathParts) { return FileID(); }
 
-        FileID id{};
-        if (current && pathParts && (partCount = path.split(pathParts, slashCount, '/'))) {
-            size_t start = 0;
-            if (current->isSame(pathParts[0])) {
-                start = 1;
+        //Backslashes are split here instead of copying the path just to fix it
+        for (size_t i = 0, start = 0; i <= path.length(); i++) {
+            if (i < path.length() && path[i] != '/' && path[i] != '\\') { continue; }
+            if (i > start) {
+                pathParts[partCount++] = path.slice(start, i - start);
             }
+            start = i + 1;
+        }
+
+        FileID id{};
+        size_t start = partCount > 0 && current->isSame(pathParts[0], ignoresCase()) ? 1 : 0;
+        if (start < partCount) {
+            uint64_t hash = IO::PATH_HASH_SEED;
             for (size_t i = start; i < partCount; i++) {
-                id = current->findInChild(*this, pathParts[i]);
-                current = getEntryByRef(id);
-                if (current == nullptr) { 
-                    _freea(temp);
-                    return FileID();
+                hash = hashChild(hash, pathParts[i]);
+            }
+
+            auto it = _pathIndex.find(hash);
+            if (it != _pathIndex.end()) {
+                //Verify the hit against the parent chain, a 64-bit collision is unlikely but not impossible
+                id = it->second;
+                const FileEntry* entry = getEntryByRef(id);
+                for (size_t i = partCount; i-- > start;) {
+                    if (!entry || !entry->isSame(pathParts[i], ignoresCase())) {
+                        id = FileID();
+                        break;
+                    }
+                    entry = getEntryByRef(entry->parent);
+                }
+
+                if (id.isValid() && entry != current) {
+                    id = FileID();
+                }
+            }
+
+            if (!id.isValid() && _pathCollisions > 0) {
+                id = _root;
+                for (size_t i = start; i < partCount && id.isValid(); i++) {
+                    const FileEntry* entry = getEntryByRef(id);
+                    id = entry ? entry->findInChild(*this, pathParts[i]) : FileID();
                 }
             }
         }
-        _freea(temp);
+        _freea(pathParts);
         return id;
     }
 
     uint32_t VFS::indexOfSourceFile(ConstSpan<char> path) const {
-        if (path.length() < 1) { return SIZE_MAX; }
-        uint32_t len = uint32_t(_sources.size());
-        for (uint32_t i = 0; i < len; i++) {
-            if (IO::pathsAreEqual(path, _sources[i].getFilePath())) { return i; }
+        if (path.length() < 1) { return UINT32_MAX; }
+        auto range = _sourceIndex.equal_range(IO::hashPath(path));
+        for (auto it = range.first; it != range.second; it++) {
+            const FileStream* strm = _sources.getAt(it->second);
+            if (strm && IO::pathsAreEqual(path, strm->getFilePath())) { return it->second; }
         }
-        return SIZE_MAX;
+        return UINT32_MAX;
     }
 
     bool VFS::pathExists(ConstSpan<char> path) const {
@@ -265,13 +359,14 @@ namespace JEngine {
         char* buffer = reinterpret_cast<char*>(_malloca(longest + 1 + _rootSpan.length()));
         if (!buffer) { return; }
 
-        buffer[longest] = 0;
         memcpy(buffer, _rootSpan.get(), _rootSpan.length());
         char* fileStart = buffer + _rootSpan.length();
 
+        //Removing a folder removes its children too, those slots are just skipped by 'getAt'
         FileEntry* fEnt{nullptr};
         for (uint32_t i = 0; i < _entries.size(); i++) {
-            if ((fEnt = _entries.getAt(i)) && !fEnt->isSubFile(*this) && !fEnt->parent.isValid()) {
+            if ((fEnt = _entries.getAt(i)) && fEnt->parent.isValid() && fEnt->dataInfo != RUNTIME_EINF && 
+                !fEnt->isSubFile(*this) && !getPakFile(fEnt->source)) {
                 size_t len = fEnt->buildPath(*this, false, fileStart);
                 if (len > 0) {
                     len += _rootSpan.length();
@@ -297,17 +392,162 @@ namespace JEngine {
     }
 
     bool VFS::removeEntry(FileID entry, uint8_t sourceAction) {
-        if (auto ePtr = this->getEntryByRef(entry)) {
-            switch (sourceAction) {
-                case F_ACT_CLOSE:
-                    closeSourceFile(ePtr->source);
-                    break;
-                case F_ACT_REMOVE:
-                    removeSourceFile(ePtr->source);
-                    break;
+        FileEntry* ePtr = getEntryByRef(entry);
+        if (!ePtr || entry == _root) { return false; }
+
+        switch (sourceAction) {
+            case F_ACT_CLOSE:
+                closeSourceFile(ePtr->source);
+                break;
+            case F_ACT_REMOVE:
+                removeSourceFile(ePtr->source);
+                break;
+        }
+
+        if (FileEntry* parRef = getEntryByRef(ePtr->parent)) {
+            auto it = std::find(parRef->children.begin(), parRef->children.end(), entry);
+            if (it != parRef->children.end()) {
+                parRef->children.erase(it);
+            }
+        }
+        releaseEntry(entry, hashEntry(*ePtr));
+        return true;
+    }
+
+    ConstSpan<char> VFS::toRelative(ConstSpan<char> path) const {
+        if (_rootSpan.length() < 1) { return path; }
+
+        //The root is stored trimmed so an absolute path's leading separator has to be skipped for the comparison
+        ConstSpan<char> abs = path;
+        if (abs.length() > 0 && (abs[0] == '/' || abs[0] == '\\') && _rootSpan[0] != '/') {
+            abs = abs.slice(1);
+        }
+
+        //The root only matches whole path components, 'C:/proj' must not turn 'C:/proj2/x' into '2/x'
+        if (abs.length() < _rootSpan.length() || !IO::pathsAreEqual(abs.slice(0, _rootSpan.length()), _rootSpan)) { return path; }
+        if (abs.length() == _rootSpan.length()) { return abs.slice(_rootSpan.length()); }
+
+        const char next = abs[_rootSpan.length()];
+        return next == '/' || next == '\\' ? abs.slice(_rootSpan.length() + 1) : path;
+    }
+
+    uint64_t VFS::hashEntry(const FileEntry& entry) const {
+        const FileEntry* parent = getEntryByRef(entry.parent);
+        return parent ? hashChild(hashEntry(*parent), ConstSpan<char>(entry.name)) : IO::PATH_HASH_SEED;
+    }
+
+    uint64_t VFS::hashChild(uint64_t parentHash, ConstSpan<char> name) const {
+        return IO::appendPathHash(IO::appendPathHash(parentHash, ConstSpan<char>("/", 1), false), name, ignoresCase());
+    }
+
+    FileID VFS::findIndexed(uint64_t hash, FileID parent, ConstSpan<char> name) const {
+        auto it = _pathIndex.find(hash);
+        if (it != _pathIndex.end()) {
+            const FileEntry* entry = getEntryByRef(it->second);
+            if (entry && entry->parent == parent && entry->isSame(name, ignoresCase())) {
+                return it->second;
+            }
+        }
+
+        const FileEntry* parentPtr = _pathCollisions > 0 ? getEntryByRef(parent) : nullptr;
+        return parentPtr ? parentPtr->findInChild(*this, name) : FileID();
+    }
+
+    FileID VFS::addChild(FileID parent, uint64_t hash, ConstSpan<char> name, uint32_t source, EntryInfo dataInfo, bool* addedNew) {
+        FileID find = findIndexed(hash, parent, name);
+        if (find.isValid() || !getEntryByRef(parent)) { return find; }
+
+        FileEntry* findPtr{ nullptr };
+        uint64_t index = _entries.getNext(&findPtr);
+        if (!findPtr) { return FileID(); }
+
+        //'getNext' can grow the LUT, the parent has to be fetched after it
+        find = FileID(uint32_t(index), dataInfo == FOLDER_EINF);
+        getEntryByRef(parent)->children.emplace_back(find);
+        findPtr->setup(find, parent, name, source, dataInfo);
+        indexEntry(hash, find);
+
+        if (addedNew) {
+            *addedNew = true;
+        }
+        return find;
+    }
+
+    void VFS::indexEntry(uint64_t hash, FileID id) {
+        auto res = _pathIndex.emplace(hash, id);
+        if (!res.second && res.first->second != id) {
+            _pathCollisions++;
+            JE_CORE_WARN("[VFS] Warning: Path hash collision for entry '{0}', lookups will fall back to walking the tree!", id.getID());
+        }
+    }
+
+    void VFS::indexTree(FileID id, uint64_t hash) {
+        const FileEntry* entry = getEntryByRef(id);
+        if (!entry) { return; }
+
+        if (id != _root) {
+            indexEntry(hash, id);
+        }
+
+        for (FileID ch : entry->children) {
+            if (const FileEntry* child = getEntryByRef(ch)) {
+                indexTree(ch, hashChild(hash, ConstSpan<char>(child->name)));
+            }
+        }
+    }
+
+    void VFS::rebuildIndex() {
+        _pathIndex.clear();
+        _pathCollisions = 0;
+        _pathIndex.reserve(_entries.size());
+        indexTree(_root, IO::PATH_HASH_SEED);
+    }
+
+    void VFS::rebuildSourceIndex() {
+        _sourceIndex.clear();
+        for (uint32_t i = 0; i < _sources.size(); i++) {
+            if (const FileStream* strm = _sources.getAt(i)) {
+                _sourceIndex.emplace(IO::hashPath(strm->getFilePath()), i);
+            }
+        }
+    }
+
+    void VFS::releaseEntry(FileID id, uint64_t hash) {
+        FileEntry* entry = getEntryByRef(id);
+        if (!entry) { return; }
+
+        auto it = _pathIndex.find(hash);
+        if (it != _pathIndex.end() && it->second == id) {
+            _pathIndex.erase(it);
+        }
+
+        for (FileID ch : entry->children) {
+            if (const FileEntry* child = getEntryByRef(ch)) {
+                releaseEntry(ch, hashChild(hash, ConstSpan<char>(child->name)));
+            }
+        }
+        _entries.markFree(id.getID());
+    }
+
+    void VFS::removePakEntries(uint32_t source) {
+        for (uint32_t i = 0; i < _entries.size(); i++) {
+            FileEntry* fEnt = _entries.getAt(i);
+            if (fEnt && fEnt->isFile() && fEnt->source == source) {
+                removeEntry(fEnt->id);
+            }
+        }
+
+        //Folders the pak created go once they're empty, anything added under them since keeps them alive
+        bool removed = true;
+        while (removed) {
+            removed = false;
+            for (uint32_t i = 0; i < _entries.size(); i++) {
+                FileEntry* fEnt = _entries.getAt(i);
+                if (fEnt && fEnt->isFolder() && fEnt->source == source && fEnt->children.empty() && removeEntry(fEnt->id)) {
+                    removed = true;
+                }
             }
         }
-        return _entries.markFree(entry.getID());
     }
 
     uint32_t VFS::addSourceFile(ConstSpan<char> path) {
@@ -316,9 +556,10 @@ namespace JEngine {
         if (ind != UINT32_MAX) { return ind; }
 
         FileStream* strm{ nullptr };
-        ind = _sources.getNext(&strm);
+        ind = uint32_t(_sources.getNext(&strm));
         if (strm) {
             strm->setFilepath(path.get(), path.length());
+            _sourceIndex.emplace(IO::hashPath(strm->getFilePath()), ind);
         }
         return ind;
     }
@@ -326,8 +567,8 @@ namespace JEngine {
     FileID FileEntry::findInChild(const VFS& vfs, ConstSpan<char> span) const {
         for (FileID fld : children) {
             const FileEntry* ent = vfs.getEntryByRef(fld);
-            if (ent && ent->isSame(span)) {
-                return id.getID();
+            if (ent && ent->isSame(span, vfs.ignoresCase())) {
+                return fld;
             }
         }
         return FileID();
@@ -354,15 +595,6 @@ namespace JEngine {
     }
 
     void FileEntry::remove(VFS& vfs) {
-        if (FileEntry* parRef = vfs.getEntryByRef(parent)) {
-            parRef->children.erase(std::find(parRef->children.begin(), parRef->children.end(), id));
-        }
-
-        for (FileID id : children) {
-            if (FileEntry* item = vfs.getEntryByRef(id)) {
-                item->remove(vfs);
-            }
-        }
         vfs.removeEntry(id);
     }
     size_t FileEntry::getDepth(const VFS& vfs, bool includeRoot) const {
@@ -0,0 +1,125 @@
+#include <JEngine/Utility/Parallel.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace JEngine::Parallel::detail {
+    namespace {
+        struct Job {
+            IndexFunc func;
+            void* context;
+            size_t count;
+            std::atomic<size_t> next;
+
+            //Helpers that may still join and helpers currently working, both guarded by the pool's mutex
+            uint32_t slots;
+            uint32_t active;
+
+            void work() {
+                for (size_t i = next++; i < count; i = next++) {
+                    func(context, i);
+                }
+            }
+        };
+
+        //Workers only pick up jobs while idle, the caller always works on its own job as well,
+        //so a 'forEach' inside a 'forEach' still finishes when every worker is busy.
+        class WorkerPool {
+        public:
+            WorkerPool() : _mutex(), _wake(), _done(), _jobs(), _threads(), _stop(false) {
+                uint32_t count = getWorkerCount();
+                count = count > 1 ? count - 1 : 0;
+                _threads.reserve(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    _threads.emplace_back(&WorkerPool::workerLoop, this);
+                }
+            }
+
+            ~WorkerPool() {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _stop = true;
+                }
+                _wake.notify_all();
+                for (auto& thread : _threads) {
+                    thread.join();
+                }
+            }
+
+            size_t getThreadCount() const { return _threads.size(); }
+
+            void run(Job& job) {
+                uint32_t helpers = job.slots;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _jobs.push_back(&job);
+                }
+                if (helpers > 1) {
+                    _wake.notify_all();
+                }
+                else {
+                    _wake.notify_one();
+                }
+
+                job.work();
+
+                //Nobody joins once the job is out of the queue, then it's only waiting on the helpers already in it
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (job.slots > 0) {
+                    _jobs.erase(std::find(_jobs.begin(), _jobs.end(), &job));
+                    job.slots = 0;
+                }
+                _done.wait(lock, [&job]() { return job.active == 0; });
+            }
+
+        private:
+            std::mutex _mutex;
+            std::condition_variable _wake;
+            std::condition_variable _done;
+            std::deque<Job*> _jobs;
+            std::vector<std::thread> _threads;
+            bool _stop;
+
+            void workerLoop() {
+                std::unique_lock<std::mutex> lock(_mutex);
+                while (true) {
+                    _wake.wait(lock, [this]() { return _stop || _jobs.size() > 0; });
+                    if (_stop) { return; }
+
+                    Job& job = *_jobs.front();
+                    job.active++;
+                    if (--job.slots == 0) {
+                        _jobs.pop_front();
+                    }
+
+                    lock.unlock();
+                    job.work();
+                    lock.lock();
+
+                    if (--job.active == 0) {
+                        _done.notify_all();
+                    }
+                }
+            }
+        };
+
+        WorkerPool& getPool() {
+            static WorkerPool pool{};
+            return pool;
+        }
+    }
+
+    void run(size_t count, uint32_t workers, IndexFunc func, void* context) {
+        WorkerPool& pool = getPool();
+        uint32_t helpers = uint32_t(std::min<size_t>(workers - 1, pool.getThreadCount()));
+
+        Job job{ func, context, count, { 0 }, helpers, 0 };
+        if (helpers < 1) {
+            job.work();
+            return;
+        }
+        pool.run(job);
+    }
+}
@@ -0,0 +1,142 @@
+#include <JEngine/Utility/XXHash.h>
+#include <cstring>
+
+namespace JEngine {
+    namespace Data {
+        static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+        static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+        static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+        static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+        static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+        static inline uint64_t rotl(uint64_t value, int32_t bits) {
+            return (value << bits) | (value >> (64 - bits));
+        }
+
+        //Little endian reads, memcpy keeps unaligned input legal
+        static inline uint64_t read64(const uint8_t* data) {
+            uint64_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        static inline uint32_t read32(const uint8_t* data) {
+            uint32_t value;
+            memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        static inline uint64_t round(uint64_t acc, uint64_t input) {
+            acc += input * PRIME_2;
+            return rotl(acc, 31) * PRIME_1;
+        }
+
+        static inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+            acc ^= round(0, value);
+            return acc * PRIME_1 + PRIME_4;
+        }
+
+        static inline const uint8_t* consumeStripes(uint64_t acc[4], const uint8_t* data, const uint8_t* end) {
+            while (data + 32 <= end) {
+                acc[0] = round(acc[0], read64(data));
+                acc[1] = round(acc[1], read64(data + 8));
+                acc[2] = round(acc[2], read64(data + 16));
+                acc[3] = round(acc[3], read64(data + 24));
+                data += 32;
+            }
+            return data;
+        }
+
+        static uint64_t finalize(uint64_t hash, const uint8_t* data, size_t length) {
+            const uint8_t* end = data + length;
+            while (data + 8 <= end) {
+                hash ^= round(0, read64(data));
+                hash = rotl(hash, 27) * PRIME_1 + PRIME_4;
+                data += 8;
+            }
+
+            if (data + 4 <= end) {
+                hash ^= uint64_t(read32(data)) * PRIME_1;
+                hash = rotl(hash, 23) * PRIME_2 + PRIME_3;
+                data += 4;
+            }
+
+            while (data < end) {
+                hash ^= (*data++) * PRIME_5;
+                hash = rotl(hash, 11) * PRIME_1;
+            }
+
+            hash ^= hash >> 33;
+            hash *= PRIME_2;
+            hash ^= hash >> 29;
+            hash *= PRIME_3;
+            hash ^= hash >> 32;
+            return hash;
+        }
+
+        static uint64_t mergeAccumulators(const uint64_t acc[4]) {
+            uint64_t hash = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+            hash = mergeRound(hash, acc[0]);
+            hash = mergeRound(hash, acc[1]);
+            hash = mergeRound(hash, acc[2]);
+            return mergeRound(hash, acc[3]);
+        }
+
+        uint64_t xxHash64(const void* data, size_t length, uint64_t seed) {
+            const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+            const uint8_t* end = ptr + length;
+
+            uint64_t hash = seed + PRIME_5;
+            if (length >= 32) {
+                uint64_t acc[4]{ seed + PRIME_1 + PRIME_2, seed + PRIME_2, seed, seed - PRIME_1 };
+                ptr = consumeStripes(acc, ptr, end);
+                hash = mergeAccumulators(acc);
+            }
+            return finalize(hash + length, ptr, size_t(end - ptr));
+        }
+
+        void XXHash64::reset(uint64_t seed) {
+            _acc[0] = seed + PRIME_1 + PRIME_2;
+            _acc[1] = seed + PRIME_2;
+            _acc[2] = seed;
+            _acc[3] = seed - PRIME_1;
+            _seed = seed;
+            _total = 0;
+            _buffered = 0;
+        }
+
+        void XXHash64::update(const void* data, size_t length) {
+            if (!data || length < 1) { return; }
+
+            const uint8_t* ptr = reinterpret_cast<const uint8_t*>(data);
+            const uint8_t* end = ptr + length;
+            _total += length;
+
+            //Tops up a partial stripe first
+            if (_buffered > 0) {
+                size_t fill = sizeof(_buffer) - _buffered;
+                if (length < fill) {
+                    memcpy(_buffer + _buffered, ptr, length);
+                    _buffered += uint32_t(length);
+                    return;
+                }
+
+                memcpy(_buffer + _buffered, ptr, fill);
+                consumeStripes(_acc, _buffer, _buffer + sizeof(_buffer));
+                ptr += fill;
+                _buffered = 0;
+            }
+
+            ptr = consumeStripes(_acc, ptr, end);
+            if (ptr < end) {
+                _buffered = uint32_t(end - ptr);
+                memcpy(_buffer, ptr, _buffered);
+            }
+        }
+
+        uint64_t XXHash64::digest() const {
+            uint64_t hash = _total >= 32 ? mergeAccumulators(_acc) : _seed + PRIME_5;
+            return finalize(hash + _total, _buffer, _buffered);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#include <JEngine/Core/Log.h>
+#include <JEngine/Assets/AssetPacking.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Command line packer for JPAK asset packs.
+// Usage:
+//   J-Pak <source directory> <output.jpak> [--raw] [--fast] [--level=N] [--single-thread]
+//   J-Pak --list <pak>
+//   J-Pak --verify <pak>
+// Exits with 1 if packing fails or any entry doesn't verify.
+
+using namespace JEngine;
+using namespace JEngine::AssetPacking;
+
+static void printUsage() {
+	printf(
+		"Usage:\n"
+		"  J-Pak <source directory> <output%s> [--raw] [--fast] [--level=N] [--single-thread]\n"
+		"  J-Pak --list <pak>\n"
+		"  J-Pak --verify <pak>\n", PakExtension);
+}
+
+static int listPak(const char* path, bool printEntries) {
+	PakFile pak(path);
+	if (!pak.isOpen()) { return 1; }
+
+	uint64_t stored = 0;
+	uint64_t raw = 0;
+	for (size_t i = 0; i < pak.getEntryCount(); i++) {
+		const PakEntry* entry = pak.getEntry(i);
+		ConstSpan<char> name = pak.getName(*entry);
+		if (printEntries) {
+			printf("%016llx %12llu %12llu %-4s %08x %.*s\n",
+				(unsigned long long)entry->hash, (unsigned long long)entry->size, (unsigned long long)entry->rawSize,
+				(entry->flags & PAK_ENTRY_LZ4) ? "lz4" : entry->isCompressed() ? "zlib" : "raw", entry->crc, int(name.length()), name.get());
+		}
+		stored += entry->size;
+		raw += entry->rawSize;
+	}
+	printf("%zu entries, %llu bytes stored, %llu bytes unpacked\n", pak.getEntryCount(), (unsigned long long)stored, (unsigned long long)raw);
+	return 0;
+}
+
+static int verifyPak(const char* path) {
+	PakFile pak(path);
+	if (!pak.isOpen()) { return 1; }
+
+	size_t failed = 0;
+	for (size_t i = 0; i < pak.getEntryCount(); i++) {
+		const PakEntry* entry = pak.getEntry(i);
+		if (!pak.verify(*entry) || pak.indexOf(pak.getName(*entry)) != i) {
+			ConstSpan<char> name = pak.getName(*entry);
+			printf("FAILED %.*s\n", int(name.length()), name.get());
+			failed++;
+		}
+	}
+	printf("%zu/%zu entries ok\n", pak.getEntryCount() - failed, pak.getEntryCount());
+	return failed > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+	Log::init();
+
+	if (argc == 3 && strcmp(argv[1], "--list") == 0) {
+		return listPak(argv[2], true);
+	}
+
+	if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+		return verifyPak(argv[2]);
+	}
+
+	if (argc < 3) {
+		printUsage();
+		return 1;
+	}
+
+	uint32_t flags = PAK_FLAG_COMPRESS | PAK_FLAG_MULTITHREAD;
+	int32_t level = 6;
+	for (int i = 3; i < argc; i++) {
+		const char* arg = argv[i];
+		if (strcmp(arg, "--raw") == 0) {
+			flags &= ~PAK_FLAG_COMPRESS;
+		}
+		else if (strcmp(arg, "--fast") == 0) {
+			flags |= PAK_FLAG_FAST;
+		}
+		else if (strcmp(arg, "--single-thread") == 0) {
+			flags &= ~PAK_FLAG_MULTITHREAD;
+		}
+		else if (strncmp(arg, "--level=", 8) == 0) {
+			level = std::min(std::max(atoi(arg + 8), 0), 9);
+		}
+		else {
+			printf("Unknown argument '%s'\n", arg);
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (!packAssets(ConstSpan<char>(argv[1]), ConstSpan<char>(argv[2]), flags, level)) {
+		printf("Failed to pack '%s' into '%s'\n", argv[1], argv[2]);
+		return 1;
+	}
+	return listPak(argv[2], false);
+}
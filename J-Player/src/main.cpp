@@ -28,6 +28,7 @@ namespace JEngine {
 
 				if (shouldBreak) { break; }
 				getTime().tick();
+				getAssetDB().update();
 
 				bool windowHasFocus = this->hasFocus();
 				Input::update<0>(windowHasFocus);